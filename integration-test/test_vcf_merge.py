@@ -27,6 +27,41 @@ class TestVcfMerge(IntegrationTest, unittest.TestCase):
         self.assertEqual(0, rv)
         self.assertFilesEqual(expected_file, output_file, filter_regex="##fileDate=")
 
+    # Sites where a batch leaves entries unmerged or rejects same-file
+    # duplicates must come out of a merge tree as they do from a flat merge
+    def test_vcf_merge_tree(self):
+        input_files = sorted(self.inputFiles("vcf-merge/tree/merge-[0-9].vcf"))
+        expected_file = self.inputFiles("vcf-merge/tree/expected.vcf")[0]
+
+        for fanin in ["0", "2", "3"]:
+            output_file = self.tempFile("output-%s.vcf" %fanin)
+            params = [ "vcf-merge", "--merge-tree-fanin", fanin, "-o", output_file ]
+            params.extend(input_files)
+            rv, err = self.execute(params)
+            self.assertEqual(0, rv)
+            self.assertFilesEqual(expected_file, output_file, filter_regex="##fileDate=")
+
+    # merge-1.vcf has two entries that only meet through merge-3.vcf, in
+    # another batch. The later one is rejected as in a flat merge, unless
+    # the first batch has merged it with the entry of merge-4.vcf, which a
+    # merge tree cannot undo.
+    def test_vcf_merge_tree_late_duplicate(self):
+        input_files = self.inputFiles("vcf-merge/tree-dup/merge-[0-9].vcf")
+        input_files = dict((f.split("/")[-1], f) for f in input_files)
+        expected_file = self.inputFiles("vcf-merge/tree-dup/expected.vcf")[0]
+
+        output_file = self.tempFile("output.vcf")
+        params = [ "vcf-merge", "--merge-tree-fanin", "2", "-o", output_file ]
+        params.extend(input_files["merge-%d.vcf" %i] for i in [1, 2, 3])
+        rv, err = self.execute(params)
+        self.assertEqual(0, rv)
+        self.assertFilesEqual(expected_file, output_file, filter_regex="##fileDate=")
+
+        params = [ "vcf-merge", "--merge-tree-fanin", "2", "-o", output_file ]
+        params.extend(input_files["merge-%d.vcf" %i] for i in [1, 4, 3])
+        rv, err = self.execute(params)
+        self.assertEqual(1, rv)
+        self.assertTrue("cannot merge the entries at 1:11" in err)
 
     def test_vcf_merge(self):
         merge_strategy_file = self.tempFile("strategy.ms")
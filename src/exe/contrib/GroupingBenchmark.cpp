@@ -0,0 +1,151 @@
+#include "common/Timer.hpp"
+#include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/Header.hpp"
+#include "processors/grouping/GroupBySharedRegions.hpp"
+
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Times GroupBySharedRegions on the kinds of bundles GroupOverlapping makes
+// around long deletions and in repetitive sequence, where thousands of
+// entries can end up in one bundle.
+
+typedef std::unique_ptr<Vcf::Entry> EntryPtr;
+typedef std::vector<EntryPtr> EntryPtrVector;
+
+namespace {
+    std::string const headerText =
+        "##fileformat=VCFv4.1\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n"
+        ;
+
+    char const bases[] = "ACGT";
+
+    std::string randomBases(size_t n) {
+        std::string rv(n, 'A');
+        for (size_t i = 0; i < n; ++i)
+            rv[i] = bases[rand() % 4];
+        return rv;
+    }
+
+    EntryPtr makeEntry(Vcf::Header const* header, int64_t pos,
+            std::string const& ref, std::string const& alt)
+    {
+        std::stringstream ss;
+        ss << "1\t" << pos << "\t.\t" << ref << "\t" << alt << "\t.\t.\t.";
+        return EntryPtr(new Vcf::Entry(header, ss.str()));
+    }
+
+    std::string otherBase(char c) {
+        return std::string(1, c == 'A' ? 'C' : 'A');
+    }
+
+    struct CountGroups {
+        CountGroups()
+            : groups(0)
+            , entries(0)
+        {}
+
+        void operator()(EntryPtrVector group) {
+            ++groups;
+            entries += group.size();
+        }
+
+        size_t groups;
+        size_t entries;
+    };
+}
+
+struct IBundle {
+    virtual ~IBundle() {}
+
+    virtual std::string name() const = 0;
+    virtual EntryPtrVector make(Vcf::Header const* header, size_t n) const = 0;
+};
+
+// n callers reporting the same snv: one region shared by every entry
+struct SharedSite : public IBundle {
+    std::string name() const { return "same snv"; }
+
+    EntryPtrVector make(Vcf::Header const* header, size_t n) const {
+        EntryPtrVector rv;
+        for (size_t i = 0; i < n; ++i)
+            rv.push_back(makeEntry(header, 1000, "G", "C"));
+        return rv;
+    }
+};
+
+// A deletion spanning n/2 sites, each called twice
+struct LongDeletion : public IBundle {
+    std::string name() const { return "snvs under a deletion"; }
+
+    EntryPtrVector make(Vcf::Header const* header, size_t n) const {
+        EntryPtrVector rv;
+        size_t sites = n / 2;
+        std::string ref = randomBases(sites + 2);
+        rv.push_back(makeEntry(header, 999, ref, ref.substr(0, 1)));
+        for (size_t i = 1; i <= sites; ++i) {
+            std::string base = ref.substr(i, 1);
+            rv.push_back(makeEntry(header, 999 + i, base, otherBase(base[0])));
+            rv.push_back(makeEntry(header, 999 + i, base, otherBase(base[0])));
+        }
+        return rv;
+    }
+};
+
+// Entries with two snvs each, the second shared with the next entry, so
+// the whole bundle is one group
+struct SnvChain : public IBundle {
+    std::string name() const { return "chain of snv pairs"; }
+
+    EntryPtrVector make(Vcf::Header const* header, size_t n) const {
+        EntryPtrVector rv;
+        std::string ref = randomBases(n + 1);
+        for (size_t i = 0; i < n; ++i) {
+            std::string r = ref.substr(i, 2);
+            std::string alt = otherBase(r[0]) + r[1] + "," + r[0] + otherBase(r[1]);
+            rv.push_back(makeEntry(header, 1000 + i, r, alt));
+        }
+        return rv;
+    }
+};
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoul(argv[i], 0, 10));
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+
+    Vcf::Header header = Vcf::Header::fromString(headerText);
+
+    boost::ptr_vector<IBundle> bundles;
+    bundles.push_back(new SharedSite);
+    bundles.push_back(new LongDeletion);
+    bundles.push_back(new SnvChain);
+
+    for (auto b = bundles.begin(); b != bundles.end(); ++b) {
+        for (auto n = sizes.begin(); n != sizes.end(); ++n) {
+            EntryPtrVector entries = b->make(&header, *n);
+            size_t count = entries.size();
+
+            CountGroups out;
+            auto grouper = makeGroupBySharedRegions(out);
+            WallTimer timer;
+            grouper(std::move(entries));
+            std::cout << b->name() << ": " << count << " entries in "
+                << out.groups << " groups in " << timer.elapsed() << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "common/Timer.hpp"
+#include "fileformats/vcf/Header.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Times Vcf::Header::merge on synthetic wide headers like those of large
+// cohorts: every input declares the same (many) contigs and its own
+// samples.
+//
+// usage: header-merge-benchmark [headers [contigs [samples per header]]]
+
+namespace {
+    std::string makeHeaderText(size_t idx, size_t nContigs, size_t nSamples) {
+        std::stringstream ss;
+        ss << "##fileformat=VCFv4.1\n"
+            << "##fileDate=20140101\n"
+            << "##source=header-merge-benchmark\n";
+        for (size_t i = 0; i < nContigs; ++i)
+            ss << "##contig=<ID=ctg" << i << ",length=" << 1000 + i << ">\n";
+        ss << "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Total Depth\">\n"
+            << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+            << "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Read Depth\">\n"
+            << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+        for (size_t i = 0; i < nSamples; ++i)
+            ss << "\tS" << idx << "_" << i;
+        ss << "\n";
+        return ss.str();
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nHeaders = argc > 1 ? strtoul(argv[1], 0, 10) : 1000;
+    size_t nContigs = argc > 2 ? strtoul(argv[2], 0, 10) : 100000;
+    size_t nSamples = argc > 3 ? strtoul(argv[3], 0, 10) : 50;
+
+    WallTimer timer;
+    // the inputs only differ in their sample names, so parse one and
+    // rename its samples for the others rather than holding them all
+    Vcf::Header input = Vcf::Header::fromString(makeHeaderText(0, nContigs, nSamples));
+    std::cout << "parsed a header with " << nContigs << " contigs in "
+        << timer.elapsed() << "\n";
+
+    timer.reset();
+    Vcf::Header merged;
+    for (size_t i = 0; i < nHeaders; ++i) {
+        boost::unordered_map<std::string, std::string> names;
+        std::vector<std::string> const& old = input.sampleNames();
+        for (size_t j = 0; j < old.size(); ++j) {
+            std::stringstream ss;
+            ss << "S" << i << "_" << j;
+            names[old[j]] = ss.str();
+        }
+        input.renameSamples(names);
+        merged.merge(input);
+    }
+    std::cout << "merged " << nHeaders << " headers (" << merged.sampleCount()
+        << " samples, " << merged.metaInfoLines().size() << " lines) in "
+        << timer.elapsed() << "\n";
+
+    timer.reset();
+    size_t size = merged.text().size();
+    std::cout << "built the " << size << " byte header text in "
+        << timer.elapsed() << "\n";
+
+    timer.reset();
+    std::stringstream out;
+    for (int i = 0; i < 10; ++i)
+        out << merged;
+    std::cout << "wrote it 10 times in " << timer.elapsed() << "\n";
+
+    return 0;
+}
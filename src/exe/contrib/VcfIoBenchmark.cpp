@@ -3,12 +3,16 @@
 #include "fileformats/vcf/Entry.hpp"
 #include "io/InputStream.hpp"
 #include "io/StreamHandler.hpp"
+#include "io/TempFile.hpp"
+#include "metrics/Metrics.hpp"
 
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -52,22 +56,109 @@ struct TestInOnly : public IBenchmark {
     }
 };
 
+// The per-site and per-sample metrics that vcf-report computes
+struct TestReportMetrics : public IBenchmark {
+    std::string name() const { return "report metrics"; }
+
+    size_t run(VcfReader::ptr const& reader, std::ostream& out) const {
+        Vcf::Entry entry;
+        size_t count(0);
+        auto& r = *reader;
+        std::vector<std::string> infoFields{"DBSNP"};
+        Metrics::SampleMetrics sampleMetrics(r.header().sampleCount());
+        boost::chrono::microseconds sampleTime(0);
+        while (r.next(entry)) {
+            if (entry.alt().empty() || !entry.sampleData().hasGenotypeData())
+                continue;
+            Metrics::EntryMetrics siteMetrics(entry, infoFields);
+            WallTimer timer;
+            sampleMetrics.processEntry(entry, siteMetrics);
+            sampleTime += timer.elapsed_as<boost::chrono::microseconds>();
+            ++count;
+        }
+        std::cout << "  (per-sample metrics: "
+            << boost::chrono::duration_cast<boost::chrono::milliseconds>(sampleTime) << ")\n";
+        out << "het variants in first sample: " << sampleMetrics.numHetVariants(0) << "\n";
+        return count;
+    }
+};
+
+namespace {
+    // Writes a vcf with the given number of samples and biallelic snv
+    // sites, mostly hom ref, with some variant, missing and filtered calls.
+    void writeSyntheticVcf(std::ostream& out, size_t nSamples, size_t nSites) {
+        out << "##fileformat=VCFv4.1\n"
+            << "##contig=<ID=1>\n"
+            << "##INFO=<ID=DBSNP,Number=A,Type=Integer,Description=\"dbSNP membership\">\n"
+            << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+            << "##FORMAT=<ID=FT,Number=1,Type=String,Description=\"Sample filter\">\n"
+            << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+        for (size_t i = 0; i < nSamples; ++i)
+            out << "\tS" << i;
+        out << "\n";
+
+        char const bases[] = "ACGT";
+        uint32_t x = 12345;
+        auto rand = [&x]() { x = x * 1103515245 + 12345; return (x >> 16) & 0x7fff; };
+        for (size_t site = 0; site < nSites; ++site) {
+            uint32_t ref = rand() % 4;
+            uint32_t alt = (ref + 1 + rand() % 3) % 4;
+            out << "1\t" << (site + 1) * 100 << "\t.\t" << bases[ref] << "\t" << bases[alt]
+                << "\t.\tPASS\t" << (site % 2 ? "DBSNP=1" : ".") << "\tGT:FT";
+            // how common the variant is at this site, out of 1024
+            uint32_t freq = rand() % 256;
+            for (size_t i = 0; i < nSamples; ++i) {
+                uint32_t r = rand() % 1024;
+                if (r < 10)
+                    out << "\t./.:PASS";
+                else if (r < 20)
+                    out << "\t0/1:DIE";
+                else if (r < 20 + freq / 4)
+                    out << "\t1/1:PASS";
+                else if (r < 20 + freq)
+                    out << "\t0/1:PASS";
+                else
+                    out << "\t0/0:PASS";
+            }
+            out << "\n";
+        }
+    }
+}
 
 int main(int argc, char** argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_vcf_file> <output_vcf_file>\n";
+    bool synthetic = argc >= 3 && argc <= 5 && std::string(argv[1]) == "--synthetic";
+    if (argc != 3 && !synthetic) {
+        std::cerr << "Usage: " << argv[0] << " <input_vcf_file> <output_vcf_file>\n"
+            << "       " << argv[0] << " --synthetic <output_vcf_file> [<samples> [<sites>]]\n"
+            << "\n--synthetic runs on a generated file with 10000 samples and 1000 sites by default\n";
         return 1;
     }
 
+    std::string inputPath(argv[1]);
+    std::string outputPath(argv[2]);
+    TempFile::ptr tmp;
+    if (synthetic) {
+        size_t nSamples = argc > 3 ? strtoul(argv[3], 0, 10) : 10000;
+        size_t nSites = argc > 4 ? strtoul(argv[4], 0, 10) : 1000;
+        tmp = TempFile::create(TempFile::CLEANUP);
+        WallTimer timer;
+        writeSyntheticVcf(tmp->stream(), nSamples, nSites);
+        tmp->stream().close();
+        std::cout << "generated " << nSites << " sites with " << nSamples
+            << " samples in " << timer.elapsed() << "\n";
+        inputPath = tmp->path();
+    }
+
     boost::ptr_vector<IBenchmark> tests;
 //    tests.push_back(new TestInOut);
     tests.push_back(new TestInOnly);
+    tests.push_back(new TestReportMetrics);
 
     for (auto iter = tests.begin(); iter != tests.end(); ++iter) {
         StreamHandler streams;
-        auto in = streams.openForReading(argv[1]);
+        auto in = streams.openForReading(inputPath);
         auto reader = openStream<Vcf::Entry>(*in);
-        ostream* out = streams.get<ostream>(argv[2]);
+        ostream* out = streams.get<ostream>(outputPath);
 
         WallTimer timer;
         size_t count = iter->run(reader, *out);
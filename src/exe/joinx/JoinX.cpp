@@ -6,6 +6,7 @@
 #include "ui/FindHomopolymersCommand.hpp"
 #include "ui/GenerateCommand.hpp"
 #include "ui/IntersectCommand.hpp"
+#include "ui/IntersectManyCommand.hpp"
 #include "ui/RefStatsCommand.hpp"
 #include "ui/RemapCigarCommand.hpp"
 #include "ui/SortCommand.hpp"
@@ -42,6 +43,7 @@ JoinX::JoinX() {
     registerSubCommand(std::shared_ptr<CommandBase>(new FindHomopolymersCommand));
     registerSubCommand(std::shared_ptr<CommandBase>(new GenerateCommand));
     registerSubCommand(std::shared_ptr<CommandBase>(new IntersectCommand));
+    registerSubCommand(std::shared_ptr<CommandBase>(new IntersectManyCommand));
     registerSubCommand(std::shared_ptr<CommandBase>(new RefStatsCommand));
     registerSubCommand(std::shared_ptr<CommandBase>(new RemapCigarCommand));
     registerSubCommand(std::shared_ptr<CommandBase>(new SortCommand));
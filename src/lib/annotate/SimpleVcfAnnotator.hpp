@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/ObjectPool.hpp"
 #include "common/compat.hpp"
 #include "fileformats/vcf/Compare.hpp"
 #include "fileformats/vcf/CustomType.hpp"
@@ -16,7 +17,7 @@ struct InfoTranslation {
     bool singleToPerAlt;
 };
 
-template<typename OutputType>
+template<typename OutputType, typename PoolType = NoObjectPool>
 class SimpleVcfAnnotator {
 public:
     typedef std::unique_ptr<Vcf::Entry> EntryPtr;
@@ -33,11 +34,13 @@ public:
             , bool copyIdents
             , InfoFieldMapping const& infoMap
             , Vcf::Header const& header
+            , PoolType* pool = 0
             )
         : _out(out)
         , _copyIdents(copyIdents)
         , _infoMap(infoMap)
         , _header(header)
+        , _pool(pool)
     {
     }
 
@@ -126,23 +129,35 @@ public:
 
     void operator()(std::vector<std::unique_ptr<Vcf::Entry>> entries) {
         EntryPtrVector inputs; // entries from the input file
+        EntryPtrVector annoPtrs;
 
         // FIXME: change this to have HitsType be unique_ptrs so we can just
-        // move those rather than the heavier entry objects.
-        HitsType annos;  // entries from the annotation file
+        // use those rather than swapping into entry objects.
+        HitsType& annos = _annos;  // entries from the annotation file
+        annos.clear();
 
         for (auto i = entries.begin(); i != entries.end(); ++i) {
             if ((*i)->header().sourceIndex() == 0) {
                 inputs.push_back(std::move(*i));
             }
             else {
-                annos.push_back(std::move(**i));
+                annos.emplace_back();
+                annos.back().swap(**i);
+                annoPtrs.push_back(std::move(*i));
             }
         }
 
         for (auto i = inputs.begin(); i  != inputs.end(); ++i) {
             (*this)(**i, annos);
         }
+
+        if (_pool) {
+            // hand the annotation entries their storage back for reuse
+            for (std::size_t i = 0; i < annoPtrs.size(); ++i)
+                annos[i].swap(*annoPtrs[i]);
+            _pool->release(inputs);
+            _pool->release(annoPtrs);
+        }
     }
 
     void operator()(Vcf::Entry const& a, HitsType const& b) {
@@ -155,11 +170,8 @@ public:
         }
 
         Vcf::Entry copyA(a);
-        if (_copyIdents) {
-            auto idents = best->identifiers();
-            for (auto id = idents.begin(); id != idents.end(); ++id)
-                copyA.addIdentifier(*id);
-        }
+        if (_copyIdents)
+            copyA.addIdentifiers(best->identifiers());
 
         for (auto i = _infoMap.begin(); i != _infoMap.end(); ++i) {
             Vcf::CustomValue const* inf = best->info(i->first);
@@ -176,6 +188,8 @@ protected:
     bool _copyIdents;
     InfoFieldMapping const& _infoMap;
     Vcf::Header const& _header;
+    PoolType* _pool;
+    HitsType _annos;
 };
 
 template<typename OutputType, typename ...Xs>
@@ -188,3 +202,15 @@ SimpleVcfAnnotator<OutputType> makeSimpleVcfAnnotator(
 {
     return SimpleVcfAnnotator<OutputType>(out, copyIdents, infoMap, header);
 }
+
+template<typename OutputType, typename PoolType>
+SimpleVcfAnnotator<OutputType, PoolType> makeSimpleVcfAnnotator(
+          OutputType& out
+        , bool copyIdents
+        , std::map<std::string, InfoTranslation> const& infoMap
+        , Vcf::Header const& header
+        , PoolType* pool
+        )
+{
+    return SimpleVcfAnnotator<OutputType, PoolType>(out, copyIdents, infoMap, header, pool);
+}
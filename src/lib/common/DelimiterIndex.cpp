@@ -0,0 +1,127 @@
+#include "DelimiterIndex.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define DELIMITER_INDEX_X86
+# include <immintrin.h>
+#endif
+
+namespace {
+    // Each scanner appends the offsets of delimiters in s[pos, size) to out,
+    // stopping after the block in which the maxTabs'th tab is seen (if
+    // maxTabs is nonzero). The vectorized versions only handle whole
+    // blocks and return the position they stopped at; scanScalar finishes
+    // the tail.
+    struct ScanState {
+        char const* s;
+        size_t size;
+        uint32_t maxTabs;
+        uint32_t tabs;
+        std::vector<DelimiterIndex::Offset>* out;
+
+        bool done() const {
+            return maxTabs != 0 && tabs >= maxTabs;
+        }
+
+        void appendMask(size_t base, uint32_t mask) {
+            while (mask) {
+                out->push_back(base + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+    };
+
+    size_t scanScalar(ScanState& st, size_t pos) {
+        for (; pos < st.size && !st.done(); ++pos) {
+            char c = st.s[pos];
+            if (DelimiterIndex::isDelimiter(c)) {
+                st.out->push_back(pos);
+                st.tabs += c == '\t';
+            }
+        }
+        return pos;
+    }
+
+#ifdef DELIMITER_INDEX_X86
+# ifdef __SSE2__
+    size_t scanSse2(ScanState& st, size_t pos) {
+        __m128i const tab = _mm_set1_epi8('\t');
+        __m128i const colon = _mm_set1_epi8(':');
+        __m128i const semi = _mm_set1_epi8(';');
+        __m128i const comma = _mm_set1_epi8(',');
+
+        for (; pos + 16 <= st.size && !st.done(); pos += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(st.s + pos));
+            __m128i tabs = _mm_cmpeq_epi8(block, tab);
+            __m128i any = _mm_or_si128(
+                _mm_or_si128(tabs, _mm_cmpeq_epi8(block, colon)),
+                _mm_or_si128(_mm_cmpeq_epi8(block, semi), _mm_cmpeq_epi8(block, comma)));
+
+            st.appendMask(pos, _mm_movemask_epi8(any));
+            st.tabs += __builtin_popcount(_mm_movemask_epi8(tabs));
+        }
+        return pos;
+    }
+# endif
+
+    __attribute__((target("avx2")))
+    size_t scanAvx2(ScanState& st, size_t pos) {
+        __m256i const tab = _mm256_set1_epi8('\t');
+        __m256i const colon = _mm256_set1_epi8(':');
+        __m256i const semi = _mm256_set1_epi8(';');
+        __m256i const comma = _mm256_set1_epi8(',');
+
+        for (; pos + 32 <= st.size && !st.done(); pos += 32) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(st.s + pos));
+            __m256i tabs = _mm256_cmpeq_epi8(block, tab);
+            __m256i any = _mm256_or_si256(
+                _mm256_or_si256(tabs, _mm256_cmpeq_epi8(block, colon)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, semi), _mm256_cmpeq_epi8(block, comma)));
+
+            st.appendMask(pos, uint32_t(_mm256_movemask_epi8(any)));
+            st.tabs += __builtin_popcount(uint32_t(_mm256_movemask_epi8(tabs)));
+        }
+        return pos;
+    }
+
+    bool haveAvx2() {
+        static bool const rv = __builtin_cpu_supports("avx2");
+        return rv;
+    }
+#endif
+}
+
+size_t const DelimiterIndex::npos;
+
+DelimiterIndex::DelimiterIndex()
+    : _beg(0)
+    , _size(0)
+    , _scannedEnd(0)
+{
+}
+
+DelimiterIndex::DelimiterIndex(std::string const& s, uint32_t maxTabs) {
+    index(s.data(), s.data() + s.size(), maxTabs);
+}
+
+DelimiterIndex::DelimiterIndex(char const* beg, char const* end, uint32_t maxTabs) {
+    index(beg, end, maxTabs);
+}
+
+void DelimiterIndex::index(char const* beg, char const* end, uint32_t maxTabs) {
+    _beg = beg;
+    _size = end - beg;
+    _offsets.clear();
+
+    ScanState st{beg, _size, maxTabs, 0, &_offsets};
+    size_t pos = 0;
+
+#ifdef DELIMITER_INDEX_X86
+    if (haveAvx2())
+        pos = scanAvx2(st, pos);
+# ifdef __SSE2__
+    pos = scanSse2(st, pos);
+# endif
+#endif
+
+    _scannedEnd = scanScalar(st, pos);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Records the position of every structural delimiter ('\t', ':', ';' and
+// ',') in a line of text in a single (vectorized where available) pass.
+//
+// A Tokenizer<char> built on an index looks delimiters up here instead of
+// searching for them, so a vcf line can be split into columns, sample
+// fields, and list values without rescanning the same bytes.
+//
+// Indexing can be told to stop early once a number of tabs have been seen
+// (e.g., to index only the fixed columns of a vcf line). Lookups past the
+// end of the scanned region report that nothing was found; see complete()
+// and scannedEnd().
+class DelimiterIndex {
+public:
+    typedef uint32_t Offset;
+    typedef std::vector<Offset>::size_type Cursor;
+
+    static size_t const npos = size_t(-1);
+
+    DelimiterIndex();
+    explicit DelimiterIndex(std::string const& s, uint32_t maxTabs = 0);
+    DelimiterIndex(char const* beg, char const* end, uint32_t maxTabs = 0);
+
+    // Discards any previous index (but keeps its storage) and indexes
+    // [beg, end). A maxTabs of 0 means scan everything.
+    void index(char const* beg, char const* end, uint32_t maxTabs = 0);
+
+    static bool isDelimiter(char c) {
+        return c == '\t' || c == ':' || c == ';' || c == ',';
+    }
+
+    char const* data() const { return _beg; }
+    size_t size() const { return _size; }
+    std::vector<Offset> const& offsets() const { return _offsets; }
+
+    // Offset one past the last byte examined
+    size_t scannedEnd() const { return _scannedEnd; }
+    bool complete() const { return _scannedEnd == _size; }
+
+    // Index of the first recorded delimiter at or after offset pos
+    Cursor lowerBound(size_t pos) const;
+
+    // Returns the offset of the first occurrence of delim at or after
+    // offset pos, or npos if there is none in the scanned region. cursor
+    // is a hint into offsets() (e.g., from lowerBound) that is moved
+    // forward past the result; it must not point beyond the first
+    // delimiter at or after pos.
+    size_t find(Cursor& cursor, size_t pos, char delim) const;
+
+private:
+    char const* _beg;
+    size_t _size;
+    size_t _scannedEnd;
+    std::vector<Offset> _offsets;
+};
+
+inline DelimiterIndex::Cursor DelimiterIndex::lowerBound(size_t pos) const {
+    return std::lower_bound(_offsets.begin(), _offsets.end(), pos) - _offsets.begin();
+}
+
+inline size_t DelimiterIndex::find(Cursor& cursor, size_t pos, char delim) const {
+    Cursor n = _offsets.size();
+    while (cursor < n && _offsets[cursor] < pos)
+        ++cursor;
+
+    while (cursor < n) {
+        Offset off = _offsets[cursor++];
+        if (_beg[off] == delim)
+            return off;
+    }
+    return npos;
+}
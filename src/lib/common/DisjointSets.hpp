@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Union-find over the integers [0, size()).
+//
+// Sets are joined with unite() and identified by the representative
+// find() returns for any of their members. Union by size and path halving
+// keep both operations effectively constant time, so grouping n items
+// related by m pairs is O(n + m) rather than needing the full n x n graph.
+//
+// reset() keeps the storage around so the same object can be reused for
+// many small problems without reallocating.
+class DisjointSets {
+public:
+    explicit DisjointSets(std::size_t n = 0) {
+        reset(n);
+    }
+
+    void reset(std::size_t n) {
+        parent_.resize(n);
+        size_.assign(n, 1);
+        for (std::size_t i = 0; i < n; ++i)
+            parent_[i] = i;
+    }
+
+    std::size_t size() const {
+        return parent_.size();
+    }
+
+    std::size_t find(std::size_t x) {
+        while (parent_[x] != x) {
+            parent_[x] = parent_[parent_[x]];
+            x = parent_[x];
+        }
+        return x;
+    }
+
+    // Returns false if x and y were already in the same set
+    bool unite(std::size_t x, std::size_t y) {
+        x = find(x);
+        y = find(y);
+        if (x == y)
+            return false;
+
+        if (size_[x] < size_[y])
+            std::swap(x, y);
+        parent_[y] = x;
+        size_[x] += size_[y];
+        return true;
+    }
+
+    // The number of members in the set containing x
+    std::size_t setSize(std::size_t x) {
+        return size_[find(x)];
+    }
+
+private:
+    std::vector<std::size_t> parent_;
+    std::vector<std::size_t> size_;
+};
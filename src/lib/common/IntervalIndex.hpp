@@ -0,0 +1,193 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// An in-memory index of values with chrom(), start() and stop() for
+// finding those near a region. Values are added with add(), then build()
+// sorts each chromosome's intervals by start and lays an implicit
+// interval tree over the sorted array: the node for element i at level k
+// has i's k lowest bits set, and every element records the largest stop
+// in its subtree. This is the layout of Heng Li's cgranges; it needs no
+// pointers and queries walk a contiguous array.
+//
+// Values may be added in any order. Results are given as the indices of
+// the values in the order they were added.
+template<typename ValueType>
+class IntervalIndex {
+public:
+    IntervalIndex()
+        : built_(false)
+    {}
+
+    void add(ValueType value) {
+        auto inserted = contigIds_.insert(std::make_pair(value.chrom(), contigs_.size()));
+        if (inserted.second)
+            contigs_.push_back(Contig());
+
+        Contig& contig = contigs_[inserted.first->second];
+        contig.items.push_back(Item{value.start(), value.stop(), value.stop(), values_.size()});
+        values_.push_back(std::move(value));
+        built_ = false;
+    }
+
+    // Must be called after adding values and before finding any
+    void build() {
+        for (auto i = contigs_.begin(); i != contigs_.end(); ++i)
+            buildContig(*i);
+        built_ = true;
+    }
+
+    bool built() const {
+        return built_;
+    }
+
+    std::size_t size() const {
+        return values_.size();
+    }
+
+    // The idx'th value added
+    ValueType const& value(std::size_t idx) const {
+        return values_[idx];
+    }
+
+    std::vector<ValueType> const& values() const {
+        return values_;
+    }
+
+    // Sets ids to the indices (in increasing order) of the values on chrom
+    // with start <= stop and stop >= start, i.e., those overlapping or
+    // touching [start, stop).
+    void findTouching(
+              std::string const& chrom
+            , int64_t start
+            , int64_t stop
+            , std::vector<std::size_t>& ids
+            ) const
+    {
+        ids.clear();
+        auto found = contigIds_.find(chrom);
+        if (found == contigIds_.end())
+            return;
+
+        Contig const& contig = contigs_[found->second];
+        // with half open intervals, x touches [start, stop) if it overlaps
+        // [start - 1, stop + 1)
+        overlapping(contig, start - 1, stop + 1, ids);
+        std::sort(ids.begin(), ids.end());
+    }
+
+private:
+    struct Item {
+        int64_t start;
+        int64_t stop;
+        // the largest stop in the subtree rooted here
+        int64_t maxStop;
+        std::size_t id;
+
+        bool operator<(Item const& rhs) const {
+            return start < rhs.start;
+        }
+    };
+
+    struct Contig {
+        Contig() : maxLevel(-1) {}
+
+        std::vector<Item> items;
+        int maxLevel;
+    };
+
+    // A node to visit: its level, index, and whether its left subtree has
+    // been dealt with
+    struct Visit {
+        int level;
+        std::size_t idx;
+        bool leftDone;
+    };
+
+    static void buildContig(Contig& contig) {
+        std::vector<Item>& a = contig.items;
+        std::size_t n = a.size();
+        std::stable_sort(a.begin(), a.end());
+        contig.maxLevel = -1;
+        if (n == 0)
+            return;
+
+        // leaves are at even indices; last tracks the largest stop of the
+        // rightmost (possibly incomplete) subtree at each level
+        std::size_t lastIdx = 0;
+        int64_t last = 0;
+        for (std::size_t i = 0; i < n; i += 2) {
+            lastIdx = i;
+            last = a[i].maxStop = a[i].stop;
+        }
+
+        int k = 1;
+        for (; (std::size_t(1) << k) <= n; ++k) {
+            std::size_t x = std::size_t(1) << (k - 1);
+            std::size_t first = (x << 1) - 1;
+            std::size_t step = x << 2;
+            for (std::size_t i = first; i < n; i += step) {
+                int64_t left = a[i - x].maxStop;
+                int64_t right = i + x < n ? a[i + x].maxStop : last;
+                a[i].maxStop = std::max(a[i].stop, std::max(left, right));
+            }
+            lastIdx = (lastIdx >> k & 1) ? lastIdx - x : lastIdx + x;
+            if (lastIdx < n && a[lastIdx].maxStop > last)
+                last = a[lastIdx].maxStop;
+        }
+        contig.maxLevel = k - 1;
+    }
+
+    // Appends the ids of the items overlapping [start, stop)
+    static void overlapping(
+              Contig const& contig
+            , int64_t start
+            , int64_t stop
+            , std::vector<std::size_t>& ids
+            )
+    {
+        std::vector<Item> const& a = contig.items;
+        std::size_t n = a.size();
+        if (contig.maxLevel < 0)
+            return;
+
+        Visit stack[64];
+        int top = 0;
+        stack[top++] = Visit{contig.maxLevel, (std::size_t(1) << contig.maxLevel) - 1, false};
+        while (top) {
+            Visit v = stack[--top];
+            if (v.level <= 3) {
+                // small subtrees are cheaper to scan
+                std::size_t first = v.idx >> v.level << v.level;
+                std::size_t end = std::min(n, first + (std::size_t(2) << v.level) - 1);
+                for (std::size_t i = first; i < end && a[i].start < stop; ++i) {
+                    if (start < a[i].stop)
+                        ids.push_back(a[i].id);
+                }
+            } else if (!v.leftDone) {
+                std::size_t left = v.idx - (std::size_t(1) << (v.level - 1));
+                stack[top++] = Visit{v.level, v.idx, true};
+                if (left >= n || a[left].maxStop > start)
+                    stack[top++] = Visit{v.level - 1, left, false};
+            } else if (v.idx < n && a[v.idx].start < stop) {
+                if (start < a[v.idx].stop)
+                    ids.push_back(a[v.idx].id);
+                stack[top++] = Visit{v.level - 1, v.idx + (std::size_t(1) << (v.level - 1)), false};
+            }
+        }
+    }
+
+private:
+    std::vector<ValueType> values_;
+    boost::unordered_map<std::string, std::size_t> contigIds_;
+    std::vector<Contig> contigs_;
+    bool built_;
+};
@@ -58,6 +58,12 @@ double MutationSpectrum::transitionTransversionRatio() const {
     return ts/double(tv);
 }
 
+MutationSpectrum& MutationSpectrum::operator+=(MutationSpectrum const& rhs) {
+    for (std::size_t i = 0; i < _mtx.size(); ++i)
+        _mtx[i] += rhs._mtx[i];
+    return *this;
+}
+
 int MutationSpectrum::index(uint8_t from, uint8_t to) const {
     int fromIdx = _indexTable[int(from)];
     int toIdx = _indexTable[int(to)];
@@ -21,6 +21,9 @@ public:
     // returns numeric_limits<double>::infinity if transversions=0
     double transitionTransversionRatio() const;
 
+    // Adds in the counts from another spectrum
+    MutationSpectrum& operator+=(MutationSpectrum const& rhs);
+
 protected:
     int index(uint8_t from, uint8_t to) const;
 
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common/compat.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A free list of heap allocated objects handed out as unique_ptrs.
+//
+// Objects given back with release() keep whatever memory they own (string
+// and vector capacities, etc.) and are handed out again by acquire() in
+// preference to allocating new ones. A pipeline that parses records into
+// pooled objects and releases them once they have been written does almost
+// no allocation in the steady state, provided parsing reuses the storage
+// already present in the record (e.g., via std::string::assign).
+//
+// At most maxSize objects are kept; any more released than that are simply
+// destroyed.
+template<typename T>
+class ObjectPool : public boost::noncopyable {
+public:
+    typedef std::unique_ptr<T> Ptr;
+
+    explicit ObjectPool(std::size_t maxSize = 4096)
+        : maxSize_(maxSize)
+        , allocated_(0)
+    {}
+
+    Ptr acquire() {
+        if (free_.empty()) {
+            ++allocated_;
+            return std::make_unique<T>();
+        }
+
+        Ptr rv(std::move(free_.back()));
+        free_.pop_back();
+        return rv;
+    }
+
+    void release(Ptr p) {
+        if (p && free_.size() < maxSize_)
+            free_.push_back(std::move(p));
+    }
+
+    // Releases every object in ptrs, leaving it empty.
+    void release(std::vector<Ptr>& ptrs) {
+        for (auto i = ptrs.begin(); i != ptrs.end(); ++i)
+            release(std::move(*i));
+        ptrs.clear();
+    }
+
+    // The number of objects waiting to be reused
+    std::size_t size() const {
+        return free_.size();
+    }
+
+    // The number of objects acquire() has had to allocate
+    std::size_t allocated() const {
+        return allocated_;
+    }
+
+private:
+    std::size_t maxSize_;
+    std::size_t allocated_;
+    std::vector<Ptr> free_;
+};
+
+// Stands in for an ObjectPool in processors that can optionally recycle
+// what they consume.
+struct NoObjectPool {
+    template<typename Ptr>
+    void release(Ptr&&) {}
+};
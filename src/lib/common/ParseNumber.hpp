@@ -0,0 +1,315 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+
+#include <cfloat>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Parsers for the integer and floating point fields of text formats.
+//
+// Both accept exactly the syntax of the boost::spirit any_int_parser and
+// any_real_parser they replace in Tokenizer, and like Tokenizer::extract
+// they only succeed if the whole of [beg, end) is consumed:
+//
+//   integers: [+-]?[0-9]+, failing on overflow. Negative values parsed
+//             into unsigned types wrap around, as they do in spirit.
+//   reals:    [+-]?([0-9]+\.?[0-9]*|\.[0-9]+)([eE][+-]?[0-9]+)?, or
+//             [+-]?(nan(\(...\))?|inf(inity)?) in any case.
+//
+// Digits are consumed eight at a time where possible (SWAR). Floating point
+// values are correctly rounded: values with few enough digits and a small
+// exponent are computed exactly in floating point, the rest go through the
+// Eisel-Lemire algorithm (see ParseNumber.cpp).
+namespace detail {
+    inline bool isDigit(char c) {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+# define PARSE_NUMBER_SWAR
+    inline uint64_t loadEightBytes(char const* p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline bool isEightDigits(uint64_t v) {
+        return ((v & 0xF0F0F0F0F0F0F0F0ULL)
+            | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL;
+    }
+
+    // Value of the eight ascii digits in v, most significant in the lowest
+    // byte.
+    inline uint32_t parseEightDigits(uint64_t v) {
+        uint64_t const mask = 0x000000FF000000FFULL;
+        uint64_t const mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+        uint64_t const mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+        v -= 0x3030303030303030ULL;
+        v = (v * 10) + (v >> 8);
+        v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+        return uint32_t(v);
+    }
+#endif
+
+    // Accumulates the run of digits starting at p into acc (wrapping on
+    // overflow; callers bound the number of digits) and returns the end of
+    // the run.
+    inline char const* accumulateDigits(char const* p, char const* end, uint64_t& acc) {
+#ifdef PARSE_NUMBER_SWAR
+        while (end - p >= 8) {
+            uint64_t v = loadEightBytes(p);
+            if (!isEightDigits(v))
+                break;
+            acc = acc * 100000000 + parseEightDigits(v);
+            p += 8;
+        }
+#endif
+        for (; p != end && isDigit(*p); ++p)
+            acc = acc * 10 + (*p - '0');
+        return p;
+    }
+
+    template<typename T>
+    inline bool parseInteger(char const* p, char const* end, T& value) {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "integer type too wide");
+        if (p == end)
+            return false;
+
+        bool neg = false;
+        if (*p == '-' || *p == '+') {
+            neg = *p == '-';
+            ++p;
+        }
+
+        char const* digits = p;
+        while (p != end && *p == '0')
+            ++p;
+        bool sawZero = p != digits;
+
+        // 19 digits always fit in 64 bits, a 20th needs checking
+        char const* sigBeg = p;
+        uint64_t acc = 0;
+        char const* sigEnd = accumulateDigits(p, end - p > 19 ? p + 19 : end, acc);
+        if (sigEnd == sigBeg && !sawZero)
+            return false;
+
+        if (sigEnd != end) {
+            if (sigEnd - sigBeg != 19 || !isDigit(*sigEnd) || sigEnd + 1 != end)
+                return false;
+            uint64_t d = *sigEnd - '0';
+            if (acc > (std::numeric_limits<uint64_t>::max() - d) / 10)
+                return false;
+            acc = acc * 10 + d;
+        }
+
+        typedef typename std::make_unsigned<T>::type U;
+        uint64_t limit = uint64_t(std::numeric_limits<T>::max());
+        if (neg) {
+            // down to min() for signed types. like spirit, unsigned types
+            // take -x (for x <= max()) to wrap around to max() + 1 - x.
+            if (std::is_signed<T>::value)
+                ++limit;
+            if (acc > limit)
+                return false;
+            value = T(U(0) - U(acc));
+        }
+        else {
+            if (acc > limit)
+                return false;
+            value = T(acc);
+        }
+        return true;
+    }
+
+    template<typename T>
+    struct FloatTraits;
+
+    template<>
+    struct FloatTraits<float> {
+        static uint64_t maxExactMantissa() { return uint64_t(1) << 24; }
+        static int maxExactPower() { return 10; }
+        static float exactPower(int q) {
+            static float const powers[] = {
+                1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+            };
+            return powers[q];
+        }
+    };
+
+    template<>
+    struct FloatTraits<double> {
+        static uint64_t maxExactMantissa() { return uint64_t(1) << 53; }
+        static int maxExactPower() { return 22; }
+        static double exactPower(int q) {
+            static double const powers[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            return powers[q];
+        }
+    };
+
+    // Every double is a long double, so the double limits are safe (if
+    // conservative) here.
+    template<>
+    struct FloatTraits<long double> {
+        static uint64_t maxExactMantissa() { return FloatTraits<double>::maxExactMantissa(); }
+        static int maxExactPower() { return FloatTraits<double>::maxExactPower(); }
+        static long double exactPower(int q) { return FloatTraits<double>::exactPower(q); }
+    };
+
+    // Correctly rounded (-1)^neg * w * 10^q for the cases the exact fast
+    // path can't handle. Defined in ParseNumber.cpp for float, double and
+    // long double; [beg, end) is the text w and q came from.
+    template<typename T>
+    T decimalToBinary(uint64_t w, int64_t q, bool neg, char const* beg, char const* end);
+
+    // Correctly rounded value of the validated number in [beg, end), used
+    // when it has too many significant digits to fit in 64 bits.
+    template<typename T>
+    T parseLongDecimal(char const* beg, char const* end);
+
+    template<> float decimalToBinary<float>(uint64_t, int64_t, bool, char const*, char const*);
+    template<> double decimalToBinary<double>(uint64_t, int64_t, bool, char const*, char const*);
+    template<> long double decimalToBinary<long double>(uint64_t, int64_t, bool, char const*, char const*);
+    template<> float parseLongDecimal<float>(char const*, char const*);
+    template<> double parseLongDecimal<double>(char const*, char const*);
+    template<> long double parseLongDecimal<long double>(char const*, char const*);
+
+    inline bool matchNoCase(char const*& p, char const* end, char const* lower) {
+        char const* q = p;
+        for (; *lower; ++lower, ++q) {
+            if (q == end || (*q | 0x20) != *lower)
+                return false;
+        }
+        p = q;
+        return true;
+    }
+
+    template<typename T>
+    inline bool parseNanInf(char const* p, char const* end, bool neg, T& value) {
+        T v;
+        if (matchNoCase(p, end, "nan")) {
+            if (p != end && *p == '(') {
+                while (++p != end && *p != ')')
+                    ;
+                if (p == end)
+                    return false;
+                ++p;
+            }
+            v = std::numeric_limits<T>::quiet_NaN();
+        }
+        else if (matchNoCase(p, end, "inf")) {
+            matchNoCase(p, end, "inity");
+            v = std::numeric_limits<T>::infinity();
+        }
+        else {
+            return false;
+        }
+
+        if (p != end)
+            return false;
+        value = neg ? -v : v;
+        return true;
+    }
+
+    template<typename T>
+    inline bool parseFloat(char const* p, char const* end, T& value) {
+        if (p == end)
+            return false;
+
+        char const* beg = p;
+        bool neg = false;
+        if (*p == '-' || *p == '+') {
+            neg = *p == '-';
+            ++p;
+        }
+
+        uint64_t w = 0;
+        char const* intBeg = p;
+        p = accumulateDigits(p, end, w);
+        char const* intEnd = p;
+        if (intBeg == intEnd && (p == end || *p != '.'))
+            return parseNanInf(p, end, neg, value);
+
+        char const* fracBeg = p;
+        char const* fracEnd = p;
+        if (p != end && *p == '.') {
+            fracBeg = ++p;
+            p = fracEnd = accumulateDigits(p, end, w);
+            if (intBeg == intEnd && fracBeg == fracEnd)
+                return false;
+        }
+        int64_t q = -int64_t(fracEnd - fracBeg);
+
+        size_t digits = (intEnd - intBeg) + (fracEnd - fracBeg);
+        bool tooLong = false;
+        if (digits > 19) {
+            // leading zeros don't count towards the 19 that fit in w
+            char const* s = intBeg;
+            while (s != intEnd && *s == '0')
+                ++s;
+            if (s == intEnd) {
+                s = fracBeg;
+                while (s != fracEnd && *s == '0')
+                    ++s;
+            }
+            tooLong = s < intEnd
+                ? digits - (s - intBeg) > 19
+                : size_t(fracEnd - s) > 19;
+        }
+
+        if (p != end) {
+            if (*p == 'e' || *p == 'E') {
+                int e;
+                if (!parseInteger(p + 1, end, e))
+                    return false;
+                q += e;
+            }
+            else if (fracBeg == fracEnd && w == 1 && !tooLong) {
+                // spirit also accepts the "1.#INF"-style spellings, e.g.
+                // "1inf" and "1.nan"
+                return parseNanInf(p, end, neg, value);
+            }
+            else {
+                return false;
+            }
+        }
+
+        if (tooLong) {
+            value = parseLongDecimal<T>(beg, end);
+            return true;
+        }
+
+#if FLT_EVAL_METHOD == 0
+        typedef FloatTraits<T> Traits;
+        if (w <= Traits::maxExactMantissa()
+            && q >= -Traits::maxExactPower() && q <= Traits::maxExactPower())
+        {
+            T v = T(w);
+            if (q < 0)
+                v /= Traits::exactPower(-q);
+            else
+                v *= Traits::exactPower(q);
+            value = neg ? -v : v;
+            return true;
+        }
+#endif
+
+        value = decimalToBinary<T>(w, q, neg, beg, end);
+        return true;
+    }
+}
+
+template<typename T>
+inline bool parseInteger(char const* beg, char const* end, T& value) {
+    return detail::parseInteger(beg, end, value);
+}
+
+template<typename T>
+inline bool parseFloat(char const* beg, char const* end, T& value) {
+    return detail::parseFloat(beg, end, value);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+
+// A value that is built the first time it is asked for and kept until
+// reset(), for caching something derived from an object that may be read
+// from several threads at once. If two threads build it at the same time,
+// the first one to finish publishes its copy and both use that one, so the
+// reference get() returns stays valid until the next reset().
+//
+// Copies share the cached value. reset() is meant to be called when the
+// object the value is derived from changes, and like that change must not
+// race with get().
+template<typename T>
+class SharedCache {
+public:
+    SharedCache() {}
+
+    SharedCache(SharedCache const& rhs)
+        : _value(std::atomic_load(&rhs._value))
+    {}
+
+    SharedCache& operator=(SharedCache const& rhs) {
+        std::atomic_store(&_value, std::atomic_load(&rhs._value));
+        return *this;
+    }
+
+    // build() is called to make the value when there is none
+    template<typename Func>
+    T const& get(Func build) const {
+        std::shared_ptr<T const> value = std::atomic_load(&_value);
+        if (!value) {
+            std::shared_ptr<T const> built = std::make_shared<T>(build());
+            if (std::atomic_compare_exchange_strong(&_value, &value, built))
+                value = built;
+        }
+        return *value;
+    }
+
+    void reset() {
+        std::atomic_store(&_value, std::shared_ptr<T const>());
+    }
+
+private:
+    mutable std::shared_ptr<T const> _value;
+};
@@ -1,13 +1,14 @@
 #pragma once
 
+#include "DelimiterIndex.hpp"
+#include "ParseNumber.hpp"
 #include "StringView.hpp"
 #include "common/cstdint.hpp"
 
 #include <boost/format.hpp>
-#include <boost/spirit/home/qi/numeric.hpp>
-#include <boost/spirit/home/qi/parse.hpp>
 
 #include <algorithm>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <stdexcept>
@@ -44,13 +45,8 @@ namespace detail {
         , typename std::enable_if<std::is_integral<T>::value>::type
         >
     {
-        template<typename Iter>
-        bool operator()(Iter beg, Iter end, T& attr) {
-            boost::spirit::qi::any_int_parser<T> parser;
-            if (boost::spirit::qi::parse(beg, end, parser, attr)) {
-                return beg == end;
-            }
-            return false;
+        bool operator()(char const* beg, char const* end, T& attr) {
+            return parseInteger(beg, end, attr);
         }
     };
 
@@ -60,13 +56,8 @@ namespace detail {
         , typename std::enable_if<std::is_floating_point<T>::value>::type
         >
     {
-        template<typename Iter>
-        bool operator()(Iter beg, Iter end, T& attr) {
-            boost::spirit::qi::any_real_parser<T> parser;
-            if (boost::spirit::qi::parse(beg, end, parser, attr)) {
-                return beg == end;
-            }
-            return false;
+        bool operator()(char const* beg, char const* end, T& attr) {
+            return parseFloat(beg, end, attr);
         }
     };
 
@@ -118,6 +109,9 @@ public:
         , _end(0)
         , _eofCalls(0) // to support the last field being empty, see eof()
         , _lastDelim(0)
+        , _index(0)
+        , _indexBase(0)
+        , _indexStart(0)
     {
         rewind();
     }
@@ -131,6 +125,9 @@ public:
         , _end(0)
         , _eofCalls(0) // to support the last field being empty, see eof()
         , _lastDelim(0)
+        , _index(0)
+        , _indexBase(0)
+        , _indexStart(0)
     {
         rewind();
     }
@@ -144,6 +141,45 @@ public:
         , _end(0)
         , _eofCalls(0) // to support the last field being empty, see eof()
         , _lastDelim(0)
+        , _index(0)
+        , _indexBase(0)
+        , _indexStart(0)
+    {
+        rewind();
+    }
+
+    // Tokenize [sbeg, send), which must lie within the region covered by
+    // index. Delimiters are looked up in the index rather than searched
+    // for, falling back to searching only past the end of the scanned
+    // region. Only Tokenizer<char> makes use of the index.
+    Tokenizer(DelimiterIndex const& index, char const* sbeg, char const* send, DelimType const& delim = '\t')
+        : _sbeg(sbeg)
+        , _send(send)
+        , _totalLen(send-sbeg)
+        , _delim(delim)
+        , _pos(0)
+        , _end(0)
+        , _eofCalls(0) // to support the last field being empty, see eof()
+        , _lastDelim(0)
+        , _index(&index)
+        , _indexBase(sbeg - index.data())
+        , _indexStart(index.lowerBound(_indexBase))
+    {
+        rewind();
+    }
+
+    Tokenizer(DelimiterIndex const& index, DelimType const& delim = '\t')
+        : _sbeg(index.data())
+        , _send(index.data() + index.size())
+        , _totalLen(index.size())
+        , _delim(delim)
+        , _pos(0)
+        , _end(0)
+        , _eofCalls(0) // to support the last field being empty, see eof()
+        , _lastDelim(0)
+        , _index(&index)
+        , _indexBase(0)
+        , _indexStart(0)
     {
         rewind();
     }
@@ -175,6 +211,23 @@ public:
             *v++ = std::move(tmp);
     }
 
+    template<typename IterType>
+    static void split(
+        DelimiterIndex const& index,
+        char const* beg,
+        char const* end,
+        DelimType const& delim,
+        IterType v
+        )
+    {
+        Tokenizer<DelimType> t(index, beg, end, delim);
+        typedef typename detail::IteratorValue<IterType>::value_type ValueType;
+        ValueType tmp;
+
+        while (t.extract(tmp))
+            *v++ = std::move(tmp);
+    }
+
     template<typename IterType>
     static void split(
         StringView const& s,
@@ -232,6 +285,11 @@ protected:
     std::string::size_type _end;
     uint32_t _eofCalls;
     char _lastDelim;
+
+    DelimiterIndex const* _index;
+    std::string::size_type _indexBase;
+    DelimiterIndex::Cursor _indexStart;
+    DelimiterIndex::Cursor _indexCursor;
 };
 
 template<typename DelimType>
@@ -279,6 +337,7 @@ inline bool Tokenizer<DelimType>::advance() {
 template<typename DelimType>
 inline void Tokenizer<DelimType>::rewind() {
     _pos = 0;
+    _indexCursor = _indexStart;
     _end = std::min(_totalLen, nextDelim());
     _eofCalls = 0;
 }
@@ -327,8 +386,22 @@ inline bool Tokenizer<std::string>::eof() const {
 template<>
 inline size_t Tokenizer<char>::nextDelim() {
     if (_totalLen == 0) return 0;
+    size_t from = _pos;
+    if (_index) {
+        assert(DelimiterIndex::isDelimiter(_delim));
+        size_t found = _index->find(_indexCursor, _indexBase + _pos, _delim);
+        if (found != DelimiterIndex::npos)
+            return found - _indexBase;
+
+        if (_index->complete() || _indexBase + _totalLen <= _index->scannedEnd())
+            return std::string::npos;
+
+        // the index stopped short of us, search the rest the old way
+        from = std::max(from, _index->scannedEnd() - _indexBase);
+    }
+
     char const* rv(0);
-    rv = strchr(_sbeg+_pos, _delim);
+    rv = strchr(_sbeg+from, _delim);
     return rv == 0 ? std::string::npos : rv-_sbeg;
 }
 
@@ -0,0 +1,59 @@
+#include "AlleleKey.hpp"
+
+#include "common/Iub.hpp"
+#include "common/Tokenizer.hpp"
+#include "fileformats/Bed.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+using namespace std;
+
+namespace {
+    void assignAllele(string& allele, char const* beg, char const* end) {
+        size_t len = end - beg;
+        if (len == 1 && (*beg == '0' || *beg == '-')) {
+            allele = "*";
+        } else {
+            allele.assign(beg, len);
+            boost::to_upper(allele);
+        }
+    }
+}
+
+AlleleKey::AlleleKey()
+    : _start(0)
+    , _stop(0)
+    , _reference("*")
+    , _variant("*")
+    , _variantIub(0)
+{
+}
+
+AlleleKey::AlleleKey(Bed const& bed) {
+    assign(bed);
+}
+
+void AlleleKey::assign(Bed const& bed) {
+    _chrom = bed.chrom();
+    _start = bed.start();
+    _stop = bed.stop();
+
+    // missing alleles are "*", as with Variant
+    int n = 0;
+    if (!bed.extraFields().empty()) {
+        Tokenizer<char> tokenizer(bed.extraFields()[0], '/');
+        char const* beg;
+        char const* end;
+        for (; n < 2 && !tokenizer.eof(); ++n) {
+            tokenizer.extract(&beg, &end);
+            assignAllele(n == 0 ? _reference : _variant, beg, end);
+        }
+    }
+    if (n < 1)
+        _reference = "*";
+    if (n < 2)
+        _variant = "*";
+
+    // Variant::allelePartialMatch looks at the first base only
+    _variantIub = alleles2bin(translateIub(_variant[0]));
+}
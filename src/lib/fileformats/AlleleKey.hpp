@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+
+#include <string>
+
+class Bed;
+
+// The position and first two alleles of a bed entry, parsed as Variant
+// would parse them, for matching bed entries against each other without
+// building Variants. Alleles are kept upper cased with "0" and "-" read as
+// "*", and the variant allele's IUB code is kept as the 4 bit mask of
+// alleles2bin, so allele matching is string and mask comparison.
+//
+// assign() reuses the key's storage, so a key can be refilled for each
+// entry without allocating.
+class AlleleKey {
+public:
+    AlleleKey();
+    explicit AlleleKey(Bed const& bed);
+
+    void assign(Bed const& bed);
+
+    std::string const& chrom() const {
+        return _chrom;
+    }
+
+    int64_t start() const {
+        return _start;
+    }
+
+    int64_t stop() const {
+        return _stop;
+    }
+
+    std::string const& reference() const {
+        return _reference;
+    }
+
+    std::string const& variant() const {
+        return _variant;
+    }
+
+    unsigned variantIub() const {
+        return _variantIub;
+    }
+
+    // Same as Variant::positionMatch
+    bool positionMatch(AlleleKey const& rhs) const {
+        return _start == rhs._start
+            && _stop == rhs._stop
+            && _chrom == rhs._chrom;
+    }
+
+    // Same as Variant::alleleMatch
+    bool alleleMatch(AlleleKey const& rhs) const {
+        return _reference == rhs._reference
+            && _variant == rhs._variant;
+    }
+
+    // Same as Variant::allelePartialMatch
+    bool allelePartialMatch(AlleleKey const& rhs) const {
+        return (_variantIub & rhs._variantIub) != 0u
+            && _reference == rhs._reference;
+    }
+
+private:
+    std::string _chrom;
+    int64_t _start;
+    int64_t _stop;
+    std::string _reference;
+    std::string _variant;
+    unsigned _variantIub;
+};
@@ -72,7 +72,15 @@ Bed::Bed(const std::string& chrom, int64_t start, int64_t stop, const ExtraField
 
 
 void Bed::parseLine(const BedHeader*, std::string& line, Bed& bed, int maxExtraFields) {
-    Tokenizer<char> tokenizer(line);
+    // Index chrom, start, stop, and any extra fields we are going to keep.
+    // When every field is kept, only tabs matter, so search for those
+    // directly rather than indexing every delimiter in the line.
+    thread_local DelimiterIndex delims;
+    if (maxExtraFields != -1)
+        delims.index(line.data(), line.data() + line.size(), 3 + maxExtraFields);
+    Tokenizer<char> tokenizer = maxExtraFields == -1
+        ? Tokenizer<char>(line)
+        : Tokenizer<char>(delims);
     if (!tokenizer.extract(bed._chrom))
         throw runtime_error(str(format("Failed to extract chromosome from bed line '%1%'") %line));
 
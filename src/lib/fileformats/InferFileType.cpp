@@ -4,6 +4,7 @@
 #include "ChromPos.hpp"
 #include "io/InputStream.hpp"
 #include "TypedStream.hpp"
+#include "vcf/Bcf2.hpp"
 #include "vcf/Entry.hpp"
 #include "vcf/Header.hpp"
 
@@ -52,6 +53,28 @@ namespace {
         return rv;
     }
 
+    // Records from a BCF2 file are marked as such, there is no need to
+    // try parsing them as anything else
+    bool testBcf2(InputStream& in) {
+        bool rv(false);
+        try {
+            in.caching(true);
+            string line;
+            while (!in.eof() && in.good() && in.getline(line)) {
+                if (!line.empty() && line[0] != '#') {
+                    rv = Vcf::Bcf2::isRecord(line);
+                    break;
+                }
+            }
+        } catch (...) {
+            rv = false;
+        }
+
+        in.caching(false);
+        in.rewind();
+        return rv;
+    }
+
     bool testVcf(InputStream& in) {
         bool rv(true);
         try {
@@ -72,7 +95,9 @@ namespace {
 FileType inferFileType(InputStream& in) {
     FileType rv(UNKNOWN);
 
-    if (testReader<Bed>(in)) {
+    if (testBcf2(in)) {
+        rv = VCF;
+    } else if (testReader<Bed>(in)) {
         rv = BED;
     } else if (testVcf(in)) {
         rv = VCF;
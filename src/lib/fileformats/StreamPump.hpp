@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/ObjectPool.hpp"
 #include "common/compat.hpp"
 
 #include <memory>
@@ -34,31 +35,51 @@ makeStreamPump(StreamType& s, OutputFunc& out) {
 }
 
 
+// Reads entries into heap allocated objects and passes them on as
+// unique_ptrs. If a pool is given, the objects come from it; consumers that
+// release them back to the same pool once they are done let later entries
+// be parsed into already allocated storage.
 template<typename StreamType, typename OutputFunc>
 struct PointerStreamPump {
     typedef typename StreamType::ValueType ValueType;
+    typedef ObjectPool<ValueType> PoolType;
 
-    PointerStreamPump(StreamType& s, OutputFunc& out)
+    PointerStreamPump(StreamType& s, OutputFunc& out, PoolType* pool = 0)
         : stream_(s)
         , out_(out)
+        , pool_(pool)
     {
     }
 
     void execute() {
-        auto entry = std::make_unique<ValueType>();
+        auto entry = acquire();
         while (stream_.next(*entry)) {
             out_(std::move(entry));
-            entry = std::make_unique<ValueType>();
+            entry = acquire();
         }
+        if (pool_)
+            pool_->release(std::move(entry));
         out_.flush();
     }
 
+    std::unique_ptr<ValueType> acquire() {
+        if (pool_)
+            return pool_->acquire();
+        return std::make_unique<ValueType>();
+    }
+
     StreamType& stream_;
     OutputFunc& out_;
+    PoolType* pool_;
 };
 
 template<typename StreamType, typename OutputFunc>
 PointerStreamPump<StreamType, OutputFunc>
-makePointerStreamPump(StreamType& s, OutputFunc& out) {
-    return PointerStreamPump<StreamType, OutputFunc>(s, out);
+makePointerStreamPump(
+          StreamType& s
+        , OutputFunc& out
+        , ObjectPool<typename StreamType::ValueType>* pool = 0
+        )
+{
+    return PointerStreamPump<StreamType, OutputFunc>(s, out, pool);
 }
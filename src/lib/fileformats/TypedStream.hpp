@@ -31,6 +31,7 @@ void setSourceIndex(StreamType& stream, size_t idx) {
 template<typename Parser>
 class TypedStream {
 public:
+    typedef Parser ParserType;
     typedef typename Parser::ValueType ValueType;
     typedef typename ValueType::HeaderType HeaderType;
     typedef std::unique_ptr<TypedStream<Parser>> ptr;
@@ -73,8 +74,17 @@ public:
         return parser_;
     }
 
+    // For callers that parse on their own (e.g., on other threads): reads
+    // the next data line and its line number, returning false at eof. Must
+    // not be mixed with peek().
+    bool nextLine(std::string& line, uint64_t& lineNum);
+
+    // Parses a line returned by nextLine with the given parser (a copy of
+    // parser(), say). Errors are reported as they are by next().
+    void parseLine(Parser& parser, std::string& line, uint64_t lineNum, ValueType& value) const;
+
 protected:
-    std::string nextLine();
+    void nextLine(std::string& line);
 
 protected:
     HeaderType header_;
@@ -88,6 +98,9 @@ protected:
     bool cached_;
     bool cachedRv_;
     ValueType cachedValue_;
+
+    // reused from line to line to keep its capacity
+    std::string line_;
 };
 
 template<typename Parser>
@@ -134,30 +147,55 @@ inline bool TypedStream<Parser>::next(ValueType& value) {
         return cachedRv_;
     }
 
-    std::string line = nextLine();
+    nextLine(line_);
+    if (line_.empty())
+        return false;
+
+    parseLine(parser_, line_, in_.lineNum(), value);
+    ++valueCount_;
+    return true;
+}
+
+template<typename Parser>
+inline bool TypedStream<Parser>::nextLine(std::string& line, uint64_t& lineNum) {
+    if (cached_)
+        throw std::logic_error("TypedStream::nextLine called after peek on " + name());
+
+    nextLine(line);
     if (line.empty())
         return false;
 
+    lineNum = in_.lineNum();
+    ++valueCount_;
+    return true;
+}
+
+template<typename Parser>
+inline void TypedStream<Parser>::parseLine(
+        Parser& parser,
+        std::string& line,
+        uint64_t lineNum,
+        ValueType& value
+        ) const
+{
     try {
-        parser_(&header_, line, value);
+        parser(&header_, line, value);
     }
     catch (std::exception const& e) {
         using boost::format;
         throw std::runtime_error(
             str(format("Error at %1%:%2%: %3%"
-                ) % name() % in_.lineNum() % e.what()));
+                ) % name() % lineNum % e.what()));
     }
-    ++valueCount_;
-    return true;
 }
 
 template<typename Parser>
-inline std::string TypedStream<Parser>::nextLine() {
-    std::string line;
+inline void TypedStream<Parser>::nextLine(std::string& line) {
     do {
+        // getline leaves line alone at eof
+        line.clear();
         in_.getline(line);
     } while (!eof() && (line.empty() || line[0] == '#'));
-    return line;
 }
 
 template<typename Parser>
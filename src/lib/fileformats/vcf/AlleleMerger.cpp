@@ -1,17 +1,30 @@
 #include "AlleleMerger.hpp"
 
-#include <boost/algorithm/cxx11/all_of.hpp>
-#include <boost/bind.hpp>
-
 #include "Entry.hpp"
 #include "RawVariant.hpp"
 
+#include <algorithm>
+#include <cassert>
+
 using namespace std;
-namespace ba = boost::algorithm;
 
 BEGIN_NAMESPACE(Vcf)
 
-AlleleMerger::AlleleMerger(Entry const* beg, Entry const* end)
+namespace {
+    std::vector<Entry const*> entryPointers(std::vector<Entry> const& ents) {
+        std::vector<Entry const*> rv;
+        rv.reserve(ents.size());
+        for (auto i = ents.begin(); i != ents.end(); ++i)
+            rv.push_back(&*i);
+        return rv;
+    }
+
+    bool posLess(Entry const* a, Entry const* b) {
+        return Entry::posLess(*a, *b);
+    }
+}
+
+AlleleMerger::AlleleMerger(Entry const* const* beg, Entry const* const* end)
     : _alleleIdx(0)
     , _merged(false)
 {
@@ -22,13 +35,18 @@ AlleleMerger::AlleleMerger(std::vector<Entry> const& ents)
     : _alleleIdx(0)
     , _merged(false)
 {
-    init(&*ents.begin(), &*ents.end());
+    auto ptrs = entryPointers(ents);
+    init(ptrs.data(), ptrs.data() + ptrs.size());
 }
 
-void AlleleMerger::init(Entry const* beg, Entry const* end) {
+void AlleleMerger::init(Entry const* const* beg, Entry const* const* end) {
     // make sure range is non-trivial and all on the same chromosome
-    if (end-beg < 2 || !ba::all_of(beg, end, boost::bind(&Entry::chromEq, beg->chrom(), _1))) {
+    if (end-beg < 2)
         return;
+
+    for (auto e = beg + 1; e != end; ++e) {
+        if (!Entry::chromEq((*beg)->chrom(), **e))
+            return;
     }
 
     _ref = buildRef(beg, end);
@@ -38,11 +56,9 @@ void AlleleMerger::init(Entry const* beg, Entry const* end) {
     _merged = true;
     _newAltIndices.resize(end-beg);
 
-    int64_t start = min_element(beg, end, &Entry::posLess)->pos();
-    size_t inputAlts(0);
+    int64_t start = (*min_element(beg, end, &posLess))->pos();
     for (auto e = beg; e != end; ++e) {
-        inputAlts += e->alt().size();
-        auto rawVariants = RawVariant::processEntry(*e);
+        auto rawVariants = RawVariant::processEntry(**e);
         for (auto alt = rawVariants.begin(); alt != rawVariants.end(); ++alt) {
             std::string var = _ref;
             assert(alt->pos >= start);
@@ -58,12 +74,18 @@ void AlleleMerger::init(Entry const* beg, Entry const* end) {
         _mergedAlt[i->second] = i->first;
 }
 
-string AlleleMerger::buildRef(Entry const* beg, Entry const* end) {
+string AlleleMerger::buildRef(std::vector<Entry> const& ents) {
+    auto ptrs = entryPointers(ents);
+    return buildRef(ptrs.data(), ptrs.data() + ptrs.size());
+}
+
+string AlleleMerger::buildRef(Entry const* const* beg, Entry const* const* end) {
     // beg -> end should be sorted by start position
-    string ref = beg->ref();
-    uint64_t lastPos = beg->pos() + ref.size();
+    string ref = (*beg)->ref();
+    uint64_t lastPos = (*beg)->pos() + ref.size();
 
-    for (Entry const* e = beg+1; e != end; ++e) {
+    for (auto i = beg+1; i != end; ++i) {
+        Entry const* e = *i;
         if (lastPos < e->pos())
             return "";
 
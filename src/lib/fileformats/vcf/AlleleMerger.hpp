@@ -16,9 +16,10 @@ public:
     typedef std::vector< std::vector<size_t> > AltIndices;
     typedef std::map<std::string, size_t> AlleleMap;
 
-    static std::string buildRef(Entry const* beg, Entry const* end);
+    static std::string buildRef(Entry const* const* beg, Entry const* const* end);
+    static std::string buildRef(std::vector<Entry> const& ents);
 
-    AlleleMerger(Entry const* beg, Entry const* end);
+    AlleleMerger(Entry const* const* beg, Entry const* const* end);
     AlleleMerger(std::vector<Entry> const& ents);
 
     bool merged() const { return _merged; }
@@ -27,7 +28,7 @@ public:
     AltIndices const& newAltIndices() const { return _newAltIndices; }
 
 protected:
-    void init(Entry const* beg, Entry const* end);
+    void init(Entry const* const* beg, Entry const* const* end);
 
 protected:
     uint32_t addAllele(std::string const& v);
@@ -0,0 +1,483 @@
+#include "Bcf2.hpp"
+
+#include "CustomType.hpp"
+#include "CustomValue.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using boost::format;
+using namespace std;
+
+BEGIN_NAMESPACE(Vcf)
+BEGIN_NAMESPACE(Bcf2)
+
+namespace {
+    // The values of an Integer field, with blanks as INT_MISSING
+    void intValues(CustomValue const& value, vector<int32_t>& out) {
+        out.clear();
+        auto const& raw = value.getRaw();
+        for (auto i = raw.begin(); i != raw.end(); ++i) {
+            int64_t const* v = boost::get<int64_t>(&*i);
+            if (!v) {
+                out.push_back(INT_MISSING);
+                continue;
+            }
+
+            // the low end of the range is reserved for the sentinels
+            if (*v <= INT_END_OF_VECTOR + 6 || *v > numeric_limits<int32_t>::max()) {
+                throw runtime_error(str(format(
+                    "Value %1% of field %2% is out of range for BCF2"
+                    ) % *v % value.type().id()));
+            }
+            out.push_back(int32_t(*v));
+        }
+    }
+
+    // The values of a Float field as raw bits, with blanks as missing
+    void floatValues(CustomValue const& value, vector<uint32_t>& out) {
+        out.clear();
+        auto const& raw = value.getRaw();
+        for (auto i = raw.begin(); i != raw.end(); ++i) {
+            if (double const* v = boost::get<double>(&*i))
+                out.push_back(Writer::fromFloat(float(*v)));
+            else if (int64_t const* v = boost::get<int64_t>(&*i))
+                out.push_back(Writer::fromFloat(float(*v)));
+            else
+                out.push_back(FLOAT_MISSING_BITS);
+        }
+    }
+
+    // The smallest type for the values in v, ignoring sentinels
+    Type intType(vector<int32_t> const& v) {
+        int32_t lo = 0;
+        int32_t hi = 0;
+        for (auto i = v.begin(); i != v.end(); ++i) {
+            if (*i == INT_MISSING || *i == INT_END_OF_VECTOR)
+                continue;
+            lo = min(lo, *i);
+            hi = max(hi, *i);
+        }
+        return Writer::intType(lo, hi);
+    }
+
+    // Adds the alleles of a GT string like "0|1" to out as BCF2 encodes
+    // them: (allele + 1) << 1, with the low bit set if phased with the
+    // previous allele. Missing alleles are 0.
+    void genotypeValues(std::string const& gt, vector<int32_t>& out) {
+        out.clear();
+        bool phased = false;
+        auto i = gt.begin();
+        while (i != gt.end()) {
+            int32_t allele = -1;
+            if (*i == '.') {
+                ++i;
+            }
+            else if (isdigit(*i)) {
+                allele = 0;
+                for (; i != gt.end() && isdigit(*i); ++i)
+                    allele = allele * 10 + (*i - '0');
+            }
+            else {
+                throw runtime_error(str(format("Invalid genotype '%1%'") % gt));
+            }
+
+            out.push_back(((allele + 1) << 1) | (phased ? 1 : 0));
+
+            if (i == gt.end())
+                break;
+
+            if (*i != '/' && *i != '|')
+                throw runtime_error(str(format("Invalid genotype '%1%'") % gt));
+            phased = *i == '|';
+            ++i;
+        }
+    }
+}
+
+size_t Reader::typeSize(Type type) {
+    switch (type) {
+        case MISSING: return 0;
+        case INT8: return 1;
+        case INT16: return 2;
+        case INT32: return 4;
+        case FLOAT: return 4;
+        case CHAR: return 1;
+    }
+
+    throw runtime_error(str(format("Invalid BCF2 type %1%") % int(type)));
+}
+
+void Writer::descriptor(Type type, uint32_t count) {
+    if (count < 15) {
+        _out += char((count << 4) | type);
+    }
+    else {
+        _out += char((15 << 4) | type);
+        typedInt(count);
+    }
+}
+
+void Writer::intValue(Type type, int32_t v) {
+    switch (type) {
+        case INT8:
+            if (v == INT_MISSING) v = int8_t(0x80);
+            else if (v == INT_END_OF_VECTOR) v = int8_t(0x81);
+            _out += char(v & 0xff);
+            break;
+
+        case INT16:
+            if (v == INT_MISSING) v = int16_t(0x8000);
+            else if (v == INT_END_OF_VECTOR) v = int16_t(0x8001);
+            _out += char(v & 0xff);
+            _out += char((v >> 8) & 0xff);
+            break;
+
+        case INT32:
+            int32(v);
+            break;
+
+        default:
+            throw runtime_error(str(format(
+                "Expected an integer type for BCF2 value, got %1%") % int(type)));
+    }
+}
+
+void Writer::typedInt(int32_t v) {
+    Type type = intType(v, v);
+    descriptor(type, 1);
+    intValue(type, v);
+}
+
+void Writer::typedString(std::string const& s) {
+    descriptor(CHAR, s.size());
+    _out += s;
+}
+
+void Writer::paddedString(std::string const& s, std::size_t width) {
+    _out += s;
+    _out.append(width - s.size(), '\0');
+}
+
+Type Writer::intType(int32_t lo, int32_t hi) {
+    if (lo >= -120 && hi <= 127)
+        return INT8;
+    if (lo >= -32760 && hi <= 32767)
+        return INT16;
+    return INT32;
+}
+
+TypeDescriptor Reader::descriptor() {
+    need(1);
+    unsigned char byte = *_pos++;
+    TypeDescriptor rv;
+    rv.type = Type(byte & 0x0f);
+    rv.count = byte >> 4;
+    typeSize(rv.type); // validates the type
+    if (rv.count == 15) {
+        int32_t count = typedInt();
+        if (count < 0)
+            throw runtime_error("Invalid BCF2 vector length");
+        rv.count = count;
+    }
+    return rv;
+}
+
+int32_t Reader::intValue(Type type) {
+    switch (type) {
+        case INT8: {
+            need(1);
+            int8_t v = int8_t(*_pos++);
+            if (v == int8_t(0x80)) return INT_MISSING;
+            if (v == int8_t(0x81)) return INT_END_OF_VECTOR;
+            return v;
+        }
+
+        case INT16: {
+            need(2);
+            int16_t v = int16_t(uint16_t(_pos[0]) | (uint16_t(_pos[1]) << 8));
+            _pos += 2;
+            if (v == int16_t(0x8000)) return INT_MISSING;
+            if (v == int16_t(0x8001)) return INT_END_OF_VECTOR;
+            return v;
+        }
+
+        case INT32:
+            // the sentinels are already right at this width
+            return int32();
+
+        default:
+            throw runtime_error(str(format(
+                "Expected an integer type in BCF2 record, got %1%") % int(type)));
+    }
+}
+
+int32_t Reader::typedInt() {
+    TypeDescriptor td = descriptor();
+    if (td.count != 1)
+        throw runtime_error("Expected a single typed integer in BCF2 record");
+    return intValue(td.type);
+}
+
+void Reader::readString(TypeDescriptor const& td, std::string& out) {
+    if (td.type != CHAR && td.type != MISSING)
+        throw runtime_error("Expected a string in BCF2 record");
+
+    size_t size = td.type == MISSING ? 0 : td.count;
+    need(size);
+    char const* beg = pos();
+    char const* end = beg + size;
+    out.assign(beg, std::find(beg, end, '\0'));
+    _pos += size;
+}
+
+void Reader::skip(TypeDescriptor const& td) {
+    size_t size = typeSize(td.type) * td.count;
+    need(size);
+    _pos += size;
+}
+
+void decodeValue(Reader& in, TypeDescriptor const& td, CustomValue& value) {
+    CustomType const& type = value.type();
+    vector<CustomValue::ValueType> values;
+
+    switch (type.type()) {
+        case CustomType::FLAG:
+            // present means set, there is nothing else to it
+            in.skip(td);
+            return;
+
+        case CustomType::CHAR:
+        case CustomType::STRING: {
+            std::string s;
+            in.readString(td, s);
+            value = CustomValue(&type, s);
+            return;
+        }
+
+        case CustomType::INTEGER:
+        case CustomType::FLOAT: {
+            bool done = false;
+            values.reserve(td.count);
+            for (uint32_t i = 0; i < td.count; ++i) {
+                if (td.type == FLOAT) {
+                    if (type.type() != CustomType::FLOAT) {
+                        throw runtime_error(str(format(
+                            "Float value in BCF2 record for Integer field %1%"
+                            ) % type.id()));
+                    }
+
+                    uint32_t bits = in.floatBits();
+                    if (done || bits == FLOAT_END_OF_VECTOR_BITS)
+                        done = true;
+                    else if (bits == FLOAT_MISSING_BITS)
+                        values.emplace_back();
+                    else
+                        values.emplace_back(double(Reader::toFloat(bits)));
+                }
+                else {
+                    int32_t v = in.intValue(td.type);
+                    if (done || v == INT_END_OF_VECTOR)
+                        done = true;
+                    else if (v == INT_MISSING)
+                        values.emplace_back();
+                    else if (type.type() == CustomType::FLOAT)
+                        values.emplace_back(double(v));
+                    else
+                        values.emplace_back(int64_t(v));
+                }
+            }
+            break;
+        }
+
+        default:
+            throw runtime_error("Invalid custom VCF type!");
+    }
+
+    // a lone missing value is how "." comes out
+    if (values.size() == 1 && values[0].which() == 0)
+        values.clear();
+
+    if (!values.empty())
+        type.validateIndex(values.size() - 1);
+
+    value.setRaw(std::move(values));
+}
+
+void decodeGenotype(Reader& in, TypeDescriptor const& td, std::string& out) {
+    out.clear();
+    bool done = false;
+    for (uint32_t i = 0; i < td.count; ++i) {
+        int32_t v = in.intValue(td.type);
+        if (done || v == INT_END_OF_VECTOR) {
+            done = true;
+            continue;
+        }
+
+        // no call at all, as opposed to a call of missing alleles
+        if (i == 0 && v == INT_MISSING) {
+            done = true;
+            continue;
+        }
+
+        if (i > 0)
+            out += (v != INT_MISSING && (v & 1)) ? '|' : '/';
+
+        int32_t allele = v == INT_MISSING ? -1 : (v >> 1) - 1;
+        if (allele < 0)
+            out += '.';
+        else
+            out += std::to_string(allele);
+    }
+}
+
+void encodeValue(Writer& out, CustomValue const& value) {
+    CustomType const& type = value.type();
+    switch (type.type()) {
+        case CustomType::FLAG:
+            out.descriptor(MISSING, 0);
+            break;
+
+        case CustomType::CHAR:
+        case CustomType::STRING:
+            out.typedString(value.empty() ? std::string() : value.toString());
+            break;
+
+        case CustomType::INTEGER: {
+            vector<int32_t> values;
+            intValues(value, values);
+            if (values.empty())
+                values.push_back(INT_MISSING);
+
+            Type t = intType(values);
+            out.descriptor(t, values.size());
+            for (auto i = values.begin(); i != values.end(); ++i)
+                out.intValue(t, *i);
+            break;
+        }
+
+        case CustomType::FLOAT: {
+            vector<uint32_t> values;
+            floatValues(value, values);
+            if (values.empty())
+                values.push_back(FLOAT_MISSING_BITS);
+
+            out.descriptor(FLOAT, values.size());
+            for (auto i = values.begin(); i != values.end(); ++i)
+                out.uint32(*i);
+            break;
+        }
+
+        default:
+            throw runtime_error("Invalid custom VCF type!");
+    }
+}
+
+void encodeSampleValues(
+        Writer& out,
+        CustomType const& type,
+        vector<CustomValue const*> const& values
+        )
+{
+    switch (type.type()) {
+        case CustomType::CHAR:
+        case CustomType::STRING: {
+            vector<std::string> strings(values.size());
+            size_t width = 1;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i] && !values[i]->empty())
+                    strings[i] = values[i]->toString();
+                width = max(width, strings[i].size());
+            }
+
+            out.descriptor(CHAR, width);
+            for (auto i = strings.begin(); i != strings.end(); ++i)
+                out.paddedString(*i, width);
+            break;
+        }
+
+        case CustomType::INTEGER: {
+            vector<vector<int32_t>> ints(values.size());
+            vector<int32_t> all;
+            size_t width = 1;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i])
+                    intValues(*values[i], ints[i]);
+                width = max(width, ints[i].size());
+                all.insert(all.end(), ints[i].begin(), ints[i].end());
+            }
+
+            Type t = intType(all);
+            out.descriptor(t, width);
+            for (auto i = ints.begin(); i != ints.end(); ++i) {
+                for (size_t j = 0; j < width; ++j) {
+                    if (j < i->size())
+                        out.intValue(t, (*i)[j]);
+                    else
+                        out.intValue(t, j == 0 ? INT_MISSING : INT_END_OF_VECTOR);
+                }
+            }
+            break;
+        }
+
+        case CustomType::FLOAT: {
+            vector<vector<uint32_t>> floats(values.size());
+            size_t width = 1;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i])
+                    floatValues(*values[i], floats[i]);
+                width = max(width, floats[i].size());
+            }
+
+            out.descriptor(FLOAT, width);
+            for (auto i = floats.begin(); i != floats.end(); ++i) {
+                for (size_t j = 0; j < width; ++j) {
+                    if (j < i->size())
+                        out.uint32((*i)[j]);
+                    else
+                        out.uint32(j == 0 ? FLOAT_MISSING_BITS : FLOAT_END_OF_VECTOR_BITS);
+                }
+            }
+            break;
+        }
+
+        case CustomType::FLAG:
+            throw runtime_error(str(format(
+                "Flag FORMAT field %1% can not be written as BCF2") % type.id()));
+
+        default:
+            throw runtime_error("Invalid custom VCF type!");
+    }
+}
+
+void encodeGenotypes(Writer& out, vector<CustomValue const*> const& values) {
+    vector<vector<int32_t>> calls(values.size());
+    size_t width = 1;
+    int32_t hi = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i] && !values[i]->empty())
+            genotypeValues(values[i]->toString(), calls[i]);
+        width = max(width, calls[i].size());
+        for (auto j = calls[i].begin(); j != calls[i].end(); ++j)
+            hi = max(hi, *j);
+    }
+
+    Type t = Writer::intType(0, hi);
+    out.descriptor(t, width);
+    for (auto i = calls.begin(); i != calls.end(); ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            if (j < i->size())
+                out.intValue(t, (*i)[j]);
+            else
+                out.intValue(t, j == 0 ? INT_MISSING : INT_END_OF_VECTOR);
+        }
+    }
+}
+
+END_NAMESPACE(Bcf2)
+END_NAMESPACE(Vcf)
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+#include "common/namespaces.hpp"
+#include "io/Bcf2LineSource.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(Vcf)
+
+class CustomType;
+class CustomValue;
+
+// Pieces of the BCF2 binary encoding shared by the decoders in Entry,
+// InfoFields and SampleData and by Bcf2Encoder.
+BEGIN_NAMESPACE(Bcf2)
+enum Type {
+    MISSING = 0,
+    INT8 = 1,
+    INT16 = 2,
+    INT32 = 3,
+    FLOAT = 5,
+    CHAR = 7
+};
+
+// Integers of every width are widened to int32 on the way in, with
+// their missing and end-of-vector values mapped to these.
+int32_t const INT_MISSING = std::numeric_limits<int32_t>::min();
+int32_t const INT_END_OF_VECTOR = INT_MISSING + 1;
+
+uint32_t const FLOAT_MISSING_BITS = 0x7F800001;
+uint32_t const FLOAT_END_OF_VECTOR_BITS = 0x7F800002;
+
+// True if s is a raw record as produced by Bcf2LineSource
+inline bool isRecord(std::string const& s) {
+    return !s.empty() && s[0] == Bcf2LineSource::RecordMarker;
+}
+
+struct TypeDescriptor {
+    Type type;
+    uint32_t count;
+};
+
+// Reads little endian values from a record, throwing if it runs out
+class Reader {
+public:
+    Reader(char const* beg, char const* end)
+        : _pos(reinterpret_cast<unsigned char const*>(beg))
+        , _end(reinterpret_cast<unsigned char const*>(end))
+    {}
+
+    char const* pos() const {
+        return reinterpret_cast<char const*>(_pos);
+    }
+
+    bool atEnd() const {
+        return _pos == _end;
+    }
+
+    uint32_t uint32() {
+        need(4);
+        uint32_t rv = uint32_t(_pos[0])
+            | (uint32_t(_pos[1]) << 8)
+            | (uint32_t(_pos[2]) << 16)
+            | (uint32_t(_pos[3]) << 24);
+        _pos += 4;
+        return rv;
+    }
+
+    int32_t int32() {
+        return int32_t(uint32());
+    }
+
+    // The raw bits of a float, for comparing against the sentinels
+    uint32_t floatBits() {
+        return uint32();
+    }
+
+    static float toFloat(uint32_t bits) {
+        float rv;
+        std::memcpy(&rv, &bits, sizeof(rv));
+        return rv;
+    }
+
+    // A type byte and, for counts of 15 or more, the typed int after it
+    TypeDescriptor descriptor();
+
+    // One integer of the given width, widened
+    int32_t intValue(Type type);
+
+    // A type descriptor followed by a single integer
+    int32_t typedInt();
+
+    // count chars, stopping at the first NUL (BCF pads strings with them)
+    void readString(TypeDescriptor const& td, std::string& out);
+
+    void skip(TypeDescriptor const& td);
+
+    static std::size_t typeSize(Type type);
+
+private:
+    void need(std::size_t n) const {
+        if (std::size_t(_end - _pos) < n)
+            throw std::runtime_error("Truncated BCF2 record");
+    }
+
+private:
+    unsigned char const* _pos;
+    unsigned char const* _end;
+};
+
+// Appends little endian values to a record under construction
+class Writer {
+public:
+    explicit Writer(std::string& out)
+        : _out(out)
+    {}
+
+    void uint32(uint32_t v) {
+        char buf[4] = {
+            char(v & 0xff), char((v >> 8) & 0xff),
+            char((v >> 16) & 0xff), char((v >> 24) & 0xff)
+        };
+        _out.append(buf, sizeof(buf));
+    }
+
+    void int32(int32_t v) {
+        uint32(uint32_t(v));
+    }
+
+    static uint32_t fromFloat(float v) {
+        uint32_t rv;
+        std::memcpy(&rv, &v, sizeof(rv));
+        return rv;
+    }
+
+    void descriptor(Type type, uint32_t count);
+
+    // One integer at the given width. INT_MISSING and INT_END_OF_VECTOR
+    // are narrowed to the sentinels of that width.
+    void intValue(Type type, int32_t v);
+
+    // A type descriptor followed by a single integer of the smallest width
+    void typedInt(int32_t v);
+
+    void typedString(std::string const& s);
+
+    // s, padded with NULs to width chars
+    void paddedString(std::string const& s, std::size_t width);
+
+    // The smallest integer type that holds every value in [lo, hi]
+    // without colliding with the sentinels
+    static Type intType(int32_t lo, int32_t hi);
+
+private:
+    std::string& _out;
+};
+
+// Decodes a vector described by td into value, which must already have
+// its type set. Missing values come out blank, as "." would in text.
+void decodeValue(Reader& in, TypeDescriptor const& td, CustomValue& value);
+
+// Decodes a GT vector into its text form (e.g., "0|1"), leaving out
+// empty for a missing call.
+void decodeGenotype(Reader& in, TypeDescriptor const& td, std::string& out);
+
+// Encodes value as the typed vector of an INFO field
+void encodeValue(Writer& out, CustomValue const& value);
+
+// Encodes one FORMAT field for every sample (NULL for samples without a
+// value) as a single typed vector padded to the longest value
+void encodeSampleValues(
+    Writer& out,
+    CustomType const& type,
+    std::vector<CustomValue const*> const& values
+    );
+
+// The same for GT, which is stored as allele indices rather than text
+void encodeGenotypes(Writer& out, std::vector<CustomValue const*> const& values);
+
+END_NAMESPACE(Bcf2)
+
+END_NAMESPACE(Vcf)
@@ -0,0 +1,122 @@
+#include "Bcf2Dictionary.hpp"
+
+#include <boost/format.hpp>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+using boost::format;
+using namespace std;
+
+BEGIN_NAMESPACE(Vcf)
+
+namespace {
+    // Finds key=value in a <...> header value, stopping at a comma or the
+    // closing bracket. Descriptions can contain anything, so they are not
+    // parsed, just skipped over when quoted.
+    bool findAttribute(string const& text, string const& key, string& value) {
+        bool quoted = false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (c == '"') {
+                quoted = !quoted;
+                continue;
+            }
+            if (quoted || (c != '<' && c != ','))
+                continue;
+
+            if (text.compare(i + 1, key.size(), key) == 0
+                && i + 1 + key.size() < text.size()
+                && text[i + 1 + key.size()] == '=')
+            {
+                size_t beg = i + 2 + key.size();
+                size_t end = text.find_first_of(",>", beg);
+                value = text.substr(beg, end == string::npos ? end : end - beg);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename Map>
+    int32_t lookup(Map const& m, string const& key) {
+        auto found = m.find(key);
+        if (found == m.end())
+            return -1;
+        return found->second;
+    }
+
+    template<typename Vector>
+    typename Vector::value_type const* at(Vector const& v, int32_t idx) {
+        if (idx < 0 || size_t(idx) >= v.size() || v[idx].empty())
+            return 0;
+        return &v[idx];
+    }
+}
+
+Bcf2Dictionary::Bcf2Dictionary() {
+    _strings.push_back("PASS");
+    _stringIndices["PASS"] = 0;
+}
+
+void Bcf2Dictionary::add(std::string const& key, std::string const& value) {
+    if (key == "FILTER" || key == "INFO" || key == "FORMAT")
+        addId(_strings, _stringIndices, value);
+    else if (key == "contig")
+        addId(_contigs, _contigIndices, value);
+}
+
+void Bcf2Dictionary::addId(
+        vector<std::string>& names,
+        boost::unordered_map<std::string, int32_t>& indices,
+        std::string const& value
+        )
+{
+    std::string id;
+    if (!findAttribute(value, "ID", id))
+        return;
+
+    std::string idxText;
+    if (!findAttribute(value, "IDX", idxText)) {
+        // the same id shows up once each for INFO and FORMAT
+        if (indices.find(id) == indices.end()) {
+            indices[id] = names.size();
+            names.push_back(id);
+        }
+        return;
+    }
+
+    int32_t idx = atoi(idxText.c_str());
+    if (idx < 0)
+        throw runtime_error(str(format("Invalid IDX for %1% in vcf header") % id));
+
+    if (size_t(idx) >= names.size())
+        names.resize(idx + 1);
+
+    if (!names[idx].empty() && names[idx] != id) {
+        throw runtime_error(str(format(
+            "Conflicting IDX=%1% for %2% and %3% in vcf header"
+            ) % idx % names[idx] % id));
+    }
+    names[idx] = id;
+    indices[id] = idx;
+}
+
+std::string const* Bcf2Dictionary::string(int32_t idx) const {
+    return at(_strings, idx);
+}
+
+std::string const* Bcf2Dictionary::contig(int32_t idx) const {
+    return at(_contigs, idx);
+}
+
+int32_t Bcf2Dictionary::stringIndex(std::string const& id) const {
+    return lookup(_stringIndices, id);
+}
+
+int32_t Bcf2Dictionary::contigIndex(std::string const& id) const {
+    return lookup(_contigIndices, id);
+}
+
+END_NAMESPACE(Vcf)
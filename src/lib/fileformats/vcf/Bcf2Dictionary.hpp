@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+#include "common/namespaces.hpp"
+
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(Vcf)
+
+// The dictionaries BCF2 records index into instead of spelling out names:
+// one of strings (FILTER, INFO and FORMAT ids, with PASS always at 0) and
+// one of contigs. Both are built from the header lines in order, honoring
+// any explicit IDX= attributes.
+class Bcf2Dictionary {
+public:
+    Bcf2Dictionary();
+
+    // Takes note of the id declared by a ##key=<...> header line, if key is
+    // one that goes in a dictionary
+    void add(std::string const& key, std::string const& value);
+
+    // These return NULL for indices that are not defined
+    std::string const* string(int32_t idx) const;
+    std::string const* contig(int32_t idx) const;
+
+    // -1 if not present
+    int32_t stringIndex(std::string const& id) const;
+    int32_t contigIndex(std::string const& id) const;
+
+    std::vector<std::string> const& strings() const { return _strings; }
+    std::vector<std::string> const& contigs() const { return _contigs; }
+
+private:
+    static void addId(
+        std::vector<std::string>& names,
+        boost::unordered_map<std::string, int32_t>& indices,
+        std::string const& value
+        );
+
+private:
+    std::vector<std::string> _strings;
+    boost::unordered_map<std::string, int32_t> _stringIndices;
+    std::vector<std::string> _contigs;
+    boost::unordered_map<std::string, int32_t> _contigIndices;
+};
+
+END_NAMESPACE(Vcf)
@@ -0,0 +1,169 @@
+#include "Bcf2Encoder.hpp"
+
+#include "Bcf2.hpp"
+#include "Bcf2Dictionary.hpp"
+#include "CustomValue.hpp"
+#include "Entry.hpp"
+#include "Header.hpp"
+#include "SampleData.hpp"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using boost::format;
+using namespace std;
+
+BEGIN_NAMESPACE(Vcf)
+
+namespace {
+    char const magic[] = { 'B', 'C', 'F', 2, 2 };
+
+    // true if a is a prefix of b
+    bool isPrefix(vector<string> const& a, vector<string> const& b) {
+        return a.size() <= b.size() && equal(a.begin(), a.end(), b.begin());
+    }
+
+    int32_t stringIndex(Bcf2Dictionary const& dict, string const& id, char const* what) {
+        int32_t idx = dict.stringIndex(id);
+        if (idx < 0) {
+            throw runtime_error(str(format(
+                "%1% '%2%' is not declared in the VCF header, which BCF2 output requires"
+                ) % what % id));
+        }
+        return idx;
+    }
+}
+
+Bcf2Encoder::Bcf2Encoder(Header const* header)
+    : _header(header)
+{
+}
+
+void Bcf2Encoder::writeHeader(std::ostream& s) const {
+    // the header text is stored nul terminated
+    string const& text = _header->text();
+
+    string buf(magic, sizeof(magic));
+    Bcf2::Writer w(buf);
+    w.uint32(text.size() + 1);
+    s.write(buf.data(), buf.size());
+    s.write(text.data(), text.size());
+    s.put('\0');
+}
+
+void Bcf2Encoder::write(std::ostream& s, Entry const& e) {
+    _buf.clear();
+    if (!canCopyFrom(e.header()) || !e.appendRawBcf2(_buf))
+        encode(e, _buf);
+    s.write(_buf.data(), _buf.size());
+}
+
+bool Bcf2Encoder::canCopyFrom(Header const& h) {
+    for (auto i = _copyable.begin(); i != _copyable.end(); ++i) {
+        if (i->first == &h)
+            return i->second;
+    }
+
+    // Indices stay valid as long as the output dictionaries only add to
+    // the input's, and the per-sample data has to line up as is
+    Bcf2Dictionary const& in = h.bcf2Dictionary();
+    Bcf2Dictionary const& out = _header->bcf2Dictionary();
+    bool rv = isPrefix(in.strings(), out.strings())
+        && isPrefix(in.contigs(), out.contigs())
+        && h.sampleNames() == _header->sampleNames()
+        && h.mirroredSamples().empty()
+        && _header->mirroredSamples().empty();
+
+    _copyable.push_back(make_pair(&h, rv));
+    return rv;
+}
+
+void Bcf2Encoder::encode(Entry const& e, std::string& out) const {
+    Bcf2Dictionary const& dict = _header->bcf2Dictionary();
+    SampleData const& sampleData = e.sampleData();
+    auto const& info = e.info();
+    uint32_t nAllele = e.alt().size() + 1;
+    uint32_t nSample = _header->sampleCount();
+    auto const& fmt = sampleData.format();
+    uint32_t nFmt = nSample ? fmt.size() : 0;
+
+    if (nAllele > 0xffff || info.size() > 0xffff || nFmt > 0xff || nSample > 0xffffff) {
+        throw runtime_error(str(format(
+            "Entry at %1%:%2% is too large to be written as BCF2"
+            ) % e.chrom() % e.pos()));
+    }
+
+    int32_t contig = dict.contigIndex(e.chrom());
+    if (contig < 0) {
+        throw runtime_error(str(format(
+            "Contig '%1%' is not declared in the VCF header, which BCF2 output requires"
+            ) % e.chrom()));
+    }
+
+    // rlen comes from END when there is one, as with symbolic alleles
+    int64_t rlen = e.ref().size();
+    CustomValue const* end = e.info("END");
+    if (end && end->type().type() == CustomType::INTEGER && end->get<int64_t>(0))
+        rlen = *end->get<int64_t>(0) - e.pos() + 1;
+
+    string shared;
+    Bcf2::Writer s(shared);
+    s.int32(contig);
+    s.int32(e.pos() - 1);
+    s.int32(rlen);
+    if (e.qual() <= Entry::MISSING_QUALITY)
+        s.uint32(Bcf2::FLOAT_MISSING_BITS);
+    else
+        s.uint32(Bcf2::Writer::fromFloat(e.qual()));
+    s.uint32((nAllele << 16) | info.size());
+    s.uint32((nFmt << 24) | nSample);
+
+    s.typedString(e.identifiers().empty() ? "." : e.identifiers().str());
+    // a "." alt is just the ref allele on its own
+    s.typedString(e.ref());
+    for (auto i = e.alt().begin(); i != e.alt().end(); ++i)
+        s.typedString(*i);
+
+    vector<int32_t> filters;
+    int32_t hi = 0;
+    for (auto i = e.failedFilters().begin(); i != e.failedFilters().end(); ++i) {
+        filters.push_back(stringIndex(dict, *i, "FILTER"));
+        hi = max(hi, filters.back());
+    }
+    Bcf2::Type filterType = Bcf2::Writer::intType(0, hi);
+    s.descriptor(filterType, filters.size());
+    for (auto i = filters.begin(); i != filters.end(); ++i)
+        s.intValue(filterType, *i);
+
+    for (auto i = info.begin(); i != info.end(); ++i) {
+        s.typedInt(stringIndex(dict, i->first, "INFO field"));
+        Bcf2::encodeValue(s, i->second);
+    }
+
+    string indiv;
+    Bcf2::Writer d(indiv);
+    vector<CustomValue const*> values(nSample);
+    for (uint32_t f = 0; f < nFmt; ++f) {
+        for (uint32_t i = 0; i < nSample; ++i) {
+            auto const* sample = sampleData.get(i);
+            values[i] = sample && f < sample->size() ? &(*sample)[f] : 0;
+        }
+
+        string const& id = fmt[f]->id();
+        d.typedInt(stringIndex(dict, id, "FORMAT field"));
+        if (id == "GT")
+            Bcf2::encodeGenotypes(d, values);
+        else
+            Bcf2::encodeSampleValues(d, *fmt[f], values);
+    }
+
+    Bcf2::Writer w(out);
+    w.uint32(shared.size());
+    w.uint32(indiv.size());
+    out += shared;
+    out += indiv;
+}
+
+END_NAMESPACE(Vcf)
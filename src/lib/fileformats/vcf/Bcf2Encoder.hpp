@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common/namespaces.hpp"
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+BEGIN_NAMESPACE(Vcf)
+
+class Entry;
+class Header;
+
+// Writes a header and entries as (uncompressed) BCF2, indexing into the
+// dictionaries of the header being written. Records are encoded from the
+// parsed values of each entry, except that entries read from BCF2 and
+// left unchanged are copied through as they are when their header's
+// dictionaries agree with the output's.
+//
+// Copies can be used from different threads.
+class Bcf2Encoder {
+public:
+    // header must outlive the encoder
+    explicit Bcf2Encoder(Header const* header);
+
+    // The magic number and the header text
+    void writeHeader(std::ostream& s) const;
+
+    void write(std::ostream& s, Entry const& e);
+
+private:
+    void encode(Entry const& e, std::string& out) const;
+    bool canCopyFrom(Header const& h);
+
+private:
+    Header const* _header;
+    std::string _buf;
+    // Headers we have already checked with canCopyFrom()
+    std::vector<std::pair<Header const*, bool>> _copyable;
+};
+
+END_NAMESPACE(Vcf)
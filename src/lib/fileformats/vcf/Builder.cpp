@@ -79,8 +79,12 @@ void Builder::writeMergedEntry(Entry& e) const {
 
 void Builder::output(Entry* begin, Entry* end) const {
     auto cnsFilt = _mergeStrategy.consensusFilter();
+    vector<Entry const*> ptrs;
+    for (auto e = begin; e != end; ++e)
+        ptrs.push_back(e);
+
     try {
-        EntryMerger merger(_mergeStrategy, _header, begin, end);
+        EntryMerger merger(_mergeStrategy, _header, ptrs.data(), ptrs.data() + ptrs.size());
         // no merging happened, output each entry individually
         if (!merger.merged()) {
             for (auto e = begin; e != end; ++e) {
@@ -113,7 +117,7 @@ void Builder::output(Entry* begin, Entry* end) const {
         }
         if (end - begin == 2) {
             cerr << "Going with entry #" << int(chosen-begin)+1 << ".\n";
-            EntryMerger merger(_mergeStrategy, _header, chosen, chosen+1);
+            EntryMerger merger(_mergeStrategy, _header, &chosen, &chosen + 1);
             Entry merged(std::move(merger));
             if (cnsFilt)
                 cnsFilt->apply(merged, 0);
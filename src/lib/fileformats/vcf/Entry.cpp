@@ -1,13 +1,14 @@
 #include "Entry.hpp"
+#include "Bcf2.hpp"
 #include "EntryMerger.hpp"
 #include "CustomValue.hpp"
 #include "Header.hpp"
 #include "MergeStrategy.hpp"
+#include "common/ParseNumber.hpp"
 #include "common/String.hpp"
 #include "io/StreamJoin.hpp"
 
 #include <boost/format.hpp>
-#include <boost/lexical_cast.hpp>
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -18,7 +19,6 @@
 #include <utility>
 
 using boost::format;
-using boost::lexical_cast;
 using namespace std;
 
 namespace {
@@ -97,6 +97,7 @@ Entry::Entry(Entry const& e)
     , _failedFilters(e._failedFilters)
     , _info(e._info)
     , _sampleString(e._sampleString)
+    , _bcf2Shared(e._bcf2Shared)
     , _parsedSamples(e._parsedSamples)
     , _sampleData(e._sampleData)
 {
@@ -115,6 +116,7 @@ Entry::Entry(Entry&& e)
     , _failedFilters(std::move(e._failedFilters))
     , _info(std::move(e._info))
     , _sampleString(std::move(e._sampleString))
+    , _bcf2Shared(std::move(e._bcf2Shared))
     , _parsedSamples(e._parsedSamples)
     , _sampleData(std::move(e._sampleData))
 {
@@ -133,6 +135,7 @@ Entry& Entry::operator=(Entry const& e) {
     _failedFilters = e._failedFilters;
     _info = e._info;
     _sampleString = e._sampleString;
+    _bcf2Shared = e._bcf2Shared;
     _parsedSamples = e._parsedSamples;
     _sampleData = e._sampleData;
     return *this;
@@ -151,6 +154,7 @@ Entry& Entry::operator=(Entry&& e) {
     _failedFilters = std::move(e._failedFilters);
     _info = std::move(e._info);
     _sampleString = std::move(e._sampleString);
+    _bcf2Shared = std::move(e._bcf2Shared);
     _parsedSamples = std::move(e._parsedSamples);
     _sampleData = std::move(e._sampleData);
     return *this;
@@ -189,12 +193,15 @@ Entry::Entry(EntryMerger&& merger)
     if (!merger.merged()) {
         stringstream ss;
         for (size_t i = 0; i < merger.entryCount(); ++i) {
-            ss << merger.entries()[i] << "\n";
+            ss << *merger.entries()[i] << "\n";
         }
         throw runtime_error(str(format("Failed to merge entries:\n %1%") %ss.str()));
     }
 
-    merger.setAltAndGenotypeData(_alt, _sampleData);
+    if (merger.spliceSampleColumns(_alt, _sampleString))
+        _parsedSamples = false;
+    else
+        merger.setAltAndGenotypeData(_alt, _sampleData);
     merger.setInfo(getInfo_());
 
     computeStartStop();
@@ -205,6 +212,11 @@ void Entry::reheader(const Header* newHeader) {
     _header = newHeader;
 }
 
+void Entry::reheader(const Header* newHeader, std::vector<uint32_t> const& newSampleIndices) {
+    sampleData().reheader(newHeader, newSampleIndices);
+    _header = newHeader;
+}
+
 const Header& Entry::header() const {
     if (!_header)
         throw runtime_error("Attempted to use Vcf Entry with no header!");
@@ -219,15 +231,25 @@ void Entry::parseAndReheader(const Header* h, const Header* newHeader, const str
 void Entry::parse(const Header* h, const string& s) {
     _parsedSamples = false;
     _header = h;
+    _bcf2Shared.clear();
 
-    // clear containers
+    // clear containers. _alt is resized below, reusing its strings
     _info.clear();
     _sampleData.clear();
     _identifiers.clear();
-    _alt.clear();
     _failedFilters.clear();
 
-    Tokenizer<char> tok(s, '\t');
+    if (Bcf2::isRecord(s)) {
+        parseBcf2(s);
+        return;
+    }
+
+    // Only the fixed columns (through INFO) are parsed here, leave the
+    // sample data unscanned until someone asks for it. The index is
+    // scratch space reused from line to line.
+    thread_local DelimiterIndex delims;
+    delims.index(s.data(), s.data() + s.size(), INFO + 1);
+    Tokenizer<char> tok(delims, '\t');
     if (!tok.extract(_chrom))
         throw runtime_error("Failed to extract chromosome from vcf entry: " + s);
     if (!tok.extract(_pos))
@@ -241,7 +263,7 @@ void Entry::parse(const Header* h, const string& s) {
         throw runtime_error("Failed to extract id from vcf entry: " + s);
 
     if (end-beg != 1 || *beg != '.')
-        Tokenizer<char>::split(beg, end, ';', inserter(_identifiers, _identifiers.begin()));
+        _identifiers.assign(beg, end);
 
     // ref alleles
     if (!tok.extract(_ref))
@@ -251,46 +273,167 @@ void Entry::parse(const Header* h, const string& s) {
     if (!tok.extract(&beg, &end))
         throw runtime_error("Failed to extract alt alleles from vcf entry: " + s);
 
-    if (end-beg != 1 || *beg != '.')
-        Tokenizer<char>::split(beg, end, ',', back_inserter(_alt));
+    size_t altCount = 0;
+    if (end-beg != 1 || *beg != '.') {
+        Tokenizer<char> alts(delims, beg, end, ',');
+        for (; !alts.eof(); ++altCount) {
+            if (altCount == _alt.size())
+                _alt.emplace_back();
+            alts.extract(_alt[altCount]);
+        }
+    }
+    _alt.resize(altCount);
 
     // phred quality
-    string qualstr;
-    if (!tok.extract(qualstr))
+    if (!tok.extract(&beg, &end))
         throw runtime_error("Failed to extract quality from vcf entry: " + s);
-    if (qualstr == ".")
+    if (end-beg == 1 && *beg == '.')
         _qual = MISSING_QUALITY;
-    else
-        _qual = lexical_cast<double>(qualstr);
+    else if (!parseFloat(beg, end, _qual))
+        throw runtime_error("Invalid quality in vcf entry: " + s);
 
     // failed filters
     if (!tok.extract(&beg, &end))
         throw runtime_error("Failed to extract filters from vcf entry: " + s);
 
-    if (end-beg != 1 || *beg != '.')
-        Tokenizer<char>::split(beg, end, ';', inserter(_failedFilters,_failedFilters.end()));
-
+    if (end-beg != 1 || *beg != '.') {
+        Tokenizer<char> filters(delims, beg, end, ';');
+        char const* fbeg(0);
+        char const* fend(0);
+        while (filters.extract(&fbeg, &fend))
+            _failedFilters.insert(_header
+                ? _header->filterId(fbeg, fend)
+                : FilterSet::id(fbeg, fend));
+    }
 
     // If pass is present as well as other failed filters, remove pass
     if (_failedFilters.size() > 1) {
-        _failedFilters.erase("PASS");
+        _failedFilters.erase(FilterSet::PASS);
     }
 
     // info entries
     if (!tok.extract(&beg, &end))
         throw runtime_error("Failed to extract info from vcf entry: " + s);
 
-    _info = decltype(_info)(std::string(beg, end));
+    _info.assign(beg, end);
 
     tok.remaining(_sampleString);
     _parsedSamples = false;
     computeStartStop();
 }
 
+void Entry::parseBcf2(const string& s) {
+    Bcf2Dictionary const& dict = _header->bcf2Dictionary();
+    Bcf2::Reader in(s.data() + 1, s.data() + s.size());
+
+    uint32_t sharedSize = in.uint32();
+    uint32_t indivSize = in.uint32();
+    char const* indiv = in.pos() + sharedSize;
+    if (s.size() != 1 + 8 + sharedSize + indivSize)
+        throw runtime_error("Inconsistent record length in BCF2 record");
+
+    int32_t chromIdx = in.int32();
+    std::string const* chrom = dict.contig(chromIdx);
+    if (!chrom)
+        throw runtime_error(str(format("Undeclared contig index %1% in BCF2 record") % chromIdx));
+    _chrom = *chrom;
+    _pos = in.int32() + 1;
+    in.int32(); // rlen, we get it from the ref allele
+
+    uint32_t qualBits = in.floatBits();
+    if (qualBits == Bcf2::FLOAT_MISSING_BITS)
+        _qual = MISSING_QUALITY;
+    else
+        _qual = Bcf2::Reader::toFloat(qualBits);
+
+    uint32_t nAlleleInfo = in.uint32();
+    uint32_t nInfo = nAlleleInfo & 0xffff;
+    uint32_t nAllele = nAlleleInfo >> 16;
+    // n_fmt and n_sample, for SampleData
+    char const* fmtSample = in.pos();
+    in.uint32();
+
+    // ids
+    std::string text;
+    in.readString(in.descriptor(), text);
+    if (!text.empty() && text != ".")
+        _identifiers.assign(text.data(), text.data() + text.size());
+
+    // alleles, ref first
+    if (nAllele == 0)
+        throw runtime_error("No ref allele in BCF2 record");
+    in.readString(in.descriptor(), _ref);
+    _alt.resize(nAllele - 1);
+    for (auto i = _alt.begin(); i != _alt.end(); ++i)
+        in.readString(in.descriptor(), *i);
+    if (_alt.size() == 1 && _alt[0] == ".")
+        _alt.clear();
+
+    // failed filters
+    Bcf2::TypeDescriptor td = in.descriptor();
+    for (uint32_t i = 0; i < td.count; ++i) {
+        int32_t idx = in.intValue(td.type);
+        if (idx == Bcf2::INT_MISSING || idx == Bcf2::INT_END_OF_VECTOR)
+            continue;
+
+        std::string const* name = dict.string(idx);
+        if (!name)
+            throw runtime_error(str(format("Undeclared filter index %1% in BCF2 record") % idx));
+        _failedFilters.insert(_header->filterId(name->data(), name->data() + name->size()));
+    }
+
+    if (_failedFilters.size() > 1) {
+        _failedFilters.erase(FilterSet::PASS);
+    }
+
+    // info entries
+    auto& info = *_info.emplace();
+    for (uint32_t i = 0; i < nInfo; ++i) {
+        int32_t key = in.typedInt();
+        std::string const* name = dict.string(key);
+        CustomType const* type = name ? _header->infoType(*name) : 0;
+        if (!type) {
+            throw runtime_error(str(format(
+                "Failed to lookup type for info field with index %1%"
+                ) % key));
+        }
+
+        CustomValue cv(type);
+        Bcf2::decodeValue(in, in.descriptor(), cv);
+        cv.setNumAlts(_alt.size());
+
+        auto inserted = info.insert(make_pair(*name, std::move(cv)));
+        if (!inserted.second)
+            throw runtime_error(str(format(
+                "Duplicate value for info field '%1%'"
+                ) % *name));
+    }
+
+    if (in.pos() != indiv)
+        throw runtime_error("Inconsistent shared data length in BCF2 record");
+
+    _bcf2Shared.assign(s.data() + 1 + 8, sharedSize);
+
+    // Like the text sample columns, the per-sample data is kept as is
+    // until someone asks for it. SampleData needs the counts from the
+    // shared part to decode it.
+    _sampleString.assign(1, Bcf2LineSource::RecordMarker);
+    _sampleString.append(fmtSample, 4);
+    _sampleString.append(indiv, indivSize);
+    _parsedSamples = false;
+    computeStartStop();
+}
+
 void Entry::addIdentifier(const std::string& id) {
+    modified();
     _identifiers.insert(id);
 }
 
+void Entry::addIdentifiers(const IdentifierList& ids) {
+    modified();
+    _identifiers.insert(ids);
+}
+
 void Entry::addFilter(const std::string& filterName) {
     // filters cannot contain whitespace or semicolons
     auto it = find_if(filterName.begin(), filterName.end(), isInvalidFilterId);
@@ -301,14 +444,21 @@ void Entry::addFilter(const std::string& filterName) {
             ) % filterName));
     }
 
-    if (_failedFilters.find("PASS") != _failedFilters.end()) {
-        _failedFilters.erase("PASS");
-    }
-
+    modified();
+    _failedFilters.erase(FilterSet::PASS);
     _failedFilters.insert(filterName);
 }
 
+void Entry::removeFilter(const std::string& filterName) {
+    if (!_failedFilters.contains(filterName))
+        return;
+
+    modified();
+    _failedFilters.erase(FilterSet::id(filterName));
+}
+
 void Entry::clearFilters() {
+    modified();
     _failedFilters.clear();
 }
 
@@ -333,6 +483,7 @@ void Entry::swap(Entry& other) {
     std::swap(_header, other._header);
     std::swap(_parsedSamples, other._parsedSamples);
     _sampleString.swap(other._sampleString);
+    _bcf2Shared.swap(other._bcf2Shared);
 }
 
 int32_t Entry::altIdx(const string& alt) const {
@@ -352,7 +503,7 @@ const CustomValue* Entry::info(const string& key) const {
 
 bool Entry::isFiltered() const {
     return !_failedFilters.empty()
-        && !(_failedFilters.size() == 1 && *_failedFilters.begin() == "PASS");
+        && !(_failedFilters.size() == 1 && _failedFilters.begin().id() == FilterSet::PASS);
 }
 
 void Entry::setInfo(std::string const& key, CustomValue const& value) {
@@ -365,7 +516,13 @@ void Entry::setInfo(std::string const& key, CustomValue const& value) {
     }
 }
 
+void Entry::removeInfo(std::string const& key) {
+    getInfo_().erase(key);
+}
+
 SampleData& Entry::sampleData() {
+    // we can't tell what the caller does with it
+    modified();
     if (!_parsedSamples) {
         _sampleData.parse(_header, _sampleString);
         _parsedSamples = true;
@@ -417,7 +574,7 @@ std::vector<std::string> Entry::allelesForSample(size_t sampleIdx) const {
 }
 
 void Entry::samplesToStream(std::ostream& s) const {
-    if (!_parsedSamples) {
+    if (!_parsedSamples && !Bcf2::isRecord(_sampleString)) {
         s << _sampleString;
     }
     else {
@@ -425,9 +582,41 @@ void Entry::samplesToStream(std::ostream& s) const {
     }
 }
 
+std::string const* Entry::rawSampleColumns() const {
+    if (_parsedSamples || Bcf2::isRecord(_sampleString))
+        return 0;
+    return &_sampleString;
+}
+
+std::size_t Entry::approxBytes() const {
+    std::size_t rv = sizeof(*this)
+        + _chrom.capacity()
+        + _ref.capacity()
+        + _sampleString.capacity()
+        + _bcf2Shared.capacity()
+        + _alt.capacity() * sizeof(std::string);
+    for (auto i = _alt.begin(); i != _alt.end(); ++i)
+        rv += i->capacity();
+    return rv;
+}
+
+bool Entry::appendRawBcf2(std::string& out) const {
+    if (_bcf2Shared.empty() || !Bcf2::isRecord(_sampleString))
+        return false;
+
+    // _sampleString holds the marker and n_fmt_sample ahead of the data
+    size_t const indivOffset = 1 + 4;
+    Bcf2::Writer w(out);
+    w.uint32(_bcf2Shared.size());
+    w.uint32(_sampleString.size() - indivOffset);
+    out += _bcf2Shared;
+    out.append(_sampleString, indivOffset, string::npos);
+    return true;
+}
+
 void Entry::allButSamplesToStream(std::ostream& s) const {
     s << _chrom << '\t' << _pos << '\t'
-        << streamJoin(identifiers()).delimiter(";").emptyString(".");
+        << (_identifiers.empty() ? "." : _identifiers.str());
 
     s << '\t' << _ref << '\t'
         << streamJoin(_alt).delimiter(",").emptyString(".");
@@ -442,6 +631,7 @@ void Entry::allButSamplesToStream(std::ostream& s) const {
 }
 
 void Entry::replaceAlts(uint64_t pos, std::string ref, std::vector<std::string> alt) {
+    modified();
     assert(alt.size() == _alt.size());
 
     _pos = pos;
@@ -463,6 +653,7 @@ InfoFields::MapType const& Entry::getInfo_() const {
 }
 
 InfoFields::MapType& Entry::getInfo_() {
+    modified();
     return *_info.get(*_header, _alt.size());
 }
 
@@ -477,10 +668,12 @@ ostream& operator<<(ostream& s, const Entry& e) {
 
 ReheaderingParser::ReheaderingParser(Header const* newHeader)
     : newHeader(newHeader)
+    , remap(newHeader)
 {}
 
 void ReheaderingParser::operator()(Header const* h, std::string& line, Entry& entry) {
-    return Entry::parseLineAndReheader(h, newHeader, line, entry);
+    Entry::parseLine(h, line, entry);
+    entry.reheader(newHeader, remap(*h));
 }
 
 END_NAMESPACE(Vcf)
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "CustomValue.hpp"
+#include "FilterSet.hpp"
 #include "Header.hpp"
+#include "IdentifierList.hpp"
 #include "InfoFields.hpp"
 #include "LazyValue.hpp"
 #include "SampleData.hpp"
+#include "SampleRemap.hpp"
 #include "common/CoordinateView.hpp"
 #include "common/LocusCompare.hpp"
 #include "common/Tokenizer.hpp"
@@ -78,26 +81,32 @@ public:
     // move the sample data around, but does not currently do any more
     // validation.
     void reheader(const Header* newHeader);
+    // As above, with the sample indices given by newHeader->sampleIndicesOf
+    // (or a SampleRemap) for the current header
+    void reheader(const Header* newHeader, std::vector<uint32_t> const& newSampleIndices);
 
     const Header& header() const;
     void parse(const Header* h, const std::string& s);
     void parseAndReheader(const Header* h, const Header* newH, const std::string& s);
 
     void addIdentifier(const std::string& id);
+    void addIdentifiers(const IdentifierList& ids);
     void addFilter(const std::string& filterName);
+    void removeFilter(const std::string& filterName);
     void clearFilters();
 
     const std::string& chrom() const { return _chrom; }
     const uint64_t& pos() const { return _pos; }
-    const std::set<std::string>& identifiers() const { return _identifiers; }
+    const IdentifierList& identifiers() const { return _identifiers; }
     const std::string& ref() const { return _ref; }
     const std::vector<std::string>& alt() const { return _alt; }
     const std::string& alt(GenotypeIndex const& idx) const;
     double qual() const { return _qual; }
-    const std::set<std::string>& failedFilters() const { return _failedFilters; }
+    const FilterSet& failedFilters() const { return _failedFilters; }
     const CustomValueMap& info() const { return getInfo_(); }
     const CustomValue* info(std::string const& key) const;
     void setInfo(std::string const& key, CustomValue const& value);
+    void removeInfo(std::string const& key);
     const SampleData& sampleData() const;
     SampleData& sampleData();
 
@@ -112,7 +121,7 @@ public:
 
         auto const& filters = failedFilters();
         for (auto i = filters.begin(); i != filters.end(); ++i) {
-            if (*i != "PASS" && whitelist.count(*i) == 0) {
+            if (i.id() != FilterSet::PASS && whitelist.count(*i) == 0) {
                 return true;
             }
         }
@@ -137,10 +146,29 @@ public:
     void allButSamplesToStream(std::ostream& s) const;
     void samplesToStream(std::ostream& s) const;
 
+    // The FORMAT and sample columns as they were read from a vcf line, or
+    // null if the sample data has been parsed (and so may have changed) or
+    // came from BCF2.
+    std::string const* rawSampleColumns() const;
+
+    // Roughly the memory this entry takes up: its own size and that of
+    // the text it holds, not counting parsed INFO or sample values
+    std::size_t approxBytes() const;
+
+    // If this entry was parsed from a BCF2 record and has not been changed
+    // since, appends that record (l_shared, l_indiv and the data, indexed
+    // by the dictionaries of header()) to out and returns true.
+    bool appendRawBcf2(std::string& out) const;
+
     void replaceAlts(uint64_t pos, std::string ref, std::vector<std::string> alt);
     void computeStartStop();
 
 private:
+    // parse() for a raw record from Bcf2LineSource
+    void parseBcf2(std::string const& s);
+    // Forgets the raw BCF2 record once the entry is changed
+    void modified() { _bcf2Shared.clear(); }
+
     InfoFields::MapType const& getInfo_() const;
     InfoFields::MapType& getInfo_();
 
@@ -150,13 +178,15 @@ protected:
     uint64_t _pos;
     int64_t _startWithoutPadding;
     int64_t _stopWithoutPadding;
-    std::set<std::string> _identifiers;
+    IdentifierList _identifiers;
     std::string _ref;
     std::vector<std::string> _alt;
     double _qual;
-    std::set<std::string> _failedFilters;
+    FilterSet _failedFilters;
     LazyValue<InfoFields> _info;
     std::string _sampleString;
+    // The shared part of the BCF2 record this came from, if unmodified
+    std::string _bcf2Shared;
     mutable bool _parsedSamples;
     mutable SampleData _sampleData;
 };
@@ -174,6 +204,7 @@ struct ReheaderingParser {
     typedef Entry ValueType;
 
     Header const* newHeader;
+    SampleRemap remap;
 
     ReheaderingParser(Header const* newHeader);
     void operator()(Header const* h, std::string& line, Entry& entry);
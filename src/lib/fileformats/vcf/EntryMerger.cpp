@@ -56,13 +56,98 @@ namespace {
                 "Programming error at %1%:%2%: didn't understand sample priority: %3%"
                 ) %__FILE__ %__LINE__ % int(prio)));
     }
+
+    // Whether beg..end is an integer as CustomValue writes one: digits with
+    // no leading zeros and an optional minus sign
+    bool isCanonicalInteger(char const* beg, char const* end) {
+        bool negative = beg != end && *beg == '-';
+        if (negative)
+            ++beg;
+
+        size_t len = end - beg;
+        if (len == 0 || len > 18 || (*beg == '0' && (len > 1 || negative)))
+            return false;
+
+        return all_of(beg, end, [](char c) { return c >= '0' && c <= '9'; });
+    }
+
+    // Whether GenotypeMerger writes the GT beg..end back as it is when the
+    // alleles keep their indices: allele indices below nAlleles or ".",
+    // without leading zeros and all joined by '/' or all by '|'
+    bool isCanonicalGT(char const* beg, char const* end, size_t nAlleles) {
+        char delim = 0;
+        for (char const* allele = beg;;) {
+            char const* alleleEnd = allele;
+            while (alleleEnd != end && *alleleEnd != '/' && *alleleEnd != '|')
+                ++alleleEnd;
+
+            if (alleleEnd - allele != 1 || *allele != '.') {
+                if (*allele == '-' || !isCanonicalInteger(allele, alleleEnd))
+                    return false;
+
+                size_t idx = 0;
+                for (char const* c = allele; c != alleleEnd; ++c)
+                    idx = idx * 10 + (*c - '0');
+                if (idx >= nAlleles)
+                    return false;
+            }
+
+            if (alleleEnd == end)
+                return true;
+            if (delim && *alleleEnd != delim)
+                return false;
+            delim = *alleleEnd;
+            allele = alleleEnd + 1;
+        }
+    }
+
+    // Whether CustomValue writes the value beg..end of the given type back
+    // as it is: "." or a list of values of the type. Floats may be written
+    // back with other digits, so are never taken as they are.
+    bool isCanonicalValue(CustomType const& type, char const* beg, char const* end) {
+        if (end - beg == 1 && *beg == '.')
+            return true;
+
+        uint32_t nItems = 1;
+        for (char const* item = beg;; ++nItems) {
+            char const* itemEnd = find(item, end, ',');
+            if (itemEnd == item)
+                return false;
+
+            if (itemEnd - item != 1 || *item != '.') {
+                switch (type.type()) {
+                    case CustomType::INTEGER:
+                        if (!isCanonicalInteger(item, itemEnd))
+                            return false;
+                        break;
+
+                    case CustomType::CHAR:
+                        if (itemEnd - item != 1)
+                            return false;
+                        break;
+
+                    case CustomType::STRING:
+                        break;
+
+                    default:
+                        return false;
+                }
+            }
+
+            if (itemEnd == end)
+                break;
+            item = itemEnd + 1;
+        }
+
+        return type.numberType() != CustomType::FIXED_SIZE || nItems <= type.number();
+    }
 }
 
 EntryMerger::EntryMerger(
         MergeStrategy const& mergeStrategy,
         Header const* mergedHeader,
-        Entry const* begin,
-        Entry const* end
+        Entry const* const* begin,
+        Entry const* const* end
         )
     : _alleleMerger(begin, end)
     , _mergeStrategy(mergeStrategy)
@@ -76,55 +161,62 @@ EntryMerger::EntryMerger(
         return;
 
     if (end-begin == 1)
-        _qual = begin->qual();
+        _qual = (*begin)->qual();
 
-    for (const Entry* e = begin; e != end; ++e) {
-        bool willMerge = e == begin;
-        for (const Entry* pe = begin; pe != e; ++pe) {
-            if (_mergeStrategy.canMerge(*e, *pe)) {
+    for (auto i = begin; i != end; ++i) {
+        Entry const* e = *i;
+        bool willMerge = i == begin;
+        for (auto pe = begin; pe != i; ++pe) {
+            if (_mergeStrategy.canMerge(*e, **pe)) {
                 willMerge = true;
                 break;
             }
         }
         if (!willMerge) {
             stringstream ss;
-            for (const Entry* ee = begin; ee != end; ++ee)
-                ss << *ee << "\n";
+            for (auto ee = begin; ee != end; ++ee)
+                ss << **ee << "\n";
             throw runtime_error(
                 str(format("Attempted to merge VCF entries with non-overlapping positions:\n%1%")
                     %ss.str()));
         }
 
         // merge identifiers
-        const set<string>& idents = e->identifiers();
-        copy(idents.begin(), idents.end(), inserter(_identifiers, _identifiers.begin()));
+        _identifiers.insert(e->identifiers());
 
         // Merge filters
-        const set<string>& filters = e->failedFilters();
-        copy(filters.begin(), filters.end(), inserter(_filters, _filters.begin()));
+        _filters.insert(e->failedFilters());
+
+        // entries from the same file share its samples (and header); any
+        // data they both have for one is caught when the samples are merged
+        bool newHeader = true;
+        for (auto pe = begin; pe != i && newHeader; ++pe)
+            newHeader = &(*pe)->header() != &e->header();
 
         const vector<string>& samples = e->header().sampleNames();
-        for (auto i = samples.begin(); i != samples.end(); ++i) {
+        for (auto i = samples.begin(); newHeader && i != samples.end(); ++i) {
             auto inserted = _sampleNames.insert(*i);
             if (!inserted.second && !_mergeStrategy.mergeSamples())
                 throw runtime_error(str(format("Duplicate sample name '%1%' in %2%") %*i %e->toString()));
         }
 
-        // Build set of all info fields present, validating as we go
+        // Build list of all info fields present, validating as we go
         const CustomValueMap& info = e->info();
         for (auto i = info.begin(); i != info.end(); ++i) {
-            _infoFieldNames.insert(i->first);
-            if (!_mergedHeader->infoType(i->first)) {
+            size_t idx = _mergeStrategy.infoPlanIndex(i->first);
+            if (idx == MergeStrategy::npos) {
                 throw runtime_error(str(format(
                     "Invalid info field '%1%' while merging vcf entries in %2%"
                     ) % i->first % e->toString()));
             }
+            if (find(_infoFields.begin(), _infoFields.end(), idx) == _infoFields.end())
+                _infoFields.push_back(idx);
         }
     }
     if (mergeStrategy.clearFilters())
         _filters.clear();
     else if (_filters.size() > 1)
-        _filters.erase("PASS");
+        _filters.erase(FilterSet::PASS);
 }
 
 bool EntryMerger::merged() const {
@@ -135,19 +227,19 @@ size_t EntryMerger::entryCount() const {
     return _end-_begin;
 }
 
-Entry const* EntryMerger::entries() const {
+Entry const* const* EntryMerger::entries() const {
     return _begin;
 }
 
 const string& EntryMerger::chrom() const {
-    return _begin->chrom();
+    return (*_begin)->chrom();
 }
 
 uint64_t EntryMerger::pos() const {
-    return _begin->pos();
+    return (*_begin)->pos();
 }
 
-set<string>& EntryMerger::identifiers() {
+IdentifierList& EntryMerger::identifiers() {
     return _identifiers;
 }
 
@@ -155,7 +247,7 @@ const string& EntryMerger::ref() const {
     return _alleleMerger.ref();
 }
 
-set<string>& EntryMerger::failedFilters() {
+FilterSet& EntryMerger::failedFilters() {
     return _filters;
 }
 
@@ -166,19 +258,20 @@ double EntryMerger::qual() const {
 
 void EntryMerger::setInfo(CustomValueMap& info) const {
     try {
-        for (auto i = _infoFieldNames.begin(); i != _infoFieldNames.end(); ++i) {
+        auto const& plan = _mergeStrategy.infoPlan();
+        for (auto i = _infoFields.begin(); i != _infoFields.end(); ++i) {
             CustomValue v = _mergeStrategy.mergeInfo(
                 *i, _begin, _end, _alleleMerger.newAltIndices());
 
             if (!v.empty()) {
                 v.setNumAlts(_alleleMerger.mergedAlt().size());
-                info.insert(make_pair(*i, v));
+                info.insert(make_pair(plan[*i].id, v));
             }
         }
     } catch (const exception& e) {
         throw runtime_error(str(format(
             "Error while merging INFO entries at position %1%,%2%: %3%"
-            ) %_begin->chrom() %_begin->pos() %e.what()));
+            ) %(*_begin)->chrom() %(*_begin)->pos() %e.what()));
     }
 }
 
@@ -193,8 +286,8 @@ void EntryMerger::setAltAndGenotypeData(
     SampleData::FormatType format;
     GenotypeMerger genotypeFormatter(_mergedHeader, alt);
     set<string> seen; // keep track of what fields we have already seen
-    for (const Entry* e = _begin; e != _end; ++e) {
-        const SampleData::FormatType& gtFormat = e->sampleData().format();
+    for (auto e = _begin; e != _end; ++e) {
+        const SampleData::FormatType& gtFormat = (*e)->sampleData().format();
         for (auto i = gtFormat.begin(); i != gtFormat.end(); ++i) {
             // check if we have already seen this field.
             auto inserted = seen.insert((*i)->id());
@@ -214,7 +307,9 @@ void EntryMerger::setAltAndGenotypeData(
 
     SampleData::MapType sdMap;
     // for each sample index where at least one entry has data...
-    for (Entry const* e = _begin; e != _end; ++e) {
+    for (auto i = _begin; i != _end; ++i) {
+        Entry const* e = *i;
+        size_t idx = i - _begin;
         SampleData const& samples = e->sampleData();
         for (auto si = samples.begin(); si != samples.end(); ++si) {
             uint32_t sampleIdx = si->first;
@@ -223,7 +318,7 @@ void EntryMerger::setAltAndGenotypeData(
             bool overridePreviousData = true;
             if (_mergedHeader->hasDuplicateSamples()) {
                 int primaryEntryIdx = getPrimaryEntryIdx(sampleName);
-                overridePreviousData = (e-_begin) == primaryEntryIdx;
+                overridePreviousData = int(idx) == primaryEntryIdx;
             }
 
             try {
@@ -232,7 +327,6 @@ void EntryMerger::setAltAndGenotypeData(
                     continue;
 
                 uint32_t mergedIdx = _mergedHeader->sampleIndex(sampleName);
-                size_t idx = e - _begin;
 
                 auto inserted = sdMap.insert(make_pair(mergedIdx, reinterpret_cast<SampleData::ValueVector*>(0)));
                 // If there is no data for this sample yet
@@ -262,19 +356,149 @@ void EntryMerger::setAltAndGenotypeData(
     sampleData = SampleData(_mergedHeader, std::move(format), std::move(sdMap));
 }
 
+bool EntryMerger::spliceSampleColumns(
+        std::vector<std::string>& alt,
+        std::string& sampleColumns) const
+{
+    // consensus filtering needs the per sample counts and merging samples
+    // needs the genotypes
+    if (_mergeStrategy.consensusFilter() || _mergedHeader->hasDuplicateSamples())
+        return false;
+
+    Entry const& first = **_begin;
+    string const* firstRaw = first.rawSampleColumns();
+    if (!firstRaw)
+        return false;
+
+    // GT must come first, as setAltAndGenotypeData would put it there
+    size_t formatLen = min(firstRaw->find('\t'), firstRaw->size());
+    string const format(*firstRaw, 0, formatLen);
+    bool gtFirst = format == "GT" || format.compare(0, 3, "GT:") == 0;
+    if (format.empty() || (!gtFirst && (":" + format + ":").find(":GT:") != string::npos))
+        return false;
+
+    vector<CustomType const*> types;
+    for (size_t beg = 0; beg <= format.size();) {
+        size_t end = min(format.find(':', beg), format.size());
+        types.push_back(_mergedHeader->formatType(format.substr(beg, end - beg)));
+        if (!types.back())
+            return false;
+        beg = end + 1;
+    }
+
+    // the genotypes are only written as they are if no allele moves
+    if (_alleleMerger.mergedAlt() != first.alt())
+        return false;
+    auto const& newAltIndices = _alleleMerger.newAltIndices();
+    for (auto i = newAltIndices.begin(); i != newAltIndices.end(); ++i) {
+        if (i->size() != first.alt().size())
+            return false;
+        for (size_t idx = 0; idx < i->size(); ++idx) {
+            if ((*i)[idx] != idx)
+                return false;
+        }
+    }
+
+    // Each merged sample's column and the number of its trailing fields
+    // setAltAndGenotypeData would add (as "."). Any column it would write
+    // differently, such as one with a float or an integer with a leading
+    // zero, rules splicing out.
+    struct Column {
+        char const* beg;
+        size_t len;
+        size_t missingFields;
+    };
+    vector<Column> columns(_mergedHeader->sampleCount(), Column{0, 0, 0});
+    for (auto i = _begin; i != _end; ++i) {
+        Entry const& e = **i;
+        string const* raw = e.rawSampleColumns();
+        if (!raw
+            || e.pos() != first.pos()
+            || e.chrom() != first.chrom()
+            || e.ref() != first.ref()
+            || e.alt() != first.alt()
+            || raw->compare(0, formatLen, format) != 0
+            || (raw->size() > formatLen && (*raw)[formatLen] != '\t'))
+        {
+            return false;
+        }
+
+        vector<string> const& names = e.header().sampleNames();
+        size_t sampleIdx = 0;
+        char const* end = raw->data() + raw->size();
+        for (char const* beg = raw->data() + formatLen; beg != end; ++sampleIdx) {
+            ++beg; // the tab ahead of this column
+            char const* colEnd = static_cast<char const*>(memchr(beg, '\t', end - beg));
+            if (!colEnd)
+                colEnd = end;
+
+            if (sampleIdx >= names.size())
+                return false;
+
+            auto& col = columns[_mergedHeader->sampleIndex(names[sampleIdx])];
+            if (col.beg)
+                return false;
+
+            // a sample with no data is written as "." either way
+            size_t nFields = types.size();
+            if (colEnd - beg != 1 || *beg != '.') {
+                nFields = 0;
+                for (char const* field = beg;; ++nFields) {
+                    if (nFields == types.size())
+                        return false;
+
+                    char const* fieldEnd = find(field, colEnd, ':');
+                    bool same = nFields == 0 && gtFirst
+                        ? isCanonicalGT(field, fieldEnd, first.alt().size() + 1)
+                        : isCanonicalValue(*types[nFields], field, fieldEnd);
+                    if (!same)
+                        return false;
+
+                    if (fieldEnd == colEnd)
+                        break;
+                    field = fieldEnd + 1;
+                }
+                ++nFields;
+            }
+
+            col = Column{beg, size_t(colEnd - beg), types.size() - nFields};
+            beg = colEnd;
+        }
+
+        if (sampleIdx != names.size())
+            return false;
+    }
+
+    alt = _alleleMerger.mergedAlt();
+    sampleColumns = format;
+    for (auto i = columns.begin(); i != columns.end(); ++i) {
+        sampleColumns += '\t';
+        if (i->beg) {
+            sampleColumns.append(i->beg, i->len);
+            for (size_t field = 0; field < i->missingFields; ++field)
+                sampleColumns += ":.";
+        }
+        else {
+            sampleColumns += '.';
+        }
+    }
+
+    return true;
+}
+
 int EntryMerger::getPrimaryEntryIdx(std::string const& sampleName) const {
-    Entry const* best(0);
+    Entry const* const* best(0);
     auto prio = _mergeStrategy.samplePriority();
     int bestSampleIdx = -1;
 
-    for (Entry const* e = _begin; e != _end; ++e) {
+    for (auto e = _begin; e != _end; ++e) {
         try {
-            int newSampleIdx = e->header().sampleIndex(sampleName);
+            int newSampleIdx = (*e)->header().sampleIndex(sampleName);
             if (best == 0) {
                 bestSampleIdx = newSampleIdx;
                 best = e;
             } else {
-                if (isBetter(e, newSampleIdx, best, bestSampleIdx, prio))
+                if (isBetter(*e, newSampleIdx, *best, bestSampleIdx, prio))
                     best = e;
             }
         } catch (SampleNotFoundError const&) {
@@ -282,7 +506,7 @@ int EntryMerger::getPrimaryEntryIdx(std::string const& sampleName) const {
         }
     }
 
-    if (best == _end)
+    if (best == 0)
         return 0;
     else
         return best - _begin;
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "AlleleMerger.hpp"
+#include "FilterSet.hpp"
+#include "IdentifierList.hpp"
 #include "InfoFields.hpp"
 #include "common/cstdint.hpp"
 #include "common/namespaces.hpp"
 
+#include <cstddef>
 #include <map>
 #include <set>
 #include <string>
@@ -26,23 +29,34 @@ public:
     EntryMerger(
         MergeStrategy const& mergeStrategy,
         Header const* mergedHeader,
-        Entry const* begin,
-        Entry const* end);
+        Entry const* const* begin,
+        Entry const* const* end);
 
     // was anything actually merged?
     bool merged() const;
     size_t entryCount() const;
-    Entry const* entries() const;
+    Entry const* const* entries() const;
 
     std::string const& chrom() const;
     uint64_t pos() const;
-    std::set<std::string>& identifiers();
+    IdentifierList& identifiers();
     std::string const& ref() const;
-    std::set<std::string>& failedFilters();
+    FilterSet& failedFilters();
     double qual() const;
     void setInfo(CustomValueMap& info) const;
     void setAltAndGenotypeData(std::vector<std::string>& alt, SampleData& sampleData) const;
 
+    // When every entry is at the same site with the same alleles and the
+    // same FORMAT, each sample has data from at most one entry and all of
+    // them still hold the text they were parsed from, the merged genotype
+    // data is just their sample columns side by side, padded with "." for
+    // missing trailing fields. In that case, unless a column holds values
+    // setAltAndGenotypeData would write differently (floats, say), this
+    // sets alt and the text of the merged FORMAT and sample columns, the
+    // same as setAltAndGenotypeData would give, and returns true; otherwise
+    // it returns false and setAltAndGenotypeData is needed.
+    bool spliceSampleColumns(std::vector<std::string>& alt, std::string& sampleColumns) const;
+
     const Header* mergedHeader() const;
 
     // The number of times each sample was seen while merging.
@@ -57,13 +71,14 @@ protected:
     AlleleMerger _alleleMerger;
     MergeStrategy const& _mergeStrategy;
     Header const* _mergedHeader;
-    Entry const* _begin;
-    Entry const* _end;
+    Entry const* const* _begin;
+    Entry const* const* _end;
     double _qual;
-    std::set<std::string> _identifiers;
-    std::set<std::string> _filters;
+    IdentifierList _identifiers;
+    FilterSet _filters;
     std::set<std::string> _sampleNames;
-    std::set<std::string> _infoFieldNames;
+    // positions in the merge strategy's info plan of the fields present
+    std::vector<std::size_t> _infoFields;
     mutable std::vector<size_t> _sampleCounts;
 };
 
@@ -0,0 +1,80 @@
+#include "EntryWriter.hpp"
+
+#include "Entry.hpp"
+#include "Header.hpp"
+
+#include <boost/format.hpp>
+
+#include <stdexcept>
+
+using boost::format;
+using namespace std;
+
+BEGIN_NAMESPACE(Vcf)
+
+namespace {
+    void requireHeader(bool haveHeader) {
+        if (!haveHeader)
+            throw runtime_error("Attempted to write VCF entries before the header");
+    }
+}
+
+OutputFormat outputFormatFromString(std::string const& s) {
+    if (s == "vcf")
+        return VCF_OUTPUT;
+    if (s == "bcf")
+        return BCF_OUTPUT;
+
+    throw runtime_error(str(format(
+        "Invalid output format '%1%'. Expected one of: vcf,bcf") % s));
+}
+
+EntryFormatter::EntryFormatter(OutputFormat format, Header const* header)
+    : _format(format)
+    , _bcf2(header)
+{
+}
+
+void EntryFormatter::operator()(std::ostream& s, Entry const& e) {
+    if (_format == BCF_OUTPUT)
+        _bcf2.write(s, e);
+    else
+        s << e << "\n";
+}
+
+EntryWriter::EntryWriter(std::ostream& out, OutputFormat format)
+    : _out(out)
+    , _format(format)
+{
+    if (_format == BCF_OUTPUT)
+        _bgzf.reset(new BgzfOutputStream(_out));
+}
+
+std::ostream& EntryWriter::stream() {
+    return _bgzf ? *_bgzf : _out;
+}
+
+void EntryWriter::writeHeader(Header const& header) {
+    _formatter.reset(new EntryFormatter(_format, &header));
+    if (_format == BCF_OUTPUT)
+        Bcf2Encoder(&header).writeHeader(stream());
+    else
+        stream() << header;
+}
+
+void EntryWriter::operator()(Entry const& e) {
+    requireHeader(_formatter != 0);
+    (*_formatter)(stream(), e);
+}
+
+EntryFormatter const& EntryWriter::formatter() const {
+    requireHeader(_formatter != 0);
+    return *_formatter;
+}
+
+void EntryWriter::close() {
+    if (_bgzf)
+        _bgzf->close();
+}
+
+END_NAMESPACE(Vcf)
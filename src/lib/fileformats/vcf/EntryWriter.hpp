@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Bcf2Encoder.hpp"
+#include "common/namespaces.hpp"
+#include "io/BgzfOutputStream.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+BEGIN_NAMESPACE(Vcf)
+
+class Entry;
+class Header;
+
+enum OutputFormat {
+    VCF_OUTPUT,
+    BCF_OUTPUT
+};
+
+// "vcf" or "bcf", as given to --output-format
+OutputFormat outputFormatFromString(std::string const& s);
+
+// Formats entries as VCF text lines or BCF2 records into whatever stream
+// it is given. Copies can be used from different threads, e.g., one per
+// OrderedPipeline worker, with the results written to EntryWriter::stream().
+class EntryFormatter {
+public:
+    EntryFormatter(OutputFormat format, Header const* header);
+
+    void operator()(std::ostream& s, Entry const& e);
+
+private:
+    OutputFormat _format;
+    Bcf2Encoder _bcf2;
+};
+
+// Writes a header and entries to a stream as VCF or as (BGZF compressed)
+// BCF2.
+class EntryWriter : public boost::noncopyable {
+public:
+    typedef void result_type;
+
+    EntryWriter(std::ostream& out, OutputFormat format);
+
+    // Where formatted entries go: out itself, or a compressor in front of
+    // it for BCF2
+    std::ostream& stream();
+
+    // This must come first. header must outlive the writer.
+    void writeHeader(Header const& header);
+
+    void operator()(Entry const& e);
+
+    // A formatter for the header given to writeHeader()
+    EntryFormatter const& formatter() const;
+
+    // Finishes off the output. The destructor does this too, but can't
+    // report errors.
+    void close();
+
+private:
+    std::ostream& _out;
+    OutputFormat _format;
+    std::unique_ptr<BgzfOutputStream> _bgzf;
+    std::unique_ptr<EntryFormatter> _formatter;
+};
+
+END_NAMESPACE(Vcf)
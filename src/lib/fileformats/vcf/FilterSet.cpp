@@ -0,0 +1,229 @@
+#include "FilterSet.hpp"
+
+#include <boost/format.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+using boost::format;
+
+BEGIN_NAMESPACE(Vcf)
+
+namespace {
+    // Assigns ids to filter names. Lookups by name take a lock, but they
+    // only happen once per distinct name per header (see Header::filterId).
+    // Lookups by id are lock free: the names live in a table of pointers
+    // that are only ever written once. The table grows in chunks, each
+    // twice the size of the one before, that are allocated as they are
+    // needed and never move, so there is no limit on the number of names
+    // short of running out of ids.
+    class FilterRegistry {
+    public:
+        FilterRegistry()
+            : _count(0)
+        {
+            for (size_t i = 0; i < MaxChunks; ++i)
+                _chunks[i].store(0, std::memory_order_relaxed);
+            // PASS is always id 0
+            id("PASS");
+        }
+
+        ~FilterRegistry() {
+            for (size_t i = 0; i < MaxChunks; ++i)
+                delete[] _chunks[i].load(std::memory_order_relaxed);
+        }
+
+        FilterSet::Id id(std::string const& name) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto found = _ids.find(name);
+            if (found != _ids.end())
+                return found->second;
+
+            if (_count == std::numeric_limits<FilterSet::Id>::max()) {
+                throw std::runtime_error(str(format(
+                    "Out of vcf filter ids adding %1%") % name));
+            }
+
+            FilterSet::Id rv = _count++;
+            size_t chunk;
+            size_t offset;
+            locate(rv, chunk, offset);
+            Slot* slots = _chunks[chunk].load(std::memory_order_relaxed);
+            if (!slots) {
+                slots = new Slot[chunkSize(chunk)];
+                for (size_t i = 0; i < chunkSize(chunk); ++i)
+                    slots[i].store(0, std::memory_order_relaxed);
+                _chunks[chunk].store(slots, std::memory_order_release);
+            }
+
+            auto inserted = _ids.insert(std::make_pair(name, rv)).first;
+            slots[offset].store(&inserted->first, std::memory_order_release);
+            return rv;
+        }
+
+        std::string const& name(FilterSet::Id id) const {
+            size_t chunk;
+            size_t offset;
+            locate(id, chunk, offset);
+            Slot const* slots = chunk < MaxChunks
+                ? _chunks[chunk].load(std::memory_order_acquire)
+                : 0;
+            std::string const* rv = slots
+                ? slots[offset].load(std::memory_order_acquire)
+                : 0;
+            if (!rv) {
+                throw std::runtime_error(str(format(
+                    "Unknown vcf filter id %1%") % id));
+            }
+            return *rv;
+        }
+
+    private:
+        typedef std::atomic<std::string const*> Slot;
+
+        enum {
+            FirstChunkBits = 8,
+            // enough chunks to cover every 32 bit id
+            MaxChunks = 33 - FirstChunkBits
+        };
+
+        static size_t chunkSize(size_t chunk) {
+            return size_t(1) << (FirstChunkBits + chunk);
+        }
+
+        // Chunk k holds ids [2^b * (2^k - 1), 2^b * (2^(k+1) - 1)), where
+        // b is FirstChunkBits
+        static void locate(FilterSet::Id id, size_t& chunk, size_t& offset) {
+            uint64_t x = (uint64_t(id) >> FirstChunkBits) + 1;
+            chunk = 0;
+            while (x >>= 1)
+                ++chunk;
+            offset = uint64_t(id) + (uint64_t(1) << FirstChunkBits) - chunkSize(chunk);
+        }
+
+    private:
+        std::mutex _mutex;
+        FilterSet::Id _count;
+        // node based, so the keys don't move once inserted
+        boost::unordered_map<std::string, FilterSet::Id> _ids;
+        std::atomic<Slot*> _chunks[MaxChunks];
+    };
+
+    FilterRegistry& registry() {
+        static FilterRegistry reg;
+        return reg;
+    }
+
+    bool nameLess(FilterSet::Id a, FilterSet::Id b) {
+        return a != b && FilterSet::name(a) < FilterSet::name(b);
+    }
+}
+
+FilterSet::Id const FilterSet::PASS;
+FilterSet::size_type const FilterSet::InlineCapacity;
+
+FilterSet::Id FilterSet::id(char const* beg, char const* end) {
+    return registry().id(std::string(beg, end));
+}
+
+FilterSet::Id FilterSet::id(std::string const& name) {
+    return registry().id(name);
+}
+
+std::string const& FilterSet::name(Id id) {
+    return registry().name(id);
+}
+
+bool FilterSet::contains(Id id) const {
+    Id const* beg = ids();
+    return std::find(beg, beg + _size, id) != beg + _size;
+}
+
+bool FilterSet::contains(std::string const& name) const {
+    for (auto i = begin(); i != end(); ++i) {
+        if (*i == name)
+            return true;
+    }
+    return false;
+}
+
+void FilterSet::insert(Id id) {
+    Id const* beg = ids();
+    Id const* pos = std::lower_bound(beg, beg + _size, id, nameLess);
+    if (pos != beg + _size && *pos == id)
+        return;
+
+    size_type offset = pos - beg;
+    if (_size < InlineCapacity) {
+        std::copy_backward(_inline + offset, _inline + _size, _inline + _size + 1);
+        _inline[offset] = id;
+    }
+    else {
+        if (_size == InlineCapacity)
+            _spill.assign(_inline, _inline + InlineCapacity);
+        _spill.insert(_spill.begin() + offset, id);
+    }
+    ++_size;
+}
+
+void FilterSet::insert(std::string const& name) {
+    insert(id(name));
+}
+
+void FilterSet::insert(FilterSet const& other) {
+    for (size_type i = 0; i < other._size; ++i)
+        insert(other.ids()[i]);
+}
+
+void FilterSet::erase(Id id) {
+    Id* beg = mutableIds();
+    Id* pos = std::find(beg, beg + _size, id);
+    if (pos == beg + _size)
+        return;
+
+    if (_size <= InlineCapacity) {
+        std::copy(pos + 1, beg + _size, pos);
+    }
+    else {
+        _spill.erase(_spill.begin() + (pos - beg));
+        if (_size - 1 == InlineCapacity) {
+            std::copy(_spill.begin(), _spill.end(), _inline);
+            _spill.clear();
+        }
+    }
+    --_size;
+}
+
+void FilterSet::clear() {
+    _spill.clear();
+    _size = 0;
+}
+
+void FilterSet::swap(FilterSet& other) {
+    std::swap(_size, other._size);
+    std::swap_ranges(_inline, _inline + InlineCapacity, other._inline);
+    _spill.swap(other._spill);
+}
+
+bool FilterSet::operator==(FilterSet const& rhs) const {
+    return _size == rhs._size && std::equal(ids(), ids() + _size, rhs.ids());
+}
+
+bool FilterSet::operator!=(FilterSet const& rhs) const {
+    return !(*this == rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, FilterSet const& filters) {
+    for (auto i = filters.begin(); i != filters.end(); ++i) {
+        if (i != filters.begin())
+            os << ';';
+        os << *i;
+    }
+    return os;
+}
+
+END_NAMESPACE(Vcf)
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+#include "common/namespaces.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(Vcf)
+
+// The FILTER column of a vcf entry.
+//
+// Filter names are mapped to small integer ids (see id()); a set stores the
+// ids of its filters, in place for up to InlineCapacity of them. The ids are
+// kept ordered by filter name, so iterating over a set gives the names in
+// the same order a std::set<std::string> would.
+//
+// Ids are shared by every header in the process, so sets from entries with
+// different headers can be combined directly (e.g., when merging).
+class FilterSet {
+public:
+    typedef uint32_t Id;
+    typedef uint32_t size_type;
+
+    static Id const PASS = 0;
+    static size_type const InlineCapacity = 3;
+
+    // Returns the id for the named filter, assigning a new one the first
+    // time a name is seen. Safe to call from multiple threads.
+    static Id id(char const* beg, char const* end);
+    static Id id(std::string const& name);
+
+    // The name of an assigned id. The reference stays valid until exit.
+    static std::string const& name(Id id);
+
+    // Iterates over filter names
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::string const* pointer;
+        typedef std::string const& reference;
+
+        explicit const_iterator(Id const* pos = 0)
+            : _pos(pos)
+        {}
+
+        std::string const& operator*() const { return name(*_pos); }
+        std::string const* operator->() const { return &name(*_pos); }
+        Id id() const { return *_pos; }
+
+        const_iterator& operator++() { ++_pos; return *this; }
+        const_iterator operator++(int) { const_iterator rv(*this); ++_pos; return rv; }
+
+        bool operator==(const_iterator const& rhs) const { return _pos == rhs._pos; }
+        bool operator!=(const_iterator const& rhs) const { return _pos != rhs._pos; }
+
+    private:
+        Id const* _pos;
+    };
+    typedef const_iterator iterator;
+
+    FilterSet()
+        : _size(0)
+    {}
+
+    bool empty() const { return _size == 0; }
+    size_type size() const { return _size; }
+    const_iterator begin() const { return const_iterator(ids()); }
+    const_iterator end() const { return const_iterator(ids() + _size); }
+
+    // The ids in name order
+    Id const* ids() const {
+        return _size <= InlineCapacity ? _inline : _spill.data();
+    }
+
+    bool contains(Id id) const;
+    bool contains(std::string const& name) const;
+
+    // Adds the filter (if not already present), keeping name order
+    void insert(Id id);
+    void insert(std::string const& name);
+    // Adds every filter in other
+    void insert(FilterSet const& other);
+    void erase(Id id);
+    void clear();
+    void swap(FilterSet& other);
+
+    bool operator==(FilterSet const& rhs) const;
+    bool operator!=(FilterSet const& rhs) const;
+
+private:
+    Id* mutableIds() {
+        return _size <= InlineCapacity ? _inline : _spill.data();
+    }
+
+private:
+    size_type _size;
+    Id _inline[InlineCapacity];
+    std::vector<Id> _spill;
+};
+
+std::ostream& operator<<(std::ostream& os, FilterSet const& filters);
+
+END_NAMESPACE(Vcf)
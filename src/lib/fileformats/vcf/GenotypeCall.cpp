@@ -1,17 +1,159 @@
 #include "GenotypeCall.hpp"
 
-#include "common/Tokenizer.hpp"
-
 #include <boost/format.hpp>
+
+#include <algorithm>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
 
 using boost::format;
 
 BEGIN_NAMESPACE(Vcf)
 
+namespace {
+    bool parseIndex(char const* beg, char const* end, GenotypeIndex::value_type& value) {
+        if (beg == end)
+            return false;
+
+        uint64_t rv = 0;
+        for (; beg != end; ++beg) {
+            unsigned digit = unsigned(*beg) - '0';
+            if (digit > 9)
+                return false;
+
+            rv = rv * 10 + digit;
+            if (rv > std::numeric_limits<GenotypeIndex::value_type>::max())
+                return false;
+        }
+        value = GenotypeIndex::value_type(rv);
+        return true;
+    }
+}
+
 GenotypeCall GenotypeCall::Null;
+std::size_t const GenotypeCall::MaxInterned;
+unsigned const GenotypeCall::ScratchCalls;
 GenotypeIndex GenotypeIndex::Null{std::numeric_limits<GenotypeIndex::value_type>::max()};
 
+GenotypeIndexList::size_type GenotypeIndexList::count(GenotypeIndex const& idx) const {
+    return std::count(begin(), end(), idx);
+}
+
+void GenotypeIndexList::push_back(GenotypeIndex const& idx) {
+    if (_size < InlineCapacity) {
+        _inline[_size++] = idx;
+        return;
+    }
+
+    if (_size == InlineCapacity)
+        _spill.assign(_inline, _inline + InlineCapacity);
+
+    _spill.push_back(idx);
+    ++_size;
+}
+
+void GenotypeIndexList::insertUnique(GenotypeIndex const& idx) {
+    auto pos = std::lower_bound(begin(), end(), idx);
+    if (pos != end() && *pos == idx)
+        return;
+
+    size_type offset = pos - begin();
+    push_back(idx);
+    GenotypeIndex* d = _size <= InlineCapacity ? _inline : _spill.data();
+    std::rotate(d + offset, d + _size - 1, d + _size);
+}
+
+bool GenotypeIndexList::operator==(GenotypeIndexList const& rhs) const {
+    return _size == rhs._size && std::equal(begin(), end(), rhs.begin());
+}
+
+bool GenotypeIndexList::operator!=(GenotypeIndexList const& rhs) const {
+    return !(*this == rhs);
+}
+
+bool GenotypeIndexList::operator==(std::vector<GenotypeIndex> const& rhs) const {
+    return _size == rhs.size() && std::equal(begin(), end(), rhs.begin());
+}
+
+bool GenotypeIndexList::operator<(GenotypeIndexList const& rhs) const {
+    return std::lexicographical_compare(begin(), end(), rhs.begin(), rhs.end());
+}
+
+GenotypeCall const& GenotypeCall::intern(std::string const& call) {
+    static GenotypeInternTable table;
+    return table.get(call);
+}
+
+GenotypeInternTable::GenotypeInternTable(std::size_t maxInterned)
+    : _maxInterned(maxInterned)
+{
+    static char const alleles[] = "0123456789.";
+    static char const delims[] = "/|";
+    std::string s;
+    for (int a = 0; a < nAlleleCodes; ++a) {
+        s.assign(1, alleles[a]);
+        _small[slot(s.data(), s.data() + s.size())] = GenotypeCall(s);
+        for (int d = 0; d < 2; ++d) {
+            for (int b = 0; b < nAlleleCodes; ++b) {
+                s.assign(1, alleles[a]);
+                s += delims[d];
+                s += alleles[b];
+                _small[slot(s.data(), s.data() + s.size())] = GenotypeCall(s);
+            }
+        }
+    }
+}
+
+GenotypeCall const& GenotypeInternTable::get(std::string const& call) {
+    int idx = slot(call.data(), call.data() + call.size());
+    if (idx >= 0)
+        return _small[idx];
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _other.find(call);
+        if (found != _other.end())
+            return found->second;
+
+        if (_other.size() < _maxInterned)
+            return _other.insert(std::make_pair(call, GenotypeCall(call))).first->second;
+    }
+
+    thread_local GenotypeCall scratch[GenotypeCall::ScratchCalls];
+    thread_local unsigned next = 0;
+    GenotypeCall& rv = scratch[next];
+    rv = GenotypeCall(call);
+    next = (next + 1) % GenotypeCall::ScratchCalls;
+    return rv;
+}
+
+int GenotypeInternTable::alleleCode(char c) {
+    if (c == '.')
+        return 10;
+    unsigned digit = unsigned(c) - '0';
+    return digit > 9 ? -1 : int(digit);
+}
+
+int GenotypeInternTable::slot(char const* beg, char const* end) {
+    switch (end - beg) {
+        case 1:
+            return alleleCode(*beg);
+
+        case 3: {
+            int a = alleleCode(beg[0]);
+            int b = alleleCode(beg[2]);
+            int d = beg[1] == '/' ? 0 : beg[1] == '|' ? 1 : -1;
+            if (a < 0 || b < 0 || d < 0)
+                return -1;
+            return nAlleleCodes + (a * 2 + d) * nAlleleCodes + b;
+        }
+
+        default:
+            return -1;
+    }
+}
+
 GenotypeCall::GenotypeCall()
     : _phased(false)
     , _partial(false)
@@ -21,36 +163,53 @@ GenotypeCall::GenotypeCall()
 GenotypeCall::GenotypeCall(const std::string& call)
     : _phased(false)
     , _partial(false)
-    , _string(call)
 {
+    parse(call.data(), call.data() + call.size());
+}
+
+GenotypeCall::GenotypeCall(char const* beg, char const* end)
+    : _phased(false)
+    , _partial(false)
+{
+    parse(beg, end);
+}
+
+void GenotypeCall::parse(char const* beg, char const* end) {
     // special case: a lone null (".") is treated as empty
-    if (call == ".") {
+    if (beg == end || (end - beg == 1 && *beg == '.')) {
         return;
     }
 
-    Tokenizer<std::string> tok(call, "|/");
-    GenotypeIndex idx;
     size_t nullCount = 0;
 
     // note: a delimiter of | denotes phased data
     // if anything is phased, we treat the whole genotype as phased
     // hopefully, mixing of phased and unphased data in a single
     // call isn't meaningful...
-    while (!tok.eof()) {
-        if (tok.nextTokenMatches(".")) {
+    char const* tokBeg = beg;
+    while (true) {
+        char const* tokEnd = tokBeg;
+        while (tokEnd != end && *tokEnd != '/' && *tokEnd != '|')
+            ++tokEnd;
+
+        GenotypeIndex idx;
+        if (tokEnd - tokBeg == 1 && *tokBeg == '.') {
             ++nullCount;
-            idx = GenotypeIndex::Null;
-            tok.advance();
         }
-        else if (!tok.extract(idx.value)) {
+        else if (!parseIndex(tokBeg, tokEnd, idx.value)) {
             throw std::runtime_error(str(format("Genotype parse error "
                 "(GT=%1%): expected a number or '.'"
-                ) % call));
+                ) % std::string(beg, end)));
         }
 
-        _phased |= tok.lastDelim() == '|';
         _indices.push_back(idx);
-        _indexSet.insert(idx);
+        _indexSet.insertUnique(idx);
+
+        if (tokEnd == end)
+            break;
+
+        _phased |= *tokEnd == '|';
+        tokBeg = tokEnd + 1;
     }
 
     if (nullCount > 0 && nullCount < _indices.size())
@@ -62,7 +221,7 @@ bool GenotypeCall::empty() const {
 }
 
 bool GenotypeCall::null() const {
-    return _indexSet.size() == 1 && _indexSet.begin()->null();
+    return _indexSet.size() == 1 && _indexSet[0].null();
 }
 
 bool GenotypeCall::partial() const {
@@ -98,32 +257,39 @@ bool GenotypeCall::diploid() const {
 }
 
 bool GenotypeCall::reference() const {
-    return _indexSet.size() == 1 && _indexSet.count(GenotypeIndex{0});
+    return _indexSet.size() == 1 && _indexSet[0] == GenotypeIndex{0};
 }
 
 const GenotypeIndex& GenotypeCall::operator[](size_type idx) const {
     return _indices[idx];
 }
 
-const vector<GenotypeIndex>& GenotypeCall::indices() const {
+const GenotypeIndexList& GenotypeCall::indices() const {
     return _indices;
 }
 
-const set<GenotypeIndex>& GenotypeCall::indexSet() const {
+const GenotypeIndexList& GenotypeCall::indexSet() const {
     return _indexSet;
 }
 
-const string& GenotypeCall::string() const {
-    return _string;
+std::string GenotypeCall::string() const {
+    std::stringstream ss;
+    char delim = _phased ? '|' : '/';
+    for (auto i = begin(); i != end(); ++i) {
+        if (i != begin())
+            ss << delim;
+        ss << *i;
+    }
+    return ss.str();
 }
 
 bool GenotypeCall::operator==(const GenotypeCall& rhs) const {
     if(_phased == rhs._phased) {
         if(_phased) {
-            return (_string == rhs._string);
+            return (_indices == rhs._indices);
         }
         else {
-            //order doesn't matter so need to sort
+            //order doesn't matter so compare the sorted sets
             return (_indexSet == rhs._indexSet);
         }
     }
@@ -148,14 +314,14 @@ bool GenotypeCall::operator<(const GenotypeCall& rhs) const {
         return false;
 
     if (_phased) {
-        return _string < rhs._string;
+        return _indices < rhs._indices;
     }
 
     if (!_indexSet.empty()) {
         // indexSets are the same size
         auto ia = _indexSet.begin();
         auto ib = rhs._indexSet.begin();
-        while (ia != _indexSet.end() && ib != _indexSet.end()) {
+        while (ia != _indexSet.end() && ib != rhs._indexSet.end()) {
             if (*ia < *ib)
                 return true;
             ++ia;
@@ -4,8 +4,11 @@
 #include "common/cstdint.hpp"
 #include "common/RelOps.hpp"
 
+#include <boost/unordered_map.hpp>
+
+#include <cstddef>
+#include <mutex>
 #include <ostream>
-#include <set>
 #include <string>
 #include <vector>
 
@@ -31,16 +34,79 @@ struct GenotypeIndex : ValueBasedRelOps<GenotypeIndex>  {
     value_type value;
 };
 
+// A short sequence of genotype indices. Calls with ploidy up to
+// InlineCapacity are stored in place; anything longer spills to the heap.
+class GenotypeIndexList {
+public:
+    typedef uint32_t size_type;
+    typedef GenotypeIndex value_type;
+    typedef GenotypeIndex const* const_iterator;
+    typedef const_iterator iterator;
+
+    static size_type const InlineCapacity = 4;
+
+    GenotypeIndexList()
+        : _size(0)
+    {}
+
+    bool empty() const { return _size == 0; }
+    size_type size() const { return _size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + _size; }
+
+    GenotypeIndex const& operator[](size_type idx) const {
+        return data()[idx];
+    }
+
+    size_type count(GenotypeIndex const& idx) const;
+
+    void push_back(GenotypeIndex const& idx);
+    // inserts idx keeping the list sorted, does nothing if already present
+    void insertUnique(GenotypeIndex const& idx);
+
+    bool operator==(GenotypeIndexList const& rhs) const;
+    bool operator!=(GenotypeIndexList const& rhs) const;
+    bool operator==(std::vector<GenotypeIndex> const& rhs) const;
+    bool operator<(GenotypeIndexList const& rhs) const;
+
+private:
+    GenotypeIndex const* data() const {
+        return _size <= InlineCapacity ? _inline : _spill.data();
+    }
+
+private:
+    size_type _size;
+    GenotypeIndex _inline[InlineCapacity];
+    std::vector<GenotypeIndex> _spill;
+};
+
 
 class GenotypeCall {
 public:
-    typedef std::vector<GenotypeIndex>::size_type size_type;
-    typedef std::vector<GenotypeIndex>::const_iterator const_iterator;
+    typedef GenotypeIndexList::size_type size_type;
+    typedef GenotypeIndexList::const_iterator const_iterator;
 
     static GenotypeCall Null;
 
+    // Distinct calls kept by intern(), beyond the common haploid and
+    // diploid ones
+    static std::size_t const MaxInterned = 1 << 16;
+    // Calls intern() gives out per thread once it is full
+    static unsigned const ScratchCalls = 16;
+
+    // Returns a shared, immutable call for the given GT text, from a
+    // process wide GenotypeInternTable holding up to MaxInterned strings.
+    // Those are parsed once and the reference stays valid until exit. Past
+    // that, new strings are parsed each time into per thread scratch space:
+    // the reference is then only good for the next ScratchCalls - 1 calls
+    // from the same thread, and the same text need not give the same
+    // address. Use the call right away, copy it to keep it, and compare
+    // calls by value, never by address. Safe to call from multiple threads.
+    static GenotypeCall const& intern(std::string const& call);
+
     GenotypeCall();
     explicit GenotypeCall(const std::string& call);
+    GenotypeCall(char const* beg, char const* end);
 
     bool empty() const;
     bool null() const;
@@ -60,17 +126,48 @@ public:
     bool diploid() const;
     bool reference() const;
 
-    const std::vector<GenotypeIndex>& indices() const;
-    const std::string& string() const;
-    const std::set<GenotypeIndex>& indexSet() const;
+    // indices in call order
+    const GenotypeIndexList& indices() const;
+    // distinct indices in ascending order
+    const GenotypeIndexList& indexSet() const;
+    std::string string() const;
 
+protected:
+    void parse(char const* beg, char const* end);
 
 protected:
     bool _phased;
     bool _partial;
-    std::vector<GenotypeIndex> _indices;
-    std::set<GenotypeIndex> _indexSet;
-    std::string _string;
+    GenotypeIndexList _indices;
+    GenotypeIndexList _indexSet;
+};
+
+// The table behind GenotypeCall::intern. Haploid and diploid calls on
+// single digit allele indices cover nearly every genotype seen in practice.
+// Those get a fixed slot computed directly from the text; anything else
+// goes through a locked hash table of at most maxInterned entries. Past
+// that, calls are parsed into a small ring of GenotypeCall::ScratchCalls
+// scratch calls kept per thread.
+class GenotypeInternTable {
+public:
+    explicit GenotypeInternTable(std::size_t maxInterned = GenotypeCall::MaxInterned);
+
+    GenotypeCall const& get(std::string const& call);
+
+private:
+    static int alleleCode(char c);
+    static int slot(char const* beg, char const* end);
+
+private:
+    enum {
+        nAlleleCodes = 11,
+        nSmallSlots = nAlleleCodes + nAlleleCodes * 2 * nAlleleCodes
+    };
+
+    std::size_t _maxInterned;
+    GenotypeCall _small[nSmallSlots];
+    std::mutex _mutex;
+    boost::unordered_map<std::string, GenotypeCall> _other;
 };
 
 std::ostream& operator<<(std::ostream& os, GenotypeIndex const& gtidx);
@@ -121,8 +121,8 @@ string GenotypeMerger::renumberGT(
 
 bool GenotypeMerger::areGenotypesDisjoint(const std::string& str1, const std::string& str2) {
     set<GenotypeIndex> values;
-    GenotypeCall gt1(str1);
-    GenotypeCall gt2(str2);
+    GenotypeCall const& gt1 = GenotypeCall::intern(str1);
+    GenotypeCall const& gt2 = GenotypeCall::intern(str2);
     copy(gt1.begin(), gt1.end(), inserter(values, values.begin()));
 
     for (auto i = gt2.begin(); i != gt2.end(); ++i) {
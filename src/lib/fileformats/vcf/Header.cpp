@@ -3,6 +3,7 @@
 #include "common/Tokenizer.hpp"
 
 #include <boost/format.hpp>
+#include <cstring>
 #include <ctime>
 #include <functional>
 #include <iostream>
@@ -68,53 +69,63 @@ void Header::add(const string& line) {
             throw runtime_error(str(format("Failed to parse VCF header line: %1%") %line));
         p.first = p.first.substr(2); // strip leading ##
         t.remaining(p.second);
+        addMetaInfoLine(p);
+    } else {
+        parseHeaderLine(line.substr(1));
+    }
+}
 
-        if (p.first == "INFO") {
-            CustomType t(p.second.substr(1, p.second.size()-2));
-            auto inserted = _infoTypes.insert(
-                make_pair(t.id(), std::move(t))
-            );
-            if (!inserted.second) {
-                if (t == inserted.first->second) {
-                    cerr << "Warning: detected duplicate (identical) INFO field in header: " << t.id() << "\n";
-                } else {
-                    throw runtime_error(str(format("Duplicate (non-identical) value for INFO:%1%") %t.id()));
-                }
+void Header::addMetaInfoLine(RawLine const& p) {
+    _text.reset();
+    if (p.first == "INFO") {
+        CustomType t(p.second.substr(1, p.second.size()-2));
+        auto inserted = _infoTypes.insert(
+            make_pair(t.id(), std::move(t))
+        );
+        if (!inserted.second) {
+            if (t == inserted.first->second) {
+                cerr << "Warning: detected duplicate (identical) INFO field in header: " << t.id() << "\n";
+            } else {
+                throw runtime_error(str(format("Duplicate (non-identical) value for INFO:%1%") %t.id()));
             }
-        } else if (p.first == "FORMAT") {
-            CustomType t(p.second.substr(1, p.second.size()-2));
-            auto inserted = _formatTypes.insert(
-                make_pair(t.id(), std::move(t))
-            );
-            if (!inserted.second) {
-                if (t == inserted.first->second) {
-                    cerr << "Warning: detected duplicate (identical) FORMAT field in header: " << t.id() << "\n";
-                } else {
-                    throw runtime_error(str(format("Duplicate (non-identical) value for FORMAT:%1%") %t.id()));
-                }
+        }
+    } else if (p.first == "FORMAT") {
+        CustomType t(p.second.substr(1, p.second.size()-2));
+        auto inserted = _formatTypes.insert(
+            make_pair(t.id(), std::move(t))
+        );
+        if (!inserted.second) {
+            if (t == inserted.first->second) {
+                cerr << "Warning: detected duplicate (identical) FORMAT field in header: " << t.id() << "\n";
+            } else {
+                throw runtime_error(str(format("Duplicate (non-identical) value for FORMAT:%1%") %t.id()));
             }
-        } else if (p.first == "FILTER") {
-            // TODO: care about duplicates?
-            Map m(p.second.substr(1, p.second.size()-2));
-            auto desc = m["Description"];
-            if (!desc.empty() && desc[0] == '"' && desc[desc.size() - 1] == '"')
-                desc = desc.substr(1, desc.size() - 2);
-
-            _filters.insert(make_pair(m["ID"], desc));
-        } else if (p.first == "SAMPLE") {
-            SampleTag st(p.second.substr(1, p.second.size()-2));
-            auto inserted = _sampleTags.insert(
-                make_pair(st.id(), std::move(st))
-            );
-            if (!inserted.second)
-                throw runtime_error(str(format("Duplicate SAMPLE ID in vcf header: %1%") %st.toString()));
-
         }
+    } else if (p.first == "FILTER") {
+        // TODO: care about duplicates?
+        Map m(p.second.substr(1, p.second.size()-2));
+        auto desc = m["Description"];
+        if (!desc.empty() && desc[0] == '"' && desc[desc.size() - 1] == '"')
+            desc = desc.substr(1, desc.size() - 2);
+
+        auto inserted = _filters.insert(make_pair(m["ID"], desc));
+        if (inserted.second) {
+            auto const& id = inserted.first->first;
+            _filterIds.push_back(make_pair(id, FilterSet::id(id)));
+        }
+    } else if (p.first == "SAMPLE") {
+        SampleTag st(p.second.substr(1, p.second.size()-2));
+        auto inserted = _sampleTags.insert(
+            make_pair(st.id(), std::move(st))
+        );
+        if (!inserted.second)
+            throw runtime_error(str(format("Duplicate SAMPLE ID in vcf header: %1%") %st.toString()));
 
-        _metaInfoLines.push_back(p);
-    } else {
-        parseHeaderLine(line.substr(1));
     }
+
+    _bcf2Dictionary.reset();
+    _metaInfoLines.push_back(p);
+    _metaInfoLineSet.insert(p);
 }
 
 void Header::addFilter(const string& id, const string& desc) {
@@ -135,6 +146,26 @@ void Header::addInfoType(CustomType const& type) {
     add(str(format("##INFO=<%1%>") %type.toString()));
 }
 
+void Header::removeInfoType(std::string const& id) {
+    if (!_infoTypes.erase(id))
+        return;
+
+    auto isType = [&id](RawLine const& p) {
+        return p.first == "INFO"
+            && CustomType(p.second.substr(1, p.second.size()-2)).id() == id;
+    };
+    for (auto iter = _metaInfoLines.begin(); iter != _metaInfoLines.end(); ++iter) {
+        if (isType(*iter))
+            _metaInfoLineSet.erase(*iter);
+    }
+    _metaInfoLines.erase(
+        remove_if(_metaInfoLines.begin(), _metaInfoLines.end(), isType),
+        _metaInfoLines.end());
+
+    _text.reset();
+    _bcf2Dictionary.reset();
+}
+
 void Header::addFormatType(CustomType const& type) {
     add(str(format("##FORMAT=<%1%>") %type.toString()));
 }
@@ -162,14 +193,12 @@ void Header::parseHeaderLine(const std::string& line) {
             throw runtime_error(str(format("Malformed header line: %1%\nExpected token: %2%") %line %expected));
     }
 
-    set<string> seenNames;
     while (t.extract(tok)) {
-        auto inserted = seenNames.insert(tok);
-        if (!inserted.second)
+        size_t newIdx = _sampleNames.size();
+        if (addSample(tok) != newIdx)
             throw runtime_error(str(format(
                 "Duplicate sample name in vcf header: %1%"
                 ) %tok));
-        addSample(tok);
     }
 }
 
@@ -190,33 +219,51 @@ void Header::assertValid() const {
 }
 
 void Header::merge(const Header& other, bool allowDuplicateSamples) {
+    size_t nSamples = _sampleNames.size() + other._sampleNames.size();
+    _sampleNames.reserve(nSamples);
+    _sampleIndices.reserve(nSamples);
     for (auto iter = other._sampleNames.begin(); iter != other._sampleNames.end(); ++iter) {
-        auto exists = _sampleIndices.find(*iter);
-        size_t idx;
-        if (exists != _sampleIndices.end()) {
+        size_t newIdx = _sampleNames.size();
+        size_t idx = addSample(*iter);
+        if (idx != newIdx) {
             if (!allowDuplicateSamples)
                 throw runtime_error(str(format("Error merging VCF headers, sample name conflict: %1%") %*iter));
-            idx = exists->second;
             _hasDuplicateSamples = true;
-        } else {
-            idx = addSample(*iter);
         }
         if (idx >= _sampleSourceCounts.size())
             _sampleSourceCounts.resize(idx+1);
         ++_sampleSourceCounts[idx];
     }
 
-
+    // Headers being merged tend to share most of their lines in the same
+    // order, so check our line where the last match left off before
+    // hashing.
+    size_t next = 0;
     for (auto iter = other._metaInfoLines.begin(); iter != other._metaInfoLines.end(); ++iter) {
+        // fileDate is replaced below
+        if (iter->first == "fileDate")
+            continue;
+
+        if (next < _metaInfoLines.size() && _metaInfoLines[next] == *iter) {
+            ++next;
+            continue;
+        }
+
         // we already have that exact line
-        if (find(_metaInfoLines.begin(), _metaInfoLines.end(), *iter) != _metaInfoLines.end())
+        if (_metaInfoLineSet.count(*iter))
             continue;
-        add("##"+iter->first+"="+iter->second);
+        addMetaInfoLine(*iter);
     }
 
+    // forget the old fileDate lines before remove_if leaves them moved from
     MetaInfoFilter filter("fileDate");
-    auto newEnd = remove_if(_metaInfoLines.begin(), _metaInfoLines.end(), filter);
-    _metaInfoLines.erase(newEnd, _metaInfoLines.end());
+    for (auto iter = _metaInfoLines.begin(); iter != _metaInfoLines.end(); ++iter) {
+        if (filter(*iter))
+            _metaInfoLineSet.erase(*iter);
+    }
+    _metaInfoLines.erase(
+        remove_if(_metaInfoLines.begin(), _metaInfoLines.end(), filter),
+        _metaInfoLines.end());
     char dateStr[32] = {0};
     time_t now = time(NULL);
     strftime(dateStr, sizeof(dateStr), "%Y%m%d", localtime(&now));
@@ -230,6 +277,18 @@ uint32_t Header::sampleIndex(const std::string& sampleName) const {
     return iter->second;
 }
 
+uint32_t const Header::NO_SAMPLE;
+
+std::vector<uint32_t> Header::sampleIndicesOf(Header const& source) const {
+    std::vector<uint32_t> rv;
+    rv.reserve(source._sampleNames.size());
+    for (auto i = source._sampleNames.begin(); i != source._sampleNames.end(); ++i) {
+        auto found = _sampleIndices.find(*i);
+        rv.push_back(found == _sampleIndices.end() ? NO_SAMPLE : found->second);
+    }
+    return rv;
+}
+
 bool Header::empty() const {
     return _metaInfoLines.empty();
 }
@@ -258,6 +317,20 @@ HeaderMap<std::string, std::string>::type const& Header::filters() const {
     return _filters;
 }
 
+FilterSet::Id Header::filterId(char const* beg, char const* end) const {
+    size_t len = end - beg;
+    if (len == 4 && memcmp(beg, "PASS", 4) == 0)
+        return FilterSet::PASS;
+
+    // headers declare a handful of filters, a linear scan beats hashing
+    for (auto i = _filterIds.begin(); i != _filterIds.end(); ++i) {
+        if (i->first.size() == len && memcmp(beg, i->first.data(), len) == 0)
+            return i->second;
+    }
+
+    return FilterSet::id(beg, end);
+}
+
 HeaderMap<std::string, SampleTag>::type const& Header::sampleTags() const {
     return _sampleTags;
 }
@@ -282,6 +355,7 @@ size_t Header::addSample(std::string const& name) {
     size_t idx = _sampleNames.size();
     _sampleIndices[name] = idx;
     _sampleNames.push_back(name);
+    _text.reset();
     return idx;
 }
 
@@ -342,6 +416,7 @@ void Header::renameSamples(boost::unordered_map<std::string, std::string> const&
     _sampleTags.swap(newSampleTags);
 
     rebuildSampleIndex();
+    _text.reset();
 }
 
 void Header::rebuildSampleIndex() {
@@ -352,15 +427,55 @@ void Header::rebuildSampleIndex() {
     }
 }
 
-std::ostream& operator<<(std::ostream& s, const Vcf::Header& h) {
-    const vector<Vcf::Header::RawLine>& mlines = h.metaInfoLines();
-    for (auto i = mlines.begin(); i != mlines.end(); ++i)
-        s << "##" << i->first << "=" << i->second << "\n";
+Bcf2Dictionary const& Header::bcf2Dictionary() const {
+    return _bcf2Dictionary.get([this]() { return buildBcf2Dictionary(); });
+}
 
-    if (!h.headerLine().empty())
-        s << '#' << h.headerLine() << "\n";
+Bcf2Dictionary Header::buildBcf2Dictionary() const {
+    Bcf2Dictionary rv;
+    for (auto i = _metaInfoLines.begin(); i != _metaInfoLines.end(); ++i)
+        rv.add(i->first, i->second);
+    return rv;
+}
+
+std::string const& Header::text() const {
+    return _text.get([this]() { return buildText(); });
+}
+
+std::string Header::buildText() const {
+    std::string text;
+    size_t size = 0;
+    for (auto i = _metaInfoLines.begin(); i != _metaInfoLines.end(); ++i)
+        size += i->first.size() + i->second.size() + 4;
+    for (auto i = _sampleNames.begin(); i != _sampleNames.end(); ++i)
+        size += i->size() + 1;
+    text.reserve(size + 64);
+
+    for (auto i = _metaInfoLines.begin(); i != _metaInfoLines.end(); ++i) {
+        text += "##";
+        text += i->first;
+        text += '=';
+        text += i->second;
+        text += '\n';
+    }
+
+    text += '#';
+    text += expectedHeaderFields[0];
+    for (unsigned i = 1; i < nExpectedHeaderFields; ++i) {
+        text += '\t';
+        text += expectedHeaderFields[i];
+    }
+    for (auto i = _sampleNames.begin(); i != _sampleNames.end(); ++i) {
+        text += '\t';
+        text += *i;
+    }
+    text += '\n';
 
-    return s;
+    return text;
+}
+
+std::ostream& operator<<(std::ostream& s, const Vcf::Header& h) {
+    return s << h.text();
 }
 
 END_NAMESPACE(Vcf)
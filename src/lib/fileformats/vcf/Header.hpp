@@ -1,10 +1,14 @@
 #pragma once
 
+#include "Bcf2Dictionary.hpp"
 #include "CustomType.hpp"
+#include "FilterSet.hpp"
 #include "SampleTag.hpp"
+#include "common/SharedCache.hpp"
 #include "common/namespaces.hpp"
 
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include <cstdlib>
 #include <iostream>
@@ -57,6 +61,8 @@ public:
     void add(std::string const& line);
     void addFilter(std::string const& name, std::string const& desc);
     void addInfoType(CustomType const& type);
+    // Removes the INFO type with the given id, and its meta-info line
+    void removeInfoType(std::string const& id);
     void addFormatType(CustomType const& type);
     void addSampleTag(SampleTag const& tag);
     void merge(const Header& other, bool allowDuplicateSamples = false);
@@ -64,6 +70,10 @@ public:
 
     const std::vector<RawLine>& metaInfoLines() const;
     std::string headerLine() const;
+    // The header as written to a vcf file. It is built on first use after
+    // any change and kept; several threads may ask for it at once, as long
+    // as none of them is modifying the header.
+    std::string const& text() const;
     // infoType/formatType return NULL for non-existing ids
     CustomType const* infoType(std::string const& id) const;
     CustomType const* formatType(std::string const& id) const;
@@ -71,7 +81,13 @@ public:
     HeaderMap<std::string, CustomType>::type const& infoTypes() const;
     HeaderMap<std::string, CustomType>::type const& formatTypes() const;
     HeaderMap<std::string, std::string>::type const& filters() const;
+    // The FilterSet id of the named filter. Filters declared in the header
+    // are found without touching the (locked) global registry.
+    FilterSet::Id filterId(char const* beg, char const* end) const;
     HeaderMap<std::string, SampleTag>::type const& sampleTags() const;
+    // The indices BCF2 records use for ids and contigs. Built from the meta
+    // info lines on first use after any change, like text().
+    Bcf2Dictionary const& bcf2Dictionary() const;
     std::vector<std::string> const& sampleNames() const;
 
     uint32_t sampleCount() const { return _sampleNames.size(); }
@@ -79,6 +95,11 @@ public:
     // throws when sampleName is not found
     uint32_t sampleIndex(std::string const& sampleName) const;
 
+    static uint32_t const NO_SAMPLE = uint32_t(-1);
+    // The index in this header of each of source's samples, or NO_SAMPLE
+    // for those it does not have
+    std::vector<uint32_t> sampleIndicesOf(Header const& source) const;
+
     void sourceIndex(uint32_t value) { _sourceIndex = value; }
     uint32_t sourceIndex() const { return _sourceIndex; }
 
@@ -103,15 +124,24 @@ public:
 
 protected:
     void parseHeaderLine(std::string const& line);
+    void addMetaInfoLine(RawLine const& line);
     size_t addSample(std::string const& name);
     void rebuildSampleIndex();
+    std::string buildText() const;
+    Bcf2Dictionary buildBcf2Dictionary() const;
 
 protected:
     HeaderMap<std::string, CustomType>::type _infoTypes;
     HeaderMap<std::string, CustomType>::type _formatTypes;
     // filters = name -> description
     HeaderMap<std::string, std::string>::type _filters;
+    // declared filter name -> FilterSet id, in header order
+    std::vector<std::pair<std::string, FilterSet::Id>> _filterIds;
     std::vector<RawLine> _metaInfoLines;
+    // the distinct lines in _metaInfoLines, so merging does not scan them
+    boost::unordered_set<RawLine> _metaInfoLineSet;
+    // see bcf2Dictionary()
+    SharedCache<Bcf2Dictionary> _bcf2Dictionary;
     std::vector<SampleName> _sampleNames;
     HeaderMap<SampleName, SampleTag>::type _sampleTags;
     bool _headerSeen;
@@ -127,6 +157,9 @@ protected:
 
     HeaderMap<SampleName, size_t>::type _sampleIndices;
     bool _hasDuplicateSamples;
+
+    // see text()
+    SharedCache<std::string> _text;
 };
 
 std::ostream& operator<<(std::ostream& s, Header const& h);
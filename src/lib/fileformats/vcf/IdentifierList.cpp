@@ -0,0 +1,126 @@
+#include "IdentifierList.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+BEGIN_NAMESPACE(Vcf)
+
+namespace {
+    // Same ordering as std::string::compare
+    int compare(StringView const& a, StringView const& b) {
+        size_t n = std::min(a.size(), b.size());
+        int rv = n ? memcmp(a.begin(), b.begin(), n) : 0;
+        if (rv != 0)
+            return rv;
+        return a.size() < b.size() ? -1 : a.size() > b.size() ? 1 : 0;
+    }
+}
+
+void IdentifierList::assign(char const* beg, char const* end) {
+    // The ids in a file are usually already sorted (most often there is
+    // just one), in which case the column can be taken as it is.
+    size_type count = 0;
+    StringView prev;
+    for (char const* p = beg; p != end; ) {
+        char const* stop = std::find(p, end, ';');
+        StringView cur(p, stop);
+        if (cur.empty() || (count > 0 && compare(prev, cur) >= 0)) {
+            clear();
+            for (char const* q = beg; q != end; ) {
+                char const* qstop = std::find(q, end, ';');
+                insert(StringView(q, qstop));
+                q = qstop == end ? end : qstop + 1;
+            }
+            return;
+        }
+        prev = cur;
+        ++count;
+        p = stop == end ? end : stop + 1;
+    }
+
+    _text.assign(beg, end);
+    _count = count;
+}
+
+IdentifierList::const_iterator IdentifierList::find(StringView const& id, bool& found) const {
+    found = false;
+    const_iterator i = begin();
+    for (; i != end(); ++i) {
+        int cmp = compare(*i, id);
+        if (cmp >= 0) {
+            found = cmp == 0;
+            break;
+        }
+    }
+    return i;
+}
+
+bool IdentifierList::contains(StringView const& id) const {
+    bool found;
+    find(id, found);
+    return found;
+}
+
+void IdentifierList::insert(StringView const& id) {
+    // empty ids are not representable (and not valid vcf)
+    if (id.empty())
+        return;
+
+    bool found;
+    const_iterator pos = find(id, found);
+    if (found)
+        return;
+
+    if (pos == end()) {
+        if (!_text.empty())
+            _text += ';';
+        _text.append(id.begin(), id.end());
+    }
+    else {
+        size_t offset = pos->begin() - _text.data();
+        _text.insert(offset, 1, ';');
+        _text.insert(offset, id.begin(), id.size());
+    }
+    ++_count;
+}
+
+void IdentifierList::insert(std::string const& id) {
+    insert(StringView(id.data(), id.data() + id.size()));
+}
+
+void IdentifierList::insert(IdentifierList const& other) {
+    if (&other == this)
+        return;
+
+    if (empty()) {
+        *this = other;
+        return;
+    }
+
+    for (auto i = other.begin(); i != other.end(); ++i)
+        insert(*i);
+}
+
+void IdentifierList::clear() {
+    _text.clear();
+    _count = 0;
+}
+
+void IdentifierList::swap(IdentifierList& other) {
+    _text.swap(other._text);
+    std::swap(_count, other._count);
+}
+
+bool IdentifierList::operator==(IdentifierList const& rhs) const {
+    return _count == rhs._count && _text == rhs._text;
+}
+
+bool IdentifierList::operator!=(IdentifierList const& rhs) const {
+    return !(*this == rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, IdentifierList const& ids) {
+    return os << ids.str();
+}
+
+END_NAMESPACE(Vcf)
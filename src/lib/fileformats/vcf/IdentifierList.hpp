@@ -0,0 +1,134 @@
+#pragma once
+
+#include "common/StringView.hpp"
+#include "common/cstdint.hpp"
+#include "common/namespaces.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <string>
+
+BEGIN_NAMESPACE(Vcf)
+
+// The ID column of a vcf entry.
+//
+// The identifiers are kept sorted and without duplicates (as they were when
+// this was a std::set<std::string>), stored as the text of the column: a
+// single string with the ids separated by ';'. Since an id can't contain a
+// ';', the separators themselves mark where each id begins and ends. Most
+// entries have zero or one id, so this is one small (often inline) string
+// rather than a tree of separately allocated nodes. Empty ids are dropped.
+class IdentifierList {
+public:
+    typedef uint32_t size_type;
+
+    // Iterates over the ids, yielding StringViews into the list
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef StringView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef StringView const* pointer;
+        typedef StringView const& reference;
+
+        const_iterator()
+            : _end(0)
+        {}
+
+        const_iterator(char const* pos, char const* end)
+            : _end(end)
+        {
+            set(pos);
+        }
+
+        StringView const& operator*() const { return _cur; }
+        StringView const* operator->() const { return &_cur; }
+
+        const_iterator& operator++() {
+            set(_cur.end() == _end ? _end : _cur.end() + 1);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator rv(*this);
+            ++*this;
+            return rv;
+        }
+
+        bool operator==(const_iterator const& rhs) const { return _cur.begin() == rhs._cur.begin(); }
+        bool operator!=(const_iterator const& rhs) const { return !(*this == rhs); }
+
+    private:
+        void set(char const* pos);
+
+    private:
+        char const* _end;
+        StringView _cur;
+    };
+    typedef const_iterator iterator;
+
+    IdentifierList()
+        : _count(0)
+    {}
+
+    // Replaces the contents with the ';' separated ids in [beg, end)
+    void assign(char const* beg, char const* end);
+
+    bool empty() const { return _count == 0; }
+    size_type size() const { return _count; }
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // The ids as they appear in the ID column (empty if there are none)
+    std::string const& str() const { return _text; }
+
+    bool contains(StringView const& id) const;
+
+    void insert(StringView const& id);
+    void insert(std::string const& id);
+    // Adds every id in other
+    void insert(IdentifierList const& other);
+    void clear();
+    void swap(IdentifierList& other);
+
+    bool operator==(IdentifierList const& rhs) const;
+    bool operator!=(IdentifierList const& rhs) const;
+
+private:
+    // The first id not less than the given one
+    const_iterator find(StringView const& id, bool& found) const;
+
+private:
+    std::string _text;
+    size_type _count;
+};
+
+std::ostream& operator<<(std::ostream& os, IdentifierList const& ids);
+
+inline
+void IdentifierList::const_iterator::set(char const* pos) {
+    if (pos == _end) {
+        _cur.assign(_end, _end);
+        return;
+    }
+
+    char const* stop = pos;
+    while (stop != _end && *stop != ';')
+        ++stop;
+    _cur.assign(pos, stop);
+}
+
+inline
+IdentifierList::const_iterator IdentifierList::begin() const {
+    char const* end = _text.data() + _text.size();
+    return const_iterator(_text.data(), end);
+}
+
+inline
+IdentifierList::const_iterator IdentifierList::end() const {
+    char const* end = _text.data() + _text.size();
+    return const_iterator(end, end);
+}
+
+END_NAMESPACE(Vcf)
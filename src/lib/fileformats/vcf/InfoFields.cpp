@@ -5,8 +5,7 @@
 
 #include <boost/format.hpp>
 
-#include <iterator>
-#include <vector>
+#include <algorithm>
 
 BEGIN_NAMESPACE(Vcf)
 
@@ -14,23 +13,28 @@ BEGIN_NAMESPACE(Vcf)
 InfoFields::InfoFields(Header const& h, std::string const& s, std::size_t numAlts) {
     using boost::format;
 
-    std::vector<std::string> infoStrings;
-    auto beg = s.c_str();
-    auto end = beg + s.size();
+    if (s.empty() || s == ".")
+        return;
 
-    if (beg != end && s != ".")
-        Tokenizer<char>::split(beg, end, ';', std::back_inserter(infoStrings));
+    thread_local DelimiterIndex delims;
+    delims.index(s.data(), s.data() + s.size());
+    Tokenizer<char> tok(delims, ';');
+    char const* beg(0);
+    char const* end(0);
+    std::string key;
+    std::string value;
 
-
-    for (auto i = infoStrings.begin(); i != infoStrings.end(); ++i) {
-        if (i->empty())
+    while (tok.extract(&beg, &end)) {
+        if (beg == end)
             continue;
 
-        Tokenizer<char> kv(*i, '=');
-        std::string key;
-        std::string value;
-        kv.extract(key);
-        kv.remaining(value);
+        char const* eq = std::find(beg, end, '=');
+        key.assign(beg, eq);
+        if (eq != end)
+            value.assign(eq + 1, end);
+        else
+            value.clear();
+
         CustomType const* type = h.infoType(key);
         if (type == NULL) {
             throw std::runtime_error(str(format(
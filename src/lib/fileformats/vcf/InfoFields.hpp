@@ -19,6 +19,7 @@ class InfoFields {
 public:
     typedef std::map<std::string, CustomValue> MapType;
 
+    InfoFields() {}
     InfoFields(Header const& h, std::string const& s, std::size_t numAlts);
     MapType const& operator*() const;
     MapType& operator*();
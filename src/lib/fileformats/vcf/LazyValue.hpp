@@ -84,6 +84,21 @@ public:
         data_.reset();
     }
 
+    // Discards any text and constructs the value directly, for when it
+    // never existed as text in the first place
+    template<typename... Args>
+    T& emplace(Args&&... args) {
+        text_.clear();
+        data_ = std::make_unique<T>(std::forward<Args>(args)...);
+        return *data_;
+    }
+
+    // Replaces the text (reusing its storage) and discards any parsed value
+    void assign(char const* beg, char const* end) {
+        text_.assign(beg, end);
+        data_.reset();
+    }
+
     friend std::ostream& operator<<(std::ostream& os, LazyValue const& x) {
         if (x.data_) {
             os << *x.data_;
@@ -8,6 +8,7 @@
 #include <boost/bind.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <set>
 #include <stdexcept>
@@ -17,7 +18,7 @@ using namespace std;
 
 BEGIN_NAMESPACE(Vcf)
 
-typedef ValueMergers::Base::FetchFunc FetchFunc;
+size_t const MergeStrategy::npos;
 
 // parse a file with lines of the form: <info field id> = <strategy>, e.g.:
 // DP=sum
@@ -66,6 +67,19 @@ MergeStrategy::MergeStrategy(
     , _samplePriority(samplePriority)
     , _exactPos(false)
 {
+    vector<string> ids;
+    auto const& types = _header->infoTypes();
+    for (auto i = types.begin(); i != types.end(); ++i)
+        ids.push_back(i->first);
+    sort(ids.begin(), ids.end());
+
+    const CustomValue* (Entry::*fetchInfo)(const string&) const = &Entry::info;
+    for (auto i = ids.begin(); i != ids.end(); ++i) {
+        _infoPlanIndex[*i] = _infoPlan.size();
+        InfoMergePlan plan = {*i, _header->infoType(*i), 0, boost::bind(fetchInfo, _1, *i)};
+        _infoPlan.push_back(plan);
+    }
+
     setDefaultMerger("ignore");
 }
 
@@ -116,6 +130,7 @@ uint32_t MergeStrategy::primarySampleStreamIndex() const {
 
 void MergeStrategy::setDefaultMerger(const std::string& mergerName) {
     _default = _registry->getMerger(mergerName);
+    updateInfoPlan();
 }
 
 void MergeStrategy::setMerger(const std::string& id, const std::string& mergerName) {
@@ -131,11 +146,18 @@ void MergeStrategy::setMerger(const std::string& id, const std::string& mergerNa
     if (!inserted.second) {
         inserted.first->second = merger;
     }
+
+    size_t idx = infoPlanIndex(id);
+    if (idx != npos)
+        _infoPlan[idx].merger = merger;
+}
+
+void MergeStrategy::updateInfoPlan() {
+    for (auto i = _infoPlan.begin(); i != _infoPlan.end(); ++i)
+        i->merger = infoMerger(i->id);
 }
 
 const ValueMergers::Base* MergeStrategy::infoMerger(const string& which) const {
-    const CustomValue* (Entry::*fetchInfo)(const string&) const = &Entry::info;
-    FetchFunc fetch = boost::bind(fetchInfo, _1, which);
     const CustomType* type = _header->infoType(which);
     if (!type)
         throw runtime_error(str(format("Unknown datatype for info field '%1%'") %which));
@@ -153,18 +175,34 @@ const ValueMergers::Base* MergeStrategy::infoMerger(const string& which) const {
 
 CustomValue MergeStrategy::mergeInfo(
         const string& which,
-        const Entry* begin,
-        const Entry* end,
+        Entry const* const* begin,
+        Entry const* const* end,
         AltIndices const& newAltIndices) const
 {
-    const CustomValue* (Entry::*fetchInfo)(const string&) const = &Entry::info;
-    FetchFunc fetch = boost::bind(fetchInfo, _1, which);
-    const CustomType* type = _header->infoType(which);
-    if (!type)
+    size_t idx = infoPlanIndex(which);
+    if (idx == npos)
         throw runtime_error(str(format("Unknown datatype for info field '%1%'") %which));
 
-    const ValueMergers::Base* merger = infoMerger(which);
-    return (*merger)(type, fetch, begin, end, newAltIndices);
+    return mergeInfo(idx, begin, end, newAltIndices);
+}
+
+CustomValue MergeStrategy::mergeInfo(
+        size_t planIndex,
+        Entry const* const* begin,
+        Entry const* const* end,
+        AltIndices const& newAltIndices) const
+{
+    InfoMergePlan const& plan = _infoPlan[planIndex];
+    return (*plan.merger)(plan.type, plan.fetch, begin, end, newAltIndices);
+}
+
+vector<MergeStrategy::InfoMergePlan> const& MergeStrategy::infoPlan() const {
+    return _infoPlan;
+}
+
+size_t MergeStrategy::infoPlanIndex(string const& id) const {
+    auto found = _infoPlanIndex.find(id);
+    return found == _infoPlanIndex.end() ? npos : found->second;
 }
 
 ConsensusFilter const* MergeStrategy::consensusFilter() const {
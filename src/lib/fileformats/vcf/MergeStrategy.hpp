@@ -4,6 +4,8 @@
 #include "ValueMergers.hpp"
 #include "common/namespaces.hpp"
 
+#include <boost/unordered_map.hpp>
+
 #include <cstddef>
 #include <map>
 #include <string>
@@ -28,6 +30,19 @@ class MergeStrategy {
 public:
     typedef AlleleMerger::AltIndices AltIndices;
 
+    /// How to merge one of the merged header's info fields. The plan holds
+    /// one of these for each info type in the header, made when the strategy
+    /// is created and kept up to date by setMerger and setDefaultMerger, so
+    /// that merging entries needs no lookups by name beyond infoPlanIndex.
+    struct InfoMergePlan {
+        std::string id;
+        CustomType const* type;
+        ValueMergers::Base const* merger;
+        ValueMergers::Base::FetchFunc fetch;
+    };
+
+    static std::size_t const npos = std::size_t(-1);
+
     enum SamplePriority {
         eORDER,
         eUNFILTERED,
@@ -46,7 +61,8 @@ public:
     void parse(InputStream& description);
 
     /// Create a new empty merge strategy for the given header
-    /// \param header a merged vcf header
+    /// \param header a merged vcf header, with all of its info types added
+    ///   (the merge plan is built from them here)
     /// \param samplePriority type of samples to prefer
     MergeStrategy(
         const Header* header,
@@ -63,17 +79,31 @@ public:
 
     /// Merge the info field specified by 'which' in the given range of entries
     /// \param which the name of the info field to merge
-    /// \param begin the beginning of the range of entries to merge
-    /// \param end the end of the range of entries to merge
+    /// \param begin the beginning of the range of pointers to the entries to merge
+    /// \param end the end of the range of pointers to the entries to merge
     /// \return a CustomValue object representing the result of the merge
     /// \exception runtime_error thrown if the info field is invalid, or if no action can
     ///   be found to handle the field named by 'which'
     CustomValue mergeInfo(
             const std::string& which,
-            const Entry* begin,
-            const Entry* end,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices) const;
 
+    /// Merge the info field at the given position of infoPlan()
+    CustomValue mergeInfo(
+            std::size_t planIndex,
+            Entry const* const* begin,
+            Entry const* const* end,
+            AltIndices const& newAltIndices) const;
+
+    /// \return the merge plan, ordered by info field id
+    std::vector<InfoMergePlan> const& infoPlan() const;
+
+    /// \return the position in infoPlan() of the named info field, or npos
+    ///   if the header has no such field
+    std::size_t infoPlanIndex(std::string const& id) const;
+
     /// Set the handler for the info field
     /// \param id the name of the info field to set the action for
     /// \param the name of the action to set. actions are defined in ValueMergers.hpp.
@@ -104,6 +134,9 @@ public:
     // \return the sample priority method, (order, unfiltered, or filtered)
     SamplePriority samplePriority() const;
 
+protected:
+    void updateInfoPlan();
+
 protected:
     /// The merged Vcf header for the final output file
     const Header* _header;
@@ -120,6 +153,9 @@ protected:
     ConsensusFilter const* _cnsFilt;
     SamplePriority _samplePriority;
     bool _exactPos;
+
+    std::vector<InfoMergePlan> _infoPlan;
+    boost::unordered_map<std::string, std::size_t> _infoPlanIndex;
 };
 
 END_NAMESPACE(Vcf)
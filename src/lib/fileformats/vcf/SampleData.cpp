@@ -1,5 +1,6 @@
 #include "SampleData.hpp"
 
+#include "Bcf2.hpp"
 #include "CustomType.hpp"
 #include "CustomValue.hpp"
 #include "GenotypeCall.hpp"
@@ -76,13 +77,20 @@ SampleData::SampleData(Header const* h, std::string const& raw) {
 void SampleData::parse(Header const* h, std::string const& raw) {
     _header = h;
 
-    Tokenizer<char> tok(raw, '\t');
+    if (Bcf2::isRecord(raw)) {
+        parseBcf2(raw);
+        return;
+    }
+
+    thread_local DelimiterIndex delims;
+    delims.index(raw.data(), raw.data() + raw.size());
+    Tokenizer<char> tok(delims, '\t');
     char const* beg(0);
     char const* end(0);
 
     vector<string> fmt;
     if (tok.extract(&beg, &end) && (end - beg != 1 || *beg != '.')) {
-        Tokenizer<char>::split(beg, end, ':', back_inserter(fmt));
+        Tokenizer<char>::split(delims, beg, end, ':', back_inserter(fmt));
 
         _format.reserve(fmt.size());
         for (auto i = fmt.begin(); i != fmt.end(); ++i) {
@@ -94,29 +102,98 @@ void SampleData::parse(Header const* h, std::string const& raw) {
     }
 
     uint32_t sampleIdx(0);
+    string field;
     while (tok.extract(&beg, &end)) {
-        vector<string> data;
-
         // allow trailing tabs because our data has some :/
         if (tok.eof() && end-beg == 0)
             break;
 
         if (end-beg != 1 || *beg != '.') {
-            Tokenizer<char>::split(beg, end, ':', back_inserter(data));
-
-            if (data.size() > _format.size())
-                throw runtime_error("More per-sample values than described in format section");
+            Tokenizer<char> fields(delims, beg, end, ':');
 
             std::auto_ptr<ValueVector> values(new ValueVector);
-            values->resize(data.size());
-            for (uint32_t i = 0; i < data.size(); ++i) {
-                (*values)[i] = CustomValue(_format[i], data[i]);
+            values->reserve(_format.size());
+            while (fields.extract(field)) {
+                if (values->size() == _format.size())
+                    throw runtime_error("More per-sample values than described in format section");
+
+                values->push_back(CustomValue(_format[values->size()], field));
             }
             _values.insert(make_pair(sampleIdx, values.release()));
         }
         ++sampleIdx;
     }
 
+    mirrorSamples();
+
+    if (sampleIdx > _header->sampleNames().size()) {
+        throw runtime_error(str(boost::format(
+            "More samples than described in VCF header (%1% vs %2%)."
+            ) %sampleIdx %_header->sampleNames().size()));
+    }
+}
+
+void SampleData::parseBcf2(std::string const& raw) {
+    Bcf2Dictionary const& dict = _header->bcf2Dictionary();
+    Bcf2::Reader in(raw.data() + 1, raw.data() + raw.size());
+
+    uint32_t nFmtSample = in.uint32();
+    uint32_t nFmt = nFmtSample >> 24;
+    uint32_t nSample = nFmtSample & 0xffffff;
+
+    if (nSample > _header->sampleNames().size()) {
+        throw runtime_error(str(boost::format(
+            "More samples than described in VCF header (%1% vs %2%)."
+            ) %nSample %_header->sampleNames().size()));
+    }
+
+    // BCF stores each FORMAT field for all samples together
+    vector<ValueVector> samples(nSample);
+    string gt;
+    _format.reserve(nFmt);
+    for (uint32_t i = 0; i < nFmt; ++i) {
+        int32_t key = in.typedInt();
+        string const* name = dict.string(key);
+        if (!name) {
+            throw runtime_error(str(boost::format(
+                "Undeclared FORMAT index %1% in BCF2 record") % key));
+        }
+
+        appendFormatField(*name);
+        CustomType const* type = _format.back();
+        bool isGenotype = *name == "GT";
+        Bcf2::TypeDescriptor td = in.descriptor();
+        for (auto s = samples.begin(); s != samples.end(); ++s) {
+            s->push_back(CustomValue(type));
+            if (isGenotype) {
+                Bcf2::decodeGenotype(in, td, gt);
+                if (!gt.empty())
+                    s->back().setRaw(vector<CustomValue::ValueType>(1, gt));
+            }
+            else {
+                Bcf2::decodeValue(in, td, s->back());
+            }
+        }
+    }
+
+    if (!in.atEnd())
+        throw runtime_error("Inconsistent per-sample data length in BCF2 record");
+
+    // Trailing missing fields are left off, as they are in text, and
+    // samples with nothing at all are left out
+    for (uint32_t i = 0; i < nSample; ++i) {
+        ValueVector& values = samples[i];
+        while (!values.empty() && values.back().empty())
+            values.pop_back();
+
+        if (!values.empty())
+            _values.insert(_values.end(), make_pair(i, new ValueVector(std::move(values))));
+    }
+
+    mirrorSamples();
+}
+
+void SampleData::mirrorSamples() {
     auto const& mirrored = _header->mirroredSamples();
     for (auto i = mirrored.begin(); i != mirrored.end(); ++i) {
         size_t targetIdx = i->first;
@@ -129,13 +206,6 @@ void SampleData::parse(Header const* h, std::string const& raw) {
                 throw runtime_error("Internal error: column mirroring.");
         }
     }
-
-
-    if (sampleIdx > _header->sampleNames().size()) {
-        throw runtime_error(str(boost::format(
-            "More samples than described in VCF header (%1% vs %2%)."
-            ) %sampleIdx %_header->sampleNames().size()));
-    }
 }
 
 SampleData::SampleData(Header const* h, FormatType&& fmt, MapType&& values)
@@ -185,6 +255,27 @@ void SampleData::reheader(Header const* newHeader) {
     _values.swap(newData);
 }
 
+void SampleData::reheader(Header const* newHeader, std::vector<uint32_t> const& newIndices) {
+    if (!newHeader)
+        throw runtime_error("Attempted to reheader Vcf SampleData with null header!");
+
+    // Samples usually keep their order in the new header, making each
+    // insertion at the end constant time
+    MapType newData;
+    for (auto i = _values.begin(); i != _values.end(); ++i) {
+        uint32_t newIdx = i->first < newIndices.size() ? newIndices[i->first] : Header::NO_SAMPLE;
+        if (newIdx == Header::NO_SAMPLE) {
+            // throws the usual error
+            newIdx = newHeader->sampleIndex(header().sampleNames()[i->first]);
+        }
+        auto slot = newData.insert(newData.end(), make_pair(newIdx, static_cast<ValueVector*>(0)));
+        std::swap(slot->second, i->second);
+    }
+
+    _header = newHeader;
+    _values.swap(newData);
+}
+
 void SampleData::clear() {
     _header = 0;
     _format.clear();
@@ -324,11 +415,7 @@ GenotypeCall const& SampleData::genotype(uint32_t sampleIdx) const {
     if (!v || v->empty() || (gtString = v->get<string>(0)) == 0 || gtString->empty())
         return GenotypeCall::Null;
 
-    auto inserted = _gtCache.insert(make_pair(*gtString, GenotypeCall()));
-    // if it wasn't already in the cache
-    if (inserted.second)
-        inserted.first->second = GenotypeCall(*gtString);
-    return inserted.first->second;
+    return GenotypeCall::intern(*gtString);
 }
 
 uint32_t SampleData::samplesWithData() const {
@@ -438,7 +525,7 @@ void SampleData::renumberGT(std::map<size_t, size_t> const& altMap) {
         if (gtStr == 0)
             continue;
 
-        GenotypeCall old(*gtStr);
+        GenotypeCall const& old = GenotypeCall::intern(*gtStr);
         char delim = old.phased() ? '|' : '/';
         stringstream newss;
         for (auto alt = old.begin(); alt != old.end(); ++alt) {
@@ -4,10 +4,9 @@
 #include "common/namespaces.hpp"
 #include "common/cstdint.hpp"
 
-#include <boost/unordered_map.hpp>
-
 #include <map>
 #include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -36,6 +35,9 @@ public:
 
     Header const& header() const;
     void reheader(Header const* newHeader);
+    // As above, with newIndices[i] the index in newHeader of sample i of
+    // the current header (as given by newHeader->sampleIndicesOf)
+    void reheader(Header const* newHeader, std::vector<uint32_t> const& newIndices);
 
     void clear();
     void swap(SampleData& other);
@@ -76,6 +78,10 @@ public:
     int appendFormatFieldIfNotExists(std::string const& key);
 
 protected:
+    // parse() for the per-sample part of a BCF2 record, as set up by Entry
+    void parseBcf2(std::string const& raw);
+    // Points mirrored sample columns at the data they mirror
+    void mirrorSamples();
     int appendFormatField(std::string const& key);
     void freeValues();
 
@@ -83,8 +89,6 @@ protected:
     Header const* _header;
     std::vector<CustomType const*> _format;
     MapType _values;
-
-    mutable boost::unordered_map<std::string, GenotypeCall> _gtCache;
 };
 
 std::ostream& operator<<(std::ostream& s, SampleData const& sampleData);
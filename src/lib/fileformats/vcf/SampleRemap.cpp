@@ -0,0 +1,19 @@
+#include "SampleRemap.hpp"
+#include "Header.hpp"
+
+BEGIN_NAMESPACE(Vcf)
+
+SampleRemap::SampleRemap(Header const* target)
+    : target_(target)
+{
+}
+
+std::vector<uint32_t> const& SampleRemap::operator()(Header const& source) {
+    auto& table = tables_[&source];
+    // the source may have gained (e.g., mirrored) samples since we saw it
+    if (table.size() != source.sampleCount())
+        table = target_->sampleIndicesOf(source);
+    return table;
+}
+
+END_NAMESPACE(Vcf)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+#include "common/namespaces.hpp"
+
+#include <boost/unordered_map.hpp>
+
+#include <vector>
+
+BEGIN_NAMESPACE(Vcf)
+
+class Header;
+
+// Remembers where the samples of each source header seen are in a target
+// header, so that reheadering entries to the target moves sample data
+// without looking up sample names. The headers must outlive this object,
+// and the target must not change once it is in use. Not thread safe: give
+// each thread its own.
+class SampleRemap {
+public:
+    explicit SampleRemap(Header const* target);
+
+    Header const* target() const {
+        return target_;
+    }
+
+    // The index in the target of each of source's samples (see
+    // Header::sampleIndicesOf)
+    std::vector<uint32_t> const& operator()(Header const& source);
+
+private:
+    Header const* target_;
+    boost::unordered_map<Header const*, std::vector<uint32_t>> tables_;
+};
+
+END_NAMESPACE(Vcf)
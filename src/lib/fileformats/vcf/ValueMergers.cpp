@@ -66,13 +66,13 @@ const Registry* Registry::getInstance() {
 
 CustomValue UseFirst::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
-    const CustomValue* v(fetch(begin));
+    const CustomValue* v(fetch(*begin));
     if (!v)
         return CustomValue();
     return *v;
@@ -80,14 +80,14 @@ CustomValue UseFirst::operator()(
 
 CustomValue UseEarliest::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
     for (; begin != end; ++begin) {
-        const CustomValue* v(fetch(begin));
+        const CustomValue* v(fetch(*begin));
         if (v) {
             return *v;
         }
@@ -97,9 +97,9 @@ CustomValue UseEarliest::operator()(
 
 CustomValue UniqueConcat::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
@@ -107,7 +107,7 @@ CustomValue UniqueConcat::operator()(
         // find first non-null entry
         const CustomValue* v(NULL);
         while (!v && begin != end)
-            v = fetch(begin++);
+            v = fetch(*begin++);
         if (!v)
             return rv;
 
@@ -115,8 +115,8 @@ CustomValue UniqueConcat::operator()(
         set<string> seen;
         for (CustomValue::SizeType i = 0; i < v->size(); ++i)
             seen.insert(v->getString(i));
-        for (Entry const* e = begin; e != end; ++e) {
-            const CustomValue *v = fetch(e);
+        for (auto e = begin; e != end; ++e) {
+            const CustomValue *v = fetch(*e);
             if (v) {
                 for (CustomValue::SizeType i = 0; i < v->size(); ++i) {
                     string s = v->getString(i);
@@ -132,15 +132,15 @@ CustomValue UniqueConcat::operator()(
 
 CustomValue EnforceEquality::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
     CustomValue rv;
-    for (Entry const* e = begin; e != end; ++e) {
-        const CustomValue* v = fetch(e);
+    for (auto e = begin; e != end; ++e) {
+        const CustomValue* v = fetch(*e);
         if (!v)
             continue;
         if (rv.empty())
@@ -155,16 +155,16 @@ CustomValue EnforceEquality::operator()(
 
 CustomValue EnforceEqualityUnordered::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
     CustomValue rv;
     boost::unordered_set<std::string> values;
-    for (Entry const* e = begin; e != end; ++e) {
-        const CustomValue* v = fetch(e);
+    for (auto e = begin; e != end; ++e) {
+        const CustomValue* v = fetch(*e);
         if (!v)
             continue;
 
@@ -182,15 +182,15 @@ CustomValue EnforceEqualityUnordered::operator()(
 
 CustomValue Sum::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
     CustomValue rv(type);
-    for (Entry const* e = begin; e != end; ++e) {
-        const CustomValue* v = fetch(e);
+    for (auto e = begin; e != end; ++e) {
+        const CustomValue* v = fetch(*e);
         if (!v || v->empty())
             continue;
         rv += *v;
@@ -200,9 +200,9 @@ CustomValue Sum::operator()(
 
 CustomValue Ignore::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
@@ -211,9 +211,9 @@ CustomValue Ignore::operator()(
 
 CustomValue PerAltDelimitedList::operator()(
     CustomType const* type,
-    FetchFunc fetch,
-    Entry const* begin,
-    Entry const* end,
+    FetchFunc const& fetch,
+    Entry const* const* begin,
+    Entry const* const* end,
     AltIndices const& newAltIndices
     ) const
 {
@@ -230,8 +230,8 @@ CustomValue PerAltDelimitedList::operator()(
     boost::unordered_map<size_t, std::set<std::string>> newValues;
 
     size_t i(0);
-    for (Entry const* e = begin; e != end; ++e, ++i) {
-        CustomValue const* v = fetch(e);
+    for (auto e = begin; e != end; ++e, ++i) {
+        CustomValue const* v = fetch(*e);
         if (!v || v->empty())
             continue;
 
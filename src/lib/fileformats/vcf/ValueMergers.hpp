@@ -38,15 +38,16 @@ namespace ValueMergers {
         /// \param fetch a functor that will extract the desired CustomValue
         ///   given a Vcf::Entry. For example, this might be an object that
         ///   calls entry->info("DP") to retrieve the depth INFO value
-        /// \param begin the beginning of the range of Vcf::Entry objects to
-        ///   merge
-        /// \param end the end of the range of Vcf::Entry objects to merge
+        /// \param begin the beginning of the range of pointers to the
+        ///   Vcf::Entry objects to merge
+        /// \param end the end of the range of pointers to the Vcf::Entry
+        ///   objects to merge
         /// \return the new merged CustomValue
         virtual CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const = 0;
     };
@@ -82,9 +83,9 @@ namespace ValueMergers {
     struct UseFirst : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "first"; }
@@ -94,9 +95,9 @@ namespace ValueMergers {
     struct UseEarliest : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "earliest"; }
@@ -107,9 +108,9 @@ namespace ValueMergers {
     struct UniqueConcat : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "uniq-concat"; }
@@ -121,9 +122,9 @@ namespace ValueMergers {
     struct EnforceEquality : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "enforce-equal"; }
@@ -134,9 +135,9 @@ namespace ValueMergers {
     struct EnforceEqualityUnordered : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc func,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& func,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "enforce-equal-unordered"; }
@@ -147,9 +148,9 @@ namespace ValueMergers {
     struct Sum : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "sum"; }
@@ -160,9 +161,9 @@ namespace ValueMergers {
     struct Ignore : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "ignore"; }
@@ -171,9 +172,9 @@ namespace ValueMergers {
     struct PerAltDelimitedList : public Base {
         CustomValue operator()(
             CustomType const* type,
-            FetchFunc fetch,
-            Entry const* begin,
-            Entry const* end,
+            FetchFunc const& fetch,
+            Entry const* const* begin,
+            Entry const* const* end,
             AltIndices const& newAltIndices
             ) const;
         std::string name() const { return "per-alt-delimited-list"; }
@@ -0,0 +1,116 @@
+#include "Bcf2LineSource.hpp"
+
+#include "common/Exceptions.hpp"
+#include "common/cstdint.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+    // "BCF" followed by the major version. We read any 2.x minor version.
+    char const magic[] = { 'B', 'C', 'F', 2 };
+
+    uint32_t decodeUint32(char const* p) {
+        unsigned char const* u = reinterpret_cast<unsigned char const*>(p);
+        return uint32_t(u[0])
+            | (uint32_t(u[1]) << 8)
+            | (uint32_t(u[2]) << 16)
+            | (uint32_t(u[3]) << 24);
+    }
+}
+
+char const Bcf2LineSource::RecordMarker;
+std::size_t const Bcf2LineSource::MagicSize;
+
+bool Bcf2LineSource::isBcf2(GZipLineSource& in) {
+    return in.startsWith(magic, sizeof(magic));
+}
+
+Bcf2LineSource::Bcf2LineSource(std::unique_ptr<GZipLineSource> in)
+    : _in(std::move(in))
+    , _headerIdx(0)
+    , _eof(false)
+{
+    readHeader();
+}
+
+void Bcf2LineSource::readExactly(char* dst, std::size_t n) {
+    if (_in->read(dst, n) != n)
+        throw IOError("Unexpected end of file in BCF2 data");
+}
+
+void Bcf2LineSource::readHeader() {
+    char buf[MagicSize];
+    readExactly(buf, MagicSize);
+    if (!std::equal(magic, magic + sizeof(magic), buf))
+        throw IOError("Invalid BCF2 magic number");
+
+    char lenBuf[4];
+    readExactly(lenBuf, sizeof(lenBuf));
+    std::string text(decodeUint32(lenBuf), '\0');
+    if (!text.empty())
+        readExactly(&text[0], text.size());
+
+    // the text is NUL terminated
+    text.erase(std::find(text.begin(), text.end(), '\0'), text.end());
+
+    std::size_t beg = 0;
+    while (beg < text.size()) {
+        std::size_t end = text.find('\n', beg);
+        if (end == std::string::npos)
+            end = text.size();
+        if (end > beg)
+            _headerLines.push_back(text.substr(beg, end - beg));
+        beg = end + 1;
+    }
+}
+
+bool Bcf2LineSource::getline(std::string& line) {
+    line.erase();
+    if (_headerIdx < _headerLines.size()) {
+        line.swap(_headerLines[_headerIdx++]);
+        return true;
+    }
+
+    if (_eof)
+        return false;
+
+    char lengths[8];
+    std::size_t got = _in->read(lengths, sizeof(lengths));
+    if (got == 0) {
+        _eof = true;
+        return false;
+    }
+    if (got != sizeof(lengths))
+        throw IOError("Truncated BCF2 record");
+
+    std::size_t size = std::size_t(decodeUint32(lengths))
+        + decodeUint32(lengths + 4);
+
+    line.resize(1 + sizeof(lengths) + size);
+    line[0] = RecordMarker;
+    std::copy(lengths, lengths + sizeof(lengths), &line[1]);
+    if (_in->read(&line[1 + sizeof(lengths)], size) != size)
+        throw IOError("Truncated BCF2 record");
+
+    return true;
+}
+
+char Bcf2LineSource::peek() {
+    if (_headerIdx < _headerLines.size())
+        return _headerLines[_headerIdx][0];
+
+    return RecordMarker;
+}
+
+bool Bcf2LineSource::eof() const {
+    return _headerIdx == _headerLines.size() && _eof;
+}
+
+bool Bcf2LineSource::good() const {
+    return !eof();
+}
+
+Bcf2LineSource::operator bool() const {
+    return good();
+}
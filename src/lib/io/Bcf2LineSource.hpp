@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ILineSource.hpp"
+#include "GZipLineSource.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Presents a BCF2 file (bgzf compressed or not) as lines so that it can be
+// read through InputStream and TypedStream like text VCF.
+//
+// The header text comes out one line at a time as usual. Each record then
+// comes out as a single "line" holding RecordMarker followed by the raw
+// record: l_shared and l_indiv (4 bytes each, little endian) and the shared
+// and per-sample data. Vcf::Entry recognizes the marker and decodes the
+// record directly rather than parsing it as text.
+class Bcf2LineSource : public ILineSource {
+public:
+    // Never the first byte of a text line, and records are never empty
+    static char const RecordMarker = '\0';
+    static std::size_t const MagicSize = 5;
+
+    // True if in holds BCF2 data. Must be called before reading from in.
+    static bool isBcf2(GZipLineSource& in);
+
+    // Reads the magic number and the header text, throws on failure
+    explicit Bcf2LineSource(std::unique_ptr<GZipLineSource> in);
+
+    operator bool() const;
+    bool getline(std::string& line);
+    char peek();
+    bool eof() const;
+    bool good() const;
+
+private:
+    void readHeader();
+    void readExactly(char* dst, std::size_t n);
+
+private:
+    std::unique_ptr<GZipLineSource> _in;
+    std::vector<std::string> _headerLines;
+    std::size_t _headerIdx;
+    bool _eof;
+};
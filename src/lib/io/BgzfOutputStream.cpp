@@ -0,0 +1,149 @@
+#include "BgzfOutputStream.hpp"
+
+#include "common/Exceptions.hpp"
+#include "common/cstdint.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // gzip member header with the BC extra field that holds the block size
+    std::size_t const HeaderSize = 18;
+    // crc32 and uncompressed size
+    std::size_t const FooterSize = 8;
+
+    unsigned char const blockHeader[HeaderSize] = {
+        0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0
+    };
+
+    // An empty block, which marks the end of the file
+    unsigned char const eofBlock[] = {
+        0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+        0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    void encodeUint32(char* p, uint32_t v) {
+        for (int i = 0; i < 4; ++i, v >>= 8)
+            p[i] = char(v & 0xff);
+    }
+}
+
+std::size_t const BgzfStreambuf::BlockDataSize;
+std::size_t const BgzfStreambuf::MaxBlockSize;
+
+BgzfStreambuf::BgzfStreambuf(std::ostream& out)
+    : _out(out)
+    , _data(BlockDataSize)
+    , _block(MaxBlockSize)
+    , _closed(false)
+{
+    std::memset(&_zs, 0, sizeof(_zs));
+    // negative window bits: raw deflate, we write the gzip framing ourselves
+    if (deflateInit2(&_zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw IOError("Failed to initialize BGZF compression");
+
+    setp(&_data[0], &_data[0] + _data.size());
+}
+
+BgzfStreambuf::~BgzfStreambuf() {
+    try {
+        close();
+    }
+    catch (...) {
+    }
+    deflateEnd(&_zs);
+}
+
+void BgzfStreambuf::close() {
+    if (_closed)
+        return;
+
+    writeBlock();
+    _out.write(reinterpret_cast<char const*>(eofBlock), sizeof(eofBlock));
+    _out.flush();
+    _closed = true;
+}
+
+BgzfStreambuf::int_type BgzfStreambuf::overflow(int_type c) {
+    if (_closed)
+        return traits_type::eof();
+
+    writeBlock();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize BgzfStreambuf::xsputn(char const* s, std::streamsize n) {
+    if (_closed)
+        return 0;
+
+    std::streamsize done = 0;
+    while (done < n) {
+        if (pptr() == epptr())
+            writeBlock();
+
+        std::streamsize chunk = std::min<std::streamsize>(n - done, epptr() - pptr());
+        std::copy(s + done, s + done + chunk, pptr());
+        pbump(chunk);
+        done += chunk;
+    }
+    return done;
+}
+
+int BgzfStreambuf::sync() {
+    if (!_closed)
+        writeBlock();
+    _out.flush();
+    return _out ? 0 : -1;
+}
+
+void BgzfStreambuf::writeBlock() {
+    std::size_t size = pptr() - pbase();
+    if (size == 0)
+        return;
+
+    if (deflateReset(&_zs) != Z_OK)
+        throw IOError("Failed to reset BGZF compression");
+
+    std::size_t avail = _block.size() - HeaderSize - FooterSize;
+    _zs.next_in = reinterpret_cast<Bytef*>(pbase());
+    _zs.avail_in = size;
+    _zs.next_out = reinterpret_cast<Bytef*>(&_block[HeaderSize]);
+    _zs.avail_out = avail;
+
+    // A block's worth of data always fits, even if it does not compress
+    if (deflate(&_zs, Z_FINISH) != Z_STREAM_END)
+        throw IOError("Failed to compress BGZF block");
+
+    std::size_t blockSize = HeaderSize + (avail - _zs.avail_out) + FooterSize;
+    std::copy(blockHeader, blockHeader + HeaderSize, _block.begin());
+    _block[16] = char((blockSize - 1) & 0xff);
+    _block[17] = char((blockSize - 1) >> 8);
+
+    uint32_t crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<Bytef const*>(pbase()), size);
+    encodeUint32(&_block[blockSize - FooterSize], crc);
+    encodeUint32(&_block[blockSize - 4], size);
+
+    if (!_out.write(&_block[0], blockSize))
+        throw IOError("Failed to write BGZF block");
+
+    setp(&_data[0], &_data[0] + _data.size());
+}
+
+BgzfOutputStream::BgzfOutputStream(std::ostream& out)
+    : std::ostream(0)
+    , _buf(out)
+{
+    rdbuf(&_buf);
+}
+
+BgzfOutputStream::~BgzfOutputStream() {
+    rdbuf(0);
+}
+
+void BgzfOutputStream::close() {
+    _buf.close();
+}
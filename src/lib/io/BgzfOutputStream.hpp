@@ -0,0 +1,53 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+// Compresses everything written to it into BGZF blocks (gzip members of at
+// most 64k, as used by BCF2 and tabix) on the wrapped stream. Readers that
+// understand gzip read the output as one stream.
+class BgzfStreambuf : public std::streambuf, public boost::noncopyable {
+public:
+    // The most uncompressed data a single block holds
+    static std::size_t const BlockDataSize = 0xff00;
+    static std::size_t const MaxBlockSize = 0x10000;
+
+    explicit BgzfStreambuf(std::ostream& out);
+    ~BgzfStreambuf();
+
+    // Writes out any pending data and the empty block that marks the end
+    // of a BGZF file. Nothing may be written afterwards.
+    void close();
+
+protected:
+    int_type overflow(int_type c);
+    std::streamsize xsputn(char const* s, std::streamsize n);
+    int sync();
+
+private:
+    void writeBlock();
+
+private:
+    std::ostream& _out;
+    std::vector<char> _data;
+    std::vector<char> _block;
+    z_stream _zs;
+    bool _closed;
+};
+
+class BgzfOutputStream : public std::ostream {
+public:
+    explicit BgzfOutputStream(std::ostream& out);
+    ~BgzfOutputStream();
+
+    void close();
+
+private:
+    BgzfStreambuf _buf;
+};
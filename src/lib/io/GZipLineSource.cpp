@@ -49,6 +49,25 @@ public:
         return _buf[_beg];
     }
 
+    value_type const* data() const {
+        return _buf.data() + _beg;
+    }
+
+    size_type available() const {
+        return _end - _beg;
+    }
+
+    // Copies up to n buffered bytes to dst, returning how many were copied
+    size_type take(value_type* dst, size_type n) {
+        n = std::min(n, available());
+        std::copy(data(), data() + n, dst);
+        _beg += n;
+        if (_beg == _end) {
+            _beg = _end = 0u;
+        }
+        return n;
+    }
+
     size_type size() const {
         return _buf.size();
     }
@@ -131,6 +150,31 @@ bool GZipLineSource::getline(std::string& line) {
     return !_eof;
 }
 
+bool GZipLineSource::startsWith(char const* prefix, std::size_t n) {
+    if (_buffer->empty()) {
+        int sz = gzread(_fp, _buffer->buffer(), _buffer->size());
+        if (sz > 0) {
+            _buffer->setEnd(sz);
+        }
+    }
+
+    return _buffer->available() >= n
+        && std::equal(prefix, prefix + n, _buffer->data());
+}
+
+std::size_t GZipLineSource::read(char* dst, std::size_t n) {
+    std::size_t rv = _buffer->take(dst, n);
+    while (rv < n) {
+        int sz = gzread(_fp, dst + rv, n - rv);
+        if (sz <= 0) {
+            _eof = true;
+            break;
+        }
+        rv += sz;
+    }
+    return rv;
+}
+
 char GZipLineSource::peek() {
     if (!_buffer->empty()) {
         return _buffer->peek();
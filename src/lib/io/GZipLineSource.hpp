@@ -25,6 +25,15 @@ public:
     bool good() const;
     bool getline(std::string& line);
 
+    // For binary formats: true if the (decompressed) data starts with the n
+    // bytes at prefix. Reads ahead but consumes nothing, so it is only
+    // meaningful before anything else has been read.
+    bool startsWith(char const* prefix, std::size_t n);
+
+    // Reads up to n raw bytes into dst, returning how many were read. Fewer
+    // than n means we hit eof.
+    std::size_t read(char* dst, std::size_t n);
+
     static size_t bufferSize();
 
 private:
@@ -2,11 +2,13 @@
 
 #include "common/Exceptions.hpp"
 #include "common/compat.hpp"
+#include "io/Bcf2LineSource.hpp"
 #include "io/GZipLineSource.hpp"
 
 #include <boost/format.hpp>
 
 #include <cstdio>
+#include <utility>
 
 using namespace std;
 using boost::format;
@@ -29,16 +31,24 @@ std::vector<InputStream::ptr> StreamHandler::openForReading(
 
 
 InputStream::ptr StreamHandler::openForReading(std::string const& path) {
-    ILineSource::ptr lineSource;
+    std::unique_ptr<GZipLineSource> gzSource;
     if (path == "-") {
-        lineSource = std::make_unique<GZipLineSource>(fileno(stdin));
+        gzSource = std::make_unique<GZipLineSource>(fileno(stdin));
     }
     else {
-        lineSource = std::make_unique<GZipLineSource>(path);
+        gzSource = std::make_unique<GZipLineSource>(path);
     }
-    if (!*lineSource) {
+    if (!*gzSource) {
         throw IOError(str(format("Failed to open file %1%") %path));
     }
+
+    ILineSource::ptr lineSource;
+    if (Bcf2LineSource::isBcf2(*gzSource)) {
+        lineSource = std::make_unique<Bcf2LineSource>(std::move(gzSource));
+    }
+    else {
+        lineSource = std::move(gzSource);
+    }
     return InputStream::create(path, lineSource);
 }
 
@@ -9,6 +9,7 @@
 #include <boost/format.hpp>
 #include <stdexcept>
 #include <functional>
+#include <limits>
 #include <numeric>
 
 using boost::format;
@@ -25,21 +26,50 @@ namespace {
     bool isRefOrNull(Vcf::GenotypeIndex const& gtidx) {
         return gtidx == Vcf::GenotypeIndex::Null || gtidx.value == 0;
     }
+
+    void addCounts(vector<uint32_t>& lhs, vector<uint32_t> const& rhs) {
+        for (size_t i = 0; i < lhs.size(); ++i)
+            lhs[i] += rhs[i];
+    }
+
+    // As SampleData::genotype, given the sample's values and where GT is
+    Vcf::GenotypeCall const& genotype(Vcf::SampleData::ValueVector const& values, int gtOffset) {
+        if (gtOffset < 0 || size_t(gtOffset) >= values.size())
+            return Vcf::GenotypeCall::Null;
+
+        auto const& v = values[gtOffset];
+        const string* gtString(0);
+        if (v.empty() || (gtString = v.get<string>(0)) == 0 || gtString->empty())
+            return Vcf::GenotypeCall::Null;
+
+        return Vcf::GenotypeCall::intern(*gtString);
+    }
+
+    // counts[i] += deltas[classes[i]] for every sample. There are no
+    // branches, so this vectorizes (as a gather where the target has one).
+    void addDeltas(uint32_t* counts, vector<uint16_t> const& classes, vector<uint8_t> const& deltas) {
+        uint16_t const* cls = classes.data();
+        uint8_t const* d = deltas.data();
+        size_t n = classes.size();
+        for (size_t i = 0; i < n; ++i)
+            counts[i] += d[cls[i]];
+    }
 }
 
-EntryMetrics::EntryMetrics(Vcf::Entry const& entry, std::vector<std::string> const& novelInfoFields)
+EntryMetrics::EntryMetrics(Vcf::Entry const& entry, std::vector<std::string> const& novelInfoFields,
+        std::ostream& err)
     : _maxGtIdx(0)
     , _entry(entry)
     , _novelInfoFields(novelInfoFields)
 {
     identifyNovelAlleles();
-    calculateGenotypeDistribution();
+    calculateGenotypeDistribution(err);
     calculateAllelicDistribution();
     calculateAllelicDistributionBySample();
     calculateMutationSpectrum();
 }
 
-void EntryMetrics::calculateGenotypeDistribution() {
+void EntryMetrics::calculateGenotypeDistribution(std::ostream& err) {
     // convenience
     auto const& sd = _entry.sampleData();
 
@@ -58,7 +88,7 @@ void EntryMetrics::calculateGenotypeDistribution() {
         if (!gt.diploid()) {
             // anything but diploid is not supported until we understand a bit
             // better how to represent them
-            cerr << "Non-diploid genotype for sample " <<
+            err << "Non-diploid genotype for sample " <<
                 _entry.header().sampleNames()[sampleIdx]
                 << " skipped at position "
                 << _entry.chrom() << "\t" << _entry.pos() << endl;
@@ -269,24 +299,25 @@ const std::vector<uint32_t>& EntryMetrics::allelicDistributionBySample() const {
 }
 
 SampleMetrics::SampleMetrics(size_t sampleCount)
-    : _totalSites(0)
-    , _perSampleHetVariants(sampleCount, 0)
-    , _perSampleHomVariants(sampleCount, 0)
-    , _perSampleRefCall(sampleCount, 0)
-    , _perSampleFilteredCall(sampleCount, 0)
-    , _perSampleCalls(sampleCount, 0)
-    , _perSampleNonDiploidCall(sampleCount, 0)
-    , _perSampleSingletons(sampleCount, 0)
-    , _perSampleVeryRareVariants(sampleCount, 0)
-    , _perSampleRareVariants(sampleCount, 0)
-    , _perSampleCommonVariants(sampleCount, 0)
-    , _perSampleKnownVariants(sampleCount, 0)
-    , _perSampleNovelVariants(sampleCount, 0)  
+    : _sampleCount(sampleCount)
+    , _totalSites(0)
+    , _counts(NUM_COUNTERS * sampleCount, 0)
     , _perSampleMutationSpectrum(sampleCount)
+    , _classes(FIRST_GENOTYPE_CLASS)
+    , _sampleClass(sampleCount, NO_CLASS)
 {
+    for (auto i = _classes.begin(); i != _classes.end(); ++i) {
+        i->deltas.fill(0);
+        i->nonDiploid = false;
+    }
+    _classes[FILTERED_CLASS].deltas[FILTERED_CALLS] = 1;
 }
 
-void SampleMetrics::processEntry(Vcf::Entry& e, EntryMetrics& m) {
+// Samples are handled in two passes. The first works out which genotype
+// class each sample falls into, classifying each distinct genotype call
+// only once. The second adds each class's contribution to
+// every counter with a branch-free loop over the samples.
+void SampleMetrics::processEntry(Vcf::Entry& e, EntryMetrics& m, std::ostream& err) {
     ++_totalSites;
 
     // convenience
@@ -294,21 +325,10 @@ void SampleMetrics::processEntry(Vcf::Entry& e, EntryMetrics& m) {
     auto const& fmt = sd.format();
     uint64_t offset = distance(fmt.begin(), find_if(fmt.begin(), fmt.end(),
             boost::bind(&customTypeIdMatches, "FT", _1)));
+    int gtOffset = sd.formatKeyIndex("GT");
 
-    locale loc;
-    std::string ref(e.ref());   //for mutation spectrum
-
-    bool canCalcSpectrum = false;
-    bool complement = false;
-
-    if(e.ref().size() == 1) {
-        canCalcSpectrum = true;
-        toupper(ref[0],loc);
-        if(ref == "G" || ref == "T") {
-            complement = true;
-            ref = Sequence::reverseComplement(ref);
-        }
-    }
+    _classes.resize(FIRST_GENOTYPE_CLASS);
+    fill(_sampleClass.begin(), _sampleClass.end(), uint16_t(NO_CLASS));
 
     for (auto i = sd.begin(); i != sd.end(); ++i) {
         auto const& sampleIdx = i->first;
@@ -319,121 +339,181 @@ void SampleMetrics::processEntry(Vcf::Entry& e, EntryMetrics& m) {
         if (values.size() > offset) {
             const std::string *filter(values[offset].get<std::string>(0));
             if (filter != 0 && *filter != "PASS") {
-                ++_perSampleFilteredCall[sampleIdx];
+                _sampleClass[sampleIdx] = FILTERED_CLASS;
                 continue;
             }
         }
 
         //if no FT then we assume all have passed :-(
-        Vcf::GenotypeCall const& gt = e.sampleData().genotype(sampleIdx);
-        if(gt.size() == 0) {
-            //++_perSampleMissingCall[sampleIdx];
+        Vcf::GenotypeCall const& gt = genotype(values, gtOffset);
+        if(gt.size() == 0 || gt.null())
             continue;
+
+        uint16_t cls = classIndex(gt, e, m);
+        if (_classes[cls].nonDiploid) {
+            //anything but diploid is not supported until we understand a bit better how to represent them
+            err << "Non-diploid genotype for sample " << e.header().sampleNames()[sampleIdx] << " skipped at position " << e.chrom() << "\t" << e.pos() << endl;
         }
+        _sampleClass[sampleIdx] = cls;
+    }
 
-        ++_perSampleCalls[sampleIdx];
+    _deltas.resize(_classes.size());
+    for (int c = 0; c < NUM_COUNTERS; ++c) {
+        bool any = false;
+        for (size_t k = 0; k < _classes.size(); ++k) {
+            _deltas[k] = _classes[k].deltas[c];
+            any |= _deltas[k] != 0;
+        }
+        if (any)
+            addDeltas(&_counts[c * _sampleCount], _sampleClass, _deltas);
+    }
 
-        if (!gt.diploid()) {
-            //anything but diploid is not supported until we understand a bit better how to represent them
-            cerr << "Non-diploid genotype for sample " << e.header().sampleNames()[sampleIdx] << " skipped at position " << e.chrom() << "\t" << e.pos() << endl;
-            ++_perSampleNonDiploidCall[sampleIdx];
-            continue;
+    // Only variant calls at single base sites touch the spectrum
+    bool anyMutations = false;
+    for (auto i = _classes.begin(); i != _classes.end(); ++i)
+        anyMutations |= !i->mutations.empty();
+    if (!anyMutations)
+        return;
+
+    for (size_t i = 0; i < _sampleCount; ++i) {
+        auto const& mutations = _classes[_sampleClass[i]].mutations;
+        for (auto j = mutations.begin(); j != mutations.end(); ++j)
+            _perSampleMutationSpectrum[i](j->first, j->second) += 1;
+    }
+}
+
+uint16_t SampleMetrics::classIndex(Vcf::GenotypeCall const& gt, Vcf::Entry const& e, EntryMetrics& m) {
+    // Calls are matched on phase and indices in call order, which is
+    // stricter than GenotypeCall::operator== (e.g., 1/2 vs 1/1/2)
+    for (size_t i = FIRST_GENOTYPE_CLASS; i < _classes.size(); ++i) {
+        auto const& other = _classes[i].gt;
+        if (other.phased() == gt.phased() && other.indices() == gt.indices())
+            return i;
+    }
+
+    if (_classes.size() > numeric_limits<uint16_t>::max()) {
+        throw runtime_error(str(format(
+            "Too many distinct genotype calls at %1%:%2%"
+            ) % e.chrom() % e.pos()));
+    }
+
+    GenotypeClass c;
+    c.gt = gt;
+    c.deltas.fill(0);
+    c.nonDiploid = !gt.diploid();
+    c.deltas[CALLS] = 1;
+
+    if (c.nonDiploid) {
+        c.deltas[NON_DIPLOID_CALLS] = 1;
+    }
+    else if(gt.reference()) {
+        c.deltas[REF_CALLS] = 1;
+    }
+    else {
+        c.deltas[gt.heterozygous() ? HET_VARIANTS : HOM_VARIANTS] = 1;
+
+        double maf = m.minorAlleleFrequency();
+        if(m.singleton(&gt)) {
+            c.deltas[SINGLETONS] = 1;
+        }
+        else if(maf < 0.01) {
+            c.deltas[VERY_RARE_VARIANTS] = 1;
+        }
+        else if(maf >= 0.01 && maf < 0.05) {
+            c.deltas[RARE_VARIANTS] = 1;
         }
         else {
-            if(gt.reference()) {
-                ++_perSampleRefCall[sampleIdx];
-                continue;
-            }
-            else if(gt.heterozygous()) {
-                ++_perSampleHetVariants[sampleIdx];
-            }
-            else {
-                ++_perSampleHomVariants[sampleIdx];
-            }
-
-            double maf = m.minorAlleleFrequency();
-            if(m.singleton(&gt)) {
-                ++_perSampleSingletons[sampleIdx];
-            }
-            else if(maf < 0.01) {
-                ++_perSampleVeryRareVariants[sampleIdx];
-            }
-            else if(maf >= 0.01 && maf < 0.05) {
-                ++_perSampleRareVariants[sampleIdx];
-            }
-            else {
-                ++_perSampleCommonVariants[sampleIdx];
-            }
+            c.deltas[COMMON_VARIANTS] = 1;
+        }
 
-            if(canCalcSpectrum) {
-                for(auto j = gt.indexSet().begin(); j != gt.indexSet().end(); ++j) {
-                    if(isRefOrNull(*j))
-                        continue;
-                    std::string variant( e.alt()[j->value - 1] );
-                    if (variant.size() != 1)
-                        //throw runtime_error(str(format("Invalid variant for ref entry %1%: %2%") %ref %variant));
-                        continue;
-                    toupper(variant[0],loc);
-                    if(complement)
-                        variant = Sequence::reverseComplement(variant);
-                    //now have mutation class so go ahead and record
-                    _perSampleMutationSpectrum[sampleIdx](ref[0], variant[0]) += 1;
-                }
-            }
+        if(e.ref().size() == 1) {
+            std::string ref(e.ref());   //for mutation spectrum
+            bool complement = ref == "G" || ref == "T";
+            if(complement)
+                ref = Sequence::reverseComplement(ref);
 
-            //determine if novel which is by allele
-            std::vector<bool> novelByAlt = m.novelStatusByAlt();
             for(auto j = gt.indexSet().begin(); j != gt.indexSet().end(); ++j) {
-                if(*j == 0)
+                if(isRefOrNull(*j))
                     continue;
-                if(novelByAlt[j->value - 1]) {    //need to subtract one because reference is not an Alt
-                    ++_perSampleNovelVariants[sampleIdx];
-                }
-                else {
-                    ++_perSampleKnownVariants[sampleIdx];
-                }
+                std::string variant( e.alt()[j->value - 1] );
+                if (variant.size() != 1)
+                    continue;
+                if(complement)
+                    variant = Sequence::reverseComplement(variant);
+                c.mutations.push_back(make_pair(ref[0], variant[0]));
             }
         }
+
+        //determine if novel which is by allele
+        std::vector<bool> const& novelByAlt = m.novelStatusByAlt();
+        for(auto j = gt.indexSet().begin(); j != gt.indexSet().end(); ++j) {
+            if(isRefOrNull(*j))
+                continue;
+            //need to subtract one because reference is not an Alt
+            ++c.deltas[novelByAlt[j->value - 1] ? NOVEL_VARIANTS : KNOWN_VARIANTS];
+        }
+    }
+
+    _classes.push_back(c);
+    return _classes.size() - 1;
+}
+
+SampleMetrics& SampleMetrics::operator+=(SampleMetrics const& rhs) {
+    if (rhs._sampleCount != _sampleCount) {
+        throw runtime_error(str(format(
+            "Attempted to add sample metrics for %1% samples to metrics for %2%"
+            ) % rhs._sampleCount % _sampleCount));
     }
+
+    _totalSites += rhs._totalSites;
+    addCounts(_counts, rhs._counts);
+    for (size_t i = 0; i < _perSampleMutationSpectrum.size(); ++i)
+        _perSampleMutationSpectrum[i] += rhs._perSampleMutationSpectrum[i];
+
+    return *this;
+}
+
+uint32_t SampleMetrics::count(Counter c, uint32_t index) const {
+    return _counts[c * _sampleCount + index];
 }
 
 uint32_t SampleMetrics::numHetVariants(uint32_t index) const {
-    return _perSampleHetVariants[index];
+    return count(HET_VARIANTS, index);
 }
 
 uint32_t SampleMetrics::numHomVariants(uint32_t index) const {
-    return _perSampleHomVariants[index];
+    return count(HOM_VARIANTS, index);
 }
 
 uint32_t SampleMetrics::numRefCalls(uint32_t index) const {
-    return _perSampleRefCall[index];
+    return count(REF_CALLS, index);
 }
 uint32_t SampleMetrics::numFilteredCalls(uint32_t index) const {
-    return _perSampleFilteredCall[index];
+    return count(FILTERED_CALLS, index);
 }
 uint32_t SampleMetrics::numMissingCalls(uint32_t index) const {
-    return _totalSites - _perSampleCalls[index] - _perSampleFilteredCall[index];
+    return _totalSites - count(CALLS, index) - count(FILTERED_CALLS, index);
 }
 uint32_t SampleMetrics::numNonDiploidCalls(uint32_t index) const {
-    return _perSampleNonDiploidCall[index];
+    return count(NON_DIPLOID_CALLS, index);
 }
 uint32_t SampleMetrics::numSingletonVariants(uint32_t index) const {
-    return _perSampleSingletons[index];
+    return count(SINGLETONS, index);
 }
 uint32_t SampleMetrics::numVeryRareVariants(uint32_t index) const {
-    return _perSampleVeryRareVariants[index];
+    return count(VERY_RARE_VARIANTS, index);
 }
 uint32_t SampleMetrics::numRareVariants(uint32_t index) const {
-    return _perSampleRareVariants[index];
+    return count(RARE_VARIANTS, index);
 }
 uint32_t SampleMetrics::numCommonVariants(uint32_t index) const {
-    return _perSampleCommonVariants[index];
+    return count(COMMON_VARIANTS, index);
 }
 uint32_t SampleMetrics::numKnownVariants(uint32_t index) const {
-    return _perSampleKnownVariants[index];
+    return count(KNOWN_VARIANTS, index);
 }
 uint32_t SampleMetrics::numNovelVariants(uint32_t index) const {
-    return _perSampleNovelVariants[index];
+    return count(NOVEL_VARIANTS, index);
 }
 
 MutationSpectrum const& SampleMetrics::mutationSpectrum(uint32_t index) const {
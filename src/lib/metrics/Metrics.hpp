@@ -7,7 +7,10 @@
 
 #include <array>
 #include <cstddef>
+#include <iostream>
 #include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 class MutationSpectrum;
@@ -16,7 +19,9 @@ BEGIN_NAMESPACE(Metrics)
 
 class EntryMetrics {
 public:
-    EntryMetrics(Vcf::Entry const& entry, std::vector<std::string> const& novelInfoFields);
+    // Warnings about individual genotypes go to err
+    EntryMetrics(Vcf::Entry const& entry, std::vector<std::string> const& novelInfoFields,
+        std::ostream& err = std::cerr);
     double minorAlleleFrequency() const;
     const std::vector<double> alleleFrequencies() const;
 
@@ -35,7 +40,7 @@ public:
     //bool novel(const Vcf::Entry& entry, const std::vector<std::string>& novelInfoFields, const Vcf::GenotypeCall* geno);
 
 protected:
-    void calculateGenotypeDistribution();
+    void calculateGenotypeDistribution(std::ostream& err);
     void calculateAllelicDistribution();
     void calculateAllelicDistributionBySample();
     void calculateMutationSpectrum();
@@ -56,10 +61,15 @@ protected:
     std::vector<std::string> const& _novelInfoFields;
 };
 
+// Per-sample totals over a set of entries. Totals for different parts of
+// a file (e.g., from different threads) can be added up with +=.
 class SampleMetrics {
 public:
     SampleMetrics(size_t sampleCount);
-    void processEntry(Vcf::Entry& e, EntryMetrics& m);
+    // Warnings about individual genotypes go to err
+    void processEntry(Vcf::Entry& e, EntryMetrics& m, std::ostream& err = std::cerr);
+    SampleMetrics& operator+=(SampleMetrics const& rhs);
+
     uint32_t numHetVariants(uint32_t index) const;
     uint32_t numHomVariants(uint32_t index) const;
     uint32_t numRefCalls(uint32_t index) const;
@@ -75,21 +85,57 @@ public:
     MutationSpectrum const& mutationSpectrum(uint32_t index) const;
 
 protected:
+    // Each counter is a row of _counts with one column per sample, so that
+    // one counter can be updated for every sample in a single pass.
+    enum Counter {
+        HET_VARIANTS,
+        HOM_VARIANTS,
+        REF_CALLS,
+        FILTERED_CALLS,
+        CALLS,
+        NON_DIPLOID_CALLS,
+        SINGLETONS,
+        VERY_RARE_VARIANTS,
+        RARE_VARIANTS,
+        COMMON_VARIANTS,
+        KNOWN_VARIANTS,
+        NOVEL_VARIANTS,
+        NUM_COUNTERS
+    };
+
+    // Classes in _classes that come before the ones for genotype calls
+    enum {
+        NO_CLASS,
+        FILTERED_CLASS,
+        FIRST_GENOTYPE_CLASS
+    };
+
+    // What each sample with a given genotype call at the current entry adds
+    // to its counters. The call is a copy: interned calls are not guaranteed
+    // one address per GT string.
+    struct GenotypeClass {
+        Vcf::GenotypeCall gt;
+        std::array<uint8_t, NUM_COUNTERS> deltas;
+        bool nonDiploid;
+        // (from, to) pairs for the mutation spectrum
+        std::vector<std::pair<char, char>> mutations;
+    };
+
+    uint32_t count(Counter c, uint32_t index) const;
+    // The index in _classes for gt, adding it if it is new at this entry
+    uint16_t classIndex(Vcf::GenotypeCall const& gt, Vcf::Entry const& e, EntryMetrics& m);
+
+protected:
+    size_t _sampleCount;
     uint64_t _totalSites;
-    //per-sample metrics
-    std::vector<uint32_t> _perSampleHetVariants;
-    std::vector<uint32_t> _perSampleHomVariants;
-    std::vector<uint32_t> _perSampleRefCall;
-    std::vector<uint32_t> _perSampleFilteredCall;
-    std::vector<uint32_t> _perSampleCalls;
-    std::vector<uint32_t> _perSampleNonDiploidCall;
-    std::vector<uint32_t> _perSampleSingletons;
-    std::vector<uint32_t> _perSampleVeryRareVariants;
-    std::vector<uint32_t> _perSampleRareVariants;
-    std::vector<uint32_t> _perSampleCommonVariants;
-    std::vector<uint32_t> _perSampleKnownVariants;
-    std::vector<uint32_t> _perSampleNovelVariants;
+    std::vector<uint32_t> _counts;
     std::vector<MutationSpectrum> _perSampleMutationSpectrum;
+
+    // Scratch space for processEntry: the distinct genotype classes seen at
+    // an entry, and which of them each sample has
+    std::vector<GenotypeClass> _classes;
+    std::vector<uint16_t> _sampleClass;
+    std::vector<uint8_t> _deltas;
 };
 
 
@@ -1,19 +1,29 @@
 #pragma once
 
-template<typename OutputType>
+#include "common/ObjectPool.hpp"
+
+#include <utility>
+
+// Passes on what a pointer points to. If a pool is given, the pointer is
+// released to it afterwards.
+template<typename OutputType, typename PoolType = NoObjectPool>
 class Deref {
 public:
-    Deref(OutputType& out)
+    Deref(OutputType& out, PoolType* pool = 0)
         : out_(out)
+        , pool_(pool)
     {}
 
     template<typename T>
     void operator()(T value) {
         out_(*value);
+        if (pool_)
+            pool_->release(std::move(value));
     }
 
 private:
     OutputType& out_;
+    PoolType* pool_;
 };
 
 template<typename OutputType>
@@ -21,3 +31,9 @@ Deref<OutputType>
 makeDeref(OutputType& out) {
     return Deref<OutputType>(out);
 }
+
+template<typename OutputType, typename PoolType>
+Deref<OutputType, PoolType>
+makeDeref(OutputType& out, PoolType* pool) {
+    return Deref<OutputType, PoolType>(out, pool);
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "common/UnsortedDataError.hpp"
+#include "common/compat.hpp"
+#include "common/cstdint.hpp"
+
+#include <boost/format.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The raw lines of one chromosome of a TypedStream. Lines are parsed with
+// a copy of the stream's parser as they are read, so this can stand in for
+// the stream in an intersector on any thread.
+template<typename StreamType>
+class ChromosomeLines {
+public:
+    typedef typename StreamType::ValueType ValueType;
+
+    explicit ChromosomeLines(StreamType& stream)
+        : bytes(0)
+        , stream_(stream)
+        , parser_(stream.parser())
+        , pos_(0)
+        , cached_(false)
+    {}
+
+    std::string const& name() const {
+        return stream_.name();
+    }
+
+    bool eof() const {
+        return !cached_ && pos_ >= lines.size();
+    }
+
+    bool peek(ValueType** value) {
+        if (!cached_) {
+            if (!next(cachedValue_))
+                return false;
+            cached_ = true;
+        }
+        *value = &cachedValue_;
+        return true;
+    }
+
+    bool next(ValueType& value) {
+        if (cached_) {
+            value.swap(cachedValue_);
+            cached_ = false;
+            return true;
+        }
+
+        if (pos_ >= lines.size())
+            return false;
+
+        stream_.parseLine(parser_, lines[pos_], lineNums[pos_], value);
+        ++pos_;
+        return true;
+    }
+
+    std::string chrom;
+    std::vector<std::string> lines;
+    std::vector<uint64_t> lineNums;
+    // the total length of lines
+    std::size_t bytes;
+
+private:
+    StreamType& stream_;
+    typename StreamType::ParserType parser_;
+    std::size_t pos_;
+    bool cached_;
+    ValueType cachedValue_;
+};
+
+// What intersecting one chromosome writes, held until its turn to go out
+struct IntersectChunkOutput {
+    std::ostringstream hits;
+    std::ostringstream missA;
+    std::ostringstream missB;
+};
+
+// Intersects two sorted streams one chromosome at a time on several
+// threads.
+//
+// A reader thread cuts both inputs into chromosomes of raw lines, pairing
+// up the chromosomes found in either input in sorted order (one of a pair
+// is empty when a chromosome is only in one input). Worker threads call
+// their own copy of the functor as func(linesA, linesB, output) on each
+// pair, intersecting them and writing hits and misses to the output's
+// buffers. The calling thread writes those out pair by pair in order, so
+// the output is the same as that of one intersector over the whole
+// streams. Errors, including chromosomes out of order, are rethrown from
+// run() once everything before them has been written.
+//
+// Each pair is held in memory in full while it is being intersected, with
+// at most twice as many pairs in flight as there are threads, so memory use
+// grows with the size of the largest chromosomes times the threads. Given
+// maxBufferedBytes, the reader also waits while the lines of the pairs in
+// flight add up to that many bytes or more; it always reads a pair when
+// none are in flight, however big.
+template<typename StreamTypeA, typename StreamTypeB>
+class IntersectByChromosome : public boost::noncopyable {
+public:
+    typedef ChromosomeLines<StreamTypeA> LinesA;
+    typedef ChromosomeLines<StreamTypeB> LinesB;
+
+    IntersectByChromosome(
+            StreamTypeA& a,
+            StreamTypeB& b,
+            std::ostream& hits,
+            std::ostream* missA,
+            std::ostream* missB,
+            std::size_t threads,
+            std::size_t maxBufferedBytes = 0
+            )
+        : a_(a)
+        , b_(b)
+        , hits_(hits)
+        , missA_(missA)
+        , missB_(missB)
+        , threads_(threads ? threads : 1)
+        , maxBufferedBytes_(maxBufferedBytes)
+    {}
+
+    template<typename Func>
+    void run(Func const& func) {
+        std::vector<Func> funcs(threads_, func);
+        maxInFlight_ = threads_ * 2;
+        inFlight_ = 0;
+        bufferedBytes_ = 0;
+        nextSeq_ = 0;
+        readerDone_ = false;
+        abort_ = false;
+
+        std::vector<std::thread> threads;
+        threads.emplace_back(&IntersectByChromosome::readPairs, this);
+        for (std::size_t i = 0; i < threads_; ++i)
+            threads.emplace_back(&IntersectByChromosome::template work<Func>, this, std::ref(funcs[i]));
+
+        std::exception_ptr error;
+        try {
+            writePairs();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            abort_ = true;
+        }
+        canRead_.notify_all();
+        canWork_.notify_all();
+
+        for (auto i = threads.begin(); i != threads.end(); ++i)
+            i->join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    struct Pair {
+        Pair(StreamTypeA& a, StreamTypeB& b)
+            : seq(0)
+            , a(a)
+            , b(b)
+        {}
+
+        uint64_t seq;
+        LinesA a;
+        LinesB b;
+        IntersectChunkOutput out;
+        std::exception_ptr error;
+    };
+    typedef std::unique_ptr<Pair> PairPtr;
+
+    // Reads a stream a chromosome at a time, holding on to the first line
+    // of the next one
+    template<typename StreamType>
+    class ChromosomeReader {
+    public:
+        explicit ChromosomeReader(StreamType& stream)
+            : stream_(stream)
+            , lineNum_(0)
+            , started_(false)
+            , have_(false)
+        {}
+
+        bool done() {
+            if (!started_) {
+                started_ = true;
+                advance();
+            }
+            return !have_;
+        }
+
+        std::string const& chrom() const {
+            return chrom_;
+        }
+
+        void read(ChromosomeLines<StreamType>& lines) {
+            lines.chrom = chrom_;
+            do {
+                lines.bytes += line_.size();
+                lines.lines.push_back(std::move(line_));
+                lines.lineNums.push_back(lineNum_);
+                advance();
+            } while (have_ && chrom_ == lines.chrom);
+
+            if (have_ && strverscmp(chrom_.c_str(), lines.chrom.c_str()) < 0)
+                throw UnsortedDataError(unsortedMessage(lines.lines.back(), lines.lineNums.back()));
+        }
+
+    private:
+        void advance() {
+            have_ = stream_.nextLine(line_, lineNum_);
+            if (have_)
+                chrom_.assign(line_, 0, line_.find('\t'));
+        }
+
+        std::string unsortedMessage(std::string prevLine, uint64_t prevLineNum) {
+            using boost::format;
+            auto parser = stream_.parser();
+            typename StreamType::ValueType prev;
+            typename StreamType::ValueType next;
+            stream_.parseLine(parser, prevLine, prevLineNum, prev);
+            stream_.parseLine(parser, line_, lineNum_, next);
+            return str(format("Unsorted data found in stream %1%\n'%2%' follows '%3%'")
+                %stream_.name() %next.toString() %prev.toString());
+        }
+
+    private:
+        StreamType& stream_;
+        std::string line_;
+        uint64_t lineNum_;
+        std::string chrom_;
+        bool started_;
+        bool have_;
+    };
+
+    // Call with mutex_ held
+    bool overBufferLimit() const {
+        return maxBufferedBytes_ && bufferedBytes_ >= maxBufferedBytes_;
+    }
+
+    void readPairs() {
+        ChromosomeReader<StreamTypeA> readerA(a_);
+        ChromosomeReader<StreamTypeB> readerB(b_);
+        uint64_t seq = 0;
+        bool eof = false;
+        while (!eof) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!abort_ && inFlight_ > 0 && (inFlight_ >= maxInFlight_ || overBufferLimit()))
+                    canRead_.wait(lock);
+                if (abort_)
+                    return;
+                ++inFlight_;
+            }
+
+            PairPtr pair = std::make_unique<Pair>(a_, b_);
+            pair->seq = seq++;
+            try {
+                // b is not read past the end of a unless its misses are
+                // wanted, as with a single intersector
+                bool doneA = readerA.done();
+                bool doneB = (doneA && !missB_) || readerB.done();
+                if (doneA && doneB) {
+                    eof = true;
+                } else {
+                    int cmp = doneA ? 1 : doneB ? -1
+                        : strverscmp(readerA.chrom().c_str(), readerB.chrom().c_str());
+                    if (cmp <= 0)
+                        readerA.read(pair->a);
+                    if (cmp >= 0)
+                        readerB.read(pair->b);
+                }
+            }
+            catch (...) {
+                pair->error = std::current_exception();
+                eof = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                bufferedBytes_ += pair->a.bytes + pair->b.bytes;
+                todo_.push_back(std::move(pair));
+                readerDone_ = eof;
+            }
+            canWork_.notify_one();
+        }
+        canWork_.notify_all();
+    }
+
+    template<typename Func>
+    void work(Func& func) {
+        while (true) {
+            PairPtr pair;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!abort_ && todo_.empty() && !readerDone_)
+                    canWork_.wait(lock);
+                if (abort_ || todo_.empty())
+                    return;
+                pair = std::move(todo_.front());
+                todo_.pop_front();
+            }
+
+            if (!pair->error && !(pair->a.lines.empty() && pair->b.lines.empty())) {
+                try {
+                    func(pair->a, pair->b, pair->out);
+                }
+                catch (...) {
+                    pair->error = std::current_exception();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                uint64_t seq = pair->seq;
+                done_[seq] = std::move(pair);
+            }
+            canWrite_.notify_one();
+        }
+    }
+
+    void writePairs() {
+        while (true) {
+            PairPtr pair;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (done_.count(nextSeq_) == 0 && !(readerDone_ && inFlight_ == 0))
+                    canWrite_.wait(lock);
+
+                auto found = done_.find(nextSeq_);
+                if (found == done_.end())
+                    return;
+                pair = std::move(found->second);
+                done_.erase(found);
+            }
+
+            hits_ << pair->out.hits.str();
+            if (missA_)
+                *missA_ << pair->out.missA.str();
+            if (missB_)
+                *missB_ << pair->out.missB.str();
+            if (pair->error)
+                std::rethrow_exception(pair->error);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++nextSeq_;
+                --inFlight_;
+                bufferedBytes_ -= pair->a.bytes + pair->b.bytes;
+            }
+            canRead_.notify_one();
+        }
+    }
+
+private:
+    StreamTypeA& a_;
+    StreamTypeB& b_;
+    std::ostream& hits_;
+    std::ostream* missA_;
+    std::ostream* missB_;
+    std::size_t threads_;
+    std::size_t maxBufferedBytes_;
+
+    // everything below is guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable canRead_;
+    std::condition_variable canWork_;
+    std::condition_variable canWrite_;
+    std::size_t maxInFlight_;
+    std::size_t inFlight_;
+    std::size_t bufferedBytes_;
+    uint64_t nextSeq_;
+    bool readerDone_;
+    bool abort_;
+    std::deque<PairPtr> todo_;
+    std::map<uint64_t, PairPtr> done_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "common/UnsortedDataError.hpp"
+
+#include <boost/format.hpp>
+
+#include <cstring>
+
+// Where one feature lies relative to another (by chromosome, then
+// position) for intersecting streams of them. Identical insertions
+// intersect; with adjacentInsertions, insertions also intersect features
+// they touch.
+class IntersectCompare {
+public:
+    // compare results
+    enum Compare {
+        BEFORE,
+        INTERSECT,
+        AFTER
+    };
+
+    explicit IntersectCompare(bool adjacentInsertions = false)
+        : _adjacentInsertions(adjacentInsertions)
+    {
+    }
+
+    template<typename TA, typename TB>
+    Compare compare(const TA& a, const TB& b) const {
+        if (_adjacentInsertions)
+            return compareWithAdjacentInsertions(a, b);
+
+        int rv = compareChrom(a, b);
+        if (rv < 0)
+            return BEFORE;
+        if (rv > 0)
+            return AFTER;
+
+        // to handle identical insertions
+        if (a.start() == a.stop() && b.start() == b.stop() && a.start() == b.start())
+            return INTERSECT;
+
+        if (a.stop() <= b.start())
+            return BEFORE;
+        if (b.stop() <= a.start())
+            return AFTER;
+
+        return INTERSECT;
+    }
+
+    template<typename TA, typename TB>
+    Compare compareWithAdjacentInsertions(const TA& a, const TB& b) const {
+        int rv = compareChrom(a, b);
+        if (rv < 0)
+            return BEFORE;
+        if (rv > 0)
+            return AFTER;
+
+        // to handle adjacent/exact match insertions!
+        if ((containsInsertions(a) && (a.stop() == b.start() || a.start() == b.stop())) ||
+            (containsInsertions(b) && (b.stop() == a.start() || b.start() == a.stop())) )
+        {
+            return INTERSECT;
+        }
+
+        if (a.stop() <= b.start())
+            return BEFORE;
+        if (b.stop() <= a.start())
+            return AFTER;
+
+        return INTERSECT;
+    }
+
+    // Reads the next value and checks that the one after it does not come
+    // before it. The check looks ahead rather than back since values read
+    // may be moved away by the caller.
+    template<typename T, typename S>
+    bool advanceSorted(S& stream, T& value) const {
+        using boost::format;
+        if (!stream.next(value))
+            return false;
+
+        T* peek = NULL;
+        if (!stream.eof() && stream.peek(&peek) && compare(*peek, value) == BEFORE)
+            throw UnsortedDataError(str(format("Unsorted data found in stream %1%\n'%2%' follows '%3%'") %stream.name() %peek->toString() %value.toString()));
+        return true;
+    }
+
+protected:
+    // Most comparisons are between features on the same chromosome, which
+    // a plain string comparison settles more cheaply than strverscmp
+    template<typename TA, typename TB>
+    static int compareChrom(const TA& a, const TB& b) {
+        if (a.chrom() == b.chrom())
+            return 0;
+        return strverscmp(a.chrom().c_str(), b.chrom().c_str());
+    }
+
+protected:
+    bool _adjacentInsertions;
+};
@@ -1,15 +1,17 @@
 #pragma once
 
-#include "common/UnsortedDataError.hpp"
+#include "IntersectCompare.hpp"
 
-#include <boost/format.hpp>
-#include <cstring>
-#include <list>
+#include <boost/circular_buffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
 
 // This class is capable of performing intersection as well as symmetric
 // difference.
 template<typename StreamTypeA, typename StreamTypeB, typename CollectorType>
-class IntersectFull {
+class IntersectFull : public IntersectCompare {
 public: // types and data
     // value types
     typedef typename StreamTypeA::ValueType TypeA;
@@ -17,170 +19,141 @@ public: // types and data
 
     // cache types
     struct CacheEntry {
-        CacheEntry(const TypeB& v) : value(v), hit(false) {}
-        CacheEntry(const TypeB& v, bool hit) : value(v), hit(hit) {}
+        CacheEntry(TypeB&& v, bool hit) : value(std::move(v)), hit(hit) {}
 
         TypeB value;
         bool hit;
     };
 
-    typedef typename std::list<CacheEntry> CacheType;
+    // Entries of B that may still intersect later entries of A, in the
+    // order they were read. Records are moved into contiguous storage that
+    // grows as needed, rather than copied into list nodes.
+    typedef boost::circular_buffer<CacheEntry> CacheType;
     typedef typename CacheType::iterator CacheIterator;
 
-    // compare results
-    enum Compare {
-        BEFORE,
-        INTERSECT,
-        AFTER
-    };
-
+    enum { INITIAL_CACHE_CAPACITY = 64 };
 
 public: // code
     IntersectFull(StreamTypeA& a, StreamTypeB& b, CollectorType& rc, bool adjacentInsertions = false)
-        : _a(a) , _b(b), _rc(rc), _adjacentInsertions(adjacentInsertions)
+        : IntersectCompare(adjacentInsertions)
+        , _a(a) , _b(b), _rc(rc)
+        , _cache(INITIAL_CACHE_CAPACITY)
     {
     }
 
     virtual ~IntersectFull() {}
 
-    template<typename TA, typename TB>
-    Compare compare(const TA& a, const TB& b) const {
-        if (_adjacentInsertions)
-            return compareWithAdjacentInsertions(a, b);
-
-        int rv = strverscmp(a.chrom().c_str(), b.chrom().c_str());
-        if (rv < 0)
-            return BEFORE;
-        if (rv > 0)
-            return AFTER;
-
-        // to handle identical insertions
-        if (a.start() == a.stop() && b.start() == b.stop() && a.start() == b.start())
-            return INTERSECT;
-
-        if (a.stop() <= b.start())
-            return BEFORE;
-        if (b.stop() <= a.start())
-            return AFTER;
-
-        return INTERSECT;
-    }
-
-    template<typename TA, typename TB>
-    Compare compareWithAdjacentInsertions(const TA& a, const TB& b) const {
-        int rv = strverscmp(a.chrom().c_str(), b.chrom().c_str());
-        if (rv < 0)
-            return BEFORE;
-        if (rv > 0)
-            return AFTER;
-
-        // to handle adjacent/exact match insertions!
-        if ((containsInsertions(a) && (a.stop() == b.start() || a.start() == b.stop())) ||
-            (containsInsertions(b) && (b.stop() == a.start() || b.start() == a.stop())) )
-        {
-            return INTERSECT;
-        }
-
-        if (a.stop() <= b.start())
-            return BEFORE;
-        if (b.stop() <= a.start())
-            return AFTER;
-
-        return INTERSECT;
-    }
-
     bool eof() const {
         return _a.eof() || _b.eof();
     }
 
+    // Entries of the cache that valueA is past are removed as they are
+    // visited, with the ones kept moved down over them, so the cache only
+    // ever holds entries that can still intersect.
     bool checkCache(const TypeA& valueA) {
         bool rv = false;
-        auto iter = _cache.begin();
-        while (iter != _cache.end()) {
+        CacheIterator out = _cache.begin();
+        CacheIterator iter = _cache.begin();
+        for (; iter != _cache.end(); ++iter) {
             Compare cmp = compare(valueA, iter->value);
             if (cmp == BEFORE) {
                 break;
             } else if (cmp == AFTER) {
-                auto toRemove = iter;
-                ++iter;
-                cacheRemove(toRemove);
+                expire(*iter);
                 continue;
             }
 
             bool isHit = _rc.hit(valueA, iter->value);
             rv |= isHit;
             iter->hit |= isHit;
-            ++iter;
+            if (out != iter)
+                *out = std::move(*iter);
+            ++out;
         }
-        return rv;
-    }
 
-    template<typename T, typename S>
-    bool advanceSorted(S& stream, T& value) {
-        using boost::format;
-        T* peek = NULL;
-        if (stream.peek(&peek) && compare(*peek, value) == BEFORE)
-            throw UnsortedDataError(str(format("Unsorted data found in stream %1%\n'%2%' follows '%3%'") %stream.name() %peek->toString() %value.toString()));
-        return stream.next(value);
+        if (out != iter) {
+            out = std::move(iter, _cache.end(), out);
+            _cache.erase_end(_cache.end() - out);
+        }
+        return rv;
     }
 
     void execute() {
         TypeA valueA;
-        TypeB valueB;
         while (!_a.eof() && advanceSorted(_a, valueA)) {
-            // burn entries from the cache
-            while (!_cache.empty() && compare(valueA, _cache.front().value) == AFTER)
-                popCache();
-
-            // look ahead and burn entries from the input file
-            TypeB* peek = NULL;
-            if (_cache.empty()) {
-                while (!_b.eof() && _b.peek(&peek) && compare(valueA, *peek) == AFTER) {
-                    advanceSorted(_b, valueB);
-                    if (_rc.wantMissB())
-                        _rc.missB(valueB);
-                }
+            bool hitA = intersect(valueA);
+            if (!hitA && _rc.wantMissA()) {
+                _rc.missA(valueA);
             }
+        }
+        finish();
+    }
 
-            bool hitA = checkCache(valueA);
-            while (!_b.eof() && advanceSorted(_b, valueB)) {
-                Compare cmp = compare(valueA, valueB);
-                if (cmp == BEFORE) {
-                    cache(valueB, false);
-                    break;
-                } else if (cmp == AFTER) {
-                    if (_rc.wantMissB())
-                        _rc.missB(valueB);
-                    continue;
-                }
-
-                bool rv = _rc.hit(valueA, valueB);
-                hitA |= rv;
-                cache(valueB, rv);
+    // Gives the collector the hits of one entry of A, reading B as far as
+    // needed, and returns whether there were any. Entries of A must be
+    // given in sorted order; execute() reads them from the A stream, but
+    // they may come from elsewhere.
+    bool intersect(const TypeA& valueA) {
+        // burn entries from the cache
+        while (!_cache.empty() && compare(valueA, _cache.front().value) == AFTER)
+            popCache();
+
+        // look ahead and burn entries from the input file
+        TypeB* peek = NULL;
+        if (_cache.empty()) {
+            while (!_b.eof() && _b.peek(&peek) && compare(valueA, *peek) == AFTER) {
+                advanceSorted(_b, _valueB);
+                if (_rc.wantMissB())
+                    _rc.missB(_valueB);
             }
+        }
 
-            if (!hitA && _rc.wantMissA()) {
-                _rc.missA(valueA);
+        bool hitA = checkCache(valueA);
+        while (!_b.eof() && advanceSorted(_b, _valueB)) {
+            Compare cmp = compare(valueA, _valueB);
+            if (cmp == BEFORE) {
+                cache(std::move(_valueB), false);
+                break;
+            } else if (cmp == AFTER) {
+                if (_rc.wantMissB())
+                    _rc.missB(_valueB);
+                continue;
             }
+
+            bool rv = _rc.hit(valueA, _valueB);
+            hitA |= rv;
+            cache(std::move(_valueB), rv);
         }
+        return hitA;
+    }
+
+    // Reports what is left of B as misses once A is done
+    void finish() {
         while (_rc.wantMissB() && !_cache.empty())
             popCache();
-        while (_rc.wantMissB() && !_b.eof() && advanceSorted(_b, valueB))
-            _rc.missB(valueB);
+        while (_rc.wantMissB() && !_b.eof() && advanceSorted(_b, _valueB))
+            _rc.missB(_valueB);
     }
 
-    void cache(const TypeB& valueB, bool hit) {
-        _cache.push_back(CacheEntry(valueB, hit));
+    void cache(TypeB&& valueB, bool hit) {
+        if (_cache.full()) {
+            CacheType bigger(_cache.capacity() * 2);
+            for (auto i = _cache.begin(); i != _cache.end(); ++i)
+                bigger.push_back(std::move(*i));
+            _cache.swap(bigger);
+        }
+        _cache.push_back(CacheEntry(std::move(valueB), hit));
     }
 
-    void cacheRemove(const CacheIterator& iter) {
-        if (!iter->hit && _rc.wantMissB())
-            _rc.missB(iter->value);
-        _cache.erase(iter);
+    // Reports an entry leaving the cache as a miss if nothing hit it
+    void expire(CacheEntry& entry) {
+        if (!entry.hit && _rc.wantMissB())
+            _rc.missB(entry.value);
     }
 
     void popCache() {
-        cacheRemove(_cache.begin());
+        expire(_cache.front());
+        _cache.pop_front();
     }
 
 protected:
@@ -188,7 +161,8 @@ protected:
     StreamTypeB& _b;
     CollectorType& _rc;
     CacheType _cache;
-    bool _adjacentInsertions;
+    // read into and moved from as B is read
+    TypeB _valueB;
 };
 
 template<typename StreamTypeA, typename StreamTypeB, typename OutType>
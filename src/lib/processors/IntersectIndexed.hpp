@@ -0,0 +1,83 @@
+#pragma once
+
+#include "IntersectCompare.hpp"
+#include "common/IntervalIndex.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Intersects like IntersectFull, but reads all of B into an IntervalIndex
+// first and then looks up each entry of A in it, so neither input has to
+// be sorted. Meant for a B small enough to keep in memory (e.g., target
+// regions) against a large A.
+//
+// Each entry of A is given to the collector with every entry of B it
+// intersects, in the order they appear in B. Misses in A are reported as
+// they are read, misses in B (in B's order) once A is exhausted.
+template<typename StreamTypeA, typename StreamTypeB, typename CollectorType>
+class IntersectIndexed : public IntersectCompare {
+public:
+    typedef typename StreamTypeA::ValueType TypeA;
+    typedef typename StreamTypeB::ValueType TypeB;
+
+    IntersectIndexed(StreamTypeA& a, StreamTypeB& b, CollectorType& rc, bool adjacentInsertions = false)
+        : IntersectCompare(adjacentInsertions)
+        , _a(a), _b(b), _rc(rc)
+    {
+    }
+
+    void loadB() {
+        TypeB valueB;
+        while (_b.next(valueB))
+            _index.add(std::move(valueB));
+        _index.build();
+        _hitB.assign(_index.size(), false);
+    }
+
+    void execute() {
+        if (!_index.built())
+            loadB();
+
+        TypeA valueA;
+        std::vector<std::size_t> ids;
+        while (_a.next(valueA)) {
+            _index.findTouching(valueA.chrom(), valueA.start(), valueA.stop(), ids);
+
+            bool hitA = false;
+            for (auto i = ids.begin(); i != ids.end(); ++i) {
+                TypeB const& valueB = _index.value(*i);
+                if (compare(valueA, valueB) != INTERSECT)
+                    continue;
+
+                bool rv = _rc.hit(valueA, valueB);
+                hitA |= rv;
+                if (rv)
+                    _hitB[*i] = true;
+            }
+
+            if (!hitA && _rc.wantMissA())
+                _rc.missA(valueA);
+        }
+
+        if (_rc.wantMissB()) {
+            for (std::size_t i = 0; i < _hitB.size(); ++i) {
+                if (!_hitB[i])
+                    _rc.missB(_index.value(i));
+            }
+        }
+    }
+
+protected:
+    StreamTypeA& _a;
+    StreamTypeB& _b;
+    CollectorType& _rc;
+    IntervalIndex<TypeB> _index;
+    std::vector<bool> _hitB;
+};
+
+template<typename StreamTypeA, typename StreamTypeB, typename OutType>
+IntersectIndexed<StreamTypeA, StreamTypeB, OutType>
+makeIndexedIntersector(StreamTypeA& sa, StreamTypeB& sb, OutType& out, bool adjacentInsertions = false) {
+    return IntersectIndexed<StreamTypeA, StreamTypeB, OutType>(sa, sb, out, adjacentInsertions);
+}
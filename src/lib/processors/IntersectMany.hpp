@@ -0,0 +1,81 @@
+#pragma once
+
+#include "IntersectCompare.hpp"
+#include "IntersectFull.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Intersects one sorted stream A with several sorted streams B in a single
+// pass over A. Each B stream keeps its own cache, as in IntersectFull, and
+// each entry of A is given to the collector with a flag for each B stream
+// telling whether anything in it intersects the entry:
+//
+//   rc(valueA, hits)
+//
+// where hits[i] is true if valueA intersects something in the i'th B.
+template<typename StreamTypeA, typename StreamTypeB, typename CollectorType>
+class IntersectMany : public IntersectCompare {
+public:
+    typedef typename StreamTypeA::ValueType TypeA;
+    typedef typename StreamTypeB::ValueType TypeB;
+
+    IntersectMany(
+            StreamTypeA& a,
+            std::vector<StreamTypeB*> const& bs,
+            CollectorType& rc,
+            bool adjacentInsertions = false
+            )
+        : IntersectCompare(adjacentInsertions)
+        , _a(a)
+        , _rc(rc)
+        , _anyHit(new AnyHit)
+    {
+        for (auto i = bs.begin(); i != bs.end(); ++i) {
+            _tracks.push_back(std::unique_ptr<TrackType>(
+                new TrackType(a, **i, *_anyHit, adjacentInsertions)));
+        }
+    }
+
+    void execute() {
+        TypeA valueA;
+        std::vector<bool> hits(_tracks.size());
+        while (!_a.eof() && advanceSorted(_a, valueA)) {
+            for (std::size_t i = 0; i < _tracks.size(); ++i)
+                hits[i] = _tracks[i]->intersect(valueA);
+            _rc(valueA, hits);
+        }
+    }
+
+private:
+    // Counts anything that intersects as a hit
+    struct AnyHit {
+        bool hit(TypeA const&, TypeB const&) { return true; }
+        bool wantMissA() const { return false; }
+        bool wantMissB() const { return false; }
+        void missA(TypeA const&) {}
+        void missB(TypeB const&) {}
+    };
+
+    typedef IntersectFull<StreamTypeA, StreamTypeB, AnyHit> TrackType;
+
+private:
+    StreamTypeA& _a;
+    CollectorType& _rc;
+    // held by pointer so that the tracks' references to it survive a move
+    std::unique_ptr<AnyHit> _anyHit;
+    std::vector<std::unique_ptr<TrackType>> _tracks;
+};
+
+template<typename StreamTypeA, typename StreamTypeB, typename OutType>
+IntersectMany<StreamTypeA, StreamTypeB, OutType>
+makeManyIntersector(
+        StreamTypeA& a,
+        std::vector<StreamTypeB*> const& bs,
+        OutType& out,
+        bool adjacentInsertions = false
+        )
+{
+    return IntersectMany<StreamTypeA, StreamTypeB, OutType>(a, bs, out, adjacentInsertions);
+}
@@ -4,6 +4,7 @@
 #include "common/RelOps.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <set>
@@ -11,21 +12,33 @@
 #include <vector>
 
 namespace {
+    // Orders streams by their next value. Streams whose next values compare
+    // equal are taken in input order, so ties come out grouped by stream in
+    // the order the streams were given.
     template<typename StreamType, typename LessThanCmp>
     struct StreamLessThan {
+        typedef std::pair<StreamType*, std::size_t> Item;
+
         StreamLessThan(LessThanCmp cmp = LessThanCmp())
             : cmp_(cmp)
         {}
 
-        bool operator()(StreamType* a, StreamType* b) const {
+        bool operator()(Item const& a, Item const& b) const {
             typedef typename StreamType::ValueType ValueType;
             ValueType* pa(0);
             ValueType* pb(0);
-            if (a->eof()) return false;
-            if (b->eof()) return true;
-            a->peek(&pa);
-            b->peek(&pb);
-            return cmp_(*pa, *pb);
+            if (a.first->eof() || b.first->eof()) {
+                if (!b.first->eof()) return false;
+                if (!a.first->eof()) return true;
+                return a.second < b.second;
+            }
+            a.first->peek(&pa);
+            b.first->peek(&pb);
+            if (cmp_(*pa, *pb))
+                return true;
+            if (cmp_(*pb, *pa))
+                return false;
+            return a.second < b.second;
         }
 
         LessThanCmp cmp_;
@@ -39,14 +52,18 @@ public:
     typedef typename StreamType::ValueType ValueType;
     typedef std::unique_ptr<StreamType> StreamPtr;
     typedef StreamLessThan<StreamType, LessThanCmp> StreamCmp;
+    typedef typename StreamCmp::Item Item;
 
     MergeSorted(std::vector<StreamPtr> const& inputs, LessThanCmp cmp = LessThanCmp())
         : inputs_(inputs)
         , sortedInputs_(StreamCmp(cmp))
     {
-        for (auto i = inputs_.begin(); i != inputs_.end(); ++i)
-            if (!(*i)->eof())
-                sortedInputs_.insert(i->get());
+        // streams are only added once they are known to have a value so
+        // that comparing them never has to read ahead
+        ValueType* p;
+        for (std::size_t i = 0; i < inputs_.size(); ++i)
+            if (!inputs_[i]->eof() && inputs_[i]->peek(&p))
+                sortedInputs_.insert(Item(inputs_[i].get(), i));
     }
 
     bool next(ValueType& next) {
@@ -56,12 +73,13 @@ public:
 
         bool rv = false;
         while (rv == false && !sortedInputs_.empty()) {
-            StreamType* s = (*sortedInputs_.begin());
+            Item item = *sortedInputs_.begin();
+            StreamType* s = item.first;
             sortedInputs_.erase(sortedInputs_.begin());
             if ((rv = s->next(next))) {
                 ValueType* p;
                 if (s->peek(&p))
-                    sortedInputs_.insert(s);
+                    sortedInputs_.insert(item);
             }
         }
 
@@ -70,7 +88,7 @@ public:
 
 protected:
     std::vector<StreamPtr> const& inputs_;
-    std::multiset<StreamType*, StreamCmp> sortedInputs_;
+    std::set<Item, StreamCmp> sortedInputs_;
 };
 
 
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "common/ObjectPool.hpp"
+#include "common/cstdint.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Processes groups of values (e.g., the bundles made by GroupOverlapping) on
+// worker threads, while keeping the output in the order the groups came in.
+//
+// The calling thread hands in groups with operator(), so the pipeline can
+// sit at the end of a chain of processors. Groups are collected into
+// batches of about batchSize values. Each worker thread calls its own copy
+// of the functor given to start() as func(pipeline). That sets up whatever
+// per-thread state it needs (e.g., a chain of processors) and then calls
+// work(f), which calls f(group, out) for each group in the batches it takes,
+// collecting what f writes to out. The calling thread writes those out
+// batch by batch in input order, while it waits for room to queue more
+// groups and in finish(), so the output is the same as that of processing
+// every group in turn on one thread. An exception thrown for a group is
+// rethrown once every batch before it has been written.
+//
+// If a pool is given, values the workers are done with can be handed to
+// a Recycler passed to work(), and are given back to the pool by the calling
+// thread (which is presumably where they came from) once their batch is
+// written.
+template<typename ValueType>
+class OrderedGroupPipeline : public boost::noncopyable {
+public:
+    typedef std::unique_ptr<ValueType> ValuePtr;
+    typedef std::vector<ValuePtr> ValuePtrVector;
+    typedef ObjectPool<ValueType> PoolType;
+
+    // Takes the place of a worker thread's ObjectPool in processors that
+    // release what they consume
+    struct Recycler {
+        void release(ValuePtr p) {
+            if (p)
+                values.push_back(std::move(p));
+        }
+
+        ValuePtrVector values;
+    };
+
+    OrderedGroupPipeline(
+            std::ostream& out,
+            std::size_t threads = 1,
+            std::size_t batchSize = 1000,
+            PoolType* pool = 0
+            )
+        : out_(out)
+        , pool_(pool)
+        , threads_(threads ? threads : 1)
+        , batchSize_(batchSize ? batchSize : 1)
+        , maxInFlight_(threads_ * 2)
+        , inFlight_(0)
+        , nextSeq_(0)
+        , nextWrite_(0)
+        , noMore_(false)
+        , abort_(false)
+    {}
+
+    ~OrderedGroupPipeline() {
+        stop();
+    }
+
+    template<typename Func>
+    void start(Func const& func) {
+        for (std::size_t i = 0; i < threads_; ++i)
+            workers_.emplace_back(&OrderedGroupPipeline::template runWorker<Func>, this, func);
+    }
+
+    void operator()(ValuePtrVector group) {
+        if (!current_)
+            current_ = acquire();
+        current_->size += group.size();
+        current_->groups.push_back(std::move(group));
+        if (current_->size >= batchSize_)
+            send();
+    }
+
+    // Processes whatever is left and waits for it to be written
+    void finish() {
+        if (current_ && !current_->groups.empty())
+            send();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            noMore_ = true;
+        }
+        canWork_.notify_all();
+
+        std::exception_ptr error = writeUntil(0);
+        stop();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // For worker threads: calls f(group, out) for each group until there
+    // are no more
+    template<typename GroupFunc>
+    void work(GroupFunc& f, Recycler* recycler = 0) {
+        std::ostringstream out;
+        while (true) {
+            BatchPtr batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!abort_ && todo_.empty() && !noMore_)
+                    canWork_.wait(lock);
+                if (abort_ || todo_.empty())
+                    return;
+                batch = std::move(todo_.front());
+                todo_.pop_front();
+            }
+
+            out.str(std::string());
+            try {
+                for (auto i = batch->groups.begin(); i != batch->groups.end(); ++i)
+                    f(std::move(*i), out);
+            }
+            catch (...) {
+                batch->error = std::current_exception();
+            }
+            batch->out = out.str();
+            if (recycler)
+                batch->spent.swap(recycler->values);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                uint64_t seq = batch->seq;
+                done_[seq] = std::move(batch);
+            }
+            canWrite_.notify_one();
+        }
+    }
+
+private:
+    struct Batch {
+        Batch()
+            : seq(0)
+            , size(0)
+        {}
+
+        uint64_t seq;
+        // the number of values in groups
+        std::size_t size;
+        std::vector<ValuePtrVector> groups;
+        ValuePtrVector spent;
+        std::string out;
+        std::exception_ptr error;
+    };
+    typedef typename ObjectPool<Batch>::Ptr BatchPtr;
+
+    template<typename Func>
+    void runWorker(Func func) {
+        try {
+            func(*this);
+        }
+        catch (...) {
+            // not tied to any batch, so it stops everything as soon as the
+            // writer sees it
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!workerError_)
+                workerError_ = std::current_exception();
+        }
+        canWrite_.notify_all();
+    }
+
+    BatchPtr acquire() {
+        BatchPtr rv;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rv = batches_.acquire();
+        }
+        rv->size = 0;
+        rv->groups.clear();
+        rv->error = std::exception_ptr();
+        return rv;
+    }
+
+    void send() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_->seq = nextSeq_++;
+            todo_.push_back(std::move(current_));
+            ++inFlight_;
+        }
+        canWork_.notify_one();
+
+        std::exception_ptr error = writeUntil(maxInFlight_ - 1);
+        if (error) {
+            stop();
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Writes finished batches in order until no more than maxInFlight are
+    // still to be written
+    std::exception_ptr writeUntil(std::size_t maxInFlight) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            if (workerError_)
+                return workerError_;
+
+            auto found = done_.find(nextWrite_);
+            if (found != done_.end()) {
+                BatchPtr batch = std::move(found->second);
+                done_.erase(found);
+                lock.unlock();
+
+                out_ << batch->out;
+                if (batch->error)
+                    return batch->error;
+                if (pool_)
+                    pool_->release(batch->spent);
+                batch->spent.clear();
+
+                lock.lock();
+                ++nextWrite_;
+                --inFlight_;
+                batches_.release(std::move(batch));
+                continue;
+            }
+
+            if (inFlight_ <= maxInFlight)
+                return std::exception_ptr();
+
+            canWrite_.wait(lock);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            abort_ = true;
+        }
+        canWork_.notify_all();
+
+        for (auto i = workers_.begin(); i != workers_.end(); ++i) {
+            if (i->joinable())
+                i->join();
+        }
+        workers_.clear();
+    }
+
+private:
+    std::ostream& out_;
+    PoolType* pool_;
+    std::size_t threads_;
+    std::size_t batchSize_;
+    std::size_t maxInFlight_;
+    std::vector<std::thread> workers_;
+    // only used by the calling thread
+    BatchPtr current_;
+
+    // everything below is guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable canWork_;
+    std::condition_variable canWrite_;
+    std::size_t inFlight_;
+    uint64_t nextSeq_;
+    uint64_t nextWrite_;
+    bool noMore_;
+    bool abort_;
+    std::exception_ptr workerError_;
+    ObjectPool<Batch> batches_;
+    std::deque<BatchPtr> todo_;
+    std::map<uint64_t, BatchPtr> done_;
+};
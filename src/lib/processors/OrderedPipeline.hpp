@@ -0,0 +1,297 @@
+#pragma once
+
+#include "common/ObjectPool.hpp"
+#include "common/compat.hpp"
+#include "common/cstdint.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What a pipeline functor gets along with each value: somewhere to write
+// its output and warnings, and where the value came from.
+struct OrderedPipelineContext {
+    std::ostream& out;
+    std::ostream& err;
+    uint64_t lineNum;
+};
+
+// Runs a per-value functor over every value in a TypedStream, in parallel,
+// while keeping the output in input order.
+//
+// A reader thread cuts the input into batches of raw lines. Worker threads
+// each take a batch, parse its lines and call their own copy of the functor
+// as func(value, context) on each value, collecting whatever it writes to
+// context.out and context.err. The calling thread writes those out batch by
+// batch in input order, so the output is the same as that of a serial loop.
+// An exception in any stage is rethrown from run() once every batch before
+// it has been written.
+//
+// Each worker has its own copy of the functor, so per-thread state (caches,
+// accumulators) can live in it directly; anything shared between the
+// copies must be safe to use from several threads. run() returns the copies
+// so that per-thread results can be combined.
+//
+// With a single thread, run() is a plain loop on the calling thread that
+// writes straight to the output streams.
+template<typename StreamType>
+class OrderedPipeline : public boost::noncopyable {
+public:
+    typedef typename StreamType::ValueType ValueType;
+
+    OrderedPipeline(
+            StreamType& stream,
+            std::ostream& out,
+            std::size_t threads = 1,
+            std::size_t batchSize = 1000,
+            std::ostream& err = std::cerr
+            )
+        : stream_(stream)
+        , out_(out)
+        , err_(err)
+        , threads_(threads ? threads : 1)
+        , batchSize_(batchSize ? batchSize : 1)
+    {}
+
+    template<typename Func>
+    std::vector<Func> run(Func const& func) {
+        if (threads_ == 1)
+            return runSerial(func);
+        return runParallel(func);
+    }
+
+private:
+    struct Batch {
+        Batch()
+            : seq(0)
+            , size(0)
+        {}
+
+        uint64_t seq;
+        // lines are reused from batch to batch, only the first size are live
+        std::size_t size;
+        std::vector<std::string> lines;
+        std::vector<uint64_t> lineNums;
+        std::string out;
+        std::string err;
+        std::exception_ptr error;
+    };
+    typedef typename ObjectPool<Batch>::Ptr BatchPtr;
+
+    template<typename Func>
+    std::vector<Func> runSerial(Func const& func) {
+        std::vector<Func> funcs(1, func);
+        auto parser = stream_.parser();
+        ValueType value;
+        std::string line;
+        uint64_t lineNum = 0;
+        while (stream_.nextLine(line, lineNum)) {
+            stream_.parseLine(parser, line, lineNum, value);
+            OrderedPipelineContext ctx{out_, err_, lineNum};
+            funcs[0](value, ctx);
+        }
+        return funcs;
+    }
+
+    template<typename Func>
+    std::vector<Func> runParallel(Func const& func) {
+        std::vector<Func> funcs(threads_, func);
+        maxInFlight_ = threads_ * 2;
+        inFlight_ = 0;
+        nextSeq_ = 0;
+        readerDone_ = false;
+        abort_ = false;
+
+        std::vector<std::thread> threads;
+        threads.emplace_back(&OrderedPipeline::readBatches, this);
+        for (std::size_t i = 0; i < threads_; ++i)
+            threads.emplace_back(&OrderedPipeline::template work<Func>, this, std::ref(funcs[i]));
+
+        std::exception_ptr error;
+        try {
+            writeBatches();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            abort_ = true;
+        }
+        canRead_.notify_all();
+        canWork_.notify_all();
+
+        for (auto i = threads.begin(); i != threads.end(); ++i)
+            i->join();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        return funcs;
+    }
+
+    void readBatches() {
+        uint64_t seq = 0;
+        bool eof = false;
+        while (!eof) {
+            BatchPtr batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!abort_ && inFlight_ >= maxInFlight_)
+                    canRead_.wait(lock);
+                if (abort_)
+                    return;
+                batch = batches_.acquire();
+                ++inFlight_;
+            }
+
+            batch->seq = seq++;
+            batch->size = 0;
+            batch->error = std::exception_ptr();
+            try {
+                while (batch->size < batchSize_) {
+                    if (batch->size == batch->lines.size()) {
+                        batch->lines.emplace_back();
+                        batch->lineNums.emplace_back();
+                    }
+                    std::size_t idx = batch->size;
+                    if (!stream_.nextLine(batch->lines[idx], batch->lineNums[idx])) {
+                        eof = true;
+                        break;
+                    }
+                    ++batch->size;
+                }
+            }
+            catch (...) {
+                batch->error = std::current_exception();
+                eof = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                todo_.push_back(std::move(batch));
+                readerDone_ = eof;
+            }
+            canWork_.notify_one();
+        }
+        canWork_.notify_all();
+    }
+
+    template<typename Func>
+    void work(Func& func) {
+        auto parser = stream_.parser();
+        ValueType value;
+        std::ostringstream out;
+        std::ostringstream err;
+
+        while (true) {
+            BatchPtr batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!abort_ && todo_.empty() && !readerDone_)
+                    canWork_.wait(lock);
+                if (abort_ || todo_.empty())
+                    return;
+                batch = std::move(todo_.front());
+                todo_.pop_front();
+            }
+
+            out.str(std::string());
+            err.str(std::string());
+            try {
+                for (std::size_t i = 0; i < batch->size; ++i) {
+                    stream_.parseLine(parser, batch->lines[i], batch->lineNums[i], value);
+                    OrderedPipelineContext ctx{out, err, batch->lineNums[i]};
+                    func(value, ctx);
+                }
+            }
+            catch (...) {
+                // anything here comes before a read error in the same batch
+                batch->error = std::current_exception();
+            }
+            batch->out = out.str();
+            batch->err = err.str();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                uint64_t seq = batch->seq;
+                done_[seq] = std::move(batch);
+            }
+            canWrite_.notify_one();
+        }
+    }
+
+    void writeBatches() {
+        while (true) {
+            BatchPtr batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (done_.count(nextSeq_) == 0 && !(readerDone_ && inFlight_ == 0))
+                    canWrite_.wait(lock);
+
+                auto found = done_.find(nextSeq_);
+                if (found == done_.end())
+                    return;
+                batch = std::move(found->second);
+                done_.erase(found);
+            }
+
+            out_ << batch->out;
+            err_ << batch->err;
+            if (batch->error)
+                std::rethrow_exception(batch->error);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++nextSeq_;
+                --inFlight_;
+                batches_.release(std::move(batch));
+            }
+            canRead_.notify_one();
+        }
+    }
+
+private:
+    StreamType& stream_;
+    std::ostream& out_;
+    std::ostream& err_;
+    std::size_t threads_;
+    std::size_t batchSize_;
+
+    // everything below is guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable canRead_;
+    std::condition_variable canWork_;
+    std::condition_variable canWrite_;
+    std::size_t maxInFlight_;
+    std::size_t inFlight_;
+    uint64_t nextSeq_;
+    bool readerDone_;
+    bool abort_;
+    ObjectPool<Batch> batches_;
+    std::deque<BatchPtr> todo_;
+    std::map<uint64_t, BatchPtr> done_;
+};
+
+template<typename StreamType>
+std::unique_ptr<OrderedPipeline<StreamType>> makeOrderedPipeline(
+        StreamType& stream,
+        std::ostream& out,
+        std::size_t threads = 1,
+        std::size_t batchSize = 1000
+        )
+{
+    return std::make_unique<OrderedPipeline<StreamType>>(stream, out, threads, batchSize);
+}
@@ -0,0 +1,150 @@
+#include "StageStats.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    thread_local StageTimer* currentTimer = 0;
+
+    double toSeconds(chrono::steady_clock::duration d) {
+        return chrono::duration_cast<chrono::duration<double>>(d).count();
+    }
+
+    void writeJsonString(ostream& s, string const& str) {
+        s << '"';
+        for (auto i = str.begin(); i != str.end(); ++i) {
+            if (*i == '"' || *i == '\\')
+                s << '\\';
+            s << *i;
+        }
+        s << '"';
+    }
+}
+
+StageStats::StageStats(string name)
+    : name_(std::move(name))
+    , calls_(0)
+    , records_(0)
+    , maxGroupSize_(0)
+    , peakGroupBytes_(0)
+    , time_(0)
+    , childTime_(0)
+{}
+
+void StageStats::addRecords(size_t n) {
+    ++calls_;
+    records_ += n;
+}
+
+void StageStats::addGroup(size_t size, size_t bytes) {
+    addRecords(size);
+
+    size_t bucket = 0;
+    for (size_t x = size; x; x >>= 1)
+        ++bucket;
+    if (bucket >= groupSizes_.size())
+        groupSizes_.resize(bucket + 1);
+    ++groupSizes_[bucket];
+
+    maxGroupSize_ = max(maxGroupSize_, size);
+    peakGroupBytes_ = max(peakGroupBytes_, bytes);
+}
+
+StageStats& StageStats::operator+=(StageStats const& rhs) {
+    calls_ += rhs.calls_;
+    records_ += rhs.records_;
+    if (rhs.groupSizes_.size() > groupSizes_.size())
+        groupSizes_.resize(rhs.groupSizes_.size());
+    for (size_t i = 0; i < rhs.groupSizes_.size(); ++i)
+        groupSizes_[i] += rhs.groupSizes_[i];
+    maxGroupSize_ = max(maxGroupSize_, rhs.maxGroupSize_);
+    peakGroupBytes_ = max(peakGroupBytes_, rhs.peakGroupBytes_);
+    time_ += rhs.time_;
+    childTime_ += rhs.childTime_;
+    return *this;
+}
+
+double StageStats::seconds() const {
+    return toSeconds(time_);
+}
+
+double StageStats::selfSeconds() const {
+    return toSeconds(time_ - childTime_);
+}
+
+void StageStats::toJson(ostream& s) const {
+    s << "{\"name\": ";
+    writeJsonString(s, name_);
+    s << ", \"calls\": " << calls_
+        << ", \"records\": " << records_
+        << ", \"seconds\": " << seconds()
+        << ", \"self_seconds\": " << selfSeconds();
+
+    if (!groupSizes_.empty()) {
+        s << ", \"max_group_size\": " << maxGroupSize_
+            << ", \"peak_group_bytes\": " << peakGroupBytes_
+            << ", \"group_sizes\": [";
+        bool first = true;
+        for (size_t i = 0; i < groupSizes_.size(); ++i) {
+            if (!groupSizes_[i])
+                continue;
+            uint64_t lo = i ? uint64_t(1) << (i - 1) : 0;
+            uint64_t hi = i ? (uint64_t(1) << i) - 1 : 0;
+            s << (first ? "" : ", ")
+                << "{\"min\": " << lo << ", \"max\": " << hi
+                << ", \"count\": " << groupSizes_[i] << "}";
+            first = false;
+        }
+        s << "]";
+    }
+    s << "}";
+}
+
+StageTimer::StageTimer(StageStats* stage)
+    : stage_(stage)
+    , parent_(0)
+{
+    if (!stage_)
+        return;
+
+    parent_ = currentTimer;
+    currentTimer = this;
+    start_ = chrono::steady_clock::now();
+}
+
+StageTimer::~StageTimer() {
+    if (!stage_)
+        return;
+
+    auto elapsed = chrono::steady_clock::now() - start_;
+    stage_->time_ += elapsed;
+    if (parent_)
+        parent_->stage_->childTime_ += elapsed;
+    currentTimer = parent_;
+}
+
+StageStats* PipelineStats::stage(string const& name) {
+    for (auto i = stages_.begin(); i != stages_.end(); ++i) {
+        if ((*i)->name() == name)
+            return i->get();
+    }
+
+    stages_.push_back(std::unique_ptr<StageStats>(new StageStats(name)));
+    return stages_.back().get();
+}
+
+PipelineStats& PipelineStats::operator+=(PipelineStats const& rhs) {
+    for (auto i = rhs.stages_.begin(); i != rhs.stages_.end(); ++i)
+        *stage((*i)->name()) += **i;
+    return *this;
+}
+
+void PipelineStats::toJson(ostream& s) const {
+    s << "{\"stages\": [";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        s << (i ? ",\n    " : "\n    ");
+        stages_[i]->toJson(s);
+    }
+    s << "\n]}\n";
+}
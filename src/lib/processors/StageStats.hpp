@@ -0,0 +1,203 @@
+#pragma once
+
+#include "common/cstdint.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Wall time, calls and record counts of one stage of a pipeline, with a
+// histogram of group sizes and the largest group seen for stages that take
+// groups of records. Time is kept both in total and excluding the time
+// spent in other timed stages called from this one (see StageTimer).
+// Totals kept by different threads can be added up with +=, in which case
+// the times are summed over the threads.
+class StageStats {
+public:
+    explicit StageStats(std::string name);
+
+    // n records passed through in one call
+    void addRecords(std::size_t n);
+    // A group of size records taking up about bytes of memory passed
+    // through in one call
+    void addGroup(std::size_t size, std::size_t bytes);
+
+    StageStats& operator+=(StageStats const& rhs);
+
+    std::string const& name() const { return name_; }
+    uint64_t calls() const { return calls_; }
+    uint64_t records() const { return records_; }
+    std::size_t maxGroupSize() const { return maxGroupSize_; }
+    std::size_t peakGroupBytes() const { return peakGroupBytes_; }
+
+    // Counts of groups by size: element i counts groups of 2^(i-1) to
+    // 2^i - 1 records (element 0 counts empty groups)
+    std::vector<uint64_t> const& groupSizes() const { return groupSizes_; }
+
+    double seconds() const;
+    double selfSeconds() const;
+
+    void toJson(std::ostream& s) const;
+
+private:
+    friend class StageTimer;
+
+    std::string name_;
+    uint64_t calls_;
+    uint64_t records_;
+    std::vector<uint64_t> groupSizes_;
+    std::size_t maxGroupSize_;
+    std::size_t peakGroupBytes_;
+    std::chrono::steady_clock::duration time_;
+    std::chrono::steady_clock::duration childTime_;
+};
+
+// Adds the time from its construction to its destruction to a stage and
+// takes it off the self time of the stage of the enclosing StageTimer on
+// the same thread, if any. Does nothing for a null stage.
+class StageTimer : public boost::noncopyable {
+public:
+    explicit StageTimer(StageStats* stage);
+    ~StageTimer();
+
+private:
+    StageStats* stage_;
+    StageTimer* parent_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// The stages of a pipeline, in the order they were first asked for
+class PipelineStats {
+public:
+    // The named stage, added if it is not there yet. The pointer stays
+    // valid for the life of this object.
+    StageStats* stage(std::string const& name);
+
+    // Adds up the stages of the same name, appending those not seen yet
+    PipelineStats& operator+=(PipelineStats const& rhs);
+
+    std::vector<std::unique_ptr<StageStats>> const& stages() const {
+        return stages_;
+    }
+
+    void toJson(std::ostream& s) const;
+
+private:
+    std::vector<std::unique_ptr<StageStats>> stages_;
+};
+
+// The named stage of stats, or null if stats is null
+inline StageStats* pipelineStage(PipelineStats* stats, std::string const& name) {
+    return stats ? stats->stage(name) : 0;
+}
+
+// Passes what it is given on to out, timing each call as a stage and
+// counting what goes through. Vectors are taken as groups of records; the
+// memory of a group is estimated with approxBytes() on each of its
+// (pointed to) values. With a null stage, values are just passed on.
+template<typename OutputFunc>
+class TimedStage {
+public:
+    TimedStage(OutputFunc& out, StageStats* stage)
+        : out_(out)
+        , stage_(stage)
+    {}
+
+    template<typename T>
+    void operator()(T&& value) {
+        if (stage_)
+            count(value);
+        StageTimer timer(stage_);
+        out_(std::forward<T>(value));
+    }
+
+    // Passes on the end of a stream (see StreamPump)
+    void flush() {
+        StageTimer timer(stage_);
+        out_.flush();
+    }
+
+private:
+    template<typename ValuePtr>
+    void count(std::vector<ValuePtr> const& group) {
+        std::size_t bytes = 0;
+        for (auto i = group.begin(); i != group.end(); ++i)
+            bytes += (*i)->approxBytes();
+        stage_->addGroup(group.size(), bytes);
+    }
+
+    template<typename T>
+    void count(T const&) {
+        stage_->addRecords(1);
+    }
+
+private:
+    OutputFunc& out_;
+    StageStats* stage_;
+};
+
+template<typename OutputFunc>
+TimedStage<OutputFunc>
+makeTimedStage(OutputFunc& out, StageStats* stage) {
+    return TimedStage<OutputFunc>(out, stage);
+}
+
+// Wraps a stream (anything with next(ValueType&), peek(ValueType**), eof()
+// and name()) timing the calls that read a new value as a stage: next()
+// and the first peek() after it. Later peeks just return what was read.
+template<typename StreamType>
+class TimedStream {
+public:
+    typedef typename StreamType::ValueType ValueType;
+
+    TimedStream(StreamType& in, StageStats* stage)
+        : in_(in)
+        , stage_(stage)
+        , peeked_(false)
+    {}
+
+    std::string const& name() const {
+        return in_.name();
+    }
+
+    bool eof() const {
+        return in_.eof();
+    }
+
+    bool peek(ValueType** value) {
+        if (peeked_)
+            return in_.peek(value);
+
+        peeked_ = true;
+        StageTimer timer(stage_);
+        return in_.peek(value);
+    }
+
+    bool next(ValueType& value) {
+        if (peeked_) {
+            peeked_ = false;
+            return count(in_.next(value));
+        }
+
+        StageTimer timer(stage_);
+        return count(in_.next(value));
+    }
+
+private:
+    bool count(bool read) {
+        if (read && stage_)
+            stage_->addRecords(1);
+        return read;
+    }
+
+private:
+    StreamType& in_;
+    StageStats* stage_;
+    bool peeked_;
+};
@@ -1,16 +1,18 @@
 #pragma once
 
+#include "common/ObjectPool.hpp"
 #include "fileformats/vcf/ConsensusFilter.hpp"
 #include "fileformats/vcf/Entry.hpp"
 #include "fileformats/vcf/EntryMerger.hpp"
 #include "fileformats/vcf/GenotypeMerger.hpp" // TODO: move DisjointAllelesException out of this header
 #include "fileformats/vcf/Header.hpp"
 #include "fileformats/vcf/MergeStrategy.hpp"
+#include "fileformats/vcf/SampleRemap.hpp"
 
 #include <memory>
 #include <vector>
 
-template<typename OutputFunc>
+template<typename OutputFunc, typename PoolType = NoObjectPool>
 class VcfEntryMerger {
 public:
     typedef std::unique_ptr<Vcf::Entry> ValuePtr;
@@ -20,10 +22,13 @@ public:
               OutputFunc& out
             , Vcf::Header* mergedHeader
             , Vcf::MergeStrategy const& mergeStrategy
+            , PoolType* pool = 0
             )
         : out_(out)
         , mergedHeader_(mergedHeader)
         , mergeStrategy_(mergeStrategy)
+        , pool_(pool)
+        , remap_(mergedHeader)
     {}
 
     void writeMergedEntry(Vcf::Entry& e) {
@@ -33,31 +38,35 @@ public:
     }
 
     void operator()(ValuePtrVector entries) {
-        using namespace Vcf;
-        // FIXME: rewrite EntryMerger to work with pointers so we don't
-        // have to move the entries into this vector
-        std::vector<Vcf::Entry> rawEntries(entries.size());
-        for (std::size_t i = 0; i < entries.size(); ++i) {
-            rawEntries[i] = std::move(*entries[i]);
-        }
-        entries.clear();
+        entryPtrs_.clear();
+        for (auto i = entries.begin(); i != entries.end(); ++i)
+            entryPtrs_.push_back(i->get());
 
-        auto begin = rawEntries.data();
-        auto end = rawEntries.data() + rawEntries.size();
+        merge(entries);
 
-        EntryMerger merger(mergeStrategy_ , mergedHeader_ , begin , end);
+        if (pool_) {
+            for (auto i = entries.begin(); i != entries.end(); ++i)
+                pool_->release(std::move(*i));
+        }
+    }
+
+private:
+    void merge(ValuePtrVector& entries) {
+        using namespace Vcf;
+        auto begin = entryPtrs_.data();
+        auto end = entryPtrs_.data() + entryPtrs_.size();
 
         auto cnsFilt = mergeStrategy_.consensusFilter();
         try {
             EntryMerger merger(mergeStrategy_, mergedHeader_, begin, end);
             // no merging happened, output each entry individually
             if (!merger.merged()) {
-                for (auto e = rawEntries.begin(); e != rawEntries.end(); ++e) {
+                for (auto e = entries.begin(); e != entries.end(); ++e) {
                     if (cnsFilt)
-                        cnsFilt->apply(*e, 0);
+                        cnsFilt->apply(**e, 0);
 
-                    e->reheader(mergedHeader_);
-                    writeMergedEntry(*e);
+                    (*e)->reheader(mergedHeader_, remap_((*e)->header()));
+                    writeMergedEntry(**e);
                 }
                 return;
             }
@@ -76,11 +85,13 @@ public:
         }
     }
 
-
 private:
     OutputFunc& out_;
     Vcf::Header* mergedHeader_;
     Vcf::MergeStrategy const& mergeStrategy_;
+    PoolType* pool_;
+    Vcf::SampleRemap remap_;
+    std::vector<Vcf::Entry const*> entryPtrs_;
 };
 
 template<typename OutputFunc>
@@ -94,3 +105,15 @@ makeVcfEntryMerger(
     return VcfEntryMerger<OutputFunc>(out, mergedHeader, mergeStrategy);
 }
 
+template<typename OutputFunc, typename PoolType>
+VcfEntryMerger<OutputFunc, PoolType>
+makeVcfEntryMerger(
+          OutputFunc& out
+        , Vcf::Header* mergedHeader
+        , Vcf::MergeStrategy const& mergeStrategy
+        , PoolType* pool
+        )
+{
+    return VcfEntryMerger<OutputFunc, PoolType>(out, mergedHeader, mergeStrategy, pool);
+}
+
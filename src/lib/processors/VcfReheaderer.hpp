@@ -2,6 +2,7 @@
 
 #include "fileformats/vcf/Entry.hpp"
 #include "fileformats/vcf/Header.hpp"
+#include "fileformats/vcf/SampleRemap.hpp"
 
 #include <memory>
 #include <vector>
@@ -15,11 +16,12 @@ public:
     VcfReheaderer(OutputFunc& out, Vcf::Header const* header)
         : out_(out)
         , header_(header)
+        , remap_(header)
     {}
 
     void operator()(ValuePtrVector entries) {
         for (auto i = entries.begin(); i != entries.end(); ++i) {
-            (*i)->reheader(header_);
+            (*i)->reheader(header_, remap_((*i)->header()));
         }
         out_(std::move(entries));
     }
@@ -27,6 +29,7 @@ public:
 private:
     OutputFunc& out_;
     Vcf::Header const* header_;
+    Vcf::SampleRemap remap_;
 };
 
 template<typename OutputFunc>
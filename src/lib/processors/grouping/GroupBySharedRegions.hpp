@@ -1,12 +1,13 @@
 #pragma once
 
 #include "common/CoordinateView.hpp"
+#include "common/DisjointSets.hpp"
 
-#include <boost/config.hpp>
-#include <boost/graph/adjacency_matrix.hpp>
-#include <boost/graph/connected_components.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -38,10 +39,19 @@ struct VcfRegionExtractor {
 };
 // END FIXME
 
+struct IgnoreGroupStart {
+    template<typename T>
+    void operator()(T const&) const {}
+};
 
+// groupStartFunc is called with the entry that starts first in each group
+// (the earliest such in the group on ties) before the group is sent on.
+// Groups go out in order of the start of that entry, so nothing in a later
+// group starts before it.
 template<
           typename OutputFunc
         , typename RegionExtractor = VcfRegionExtractor // FIXME: get rid of default
+        , typename GroupStartFunc = IgnoreGroupStart
         >
 class GroupBySharedRegions {
 public:
@@ -50,100 +60,116 @@ public:
     GroupBySharedRegions(
               OutputFunc& out
             , RegionExtractor regionExtractor = RegionExtractor()
+            , GroupStartFunc groupStartFunc = GroupStartFunc()
             )
         : out_(out)
         , regionExtractor_(regionExtractor)
+        , groupStartFunc_(groupStartFunc)
     {}
 
-    template<typename Members, typename Graph>
-    void add_component(Members const& xs, Graph& g) {
-        using namespace boost;
-        for (std::size_t i = 0; i < xs.size(); ++i) {
-            for (std::size_t j = i + 1; j < xs.size(); ++j) {
-                add_edge(xs[i], xs[j], g);
-            }
+    // A group and the index of the entry in it that starts first
+    template<typename GroupType>
+    struct LeadedGroup_ {
+        GroupType* group;
+        std::size_t lead;
+
+        typename GroupType::value_type const& leader() const {
+            return (*group)[lead];
         }
-    }
+    };
 
-    // Sort vectors of entries (all of which should have the same region) by
-    // start/stop position
+    // Sort groups by the start/stop position of their leading entries
     struct SortHelper_ {
         template<typename GroupType>
-        bool operator()(GroupType const& x, GroupType const& y) const {
-            if (x->empty() || y->empty())
-                return true; // doesn't matter if one or both are empty;
-
-            if ((*x)[0]->start() < (*y)[0]->start())
+        bool operator()(LeadedGroup_<GroupType> const& x, LeadedGroup_<GroupType> const& y) const {
+            if (x.leader()->start() < y.leader()->start())
                 return true;
 
-            if ((*x)[0]->start() > (*y)[0]->start())
+            if (x.leader()->start() > y.leader()->start())
                 return false;
 
-            return (*x)[0]->stop() < (*y)[0]->stop();
+            return x.leader()->stop() < y.leader()->stop();
         }
     };
 
+    // Entries sharing a region are joined into one set as soon as the
+    // region is seen again, so this is linear in the number of regions
+    // rather than quadratic in the number of entries sharing each one.
     template<typename ValuePtr>
     void operator()(std::vector<ValuePtr> entries) {
         typedef std::vector<ValuePtr> ValuePtrVector;
 
-        std::vector<RegionSet> regions(entries.size());
-        boost::unordered_map<Region, boost::unordered_set<std::size_t>> regionToEntries;
+        sets_.reset(entries.size());
+        firstWithRegion_.clear();
         for (std::size_t i = 0; i < entries.size(); ++i) {
-            std::size_t entryIdx = i;
-            regions[i] = regionExtractor_(*entries[i]);
-            for (auto j = regions[i].begin(); j != regions[i].end(); ++j) {
-                regionToEntries[*j].insert(entryIdx);
+            RegionSet regions = regionExtractor_(*entries[i]);
+            for (auto j = regions.begin(); j != regions.end(); ++j) {
+                auto inserted = firstWithRegion_.insert(std::make_pair(*j, i));
+                if (!inserted.second)
+                    sets_.unite(inserted.first->second, i);
             }
         }
 
-        using namespace boost;
-        typedef adjacency_matrix<undirectedS> Graph;
-        Graph graph(entries.size());
-
-        for (auto x = regionToEntries.begin(); x != regionToEntries.end(); ++x) {
-            std::vector<std::size_t> xs(x->second.begin(), x->second.end());
-            add_component(xs, graph);
-        }
-
-        std::vector<int> components(entries.size());
-        connected_components(graph, &components[0]);
-
-        boost::unordered_map<int, ValuePtrVector> groups;
-        for (std::size_t i = 0; i < components.size(); ++i) {
-            groups[components[i]].push_back(std::move(entries[i]));
+        // Number the groups in order of their first entry, as
+        // connected_components would
+        components_.assign(entries.size(), entries.size());
+        std::size_t nGroups = 0;
+        boost::unordered_map<std::size_t, ValuePtrVector> groups;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            std::size_t& component = components_[sets_.find(i)];
+            if (component == entries.size())
+                component = nGroups++;
+            groups[component].push_back(std::move(entries[i]));
         }
 
         // The groups are not necessarily sorted at this point
         // Let's fix that...
         // gcc 4.4 can't deal with sorting std::vector<std::vector<std::unique_ptr<T>>>
         // using raw pointers instead
-        std::vector<ValuePtrVector*> sortedGroups;
+        typedef LeadedGroup_<ValuePtrVector> Leaded;
+        std::vector<Leaded> sortedGroups;
         sortedGroups.reserve(groups.size());
         for (auto i = groups.begin(); i != groups.end(); ++i) {
-            sortedGroups.push_back(&i->second);
+            // an entry listed later (e.g., a snv joined to a padded indel
+            // through a multi-allelic record) can start before the first
+            ValuePtrVector const& group = i->second;
+            std::size_t lead = 0;
+            for (std::size_t j = 1; j < group.size(); ++j) {
+                if (group[j]->start() < group[lead]->start())
+                    lead = j;
+            }
+            sortedGroups.push_back(Leaded{&i->second, lead});
         }
         std::sort(sortedGroups.begin(), sortedGroups.end(), SortHelper_{});
 
         for (auto i = sortedGroups.begin(); i != sortedGroups.end(); ++i) {
-            out_(std::move(**i));
+            groupStartFunc_(*i->leader());
+            out_(std::move(*i->group));
         }
     }
 
 private:
     OutputFunc& out_;
     RegionExtractor regionExtractor_;
+    GroupStartFunc groupStartFunc_;
+    // scratch space reused between bundles
+    DisjointSets sets_;
+    boost::unordered_map<Region, std::size_t> firstWithRegion_;
+    std::vector<std::size_t> components_;
 };
 
 template<
           typename OutputFunc
         , typename RegionExtractor = VcfRegionExtractor // FIXME: get rid of default
+        , typename GroupStartFunc = IgnoreGroupStart
         >
-GroupBySharedRegions<OutputFunc, RegionExtractor>
+GroupBySharedRegions<OutputFunc, RegionExtractor, GroupStartFunc>
 makeGroupBySharedRegions(
               OutputFunc& out
             , RegionExtractor regionExtractor = RegionExtractor()
+            , GroupStartFunc groupStartFunc = GroupStartFunc()
             )
 {
-    return GroupBySharedRegions<OutputFunc, RegionExtractor>(out, regionExtractor);
+    return GroupBySharedRegions<OutputFunc, RegionExtractor, GroupStartFunc>(
+        out, regionExtractor, groupStartFunc);
 }
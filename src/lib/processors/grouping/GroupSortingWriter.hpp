@@ -1,29 +1,42 @@
 #pragma once
 
+#include "common/cstdint.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 
+#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/ref.hpp>
 
-#include <ostream>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
 #include <vector>
 
+// Writes entries sorted by start/stop position (ties in the order they came
+// in, or by REF and ALT first if orderAlleles(true) is set). Entries are held in a heap until endGroup() is called, the
+// chromosome changes, or flushBefore() says that nothing starting before
+// a given entry is still to come, so only the window of entries that may
+// still need reordering is kept in memory.
+//
+// The entries themselves are kept by value in slots that are reused once
+// written, and the heap orders slot numbers, so holding an entry does not
+// allocate.
 struct GroupSortingWriter : public boost::noncopyable {
     typedef void result_type;
 
-    struct SortHelper_ {
-        bool operator()(Vcf::Entry const& x, Vcf::Entry const& y) const {
-            if (x.start() < y.start())
-                return true;
+    typedef boost::function<void(Vcf::Entry const&)> OutputFunc;
 
-            if (x.start() > y.start())
-                return false;
-
-            return x.stop() < y.stop();
-        }
-    };
+    GroupSortingWriter(Vcf::EntryWriter& out)
+        : out(boost::ref(out))
+        , seq_(0)
+        , orderAlleles_(false)
+    {}
 
-    GroupSortingWriter(std::ostream& out)
-        : out(out)
+    explicit GroupSortingWriter(OutputFunc out)
+        : out(std::move(out))
+        , seq_(0)
+        , orderAlleles_(false)
     {}
 
     ~GroupSortingWriter() {
@@ -31,21 +44,105 @@ struct GroupSortingWriter : public boost::noncopyable {
     }
 
     void operator()(Vcf::Entry e) {
-        if (!entries.empty() && e.chrom() != entries[0].chrom())
+        if (!heap_.empty() && e.chrom() != front().chrom())
+            endGroup();
+
+        std::size_t slot;
+        if (free_.empty()) {
+            slot = slots_.size();
+            slots_.push_back(std::move(e));
+        }
+        else {
+            slot = free_.back();
+            free_.pop_back();
+            slots_[slot] = std::move(e);
+        }
+
+        heap_.push_back(Item{slot, seq_++});
+        std::push_heap(heap_.begin(), heap_.end(), Later_{slots_, orderAlleles_});
+    }
+
+    // Writes everything that sorts before any entry starting where e does
+    // (or everything, if e is on another chromosome). Later entries must not
+    // start before e.
+    void flushBefore(Vcf::Entry const& e) {
+        if (!heap_.empty() && e.chrom() != front().chrom()) {
             endGroup();
+            return;
+        }
 
-        entries.push_back(std::move(e));
+        while (!heap_.empty() && front().start() < e.start())
+            pop();
     }
 
     void endGroup() {
-        std::sort(entries.begin(), entries.end(), SortHelper_{});
-        for (auto i = entries.begin(); i != entries.end(); ++i) {
-            out << *i << "\n";
+        while (!heap_.empty())
+            pop();
+        seq_ = 0;
+    }
+
+    // Orders entries with the same start and stop by REF, then ALT, so that
+    // their order does not depend on the order they are written in
+    void orderAlleles(bool value) {
+        orderAlleles_ = value;
+    }
+
+    // The number of entries waiting to be written
+    std::size_t size() const {
+        return heap_.size();
+    }
+
+    OutputFunc out;
+
+private:
+    struct Item {
+        std::size_t slot;
+        uint64_t seq;
+    };
+
+    // Heap order: the item at the front is the first to write
+    struct Later_ {
+        std::vector<Vcf::Entry> const& slots;
+        bool orderAlleles;
+
+        bool operator()(Item const& x, Item const& y) const {
+            Vcf::Entry const& a = slots[x.slot];
+            Vcf::Entry const& b = slots[y.slot];
+            if (a.start() != b.start())
+                return a.start() > b.start();
+
+            if (a.stop() != b.stop())
+                return a.stop() > b.stop();
+
+            if (orderAlleles) {
+                if (a.ref() != b.ref())
+                    return a.ref() > b.ref();
+
+                if (a.alt() != b.alt())
+                    return a.alt() > b.alt();
+            }
+
+            return x.seq > y.seq;
         }
-        entries.clear();
+    };
+
+    Vcf::Entry const& front() const {
+        return slots_[heap_[0].slot];
     }
 
-    std::ostream& out;
-    std::vector<Vcf::Entry> entries;
-};
+    void pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), Later_{slots_, orderAlleles_});
+        Item item = heap_.back();
+        heap_.pop_back();
+        out(slots_[item.slot]);
+        free_.push_back(item.slot);
+    }
 
+private:
+    std::vector<Item> heap_;
+    // entries by value, and the slots among them that are free to reuse
+    std::vector<Vcf::Entry> slots_;
+    std::vector<std::size_t> free_;
+    uint64_t seq_;
+    bool orderAlleles_;
+};
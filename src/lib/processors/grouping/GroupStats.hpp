@@ -1,62 +1,101 @@
 #pragma once
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-#include <boost/accumulators/statistics/max.hpp>
-#include <boost/accumulators/statistics/mean.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/variance.hpp>
-
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 
-namespace detail {
-    namespace ba = boost::accumulators;
-
-    typedef ba::accumulator_set<
-          double
-        , ba::stats<
-              ba::tag::count
-            , ba::tag::mean
-            , ba::tag::max
-            , ba::tag::variance
-            >
-        > accum_type;
-}
+// Count, max, mean and standard deviation of group sizes. Totals kept for
+// different parts of the input (e.g., by different threads) can be added
+// up with +=.
+class GroupSizeStats {
+public:
+    explicit GroupSizeStats(std::string name)
+        : name_(std::move(name))
+        , count_(0)
+        , max_(0)
+        , sum_(0)
+        , sumSquares_(0)
+    {}
+
+    void add(std::size_t size) {
+        double x = size;
+        ++count_;
+        max_ = std::max(max_, x);
+        sum_ += x;
+        sumSquares_ += x * x;
+    }
+
+    GroupSizeStats& operator+=(GroupSizeStats const& rhs) {
+        count_ += rhs.count_;
+        max_ = std::max(max_, rhs.max_);
+        sum_ += rhs.sum_;
+        sumSquares_ += rhs.sumSquares_;
+        return *this;
+    }
+
+    std::size_t count() const { return count_; }
+    double max() const { return max_; }
+
+    double mean() const {
+        return count_ ? sum_ / count_ : 0;
+    }
+
+    double sd() const {
+        if (!count_)
+            return 0;
+        double m = mean();
+        return std::sqrt(std::max(0.0, sumSquares_ / count_ - m * m));
+    }
+
+    template<typename OS>
+    friend OS& operator<<(OS& os, GroupSizeStats const& stats) {
+        os << "Group size statistics for '" << stats.name_ << "':\n";
+        os << "\tcount: " << stats.count() << "\n";
+        os << "\tmax  : " << stats.max() << "\n";
+        os << "\tmean : " << stats.mean() << "\n";
+        os << "\tsd   : " << stats.sd() << "\n";
+
+        return os;
+    }
+
+private:
+    std::string name_;
+    std::size_t count_;
+    double max_;
+    double sum_;
+    double sumSquares_;
+};
 
 template<typename OutputFunc>
 class GroupStats {
 public:
     GroupStats(OutputFunc& out, std::string name)
         : out_(out)
-        , name_(name)
+        , stats_(std::move(name))
     {}
 
     template<typename ValuePtr>
     void operator()(std::vector<ValuePtr> entries) {
-        accum_(entries.size());
+        stats_.add(entries.size());
         out_(std::move(entries));
     }
 
+    GroupSizeStats const& stats() const {
+        return stats_;
+    }
+
     template<typename OS>
     friend OS& operator<<(OS& os, GroupStats const& stats) {
-        namespace ba = boost::accumulators;
-        os << "Group size statistics for '" << stats.name_ << "':\n";
-        os << "\tcount: " << ba::count(stats.accum_) << "\n";
-        os << "\tmax  : " << ba::max(stats.accum_) << "\n";
-        os << "\tmean : " << ba::mean(stats.accum_) << "\n";
-        os << "\tsd   : " << std::sqrt(ba::variance(stats.accum_)) << "\n";
-
-        return os;
+        return os << stats.stats_;
     }
 
 private:
     OutputFunc& out_;
-    std::string name_;
-    detail::accum_type accum_;
+    GroupSizeStats stats_;
 };
 
 template<typename OutputFunc>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "fileformats/AlleleKey.hpp"
 #include "fileformats/Bed.hpp"
 #include "fileformats/Variant.hpp"
 #include "processors/IntersectionOutputFormatter.hpp"
@@ -48,8 +49,9 @@ public:
     }
 
     bool hit(const Bed& a, const Bed& b) {
-        Variant va(a);
-        Variant vb(b);
+        // Hits are matched on AlleleKeys rather than Variants; they are
+        // refilled in place for each hit, and b's only when it is needed.
+        _keyA.assign(a);
 
         // If we are only outputting A then skip things that we just printed.
         // The core intersector returns the full join of A and B.
@@ -57,7 +59,7 @@ public:
         // each time A intersects something in B, an identical line
         // will be printed.
         if (_hitCount > 0 && !_outputBoth &&
-            _lastA.positionMatch(va) && _lastA.alleleMatch(va))
+            _lastA.positionMatch(_keyA) && _lastA.alleleMatch(_keyA))
         {
             return true; // already hit
         }
@@ -66,30 +68,37 @@ public:
         // TODO: clean this up! stop using bools and pass in a mode or functor
         // i.e., flatten this
         if (_exactAllele) {
-            if (!va.positionMatch(vb))
+            _keyB.assign(b);
+            if (!_keyA.positionMatch(_keyB))
                 return false;
 
             if (_dbsnpMatch) {
-                if (!va.alleleDbSnpMatch(vb))
+                // dbsnp matching looks at every allele of b
+                if (!Variant(a).alleleDbSnpMatch(Variant(b)))
                     return false;
             } else if (_iubMatch) {
-                if (!va.allelePartialMatch(vb))
+                if (!_keyA.allelePartialMatch(_keyB))
                     return false;
-            } else if (!va.alleleMatch(vb)) {
+            } else if (!_keyA.alleleMatch(_keyB)) {
                 return false;
             }
 
-        } else if (_exactPos && !va.positionMatch(vb))
-            return false;
+        } else if (_exactPos) {
+            _keyB.assign(b);
+            if (!_keyA.positionMatch(_keyB))
+                return false;
+        }
 
-        _lastA = va;
+        _lastA = _keyA;
         _outputFormatter.output(a, b);
 
         return true;
     }
 
 protected:
-    Variant _lastA;
+    AlleleKey _keyA;
+    AlleleKey _keyB;
+    AlleleKey _lastA;
     bool _outputBoth;
     bool _exactPos;
     bool _exactAllele;
@@ -3,7 +3,9 @@
 
 #include "common/cstdint.hpp"
 #include "fileformats/BedReader.hpp"
+#include "processors/IntersectByChromosome.hpp"
 #include "processors/IntersectFull.hpp"
+#include "processors/IntersectIndexed.hpp"
 #include "processors/IntersectionOutputFormatter.hpp"
 
 #include <boost/format.hpp>
@@ -31,6 +33,9 @@ IntersectCommand::IntersectCommand()
     , _iubMatch(false)
     , _dbsnpMatch(false)
     , _adjacentInsertions(false)
+    , _indexB(false)
+    , _threads(1)
+    , _bufferMb(0)
 {
 }
 
@@ -79,6 +84,22 @@ void IntersectCommand::configureOptions() {
         ("adjacent-insertions",
             po::bool_switch(&_adjacentInsertions),
             "count insertions adjacent to other regions as intersecting")
+
+        ("index-b",
+            po::bool_switch(&_indexB),
+            "load file b into memory and look up each entry of file a in it, "
+            "so that neither file needs to be sorted")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to intersect with, one chromosome at a time; "
+            "each thread holds whole chromosomes of both files in memory, and "
+            "twice as many chromosomes as threads may be read ahead")
+
+        ("buffer-mb",
+            po::value<size_t>(&_bufferMb)->default_value(0),
+            "with --threads, stop reading ahead while the chromosomes in "
+            "memory hold this many MB of input or more (0 for no limit)")
         ;
 
     _posOpts.add("file-a", 1);
@@ -122,6 +143,9 @@ void IntersectCommand::finalizeOptions() {
         _exactPos = true;
     }
 
+    if (_indexB && _threads > 1)
+        throw runtime_error("--index-b and --threads are mutually exclusive");
+
     if (_varMap.count("dbsnp-match")) {
         _exactAllele = true;
         _exactPos = true;
@@ -160,7 +184,28 @@ void IntersectCommand::exec() {
     if (!_missFileA.empty()) outMissA = _streams.get<ostream>(_missFileA);
     if (!_missFileB.empty()) outMissB = _streams.get<ostream>(_missFileB);
 
+    if (_threads > 1) {
+        // each chromosome gets its own formatter and collector writing to
+        // buffers that are written out in order
+        typedef IntersectByChromosome<BedReader, BedReader> ParallelType;
+        ParallelType intersector(fa, fb, *outHit, outMissA, outMissB, _threads, _bufferMb << 20);
+        intersector.run([&](ParallelType::LinesA& a, ParallelType::LinesB& b, IntersectChunkOutput& out) {
+            IntersectionOutput::Formatter formatter(_formatString, out.hits);
+            IntersectCollector c(_outputBoth, _exactPos, _exactAllele, _iubMatch, _dbsnpMatch, formatter,
+                outMissA ? &out.missA : 0, outMissB ? &out.missB : 0);
+            IntersectFull<ParallelType::LinesA, ParallelType::LinesB, IntersectCollector> chromIntersector(a, b, c, _adjacentInsertions);
+            chromIntersector.execute();
+        });
+        return;
+    }
+
     IntersectCollector c(_outputBoth, _exactPos, _exactAllele, _iubMatch, _dbsnpMatch, outputFormatter, outMissA, outMissB);
+    if (_indexB) {
+        IntersectIndexed<BedReader, BedReader, IntersectCollector> intersector(fa, fb, c, _adjacentInsertions);
+        intersector.execute();
+        return;
+    }
+
     IntersectFull<BedReader, BedReader, IntersectCollector> intersector(fa, fb, c, _adjacentInsertions);
     intersector.execute();
 }
@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <string>
 
 class IntersectCommand : public CommandBase {
@@ -31,4 +32,7 @@ protected:
     bool _iubMatch;
     bool _dbsnpMatch;
     bool _adjacentInsertions;
+    bool _indexB;
+    std::size_t _threads;
+    std::size_t _bufferMb;
 };
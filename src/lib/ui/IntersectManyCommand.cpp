@@ -0,0 +1,87 @@
+#include "IntersectManyCommand.hpp"
+
+#include "fileformats/Bed.hpp"
+#include "fileformats/BedReader.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "io/InputStream.hpp"
+#include "processors/IntersectMany.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <ostream>
+#include <stdexcept>
+
+namespace po = boost::program_options;
+using namespace std;
+
+namespace {
+    // Writes each entry of a followed by a column of 1 or 0 for each file b
+    struct HitFlagWriter {
+        ostream& out;
+
+        void operator()(Bed const& a, vector<bool> const& hits) {
+            out << a;
+            for (auto i = hits.begin(); i != hits.end(); ++i)
+                out << (*i ? "\t1" : "\t0");
+            out << "\n";
+        }
+    };
+}
+
+IntersectManyCommand::IntersectManyCommand()
+    : _outputFile("-")
+    , _adjacentInsertions(false)
+{
+}
+
+void IntersectManyCommand::configureOptions() {
+    _opts.add_options()
+        ("file-a,a",
+            po::value<string>(&_fileA)->required(),
+            "input .bed file a (required, - for stdin)")
+
+        ("file-b,b",
+            po::value<vector<string>>(&_filesB)->required(),
+            "input .bed files to intersect a with (required, may be given "
+            "more than once)")
+
+        ("output-file,o",
+            po::value<string>(&_outputFile)->default_value("-"),
+            "output file (empty or - means stdout)")
+
+        ("adjacent-insertions",
+            po::bool_switch(&_adjacentInsertions),
+            "count insertions adjacent to other regions as intersecting")
+        ;
+
+    _posOpts.add("file-a", 1);
+    _posOpts.add("file-b", -1);
+}
+
+void IntersectManyCommand::exec() {
+    InputStream::ptr inStreamA(_streams.openForReading(_fileA));
+    BedReader::ptr readerA = openBed(*inStreamA);
+
+    for (auto i = _filesB.begin(); i != _filesB.end(); ++i) {
+        if (*i == _fileA)
+            throw runtime_error("Input files have the same name, '" + *i + "', not good.");
+    }
+
+    // of b, only the positions and the allele column (for insertions) are
+    // needed
+    vector<InputStream::ptr> inStreamsB = _streams.openForReading(_filesB);
+    vector<BedReader::ptr> readersB;
+    vector<BedReader*> bs;
+    for (auto i = inStreamsB.begin(); i != inStreamsB.end(); ++i) {
+        readersB.push_back(openBed(**i, 1));
+        bs.push_back(readersB.back().get());
+    }
+
+    if (_streams.cinReferences() > 1)
+        throw runtime_error("Multiple input streams from stdin specified. Abort.");
+
+    ostream* out = _streams.get<ostream>(_outputFile);
+    HitFlagWriter writer{*out};
+    auto intersector = makeManyIntersector(*readerA, bs, writer, _adjacentInsertions);
+    intersector.execute();
+}
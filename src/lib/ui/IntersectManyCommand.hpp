@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ui/CommandBase.hpp"
+
+#include <string>
+#include <vector>
+
+class IntersectManyCommand : public CommandBase {
+public:
+    IntersectManyCommand();
+
+    std::string name() const { return "intersect-many"; }
+    std::string description() const {
+        return "flag which of several bed files each entry of a bed file intersects";
+    }
+
+    void configureOptions();
+    void exec();
+
+protected:
+    std::string _fileA;
+    std::vector<std::string> _filesB;
+    std::string _outputFile;
+    bool _adjacentInsertions;
+};
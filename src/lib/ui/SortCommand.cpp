@@ -7,6 +7,7 @@
 #include "fileformats/DefaultPrinter.hpp"
 #include "fileformats/InferFileType.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 #include "fileformats/vcf/Header.hpp"
 #include "io/InputStream.hpp"
 #include "processors/BedDeduplicator.hpp"
@@ -23,6 +24,7 @@ using namespace std;
 
 SortCommand::SortCommand()
     : _outputFile("-")
+    , _outputFormat("vcf")
     , _maxInMem(1000000)
     , _mergeOnly(false)
     , _stable(false)
@@ -46,6 +48,10 @@ void SortCommand::configureOptions() {
             po::value<string>(&_outputFile)->default_value("-"),
             "output file (empty or - means stdout, which is the default)")
 
+        ("output-format",
+            po::value<string>(&_outputFormat)->default_value("vcf"),
+            "output format for vcf input: vcf, or bcf for BGZF compressed BCF2")
+
         ("max-mem-lines,M",
             po::value<uint64_t>(&_maxInMem)->default_value(_maxInMem),
             "maximum number of lines to hold in memory at once")
@@ -104,6 +110,7 @@ namespace {
 
 void SortCommand::exec() {
     CompressionType compression = compressionTypeFromString(_compressionString);
+    Vcf::OutputFormat outputFormat = Vcf::outputFormatFromString(_outputFormat);
 
     vector<InputStream::ptr> inputStreams = _streams.openForReading(_filenames);
     FileType type = detectFormat(inputStreams);
@@ -115,6 +122,9 @@ void SortCommand::exec() {
     if (type == EMPTY)
         return;
 
+    if (type != VCF && outputFormat != Vcf::VCF_OUTPUT)
+        throw runtime_error("--output-format only applies to vcf input");
+
     DefaultPrinter writer(*out);
     if (type == CHROMPOS) {
         TypedStreamFactory<DefaultParser<ChromPos>> readerFactory;
@@ -152,11 +162,13 @@ void SortCommand::exec() {
             hdr.merge((*i)->header(), true);
         }
 
-        *out << hdr;
+        Vcf::EntryWriter vcfWriter(*out, outputFormat);
+        vcfWriter.writeHeader(hdr);
 
         auto sorter = makeSort(
-              readers, readerFactory, writer, hdr, _maxInMem, _stable, compression);
+              readers, readerFactory, vcfWriter, hdr, _maxInMem, _stable, compression);
         sorter->execute();
+        vcfWriter.close();
     } else {
         throw runtime_error("Unknown file type!");
     }
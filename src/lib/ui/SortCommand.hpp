@@ -20,6 +20,7 @@ public:
 
 protected:
     std::string _outputFile;
+    std::string _outputFormat;
     std::vector<std::string> _filenames;
     uint64_t _maxInMem;
     bool _mergeOnly;
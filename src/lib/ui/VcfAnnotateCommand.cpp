@@ -1,11 +1,13 @@
 #include "VcfAnnotateCommand.hpp"
 
+#include "common/ObjectPool.hpp"
 #include "common/Tokenizer.hpp"
 #include "fileformats/vcf/Compare.hpp"
 #include "fileformats/vcf/CustomType.hpp"
 #include "fileformats/StreamPump.hpp"
 #include "fileformats/vcf/CustomValue.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 #include "fileformats/vcf/Header.hpp"
 #include "io/InputStream.hpp"
 #include "processors/MergeSorted.hpp"
@@ -25,6 +27,7 @@ using namespace std;
 
 VcfAnnotateCommand::VcfAnnotateCommand()
     : _outputFile("-")
+    , _outputFormat("vcf")
 {
 }
 
@@ -42,6 +45,10 @@ void VcfAnnotateCommand::configureOptions() {
             po::value<string>(&_outputFile)->default_value("-"),
             "output file (empty or - means stdout, which is the default)")
 
+        ("output-format",
+            po::value<string>(&_outputFormat)->default_value("vcf"),
+            "output format: vcf, or bcf for BGZF compressed BCF2")
+
         ("info-fields,I",
             po::value<vector<string>>(&_infoFields),
             "info fields to use for annotation (default: all)")
@@ -120,6 +127,7 @@ void VcfAnnotateCommand::postProcessArguments(Vcf::Header& header, Vcf::Header c
 }
 
 void VcfAnnotateCommand::exec() {
+    Vcf::OutputFormat outputFormat = Vcf::outputFormatFromString(_outputFormat);
     std::vector<std::string> filenames{_vcfFile, _annoFile};
     vector<InputStream::ptr> inputStreams = _streams.openForReading(filenames);
     auto readers = openStreams<Vcf::Entry>(inputStreams);
@@ -141,12 +149,18 @@ void VcfAnnotateCommand::exec() {
 
     postProcessArguments(header, annoHeader);
 
-    GroupSortingWriter writer(*out);
-    auto annotator = makeSimpleVcfAnnotator(writer, !_noIdents, _infoMap, header);
+    Vcf::EntryWriter vcfWriter(*out, outputFormat);
+    GroupSortingWriter writer(vcfWriter);
+    ObjectPool<Vcf::Entry> entryPool;
+    auto annotator = makeSimpleVcfAnnotator(writer, !_noIdents, _infoMap, header, &entryPool);
 
-    *out << vcfReader.header();
+    vcfWriter.writeHeader(vcfReader.header());
 
-    auto regionGrouper = makeGroupBySharedRegions(annotator);
+    auto regionGrouper = makeGroupBySharedRegions(
+              annotator
+            , VcfRegionExtractor()
+            , std::bind(&GroupSortingWriter::flushBefore, std::ref(writer), std::placeholders::_1)
+            );
     auto initialGrouper = makeGroupOverlapping<Vcf::Entry>(
               regionGrouper
             , DefaultCoordinateView{}
@@ -154,8 +168,10 @@ void VcfAnnotateCommand::exec() {
             , std::bind(&GroupSortingWriter::endGroup, std::ref(writer))
             );
     auto merger = makeMergeSorted(readers);
-    auto pump = makePointerStreamPump(merger, initialGrouper);
+    auto pump = makePointerStreamPump(merger, initialGrouper, &entryPool);
 
     pump.execute();
     initialGrouper.flush();
+    writer.endGroup();
+    vcfWriter.close();
 }
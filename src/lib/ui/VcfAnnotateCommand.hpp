@@ -32,6 +32,7 @@ protected:
     std::string _vcfFile;
     std::string _annoFile;
     std::string _outputFile;
+    std::string _outputFormat;
     std::vector<std::string> _infoFields;
     bool _noIdents;
     bool _noInfo;
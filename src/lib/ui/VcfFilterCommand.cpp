@@ -1,20 +1,37 @@
 #include "VcfFilterCommand.hpp"
 
-#include "fileformats/DefaultPrinter.hpp"
 #include "fileformats/TypedStream.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 #include "fileformats/vcf/Header.hpp"
 #include "io/InputStream.hpp"
+#include "processors/OrderedPipeline.hpp"
 
 #include <stdexcept>
 
 namespace po = boost::program_options;
 using namespace std;
 
+namespace {
+    struct RemoveLowDepthGenotypes {
+        uint32_t minDepth;
+        Vcf::EntryFormatter format;
+
+        void operator()(Vcf::Entry& e, OrderedPipelineContext& ctx) {
+            e.sampleData().removeLowDepthGenotypes(minDepth);
+            if (e.sampleData().samplesWithData())
+                format(ctx.out, e);
+        }
+    };
+}
+
 VcfFilterCommand::VcfFilterCommand()
     : _infile("-")
     , _outputFile("-")
+    , _outputFormat("vcf")
     , _minDepth(0)
+    , _threads(1)
+    , _batchSize(1000)
 {
 }
 
@@ -28,27 +45,38 @@ void VcfFilterCommand::configureOptions() {
             po::value<string>(&_outputFile)->default_value("-"),
             "output file (empty or - means stdout, which is the default)")
 
+        ("output-format",
+            po::value<string>(&_outputFormat)->default_value("vcf"),
+            "output format: vcf, or bcf for BGZF compressed BCF2")
+
         ("min-depth,d",
             po::value<uint32_t>(&_minDepth)->default_value(0),
             "minimum depth")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to parse and filter with")
+
+        ("batch-size",
+            po::value<size_t>(&_batchSize)->default_value(1000),
+            "number of entries each thread processes at a time")
         ;
 
     _posOpts.add("input-file", -1);
 }
 
 void VcfFilterCommand::exec() {
+    Vcf::OutputFormat format = Vcf::outputFormatFromString(_outputFormat);
     InputStream::ptr instream(_streams.openForReading(_infile));
     ostream* out = _streams.get<ostream>(_outputFile);
     if (_streams.cinReferences() > 1)
         throw runtime_error("stdin listed more than once!");
 
-    DefaultPrinter writer(*out);
     auto reader = openStream<Vcf::Entry>(instream);
-    Vcf::Entry e;
-    *out << reader->header();
-    while (reader->next(e)) {
-        e.sampleData().removeLowDepthGenotypes(_minDepth);
-        if (e.sampleData().samplesWithData())
-            writer(e);
-    }
+    Vcf::EntryWriter writer(*out, format);
+    writer.writeHeader(reader->header());
+
+    auto pipeline = makeOrderedPipeline(*reader, writer.stream(), _threads, _batchSize);
+    pipeline->run(RemoveLowDepthGenotypes{_minDepth, writer.formatter()});
+    writer.close();
 }
@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <string>
 
 class VcfFilterCommand : public CommandBase {
@@ -19,5 +20,8 @@ public:
 protected:
     std::string _infile;
     std::string _outputFile;
+    std::string _outputFormat;
     uint32_t _minDepth;
+    std::size_t _threads;
+    std::size_t _batchSize;
 };
@@ -1,5 +1,6 @@
 #include "VcfMergeCommand.hpp"
 
+#include "common/ObjectPool.hpp"
 #include "common/Tokenizer.hpp"
 #include "fileformats/Fasta.hpp"
 #include "fileformats/StreamPump.hpp"
@@ -8,11 +9,16 @@
 #include "fileformats/vcf/ConsensusFilter.hpp"
 #include "fileformats/vcf/CustomType.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 #include "fileformats/vcf/Header.hpp"
 #include "fileformats/vcf/SampleTag.hpp"
 #include "io/InputStream.hpp"
+#include "io/StreamHandler.hpp"
+#include "io/TempFile.hpp"
 #include "processors/Deref.hpp"
 #include "processors/MergeSorted.hpp"
+#include "processors/OrderedGroupPipeline.hpp"
+#include "processors/StageStats.hpp"
 #include "processors/VcfEntryMerger.hpp"
 #include "processors/VcfFilterer.hpp"
 #include "processors/VcfReheaderer.hpp"
@@ -27,9 +33,16 @@
 #include <boost/format.hpp>
 #include <boost/function.hpp>
 #include <boost/program_options.hpp>
+#include <boost/unordered_map.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 
 namespace po = boost::program_options;
 using boost::format;
@@ -38,12 +51,16 @@ using Vcf::CustomType;
 
 VcfMergeCommand::VcfMergeCommand()
     : _outputFile("-")
+    , _outputFormat("vcf")
     , _clearFilters(false)
     , _mergeSamples(false)
     , _consensusRatio(0.0)
     , _samplePriority(Vcf::MergeStrategy::eORDER)
     , _exactPos(false)
     , _allowSameFile(false)
+    , _threads(1)
+    , _batchSize(1000)
+    , _mergeTreeFanin(0)
 {
 }
 
@@ -67,6 +84,10 @@ void VcfMergeCommand::configureOptions() {
             po::value<string>(&_outputFile)->default_value("-"),
             "output file (omit or use '-' for stdout")
 
+        ("output-format",
+            po::value<string>(&_outputFormat)->default_value("vcf"),
+            "output format: vcf, or bcf for BGZF compressed BCF2")
+
         ("merge-strategy-file,M",
             po::value<string>(&_mergeStrategyFile),
             "merge strategy file for info fields (see man page for format)")
@@ -105,6 +126,24 @@ void VcfMergeCommand::configureOptions() {
         ("print-stats",
             po::bool_switch(&_printStats)->default_value(false),
             "Print statistics about the size of each bundle of entries being merged")
+
+        ("stats-json",
+            po::value<string>(&_statsJsonFile),
+            "Time each stage of the merge and write the timings, record counts "
+            "and group sizes to this file as JSON")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to merge with")
+
+        ("batch-size",
+            po::value<size_t>(&_batchSize)->default_value(1000),
+            "number of entries each thread merges at a time")
+
+        ("merge-tree-fanin",
+            po::value<size_t>(&_mergeTreeFanin)->default_value(0),
+            "merge at most this many files at a time, merging the "
+            "intermediate results in turn (0 to merge all files at once)")
         ;
 
     _posOpts.add("input-file", -1);
@@ -184,32 +223,630 @@ void VcfMergeCommand::finalizeOptions() {
         _dupSampleMap[fn] = suffix;
         _filenames.push_back(fn);
     }
+
+    if (_mergeTreeFanin == 1)
+        throw runtime_error("--merge-tree-fanin must be 0 or at least 2");
+
+    // The merged results of batches are only the same as a flat merge if
+    // each sample (and so its consensus) comes from a single file
+    if (_mergeTreeFanin && (_mergeSamples || _consensusRatio > 0)) {
+        throw runtime_error(
+            "--merge-tree-fanin cannot be used with --merge-samples or "
+            "--require-consensus");
+    }
 }
 
 namespace {
     template<typename PrinterType, typename NormalizerType, typename EntryType>
-    void writeNormalized(PrinterType& writer, NormalizerType& normalizer, EntryType& entry) {
-        normalizer->normalize(entry);
+    void writeNormalized(PrinterType& writer, NormalizerType& normalizer, StageStats* stage, EntryType& entry) {
+        {
+            StageTimer timer(stage);
+            normalizer->normalize(entry);
+        }
+        if (stage)
+            stage->addRecords(1);
         writer(entry);
     }
+
+    typedef boost::function<void(Vcf::Entry&)> MergedEntryWriter;
+    typedef TimedStage<GroupSortingWriter> TimedPrinter;
+
+    MergedEntryWriter makeMergedEntryWriter(
+              GroupSortingWriter& printer
+            , std::unique_ptr<Vcf::AltNormalizer>& normalizer
+            , PipelineStats* stats
+            )
+    {
+        TimedPrinter timedPrinter(printer, pipelineStage(stats, "sort output"));
+        if (!normalizer)
+            return timedPrinter;
+
+        return boost::bind(
+              &writeNormalized<TimedPrinter, std::unique_ptr<Vcf::AltNormalizer>, Vcf::Entry>
+            , timedPrinter
+            , std::ref(normalizer)
+            , pipelineStage(stats, "normalize indels")
+            , _1
+            );
+    }
+
+    // Times the reading and parsing of the inputs as one stage
+    template<typename StreamType>
+    std::vector<std::unique_ptr<TimedStream<StreamType>>>
+    timeStreams(std::vector<std::unique_ptr<StreamType>> const& streams, StageStats* stage) {
+        std::vector<std::unique_ptr<TimedStream<StreamType>>> rv;
+        for (auto i = streams.begin(); i != streams.end(); ++i)
+            rv.push_back(std::make_unique<TimedStream<StreamType>>(**i, stage));
+        return rv;
+    }
+
+    // Lets the printer write what it holds as soon as the groups of a bundle
+    // have moved past it. Not used when normalizing indels, as that can move
+    // entries to the left of the groups they came from.
+    struct FlushSortedBefore {
+        GroupSortingWriter* printer;
+
+        void operator()(Vcf::Entry const& e) const {
+            if (printer)
+                printer->flushBefore(e);
+        }
+    };
+
+    // Entries rejected by an earlier level of a merge tree are marked with
+    // this in its results instead of the reject filter, which the inputs
+    // may use for their own reasons. The final level swaps it back.
+    char const TreeRejectFilter[] = "JOINX_MERGE_TREE_REJECT";
+
+    // The entries of the intermediate results of a merge tree list the
+    // input entries ("parts") they were merged from in this INFO field, as
+    // start:input:line for each. input is the position of the part's file
+    // among all the inputs, line its position in that file, and start the
+    // greatest start of the file's entries up to it on its chromosome. A
+    // flat merge takes the entries of each group in that order (the order
+    // in which MergeSorted reads them), which makes it the order the merge
+    // tree has to keep too.
+    char const TreePartsTag[] = "JOINX_MERGE_TREE_PARTS";
+
+    CustomType treePartsType() {
+        return CustomType(TreePartsTag, CustomType::VARIABLE_SIZE, 0, CustomType::STRING,
+            "Parts of this entry in a merge tree (start:input:line)");
+    }
+
+    // Where a merge sits in a merge tree
+    enum TreeLevel {
+        NOT_A_TREE,
+        // reads the input files, writes intermediate results
+        FIRST_LEVEL,
+        // reads and writes intermediate results
+        LATER_LEVEL,
+        // reads intermediate results, writes the output
+        LAST_LEVEL
+    };
+
+    struct TreePart {
+        int64_t start;
+        std::size_t input;
+        std::size_t line;
+
+        bool operator<(TreePart const& rhs) const {
+            return std::tie(start, input, line) < std::tie(rhs.start, rhs.input, rhs.line);
+        }
+    };
+
+    // Appends the parts e lists in TreePartsTag to parts. Returns false if
+    // it lists none, or one cannot be read.
+    bool readTreeParts(Vcf::Entry const& e, std::vector<TreePart>& parts) {
+        auto const* value = e.info(TreePartsTag);
+        if (!value || value->empty())
+            return false;
+
+        for (std::size_t i = 0; i < value->size(); ++i) {
+            std::string const* s = value->get<std::string>(i);
+            if (!s)
+                return false;
+
+            TreePart part;
+            Tokenizer<char> tok(*s, ':');
+            if (!tok.extract(part.start) || !tok.extract(part.input) || !tok.extract(part.line))
+                return false;
+            parts.push_back(part);
+        }
+        return true;
+    }
+
+    // Comes before the grouping in the first level of a merge tree (and
+    // passes everything on to it otherwise), listing each entry as its own
+    // part in TreePartsTag. The header's source index of each input is its
+    // position among all the inputs.
+    template<typename OutputFunc>
+    class TreePartsStamper {
+    public:
+        TreePartsStamper(OutputFunc& out, bool active)
+            : out_(out)
+            , active_(active)
+        {}
+
+        void operator()(std::unique_ptr<Vcf::Entry> e) {
+            if (active_)
+                stamp(*e);
+            out_(std::move(e));
+        }
+
+        void flush() {
+            out_.flush();
+        }
+
+    private:
+        struct InputState {
+            std::string chrom;
+            int64_t start;
+            std::size_t lines;
+        };
+
+        void stamp(Vcf::Entry& e) {
+            std::size_t input = e.header().sourceIndex();
+            auto inserted = inputs_.insert(std::make_pair(input, InputState{e.chrom(), e.start(), 0}));
+            auto& state = inserted.first->second;
+            if (state.chrom != e.chrom()) {
+                state.chrom = e.chrom();
+                state.start = e.start();
+            }
+            state.start = std::max(state.start, e.start());
+
+            Vcf::CustomValue part(e.header().infoType(TreePartsTag), str(format("%1%:%2%:%3%")
+                % state.start % input % state.lines++));
+            e.setInfo(TreePartsTag, part);
+        }
+
+    private:
+        OutputFunc& out_;
+        bool active_;
+        boost::unordered_map<std::size_t, InputState> inputs_;
+    };
+
+    template<typename OutputFunc>
+    TreePartsStamper<OutputFunc> makeTreePartsStamper(OutputFunc& out, bool active) {
+        return TreePartsStamper<OutputFunc>(out, active);
+    }
+
+    // Comes before the same-file deduplicator in the later levels of a
+    // merge tree (and passes everything on to it otherwise). The entries of
+    // each group are put in the order of their parts, and the parts are
+    // deduplicated as they are in a flat merge:
+    //  - entries rejected by an earlier level are rejected again (without
+    //    their TreeRejectFilter);
+    //  - an entry that is a single part is rejected if an earlier part of
+    //    the group came from the same file.
+    // The result is that of a flat merge as long as the parts of each entry
+    // come before those of the next (see TreeStartSplitter), and no entry
+    // of several parts has one that a flat merge would reject. If not, an
+    // earlier level merged entries that a flat merge keeps apart, and the
+    // merge stops with an error rather than give different results. The
+    // last level removes TreePartsTag from the entries.
+    template<typename PassOutputFunc, typename FailOutputFunc>
+    class TreeProvenance {
+    public:
+        typedef std::unique_ptr<Vcf::Entry> ValuePtr;
+        typedef std::vector<ValuePtr> ValuePtrVector;
+
+        TreeProvenance(
+                  PassOutputFunc& passOut
+                , FailOutputFunc& failOut
+                , TreeLevel level
+                , bool rejectSameFile
+                , std::vector<std::string> const& inputNames
+                )
+            : passOut_(passOut)
+            , failOut_(failOut)
+            , level_(level)
+            , rejectSameFile_(rejectSameFile)
+            , inputNames_(inputNames)
+        {}
+
+        void operator()(ValuePtrVector&& entries) {
+            if (level_ != LATER_LEVEL && level_ != LAST_LEVEL) {
+                passOut_(std::move(entries));
+                return;
+            }
+
+            parts_.clear();
+            items_.clear();
+            for (auto i = entries.begin(); i != entries.end(); ++i)
+                addItem(std::move(*i));
+
+            std::sort(items_.begin(), items_.end(), [this](Item const& a, Item const& b) {
+                return parts_[a.beg] < parts_[b.beg];
+            });
+
+            claimed_.clear();
+            ValuePtrVector pass;
+            ValuePtrVector fail;
+            TreePart const* last = 0;
+            for (auto i = items_.begin(); i != items_.end(); ++i) {
+                auto& e = *i->entry;
+                bool reject = e.failedFilters().contains(TreeRejectFilter);
+                if (reject)
+                    e.removeFilter(TreeRejectFilter);
+                else if (rejectSameFile_)
+                    reject = !claimParts(*i);
+
+                if (!reject) {
+                    if (last && !(*last < parts_[i->beg]))
+                        refuse(e, "entries of different batches of files would be merged in another order");
+                    last = &parts_[i->end - 1];
+                }
+
+                if (level_ == LAST_LEVEL)
+                    e.removeInfo(TreePartsTag);
+
+                if (reject)
+                    fail.push_back(std::move(i->entry));
+                else
+                    pass.push_back(std::move(i->entry));
+            }
+            passOut_(std::move(pass));
+            failOut_(std::move(fail));
+        }
+
+    private:
+        struct Item {
+            ValuePtr entry;
+            // its parts, in order, are parts_[beg..end)
+            std::size_t beg;
+            std::size_t end;
+        };
+
+        void addItem(ValuePtr entry) {
+            std::size_t beg = parts_.size();
+            if (!readTreeParts(*entry, parts_))
+                refuse(*entry, str(format("missing or invalid %1% field") % TreePartsTag));
+
+            for (auto i = parts_.begin() + beg; i != parts_.end(); ++i) {
+                if (i->input >= inputNames_.size())
+                    refuse(*entry, str(format("invalid %1% field") % TreePartsTag));
+            }
+            items_.push_back(Item{std::move(entry), beg, parts_.size()});
+        }
+
+        // Marks the files of item's parts as seen, unless one already was.
+        // Then a flat merge rejects item too if it is a single part, and
+        // cannot be matched otherwise.
+        bool claimParts(Item const& item) {
+            for (auto i = item.beg; i != item.end; ++i) {
+                auto found = claimed_.find(parts_[i].input);
+                if (found == claimed_.end())
+                    continue;
+
+                if (item.end - item.beg == 1 && found->second < parts_[i])
+                    return false;
+
+                refuse(*item.entry, str(format("%1% has more than one entry there")
+                    % inputNames_[parts_[i].input]));
+            }
+
+            for (auto i = item.beg; i != item.end; ++i)
+                claimed_.insert(std::make_pair(parts_[i].input, parts_[i]));
+            return true;
+        }
+
+        void refuse(Vcf::Entry const& e, std::string const& reason) const {
+            throw runtime_error(str(format(
+                "--merge-tree-fanin cannot merge the entries at %1%:%2% as a "
+                "flat merge would (%3%); merge these files without it"
+                ) % e.chrom() % e.pos() % reason));
+        }
+
+    private:
+        PassOutputFunc& passOut_;
+        FailOutputFunc& failOut_;
+        TreeLevel level_;
+        bool rejectSameFile_;
+        std::vector<std::string> const& inputNames_;
+        std::vector<TreePart> parts_;
+        std::vector<Item> items_;
+        boost::unordered_map<std::size_t, TreePart> claimed_;
+    };
+
+    template<typename PassOutputFunc, typename FailOutputFunc>
+    TreeProvenance<PassOutputFunc, FailOutputFunc>
+    makeTreeProvenance(
+              PassOutputFunc& passOut
+            , FailOutputFunc& failOut
+            , TreeLevel level
+            , bool rejectSameFile
+            , std::vector<std::string> const& inputNames
+            )
+    {
+        return TreeProvenance<PassOutputFunc, FailOutputFunc>(passOut, failOut, level, rejectSameFile, inputNames);
+    }
+
+    // Comes between the same-file deduplicator and the merger in the
+    // intermediate levels of a merge tree (and passes everything on to it
+    // otherwise), where it splits each group into runs of entries whose
+    // (first) parts start at the same place, and merges those separately.
+    // Entries of parts that start at one place can be merged with those of
+    // other batches in the order of a flat merge, as each batch holds
+    // consecutive inputs. The parts of entries that spanned several starts
+    // could be interleaved with those of other batches instead (see
+    // TreeProvenance).
+    template<typename OutputFunc>
+    class TreeStartSplitter {
+    public:
+        typedef std::unique_ptr<Vcf::Entry> ValuePtr;
+        typedef std::vector<ValuePtr> ValuePtrVector;
+
+        TreeStartSplitter(OutputFunc& out, bool active)
+            : out_(out)
+            , active_(active)
+        {}
+
+        void operator()(ValuePtrVector&& entries) {
+            if (!active_) {
+                out_(std::move(entries));
+                return;
+            }
+
+            // the entries come in the order of their parts
+            ValuePtrVector run;
+            int64_t runStart = 0;
+            for (auto i = entries.begin(); i != entries.end(); ++i) {
+                parts_.clear();
+                if (!readTreeParts(**i, parts_))
+                    throw runtime_error(str(format("Missing or invalid %1% field at %2%:%3%")
+                        % TreePartsTag % (*i)->chrom() % (*i)->pos()));
+
+                if (!run.empty() && parts_[0].start != runStart) {
+                    out_(std::move(run));
+                    run.clear();
+                }
+                runStart = parts_[0].start;
+                run.push_back(std::move(*i));
+            }
+
+            if (!run.empty())
+                out_(std::move(run));
+        }
+
+    private:
+        OutputFunc& out_;
+        bool active_;
+        std::vector<TreePart> parts_;
+    };
+
+    template<typename OutputFunc>
+    TreeStartSplitter<OutputFunc> makeTreeStartSplitter(OutputFunc& out, bool active) {
+        return TreeStartSplitter<OutputFunc>(out, active);
+    }
+
+    // What the merge chains on every thread share
+    struct MergeChainParams {
+        Vcf::Header* mergedHeader;
+        Vcf::MergeStrategy const* mergeStrategy;
+        std::string rejectFilter;
+        bool rejectSameFile;
+        TreeLevel treeLevel;
+        // the files that the parts of a merge tree's entries came from
+        std::vector<std::string> const* treeInputs;
+    };
+
+    // Builds the chain that takes bundles of overlapping entries, splits them
+    // into groups that share alleles, and merges each of those (rejecting
+    // duplicate entries from the same file). Then calls body(head, stats)
+    // with the start of the chain and the group size stats it keeps. Each
+    // stage is timed in stats, if given.
+    template<typename PoolType, typename Body>
+    void withMergeChain(
+              MergedEntryWriter& writer
+            , FlushSortedBefore flushSorted
+            , MergeChainParams const& params
+            , PoolType* pool
+            , PipelineStats* stats
+            , Body& body
+            )
+    {
+        auto entryMerger = makeVcfEntryMerger(writer, params.mergedHeader, *params.mergeStrategy, pool);
+        auto timedMerger = makeTimedStage(entryMerger, pipelineStage(stats, "merge entries"));
+
+        // Rejection chain
+        auto deref = makeDeref(writer, pool);
+        auto splitter = makeGroupForEach(deref);
+        auto reheader = makeVcfReheaderer(splitter, params.mergedHeader);
+        auto filterer = makeVcfFilterer(reheader, params.rejectFilter);
+        auto timedFilterer = makeTimedStage(filterer, pipelineStage(stats, "reject entries"));
+        // End rejection chain
+
+        auto startSplitter = makeTreeStartSplitter(
+              timedMerger
+            , params.treeLevel == FIRST_LEVEL || params.treeLevel == LATER_LEVEL
+            );
+
+        // Dedup will branch between the rejection chain (filterer) and the entryMerger
+        auto dedup = makeVcfSourceIndexDeduplicator(
+              startSplitter
+            , timedFilterer
+            , params.rejectSameFile && (params.treeLevel == NOT_A_TREE || params.treeLevel == FIRST_LEVEL)
+            );
+        auto provenance = makeTreeProvenance(
+              dedup
+            , timedFilterer
+            , params.treeLevel
+            , params.rejectSameFile
+            , *params.treeInputs
+            );
+        auto timedDedup = makeTimedStage(provenance, pipelineStage(stats, "find same-file duplicates"));
+
+        auto smallStats = makeGroupStats(timedDedup, "shared allele bundle size");
+        auto regionGrouper = makeGroupBySharedRegions(smallStats, VcfRegionExtractor(), flushSorted);
+        auto timedGrouper = makeTimedStage(regionGrouper, pipelineStage(stats, "group by shared regions"));
+        body(timedGrouper, smallStats.stats());
+    }
+
+    // Reads, groups and merges everything on the calling thread
+    template<typename ReaderType>
+    struct MergeSerially {
+        ReaderType& readers;
+        ObjectPool<Vcf::Entry>& entryPool;
+        GroupSortingWriter& printer;
+        bool printStats;
+        // whether this is the first level of a merge tree
+        bool stampTreeParts;
+        PipelineStats* stats;
+
+        template<typename Head>
+        void operator()(Head& head, GroupSizeStats const& smallStats) {
+            auto bigStats = makeGroupStats(head, "overlapping bundle size");
+            auto initialGrouper = makeGroupOverlapping<Vcf::Entry>(
+                      bigStats
+                    , DefaultCoordinateView{}
+                    , nothing
+                    , std::bind(&GroupSortingWriter::endGroup, std::ref(printer))
+                    );
+            auto timedGrouper = makeTimedStage(initialGrouper, pipelineStage(stats, "group overlapping"));
+            auto stamper = makeTreePartsStamper(timedGrouper, stampTreeParts);
+            auto merger = makeMergeSorted(readers);
+            TimedStream<decltype(merger)> timedMerger(merger, pipelineStage(stats, "sort inputs"));
+            auto pump = makePointerStreamPump(timedMerger, stamper, &entryPool);
+
+            pump.execute();
+            initialGrouper.flush();
+            printer.endGroup();
+
+            if (printStats) {
+                std::cerr << bigStats << smallStats << "\n";
+            }
+        }
+    };
+
+    // One thread's merge chain for bundles of overlapping entries handed out
+    // by an OrderedGroupPipeline. Each bundle is merged and written out in
+    // full before the next, as GroupSortingWriter::endGroup is called after
+    // each as in the serial case.
+    struct MergeWorker {
+        typedef OrderedGroupPipeline<Vcf::Entry> PipelineType;
+
+        MergeChainParams const* params;
+        Vcf::EntryFormatter formatter;
+        Fasta const* ref;
+        // the threads' shared allele bundle stats (and stage stats, if
+        // given) are added up here
+        GroupSizeStats* smallStats;
+        PipelineStats* stageStats;
+        std::mutex* statsMutex;
+
+        void operator()(PipelineType& pipeline) {
+            std::unique_ptr<PipelineStats> stats;
+            if (stageStats)
+                stats = std::make_unique<PipelineStats>();
+
+            std::ostream* out = 0;
+            StageStats* writeStage = pipelineStage(stats.get(), "write");
+            GroupSortingWriter printer([this, &out, writeStage](Vcf::Entry const& e) {
+                if (writeStage)
+                    writeStage->addRecords(1);
+                StageTimer timer(writeStage);
+                formatter(*out, e);
+            });
+            printer.orderAlleles(true);
+
+            std::unique_ptr<Vcf::AltNormalizer> normalizer;
+            if (ref)
+                normalizer = std::make_unique<Vcf::AltNormalizer>(*ref);
+
+            MergedEntryWriter writer = makeMergedEntryWriter(printer, normalizer, stats.get());
+            FlushSortedBefore flushSorted{normalizer ? 0 : &printer};
+            PipelineType::Recycler recycler;
+            Body body{pipeline, recycler, printer, out, *this};
+            withMergeChain(writer, flushSorted, *params, &recycler, stats.get(), body);
+
+            if (stats) {
+                std::lock_guard<std::mutex> lock(*statsMutex);
+                *stageStats += *stats;
+            }
+        }
+
+        struct Body {
+            PipelineType& pipeline;
+            PipelineType::Recycler& recycler;
+            GroupSortingWriter& printer;
+            std::ostream*& out;
+            MergeWorker& worker;
+
+            template<typename Head>
+            void operator()(Head& head, GroupSizeStats const& stats) {
+                auto mergeBundle = [&](PipelineType::ValuePtrVector bundle, std::ostream& s) {
+                    out = &s;
+                    head(std::move(bundle));
+                    printer.endGroup();
+                };
+                pipeline.work(mergeBundle, &recycler);
+
+                std::lock_guard<std::mutex> lock(*worker.statsMutex);
+                *worker.smallStats += stats;
+            }
+        };
+    };
+}
+
+namespace {
+    // The position of a file on the command line
+    size_t fileOrder(map<string, size_t> const& order, string const& path) {
+        auto found = order.find(path);
+        return found == order.end() ? 0 : found->second;
+    }
 }
 
 void VcfMergeCommand::exec() {
+    std::unique_ptr<PipelineStats> stats;
+    if (!_statsJsonFile.empty())
+        stats = std::make_unique<PipelineStats>();
+
+    if (_mergeTreeFanin && _filenames.size() > _mergeTreeFanin) {
+        mergeTree(stats.get());
+    } else {
+        vector<size_t> sourceIndices;
+        for (auto i = _filenames.begin(); i != _filenames.end(); ++i)
+            sourceIndices.push_back(fileOrder(_fileOrder, *i));
+
+        merge(MergeJob{_filenames, sourceIndices, _outputFile, false, false}, stats.get());
+    }
+
+    if (stats) {
+        StreamHandler streams;
+        ostream* out = streams.get<ostream>(_statsJsonFile);
+        stats->toJson(*out);
+    }
+}
+
+void VcfMergeCommand::merge(MergeJob const& job, PipelineStats* stats) const {
+    StageStats* jobStage = pipelineStage(stats, "merge jobs");
+    if (jobStage)
+        jobStage->addRecords(0);
+    StageTimer timer(jobStage);
+    Vcf::OutputFormat outputFormat = job.intermediate
+        ? Vcf::VCF_OUTPUT
+        : Vcf::outputFormatFromString(_outputFormat);
     std::unique_ptr<Vcf::AltNormalizer> normalizer;
     std::unique_ptr<Fasta> ref;
-    if (!_fastaFile.empty()) {
+    if (!_fastaFile.empty() && !job.intermediate) {
         ref = std::make_unique<Fasta>(_fastaFile);
         normalizer = std::make_unique<Vcf::AltNormalizer>(*ref);
     }
 
-    vector<InputStream::ptr> inputStreams = _streams.openForReading(_filenames);
+    StreamHandler streams;
+    vector<InputStream::ptr> inputStreams = streams.openForReading(job.filenames);
 
-    ostream* out = _streams.get<ostream>(_outputFile);
-    if (_streams.cinReferences() > 1)
+    ostream* out = streams.get<ostream>(job.outputFile);
+    if (streams.cinReferences() > 1)
         throw runtime_error("stdin listed more than once!");
 
     auto readers = openStreams<Vcf::Entry>(inputStreams);
 
+    TreeLevel treeLevel = NOT_A_TREE;
+    if (job.intermediateInputs)
+        treeLevel = job.intermediate ? LATER_LEVEL : LAST_LEVEL;
+    else if (job.intermediate)
+        treeLevel = FIRST_LEVEL;
+
     Vcf::Header mergedHeader;
     for (size_t i = 0; i < inputStreams.size(); ++i) {
         // if sample duplication is enabled for this file
@@ -231,28 +868,26 @@ void VcfMergeCommand::exec() {
             }
         }
 
+        if (treeLevel == FIRST_LEVEL)
+            readers[i]->header().addInfoType(treePartsType());
+
         mergedHeader.merge(readers[i]->header(), _mergeSamples);
-        readers[i]->header().sourceIndex(_fileOrder[inputStreams[i]->name()]);
+        readers[i]->header().sourceIndex(job.sourceIndices[i]);
     }
 
-    GroupSortingWriter printer_raw(*out);
-    auto printer = std::ref(printer_raw);
+    // The inputs' headers still declare TreePartsTag so that it can be
+    // read; it is removed from the entries before they are written
+    if (treeLevel == LAST_LEVEL)
+        mergedHeader.removeInfoType(TreePartsTag);
 
-    boost::function<void(Vcf::Entry&)> writer;
-    if (normalizer) {
-        writer = boost::bind(
-              &writeNormalized<GroupSortingWriter, std::unique_ptr<Vcf::AltNormalizer>, Vcf::Entry>
-            , printer
-            , std::ref(normalizer)
-            , _1
-            );
-    }
-    else {
-        writer = printer;
-    }
+    Vcf::EntryWriter vcfWriter(*out, outputFormat);
 
     std::unique_ptr<Vcf::ConsensusFilter> cnsFilt;
-    mergedHeader.addFilter(_rejectFilter, "Rejected by vcf-merge (duplicate locus in same source file)");
+    // Intermediate files mark rejected entries with TreeRejectFilter
+    // without declaring it; the reject filter is declared once, after all
+    // other filters, in the final output as it is in a flat merge.
+    if (!job.intermediate)
+        mergedHeader.addFilter(_rejectFilter, "Rejected by vcf-merge (duplicate locus in same source file)");
     if (_consensusRatio > 0) {
         mergedHeader.addFilter(_consensusFilter, _consensusFilterDesc);
         if (mergedHeader.formatType("FT") == NULL) {
@@ -271,44 +906,189 @@ void VcfMergeCommand::exec() {
     mergeStrategy.exactPos(_exactPos);
 
     if (!_mergeStrategyFile.empty()) {
-        InputStream::ptr msFile(_streams.openForReading(_mergeStrategyFile));
+        InputStream::ptr msFile(streams.openForReading(_mergeStrategyFile));
         mergeStrategy.parse(*msFile);
     }
-    mergeStrategy.clearFilters(_clearFilters);
+    // The parts of merged entries are listed in the order they are merged
+    if (job.intermediate)
+        mergeStrategy.setMerger(TreePartsTag, "uniq-concat");
+    mergeStrategy.clearFilters(_clearFilters && !job.intermediate);
     mergeStrategy.mergeSamples(_mergeSamples);
     mergeStrategy.primarySampleStreamIndex(0);
 
-    *out << mergedHeader;
+    vcfWriter.writeHeader(mergedHeader);
 
-    auto entryMerger = makeVcfEntryMerger(writer, &mergedHeader, mergeStrategy);
+    MergeChainParams params{
+          &mergedHeader
+        , &mergeStrategy
+        , job.intermediate ? TreeRejectFilter : _rejectFilter
+        , !_allowSameFile
+        , treeLevel
+        , &_filenames
+        };
 
-    // Rejection chain
-    auto deref = makeDeref(writer);
-    auto splitter = makeGroupForEach(deref);
-    auto reheader = makeVcfReheaderer(splitter, &mergedHeader);
-    auto filterer = makeVcfFilterer(reheader, _rejectFilter);
-    // End rejection chain
+    auto timedReaders = timeStreams(readers, pipelineStage(stats, "parse"));
 
-    // Dedup will branch between the rejection chain (filterer) and the entryMerger
-    auto dedup = makeVcfSourceIndexDeduplicator(entryMerger, filterer, !_allowSameFile);
+    if (_threads <= 1 || job.intermediate) {
+        auto timedWriter = makeTimedStage(vcfWriter, pipelineStage(stats, "write"));
+        GroupSortingWriter printer(std::ref(timedWriter));
+        printer.orderAlleles(true);
+        MergedEntryWriter writer = makeMergedEntryWriter(printer, normalizer, stats);
+        FlushSortedBefore flushSorted{normalizer ? 0 : &printer};
 
-    auto smallStats = makeGroupStats(dedup, "shared allele bundle size");
-    auto regionGrouper = makeGroupBySharedRegions(smallStats);
-    auto bigStats = makeGroupStats(regionGrouper, "overlapping bundle size");
+        // Entries are recycled once written so that parsing can reuse their
+        // storage
+        ObjectPool<Vcf::Entry> entryPool;
+        MergeSerially<decltype(timedReaders)> body{
+              timedReaders
+            , entryPool
+            , printer
+            , _printStats && !job.intermediate
+            , treeLevel == FIRST_LEVEL
+            , stats
+            };
+        withMergeChain(writer, flushSorted, params, &entryPool, stats, body);
+        vcfWriter.close();
+        return;
+    }
 
-    auto initialGrouper = makeGroupOverlapping<Vcf::Entry>(
-              bigStats
-            , DefaultCoordinateView{}
-            , nothing
-            , std::bind(&GroupSortingWriter::endGroup, printer)
-            );
-    auto merger = makeMergeSorted(readers);
-    auto pump = makePointerStreamPump(merger, initialGrouper);
+    // Bundles of overlapping entries never span a gap between entries, let
+    // alone a change of chromosome, so they can be merged independently.
+    // Reading and grouping stays on this thread; the bundles are merged on
+    // the worker threads and written in order, making the output the same
+    // as that of the serial path.
+    // The workers add their stage stats to stats as they finish, so the
+    // stages timed on this thread are added before they start
+    StageStats* queueStage = pipelineStage(stats, "queue bundles for threads");
+    StageStats* groupStage = pipelineStage(stats, "group overlapping");
+    StageStats* sortStage = pipelineStage(stats, "sort inputs");
+
+    GroupSizeStats smallStats("shared allele bundle size");
+    std::mutex statsMutex;
+    ObjectPool<Vcf::Entry> entryPool;
+    OrderedGroupPipeline<Vcf::Entry> pipeline(vcfWriter.stream(), _threads, _batchSize, &entryPool);
+    pipeline.start(MergeWorker{&params, vcfWriter.formatter(), ref.get(), &smallStats, stats, &statsMutex});
+
+    auto timedPipeline = makeTimedStage(pipeline, queueStage);
+    auto bigStats = makeGroupStats(timedPipeline, "overlapping bundle size");
+    auto initialGrouper = makeGroupOverlapping<Vcf::Entry>(bigStats);
+    auto timedGrouper = makeTimedStage(initialGrouper, groupStage);
+    auto merger = makeMergeSorted(timedReaders);
+    TimedStream<decltype(merger)> timedMerger(merger, sortStage);
+    auto pump = makePointerStreamPump(timedMerger, timedGrouper, &entryPool);
 
     pump.execute();
     initialGrouper.flush();
+    pipeline.finish();
+    vcfWriter.close();
 
     if (_printStats) {
         std::cerr << bigStats << smallStats << "\n";
     }
 }
+
+namespace {
+    // Runs jobs[i] for each i on up to the given number of threads,
+    // rethrowing the error of the first job to fail, if any
+    template<typename Func>
+    void runJobs(std::size_t nJobs, std::size_t threads, Func const& job) {
+        std::atomic<std::size_t> next(0);
+        std::vector<std::exception_ptr> errors(nJobs);
+        auto worker = [&]() {
+            std::size_t i;
+            while ((i = next++) < nJobs) {
+                try {
+                    job(i);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < std::min(threads, nJobs); ++i)
+            workers.emplace_back(worker);
+        worker();
+        for (auto i = workers.begin(); i != workers.end(); ++i)
+            i->join();
+
+        for (auto i = errors.begin(); i != errors.end(); ++i) {
+            if (*i)
+                std::rethrow_exception(*i);
+        }
+    }
+}
+
+// Merges the inputs in batches of _mergeTreeFanin files (on up to _threads
+// at a time), then the results of those in batches, and so on until few
+// enough are left to merge into the output, keeping far fewer files open
+// than merging everything at once. The batches are taken in the order in
+// which a flat merge reads the files, and each sample comes from a single
+// file, so entries that are merged in a flat merge are merged at some
+// level, even those that are only grouped through an entry of a file in
+// another batch.
+//
+// The output is that of a flat merge. Each entry of the intermediate
+// results lists the input entries it was merged from (see TreePartsTag),
+// and only those that start at the same place are merged before the last
+// level, so that later levels can merge them in the order a flat merge
+// does, giving the same ALT order and INFO values, and reject what it
+// rejects (see TreeProvenance). Where an earlier level has merged entries
+// that a flat merge would not, the merge stops with an error.
+void VcfMergeCommand::mergeTree(PipelineStats* stats) {
+    // each input's source index in the first level is its position here,
+    // which TreePartsTag refers to
+    vector<string> inputs(_filenames);
+    vector<size_t> sourceIndices;
+    for (size_t i = 0; i < inputs.size(); ++i)
+        sourceIndices.push_back(i);
+
+    TempDir::ptr tmpdir = TempDir::create(TempDir::CLEANUP);
+    vector<TempFile::ptr> level;
+    while (inputs.size() > _mergeTreeFanin) {
+        size_t nBatches = (inputs.size() + _mergeTreeFanin - 1) / _mergeTreeFanin;
+        vector<MergeJob> jobs;
+        vector<TempFile::ptr> results;
+        for (size_t i = 0; i < nBatches; ++i) {
+            auto first = i * _mergeTreeFanin;
+            auto last = std::min(first + _mergeTreeFanin, inputs.size());
+
+            results.push_back(tmpdir->tempFile(TempFile::CLEANUP));
+            results.back()->stream().close();
+
+            jobs.push_back(MergeJob{
+                  vector<string>(inputs.begin() + first, inputs.begin() + last)
+                , vector<size_t>(sourceIndices.begin() + first, sourceIndices.begin() + last)
+                , results.back()->path()
+                , true
+                , !level.empty()
+                });
+        }
+
+        std::mutex statsMutex;
+        runJobs(jobs.size(), _threads, [this, &jobs, stats, &statsMutex](size_t i) {
+            std::unique_ptr<PipelineStats> jobStats;
+            if (stats)
+                jobStats = std::make_unique<PipelineStats>();
+
+            merge(jobs[i], jobStats.get());
+
+            if (jobStats) {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                *stats += *jobStats;
+            }
+        });
+
+        // the inputs to this level are no longer needed
+        level.swap(results);
+        inputs.clear();
+        sourceIndices.clear();
+        for (size_t i = 0; i < level.size(); ++i) {
+            inputs.push_back(level[i]->path());
+            sourceIndices.push_back(i);
+        }
+    }
+
+    merge(MergeJob{inputs, sourceIndices, _outputFile, false, true}, stats);
+}
@@ -3,8 +3,12 @@
 #include "ui/CommandBase.hpp"
 #include "fileformats/vcf/MergeStrategy.hpp"
 
+#include <cstddef>
 #include <map>
 #include <string>
+#include <vector>
+
+class PipelineStats;
 
 class VcfMergeCommand : public CommandBase {
 public:
@@ -20,9 +24,31 @@ public:
     void exec();
 
 protected:
+    // One run of the merge: of all the inputs, or of one batch of inputs
+    // (or of intermediate results) when merging in a tree
+    struct MergeJob {
+        std::vector<std::string> filenames;
+        // the source index of each input, which orders them (in the first
+        // level of a merge tree, its position among all the inputs)
+        std::vector<std::size_t> sourceIndices;
+        std::string outputFile;
+        // Intermediate results of a merge tree are written as vcf without
+        // normalizing indels, clearing filters or printing stats; that is
+        // left to the final merge
+        bool intermediate;
+        // The inputs are intermediate results, whose source indices do not
+        // identify the original files
+        bool intermediateInputs;
+    };
+
+    // Stage timings are added to stats, if given
+    void merge(MergeJob const& job, PipelineStats* stats) const;
+    void mergeTree(PipelineStats* stats);
+
     std::vector<std::string> _filenames;
     std::vector<std::string> _dupSampleFilenames;
     std::string _outputFile;
+    std::string _outputFormat;
     std::string _fastaFile;
     std::string _mergeStrategyFile;
     bool _clearFilters;
@@ -39,5 +65,9 @@ protected:
     Vcf::MergeStrategy::SamplePriority _samplePriority;
     bool _exactPos;
     bool _printStats;
+    std::string _statsJsonFile;
     bool _allowSameFile;
+    std::size_t _threads;
+    std::size_t _batchSize;
+    std::size_t _mergeTreeFanin;
 };
@@ -4,11 +4,14 @@
 #include "fileformats/Fasta.hpp"
 #include "fileformats/TypedStream.hpp"
 #include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
 #include "fileformats/vcf/Header.hpp"
 #include "fileformats/vcf/AltNormalizer.hpp"
+#include "processors/OrderedPipeline.hpp"
 
 #include <boost/format.hpp>
 
+#include <mutex>
 #include <unordered_set>
 #include <stdexcept>
 
@@ -16,10 +19,65 @@ namespace po = boost::program_options;
 using boost::format;
 using namespace std;
 
+namespace {
+    // Sequences we have already warned about, shared by every thread
+    struct SequenceWarnings {
+        std::mutex mutex;
+        std::unordered_set<std::string> seen;
+
+        bool firstTime(std::string const& seq) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return seen.insert(seq).second;
+        }
+    };
+
+    struct NormalizeIndels {
+        NormalizeIndels(
+                Fasta const& ref,
+                std::string const& fileName,
+                std::string const& fastaPath,
+                SequenceWarnings& seqWarnings,
+                Vcf::EntryFormatter const& format
+                )
+            : norm(ref)
+            , fileName(fileName)
+            , fastaPath(fastaPath)
+            , seqWarnings(seqWarnings)
+            , format(format)
+        {}
+
+        void operator()(Vcf::Entry& e, OrderedPipelineContext& ctx) {
+            try {
+                norm.normalize(e);
+            } catch (UnknownSequenceError const& ex) {
+                // only warn the first time for each sequence
+                if (seqWarnings.firstTime(e.chrom())) {
+                    // We couldn't get reference data for the sequence
+                    ctx.err << "WARNING: at line " << ctx.lineNum
+                        << " in file " << fileName << ": sequence "
+                        << e.chrom() << " not found in reference " << fastaPath << "\n"
+                        ;
+                }
+            }
+            format(ctx.out, e);
+        }
+
+        // caches the current reference sequence, so one per thread
+        Vcf::AltNormalizer norm;
+        std::string const& fileName;
+        std::string const& fastaPath;
+        SequenceWarnings& seqWarnings;
+        Vcf::EntryFormatter format;
+    };
+}
+
 VcfNormalizeIndelsCommand::VcfNormalizeIndelsCommand()
     : _outputFile("-")
+    , _outputFormat("vcf")
     , _clearFilters(false)
     , _mergeSamples(false)
+    , _threads(1)
+    , _batchSize(1000)
 {
 }
 
@@ -36,12 +94,25 @@ void VcfNormalizeIndelsCommand::configureOptions() {
         ("output-file,o",
             po::value<string>(&_outputFile),
             "output file (omit or use '-' for stdout)")
+
+        ("output-format",
+            po::value<string>(&_outputFormat)->default_value("vcf"),
+            "output format: vcf, or bcf for BGZF compressed BCF2")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to normalize with")
+
+        ("batch-size",
+            po::value<size_t>(&_batchSize)->default_value(1000),
+            "number of entries each thread processes at a time")
         ;
 
     _posOpts.add("input-file", -1);
 }
 
 void VcfNormalizeIndelsCommand::exec() {
+    Vcf::OutputFormat format = Vcf::outputFormatFromString(_outputFormat);
     Fasta ref(_fastaPath);
     auto in = _streams.openForReading(_inputFile);
     ostream* out = _streams.get<ostream>(_outputFile);
@@ -49,24 +120,12 @@ void VcfNormalizeIndelsCommand::exec() {
         throw runtime_error("stdin listed more than once!");
 
     auto reader = openStream<Vcf::Entry>(in);
-    *out << reader->header();
-    Vcf::Entry e;
-    Vcf::AltNormalizer norm(ref);
-    std::unordered_set<std::string> seqWarnings;
-    while (reader->next(e)) {
-        try {
-            norm.normalize(e);
-        } catch (UnknownSequenceError const& ex) {
-            auto inserted = seqWarnings.insert(e.chrom());
-            // only warn the first time for each sequence
-            if (inserted.second) {
-                // We couldn't get reference data for the sequence
-                cerr << "WARNING: at line " << reader->lineNum()
-                    << " in file " << reader->name() << ": sequence "
-                    << e.chrom() << " not found in reference " << _fastaPath << "\n"
-                    ;
-            }
-        }
-        *out << e << "\n";
-    }
+    Vcf::EntryWriter writer(*out, format);
+    writer.writeHeader(reader->header());
+
+    SequenceWarnings seqWarnings;
+    auto pipeline = makeOrderedPipeline(*reader, writer.stream(), _threads, _batchSize);
+    pipeline->run(NormalizeIndels(
+        ref, reader->name(), _fastaPath, seqWarnings, writer.formatter()));
+    writer.close();
 }
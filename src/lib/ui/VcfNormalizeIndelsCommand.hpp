@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <string>
 
 class VcfNormalizeIndelsCommand : public CommandBase {
@@ -21,9 +22,12 @@ protected:
     std::string _inputFile;
     std::string _fastaPath;
     std::string _outputFile;
+    std::string _outputFormat;
     std::string _fastaFile;
     std::string _mergeStrategyFile;
     bool _clearFilters;
     bool _mergeSamples;
+    std::size_t _threads;
+    std::size_t _batchSize;
 };
 
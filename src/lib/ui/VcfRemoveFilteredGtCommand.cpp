@@ -3,6 +3,7 @@
 #include "fileformats/TypedStream.hpp"
 #include "fileformats/vcf/Entry.hpp"
 #include "io/InputStream.hpp"
+#include "processors/OrderedPipeline.hpp"
 
 #include <boost/program_options.hpp>
 
@@ -11,9 +12,22 @@
 
 namespace po = boost::program_options;
 
+namespace {
+    struct RemoveFilteredGenotypes {
+        std::set<std::string> const& whitelist;
+
+        void operator()(Vcf::Entry& entry, OrderedPipelineContext& ctx) const {
+            entry.sampleData().removeFilteredWhitelist(whitelist);
+            ctx.out << entry << "\n";
+        }
+    };
+}
+
 VcfRemoveFilteredGtCommand::VcfRemoveFilteredGtCommand()
     : inputFile_("-")
     , outputFile_("-")
+    , threads_(1)
+    , batchSize_(1000)
 {
 }
 
@@ -31,6 +45,14 @@ void VcfRemoveFilteredGtCommand::configureOptions() {
             po::value<std::vector<std::string>>(&whitelist_),
             "Filters to keep (can be specified multiple times. use if something "
             "other than PASS/. should be retained)")
+
+        ("threads",
+            po::value<size_t>(&threads_)->default_value(1),
+            "number of threads to parse and filter with")
+
+        ("batch-size",
+            po::value<size_t>(&batchSize_)->default_value(1000),
+            "number of entries each thread processes at a time")
         ;
 
     _posOpts.add("input-file", 1);
@@ -47,10 +69,8 @@ void VcfRemoveFilteredGtCommand::exec() {
     std::ostream* out = _streams.get<std::ostream>(outputFile_);
 
     auto reader = openStream<Vcf::Entry>(inStream);
-    Vcf::Entry entry;
     *out << reader->header();
-    while (reader->next(entry)) {
-        entry.sampleData().removeFilteredWhitelist(whitelistSet);
-        *out << entry << "\n";
-    }
+
+    auto pipeline = makeOrderedPipeline(*reader, *out, threads_, batchSize_);
+    pipeline->run(RemoveFilteredGenotypes{whitelistSet});
 }
@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <set>
 #include <string>
 
@@ -21,4 +22,6 @@ protected:
     std::string inputFile_;
     std::string outputFile_;
     std::vector<std::string> whitelist_;
+    std::size_t threads_;
+    std::size_t batchSize_;
 };
@@ -12,6 +12,7 @@
 #include "io/InputStream.hpp"
 #include "io/StreamHandler.hpp"
 #include "metrics/Metrics.hpp"
+#include "processors/OrderedPipeline.hpp"
 
 #include <boost/program_options.hpp>
 
@@ -26,10 +27,168 @@
 namespace po = boost::program_options;
 using namespace std;
 
+namespace {
+    // Writes the per-site report line for an entry and adds it to the
+    // totals. Each thread keeps its own totals, which are added up once
+    // the whole file has been seen.
+    struct ReportSite {
+        ReportSite(vector<string> const& infoFields, size_t sampleCount)
+            : infoFields(infoFields)
+            , totalSites(0)
+            , sampleMetrics(sampleCount)
+        {}
+
+        ReportSite& operator+=(ReportSite const& rhs) {
+            totalSites += rhs.totalSites;
+            sampleMetrics += rhs.sampleMetrics;
+            return *this;
+        }
+
+        void operator()(Vcf::Entry& entry, OrderedPipelineContext& ctx) {
+            if (entry.alt().empty() ||
+                (!entry.failedFilters().empty() && !entry.failedFilters().contains(Vcf::FilterSet::PASS)))
+
+                return;
+            ++totalSites;
+            if(!entry.sampleData().hasGenotypeData())
+                return;
+
+            std::unique_ptr<Metrics::EntryMetrics> pSiteMetrics;
+            try {
+                pSiteMetrics = std::make_unique<Metrics::EntryMetrics>(entry, infoFields, ctx.err);
+            } catch (InvalidAlleleError const& e) {
+                ctx.err << e.what() << "\nSkipping entry " << entry << "\n";
+                return;
+            }
+            auto& siteMetrics = *pSiteMetrics;
+
+            //output per-site metrics
+            ctx.out << entry.chrom() << "\t" << entry.pos() << "\t" << entry.ref() << "\t";
+            auto altIter = entry.alt().begin();
+            while(altIter+1 != entry.alt().end()) {
+                ctx.out << *(altIter++) << ",";
+            }
+            ctx.out << *(altIter);
+            //transition status per allele will go next and then number of transitions at site and number of transversions at site
+            ctx.out << "\t";
+
+            uint32_t nSamples = entry.sampleData().header().sampleCount();
+            ctx.out << nSamples << "\t"
+                << entry.sampleData().samplesFailedFilter() << "\t"
+                << entry.sampleData().samplesWithoutGenotypes() << "\t";
+
+            std::vector<bool> transitionStatus = siteMetrics.transitionStatusByAlt();
+            uint32_t transitionIdx = 0;
+            uint32_t totalTransitionAlleles = 0;
+            if(!transitionStatus.empty()) {
+                transitionStatus = siteMetrics.transitionStatusByAlt();
+
+                while(transitionIdx < (transitionStatus.size() - 1)) {
+                    totalTransitionAlleles +=  transitionStatus[transitionIdx];
+                    ctx.out << transitionStatus[transitionIdx++] << ",";
+                }
+                totalTransitionAlleles += transitionStatus[transitionIdx];
+                ctx.out << transitionStatus[transitionIdx] << "\t" << totalTransitionAlleles << "\t" << transitionStatus.size() - totalTransitionAlleles;
+            }
+            else {
+                ctx.out << "0\t" << totalTransitionAlleles << "\t" << transitionStatus.size() - totalTransitionAlleles;
+            }
+
+            //next novelness will go followed by number novel, number known
+            ctx.out << "\t";
+            std::vector<bool> novelStatus = siteMetrics.novelStatusByAlt();
+            uint32_t novelIdx = 0;
+            uint32_t totalNovelAlleles = 0;
+            while(novelIdx < (novelStatus.size() - 1)) {
+                totalNovelAlleles +=  novelStatus[novelIdx];
+                ctx.out << novelStatus[novelIdx++] << ",";
+            }
+            totalNovelAlleles += novelStatus[novelIdx];
+            ctx.out << novelStatus[novelIdx] << "\t" << totalNovelAlleles << "\t" << novelStatus.size() - totalNovelAlleles;
+
+            //next genotype distribution
+            //FIXME this will likely only work as expected if our genotypes are unphased and always diploid.
+            auto const& allelesBySample = siteMetrics.allelicDistributionBySample();
+            auto const& distribution = siteMetrics.genotypeDistribution();
+
+            ctx.out << "\t";
+            for(uint32_t index1 = 0; index1 < allelesBySample.size(); ++index1) {
+                for(uint32_t index2 = 0; index2 <= index1; ++index2) {
+                    stringstream unphasedGenotype;
+                    unphasedGenotype << index2 << "/" << index1;
+                    Vcf::GenotypeCall gt(unphasedGenotype.str());        
+                    //ctx.out << gt.string() << ":";
+
+                    uint32_t count = 0;
+                    auto iter = distribution.find(gt);
+                    if (iter != distribution.end()) {
+                        count = iter->second;
+                    }
+                    ctx.out << count;
+                    //FIXME this is undoubtedly bad
+                    if( (index1 + 1) < allelesBySample.size() || index2 < index1 ) {
+                        ctx.out << ","; 
+                    }
+                }
+            }
+
+            //this hits up the allele distribution from above. We grabbed it there so we could know how many alts there were.
+            ctx.out << "\t";
+            uint32_t bySampleIndex = 0;
+            while(bySampleIndex < (allelesBySample.size() - 1)) {
+                ctx.out << allelesBySample[bySampleIndex++] << ",";
+            }
+            ctx.out << allelesBySample[bySampleIndex];
+
+            ctx.out << "\t";
+            std::vector<uint32_t> alleles = siteMetrics.allelicDistribution();
+            uint32_t alleleIndex = 0;
+            while(alleleIndex < (alleles.size() - 1)) {
+                ctx.out  << alleles[alleleIndex++] << ",";
+            }
+            ctx.out << alleles[alleleIndex];
+
+            ctx.out << "\t";
+            std::vector<double> frequencies = siteMetrics.alleleFrequencies();
+            uint32_t freqIndex = 0;
+            while(freqIndex < (frequencies.size() - 1)) {
+                ctx.out << frequencies[freqIndex++] << ",";
+            }
+            ctx.out << frequencies[freqIndex];
+            ctx.out << "\t" << siteMetrics.minorAlleleFrequency() << endl;
+
+
+            sampleMetrics.processEntry(entry, siteMetrics, ctx.err);
+
+            //plotting the above distribution in R
+            //ggplot(x, aes(x=V7,y = ..count../sum(..count..))) + geom_histogram() + xlab("Minor Allele Frequency") + ylab("Frequency") + opts(title = "Minor Allele Frequency Distribution")
+            //ggplot(x, aes(x=V7)) + geom_histogram() + xlab("Minor Allele Frequency") + ylab("Count") + opts(title = "Minor Allele Frequency Distribution")
+
+            //next want to add to per-sample variant metrics
+            //use MAF and distribution to classify
+            //if singleton (ie this is the only sample to have that particular alt. index here then go in singleton bini
+            //if not singleton but MAF < 1% then rare
+            //if not singleton or rarest but MAF < 5% then less rare
+            //if MAF >= 5% then common
+            //for each sample report total number of no data, filtered, pass_filter, singleton, rarest, rare, common SNPs, in dbSNP, Singleton Transitions, Singleton Transversions, Non-singleton Transitions, Non-singleton Transversions
+
+            // how many samples have a non-reference genotype?
+            //cout << samplesWithNonRefGenotypes(entry) << "\n";
+        }
+
+        vector<string> const& infoFields;
+        uint32_t totalSites;
+        Metrics::SampleMetrics sampleMetrics;
+    };
+}
+
+
 VcfReportCommand::VcfReportCommand()
     : _infile("-")
     , _perSampleFile("per_sample_report.txt")
     , _perSiteFile("per_site_report.txt")
+    , _threads(1)
+    , _batchSize(1000)
 {
 }
 
@@ -50,6 +209,14 @@ void VcfReportCommand::configureOptions() {
         ("info-fields-from-db,I",
             po::value<vector<string>>(&_infoFields),
             "info fields to use for determining if a variant is known (default: none)")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to compute per-site metrics with")
+
+        ("batch-size",
+            po::value<size_t>(&_batchSize)->default_value(1000),
+            "number of entries each thread processes at a time")
         ;
 
     _posOpts.add("input-file", 1);
@@ -61,147 +228,21 @@ void VcfReportCommand::exec() {
     ostream* perSiteOut = _streams.get<ostream>(_perSiteFile);
     if (_streams.cinReferences() > 1)
         throw runtime_error("stdin listed more than once!");
-    uint32_t totalSites = 0;
     auto reader = openStream<Vcf::Entry>(*instream);
-    Vcf::Entry entry;
-    Metrics::SampleMetrics sampleMetrics(reader->header().sampleCount());
 
     *perSiteOut << "Chrom\tPos\tRef\tAlt\tTotalSamples\tNumberFiltered\tNumberMissing\tByAltTransition\tTotalTransitions\tTotalTransversions\tByAltNovel\tTotalNovel\tTotalKnown\tGenotypeDist\tAlleleDistBySample\tAlleleDist\tByAltAlleleFreq\tMAF\n"; 
-    while (reader->next(entry)) {
-        if (entry.alt().empty() ||
-            (entry.failedFilters().size() >= 1 && entry.failedFilters().find("PASS") == entry.failedFilters().end()))
-
-            continue;
-        totalSites++;
-        if(!entry.sampleData().hasGenotypeData())
-            continue;
-
-        std::unique_ptr<Metrics::EntryMetrics> pSiteMetrics;
-        try {
-            pSiteMetrics = std::make_unique<Metrics::EntryMetrics>(entry, _infoFields);
-        } catch (InvalidAlleleError const& e) {
-            std::cerr << e.what() << "\nSkipping entry " << entry << "\n";
-            continue;
-        }
-        auto& siteMetrics = *pSiteMetrics;
-
-        //output per-site metrics
-        *perSiteOut << entry.chrom() << "\t" << entry.pos() << "\t" << entry.ref() << "\t";
-        auto altIter = entry.alt().begin();
-        while(altIter+1 != entry.alt().end()) {
-            *perSiteOut << *(altIter++) << ",";
-        }
-        *perSiteOut << *(altIter);
-        //transition status per allele will go next and then number of transitions at site and number of transversions at site
-        *perSiteOut << "\t";
-
-        uint32_t nSamples = entry.sampleData().header().sampleCount();
-        *perSiteOut << nSamples << "\t"
-            << entry.sampleData().samplesFailedFilter() << "\t"
-            << entry.sampleData().samplesWithoutGenotypes() << "\t";
-
-        std::vector<bool> transitionStatus = siteMetrics.transitionStatusByAlt();
-        uint32_t transitionIdx = 0;
-        uint32_t totalTransitionAlleles = 0;
-        if(!transitionStatus.empty()) {
-            transitionStatus = siteMetrics.transitionStatusByAlt();
-
-            while(transitionIdx < (transitionStatus.size() - 1)) {
-                totalTransitionAlleles +=  transitionStatus[transitionIdx];
-                *perSiteOut << transitionStatus[transitionIdx++] << ",";
-            }
-            totalTransitionAlleles += transitionStatus[transitionIdx];
-            *perSiteOut << transitionStatus[transitionIdx] << "\t" << totalTransitionAlleles << "\t" << transitionStatus.size() - totalTransitionAlleles;
-        }
-        else {
-            *perSiteOut << "0\t" << totalTransitionAlleles << "\t" << transitionStatus.size() - totalTransitionAlleles;
-        }
-
-        //next novelness will go followed by number novel, number known
-        *perSiteOut << "\t";
-        std::vector<bool> novelStatus = siteMetrics.novelStatusByAlt();
-        uint32_t novelIdx = 0;
-        uint32_t totalNovelAlleles = 0;
-        while(novelIdx < (novelStatus.size() - 1)) {
-            totalNovelAlleles +=  novelStatus[novelIdx];
-            *perSiteOut << novelStatus[novelIdx++] << ",";
-        }
-        totalNovelAlleles += novelStatus[novelIdx];
-        *perSiteOut << novelStatus[novelIdx] << "\t" << totalNovelAlleles << "\t" << novelStatus.size() - totalNovelAlleles;
-
-        //next genotype distribution
-        //FIXME this will likely only work as expected if our genotypes are unphased and always diploid.
-        auto const& allelesBySample = siteMetrics.allelicDistributionBySample();
-        auto const& distribution = siteMetrics.genotypeDistribution();
-
-        *perSiteOut << "\t";
-        for(uint32_t index1 = 0; index1 < allelesBySample.size(); ++index1) {
-            for(uint32_t index2 = 0; index2 <= index1; ++index2) {
-                stringstream unphasedGenotype;
-                unphasedGenotype << index2 << "/" << index1;
-                Vcf::GenotypeCall gt(unphasedGenotype.str());        
-                //*perSiteOut << gt.string() << ":";
-
-                uint32_t count = 0;
-                auto iter = distribution.find(gt);
-                if (iter != distribution.end()) {
-                    count = iter->second;
-                }
-                *perSiteOut << count;
-                //FIXME this is undoubtedly bad
-                if( (index1 + 1) < allelesBySample.size() || index2 < index1 ) {
-                    *perSiteOut << ","; 
-                }
-            }
-        }
-
-        //this hits up the allele distribution from above. We grabbed it there so we could know how many alts there were.
-        *perSiteOut << "\t";
-        uint32_t bySampleIndex = 0;
-        while(bySampleIndex < (allelesBySample.size() - 1)) {
-            *perSiteOut << allelesBySample[bySampleIndex++] << ",";
-        }
-        *perSiteOut << allelesBySample[bySampleIndex];
-
-        *perSiteOut << "\t";
-        std::vector<uint32_t> alleles = siteMetrics.allelicDistribution();
-        uint32_t alleleIndex = 0;
-        while(alleleIndex < (alleles.size() - 1)) {
-            *perSiteOut  << alleles[alleleIndex++] << ",";
-        }
-        *perSiteOut << alleles[alleleIndex];
-
-        *perSiteOut << "\t";
-        std::vector<double> frequencies = siteMetrics.alleleFrequencies();
-        uint32_t freqIndex = 0;
-        while(freqIndex < (frequencies.size() - 1)) {
-            *perSiteOut << frequencies[freqIndex++] << ",";
-        }
-        *perSiteOut << frequencies[freqIndex];
-        *perSiteOut << "\t" << siteMetrics.minorAlleleFrequency() << endl;
-
-
-        sampleMetrics.processEntry(entry,siteMetrics);
-
-        //plotting the above distribution in R
-        //ggplot(x, aes(x=V7,y = ..count../sum(..count..))) + geom_histogram() + xlab("Minor Allele Frequency") + ylab("Frequency") + opts(title = "Minor Allele Frequency Distribution")
-        //ggplot(x, aes(x=V7)) + geom_histogram() + xlab("Minor Allele Frequency") + ylab("Count") + opts(title = "Minor Allele Frequency Distribution")
-
-        //next want to add to per-sample variant metrics
-        //use MAF and distribution to classify
-        //if singleton (ie this is the only sample to have that particular alt. index here then go in singleton bini
-        //if not singleton but MAF < 1% then rare
-        //if not singleton or rarest but MAF < 5% then less rare
-        //if MAF >= 5% then common
-        //for each sample report total number of no data, filtered, pass_filter, singleton, rarest, rare, common SNPs, in dbSNP, Singleton Transitions, Singleton Transversions, Non-singleton Transitions, Non-singleton Transversions
-
-        // how many samples have a non-reference genotype?
-        //cout << samplesWithNonRefGenotypes(entry) << "\n";
-    }
-
+    auto pipeline = makeOrderedPipeline(*reader, *perSiteOut, _threads, _batchSize);
+    auto sites = pipeline->run(ReportSite(_infoFields, reader->header().sampleCount()));
+    ReportSite& totals = sites[0];
+    for (size_t i = 1; i < sites.size(); ++i)
+        totals += sites[i];
+
+    uint32_t totalSites = totals.totalSites;
+    Metrics::SampleMetrics const& sampleMetrics = totals.sampleMetrics;
+    Vcf::Header const& header = reader->header();
     *perSampleOut << "SampleName\tTotalSites\tRef\tHet\tHom\tFilt\tMissing\tnonDiploid\tKnown\tNovel\tPercKnown\tSingleton\tVeryRare\tRare\tCommon\tTransitions\tTransversions\tTransition:Transversion" << endl;
-    for(uint32_t i = 0; i < entry.header().sampleCount(); ++i) {
-        *perSampleOut << entry.header().sampleNames()[i];
+    for(uint32_t i = 0; i < header.sampleCount(); ++i) {
+        *perSampleOut << header.sampleNames()[i];
         *perSampleOut << "\t" << totalSites;
         *perSampleOut << "\t" << sampleMetrics.numRefCalls(i);
         *perSampleOut << "\t" << sampleMetrics.numHetVariants(i);
@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -23,4 +24,6 @@ protected:
     std::string _perSampleFile;
     std::string _perSiteFile;
     std::vector<std::string> _infoFields;
+    std::size_t _threads;
+    std::size_t _batchSize;
 };
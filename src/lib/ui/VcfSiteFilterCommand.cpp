@@ -1,10 +1,10 @@
 #include "VcfSiteFilterCommand.hpp"
 
 #include "io/InputStream.hpp"
-#include "fileformats/DefaultPrinter.hpp"
 #include "fileformats/TypedStream.hpp"
 #include "fileformats/vcf/Entry.hpp"
 #include "fileformats/vcf/Header.hpp"
+#include "processors/OrderedPipeline.hpp"
 
 #include <boost/bind.hpp>
 #include <boost/format.hpp>
@@ -17,10 +17,36 @@ namespace po = boost::program_options;
 using boost::format;
 using namespace std;
 
+namespace {
+    struct SiteFilter {
+        std::string const& filterName;
+        double minFailFilter;
+
+        void operator()(Vcf::Entry& e, OrderedPipelineContext& ctx) const {
+            uint32_t numSamplesEval = e.sampleData().samplesEvaluatedByFilter();
+            int32_t numFailed = e.sampleData().samplesFailedFilter();
+            if(numFailed < 0) {
+                //there was no FT field available. Warn.
+                ctx.err << "No per-sample filter field available for line " << ctx.lineNum << "\n";
+            } else {
+                if (numSamplesEval && (double) numFailed/ (double) numSamplesEval > minFailFilter) {
+                    e.addFilter(filterName);
+                }
+                else {
+                    e.addFilter("PASS");
+                }
+                ctx.out << e << "\n";
+            }
+        }
+    };
+}
+
 VcfSiteFilterCommand::VcfSiteFilterCommand()
     : _infile("-")
     , _outputFile("-")
     , _minFailFilter(1.0)
+    , _threads(1)
+    , _batchSize(1000)
 {
 }
 
@@ -37,6 +63,14 @@ void VcfSiteFilterCommand::configureOptions() {
         ("min-fail-filter,f",
             po::value<double>(&_minFailFilter)->default_value(1.0),
             "minimum fraction of failed samples to fail a site")
+
+        ("threads",
+            po::value<size_t>(&_threads)->default_value(1),
+            "number of threads to parse and filter with")
+
+        ("batch-size",
+            po::value<size_t>(&_batchSize)->default_value(1000),
+            "number of entries each thread processes at a time")
         ;
 
     _posOpts.add("input-file", -1);
@@ -66,26 +100,10 @@ void VcfSiteFilterCommand::exec() {
     auto readerPtr = openStream<Vcf::Entry>(*instream);
     auto& reader = *readerPtr;
 
-    DefaultPrinter writer(*out);
     //create filter entry for header
     reader.header().addFilter(_filterName,_filterDescription);
 
-    Vcf::Entry e;
     *out << reader.header();
-    while (reader.next(e)) {
-        uint32_t numSamplesEval = e.sampleData().samplesEvaluatedByFilter();
-        int32_t numFailed = e.sampleData().samplesFailedFilter();
-        if(numFailed < 0) {
-            //there was no FT field available. Warn.
-            cerr << "No per-sample filter field available for line " << reader.lineNum() << endl;
-        } else {
-            if (numSamplesEval && (double) numFailed/ (double) numSamplesEval > _minFailFilter) {
-                e.addFilter(_filterName);
-            }
-            else {
-                e.addFilter("PASS");
-            }
-            writer(e);
-        }
-    }
+    auto pipeline = makeOrderedPipeline(reader, *out, _threads, _batchSize);
+    pipeline->run(SiteFilter{_filterName, _minFailFilter});
 }
@@ -2,6 +2,7 @@
 
 #include "ui/CommandBase.hpp"
 
+#include <cstddef>
 #include <string>
 
 class VcfSiteFilterCommand : public CommandBase {
@@ -22,4 +23,6 @@ protected:
     double _minFailFilter;
     std::string _filterName;
     std::string _filterDescription;
+    std::size_t _threads;
+    std::size_t _batchSize;
 };
@@ -0,0 +1,109 @@
+#include "common/DelimiterIndex.hpp"
+#include "common/Tokenizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    vector<DelimiterIndex::Offset> naiveOffsets(string const& s) {
+        vector<DelimiterIndex::Offset> rv;
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (DelimiterIndex::isDelimiter(s[i]))
+                rv.push_back(i);
+        }
+        return rv;
+    }
+
+    // long enough to exercise the vectorized paths and the scalar tail
+    string wideLine() {
+        string rv("1\t12345\trs1;rs2\tA\tC,G\t30\tPASS\tDP=10;AF=0.5,0.25\tGT:DP:FT");
+        for (int i = 0; i < 37; ++i) {
+            rv += "\t0/1:";
+            rv += to_string(i);
+            rv += ":q10;s50";
+        }
+        return rv;
+    }
+}
+
+TEST(TestDelimiterIndex, empty) {
+    string input;
+    DelimiterIndex idx(input);
+    EXPECT_TRUE(idx.offsets().empty());
+    EXPECT_TRUE(idx.complete());
+}
+
+TEST(TestDelimiterIndex, offsets) {
+    string input("a\tb:c;d,e");
+    DelimiterIndex idx(input);
+    vector<DelimiterIndex::Offset> expected{1, 3, 5, 7};
+    EXPECT_EQ(expected, idx.offsets());
+    EXPECT_TRUE(idx.complete());
+
+    string wide = wideLine();
+    idx.index(wide.data(), wide.data() + wide.size());
+    EXPECT_EQ(naiveOffsets(wide), idx.offsets());
+    EXPECT_TRUE(idx.complete());
+}
+
+TEST(TestDelimiterIndex, find) {
+    string input("a:b\tc:d\te");
+    DelimiterIndex idx(input);
+    DelimiterIndex::Cursor cursor = 0;
+    EXPECT_EQ(3u, idx.find(cursor, 0, '\t'));
+    EXPECT_EQ(7u, idx.find(cursor, 4, '\t'));
+    EXPECT_EQ(DelimiterIndex::npos, idx.find(cursor, 8, '\t'));
+
+    cursor = idx.lowerBound(4);
+    EXPECT_EQ(5u, idx.find(cursor, 4, ':'));
+}
+
+TEST(TestDelimiterIndex, maxTabs) {
+    string wide = wideLine();
+    DelimiterIndex idx(wide, 8);
+    EXPECT_FALSE(idx.complete());
+    EXPECT_LT(idx.scannedEnd(), wide.size());
+
+    vector<DelimiterIndex::Offset> expected = naiveOffsets(wide);
+    expected.resize(idx.offsets().size());
+    EXPECT_EQ(expected, idx.offsets());
+
+    size_t tabs = 0;
+    for (auto i = idx.offsets().begin(); i != idx.offsets().end(); ++i)
+        tabs += wide[*i] == '\t';
+    EXPECT_LE(8u, tabs);
+}
+
+TEST(TestDelimiterIndex, tokenizer) {
+    string wide = wideLine();
+
+    // a tokenizer on a partial index must agree with a plain one
+    for (uint32_t maxTabs = 0; maxTabs < 12; ++maxTabs) {
+        DelimiterIndex idx(wide, maxTabs);
+        Tokenizer<char> indexed(idx, '\t');
+        Tokenizer<char> plain(wide, '\t');
+
+        string a;
+        string b;
+        while (plain.extract(b)) {
+            ASSERT_TRUE(indexed.extract(a));
+            ASSERT_EQ(b, a);
+        }
+        EXPECT_TRUE(indexed.eof());
+    }
+}
+
+TEST(TestDelimiterIndex, splitSubrange) {
+    string input("x\t,1,,3,\ty");
+    DelimiterIndex idx(input);
+    vector<string> fields;
+    Tokenizer<char>::split(idx, input.data() + 2, input.data() + 8, ',', back_inserter(fields));
+
+    vector<string> expected{"", "1", "", "3", ""};
+    EXPECT_EQ(expected, fields);
+}
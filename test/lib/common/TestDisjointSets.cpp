@@ -0,0 +1,45 @@
+#include "common/DisjointSets.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(TestDisjointSets, unite) {
+    DisjointSets sets(6);
+    for (size_t i = 0; i < sets.size(); ++i) {
+        EXPECT_EQ(i, sets.find(i));
+        EXPECT_EQ(1u, sets.setSize(i));
+    }
+
+    EXPECT_TRUE(sets.unite(0, 3));
+    EXPECT_TRUE(sets.unite(4, 5));
+    EXPECT_TRUE(sets.unite(5, 3));
+    EXPECT_FALSE(sets.unite(0, 4));
+
+    EXPECT_EQ(sets.find(0), sets.find(3));
+    EXPECT_EQ(sets.find(0), sets.find(4));
+    EXPECT_EQ(sets.find(0), sets.find(5));
+    EXPECT_NE(sets.find(0), sets.find(1));
+    EXPECT_NE(sets.find(1), sets.find(2));
+    EXPECT_EQ(4u, sets.setSize(5));
+    EXPECT_EQ(1u, sets.setSize(2));
+}
+
+TEST(TestDisjointSets, longChain) {
+    size_t n = 100000;
+    DisjointSets sets(n);
+    for (size_t i = 1; i < n; ++i)
+        sets.unite(i - 1, i);
+
+    size_t root = sets.find(0);
+    for (size_t i = 0; i < n; ++i)
+        ASSERT_EQ(root, sets.find(i));
+    EXPECT_EQ(n, sets.setSize(n - 1));
+}
+
+TEST(TestDisjointSets, reset) {
+    DisjointSets sets(3);
+    sets.unite(0, 2);
+    sets.reset(4);
+    EXPECT_EQ(4u, sets.size());
+    for (size_t i = 0; i < sets.size(); ++i)
+        EXPECT_EQ(i, sets.find(i));
+}
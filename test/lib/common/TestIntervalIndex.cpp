@@ -0,0 +1,102 @@
+#include "common/IntervalIndex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    struct Interval {
+        string const& chrom() const { return chrom_; }
+        int64_t start() const { return start_; }
+        int64_t stop() const { return stop_; }
+
+        string chrom_;
+        int64_t start_;
+        int64_t stop_;
+    };
+
+    vector<size_t> bruteForce(
+              vector<Interval> const& xs
+            , string const& chrom
+            , int64_t start
+            , int64_t stop
+            )
+    {
+        vector<size_t> rv;
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (xs[i].chrom() == chrom && xs[i].start() <= stop && xs[i].stop() >= start)
+                rv.push_back(i);
+        }
+        return rv;
+    }
+}
+
+TEST(TestIntervalIndex, empty) {
+    IntervalIndex<Interval> index;
+    index.build();
+    EXPECT_TRUE(index.built());
+    EXPECT_EQ(0u, index.size());
+
+    vector<size_t> ids(1, 0);
+    index.findTouching("1", 0, 10, ids);
+    EXPECT_TRUE(ids.empty());
+}
+
+TEST(TestIntervalIndex, touching) {
+    IntervalIndex<Interval> index;
+    index.add(Interval{"1", 10, 20});
+    index.add(Interval{"2", 0, 100});
+    index.add(Interval{"1", 5, 10});
+    index.add(Interval{"1", 20, 20});
+    index.add(Interval{"1", 21, 30});
+    EXPECT_FALSE(index.built());
+    index.build();
+
+    vector<size_t> ids;
+    index.findTouching("1", 20, 20, ids);
+    EXPECT_EQ((vector<size_t>{0, 3}), ids);
+
+    index.findTouching("1", 10, 10, ids);
+    EXPECT_EQ((vector<size_t>{0, 2}), ids);
+
+    index.findTouching("1", 0, 4, ids);
+    EXPECT_TRUE(ids.empty());
+
+    index.findTouching("2", 50, 51, ids);
+    EXPECT_EQ((vector<size_t>{1}), ids);
+
+    index.findTouching("3", 0, 100, ids);
+    EXPECT_TRUE(ids.empty());
+
+    EXPECT_EQ(5, index.value(2).start());
+}
+
+TEST(TestIntervalIndex, matchesBruteForce) {
+    srand(42);
+    vector<string> chroms{"1", "2", "X"};
+    vector<Interval> xs;
+    IntervalIndex<Interval> index;
+    for (size_t i = 0; i < 5000; ++i) {
+        int64_t start = rand() % 100000;
+        int64_t len = rand() % 8 ? rand() % 50 : rand() % 5000;
+        Interval x{chroms[rand() % chroms.size()], start, start + len};
+        xs.push_back(x);
+        index.add(x);
+    }
+    index.build();
+    ASSERT_EQ(xs.size(), index.size());
+
+    vector<size_t> ids;
+    for (size_t i = 0; i < 2000; ++i) {
+        string const& chrom = chroms[rand() % chroms.size()];
+        int64_t start = rand() % 101000;
+        int64_t stop = start + rand() % 200;
+        index.findTouching(chrom, start, stop, ids);
+        ASSERT_EQ(bruteForce(xs, chrom, start, stop), ids)
+            << chrom << ":" << start << "-" << stop;
+    }
+}
@@ -47,3 +47,20 @@ TEST(TestMutationSpectrum, invalidAlleles) {
         }
     }
 }
+
+TEST(TestMutationSpectrum, add) {
+    MutationSpectrum a;
+    MutationSpectrum b;
+    a('A', 'G') = 2;
+    a('C', 'T') = 1;
+    b('A', 'G') = 3;
+    b('A', 'C') = 4;
+
+    a += b;
+    EXPECT_EQ(5u, a('A', 'G'));
+    EXPECT_EQ(1u, a('C', 'T'));
+    EXPECT_EQ(4u, a('A', 'C'));
+    EXPECT_EQ(6u, a.transitions());
+    EXPECT_EQ(4u, a.transversions());
+    EXPECT_EQ(3u, b('A', 'G'));
+}
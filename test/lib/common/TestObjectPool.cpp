@@ -0,0 +1,50 @@
+#include "common/ObjectPool.hpp"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(TestObjectPool, reuse) {
+    ObjectPool<string> pool;
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    EXPECT_EQ(2u, pool.allocated());
+    EXPECT_EQ(0u, pool.size());
+
+    a->assign(100, 'x');
+    size_t capacity = a->capacity();
+    string const* addr = a.get();
+    pool.release(std::move(a));
+    EXPECT_EQ(1u, pool.size());
+
+    auto c = pool.acquire();
+    EXPECT_EQ(addr, c.get());
+    EXPECT_EQ(capacity, c->capacity());
+    EXPECT_EQ(2u, pool.allocated());
+    EXPECT_EQ(0u, pool.size());
+}
+
+TEST(TestObjectPool, releaseVector) {
+    ObjectPool<int> pool;
+    vector<unique_ptr<int>> v;
+    for (int i = 0; i < 3; ++i)
+        v.push_back(pool.acquire());
+    v.push_back(nullptr);
+
+    pool.release(v);
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(3u, pool.size());
+}
+
+TEST(TestObjectPool, maxSize) {
+    ObjectPool<int> pool(2);
+    vector<unique_ptr<int>> v;
+    for (int i = 0; i < 5; ++i)
+        v.push_back(pool.acquire());
+
+    pool.release(v);
+    EXPECT_EQ(2u, pool.size());
+    EXPECT_EQ(5u, pool.allocated());
+}
@@ -0,0 +1,280 @@
+#include "common/ParseNumber.hpp"
+
+#include <boost/spirit/home/qi/numeric.hpp>
+#include <boost/spirit/home/qi/parse.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+    // The parsers Tokenizer used to use, for reference
+    template<typename T>
+    bool spiritInt(string const& s, T& value) {
+        char const* beg = s.data();
+        char const* end = s.data() + s.size();
+        boost::spirit::qi::any_int_parser<T> parser;
+        return boost::spirit::qi::parse(beg, end, parser, value) && beg == end;
+    }
+
+    template<typename T>
+    bool spiritReal(string const& s, T& value) {
+        char const* beg = s.data();
+        char const* end = s.data() + s.size();
+        boost::spirit::qi::any_real_parser<T> parser;
+        return boost::spirit::qi::parse(beg, end, parser, value) && beg == end;
+    }
+
+    template<typename T>
+    bool sameBits(T a, T b) {
+        return memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    template<typename T>
+    void expectIntMatchesSpirit(string const& s) {
+        T expected = 7;
+        T actual = 7;
+        bool expectedOk = spiritInt(s, expected);
+        bool actualOk = parseInteger(s.data(), s.data() + s.size(), actual);
+        EXPECT_EQ(expectedOk, actualOk) << "'" << s << "'";
+        if (expectedOk && actualOk) {
+            EXPECT_EQ(expected, actual) << "'" << s << "'";
+        }
+    }
+
+    template<typename T>
+    void expectRealMatchesSpirit(string const& s) {
+        T expected = 7;
+        T actual = 7;
+        bool expectedOk = spiritReal(s, expected);
+        bool actualOk = parseFloat(s.data(), s.data() + s.size(), actual);
+        EXPECT_EQ(expectedOk, actualOk) << "'" << s << "'";
+        if (expectedOk && actualOk) {
+            EXPECT_TRUE(sameBits(expected, actual)) << "'" << s << "': "
+                << expected << " != " << actual;
+        }
+    }
+
+    template<typename T>
+    void expectRealMatchesStrtod(string const& s) {
+        T actual = 7;
+        ASSERT_TRUE(parseFloat(s.data(), s.data() + s.size(), actual)) << s;
+        T expected = sizeof(T) == sizeof(float)
+            ? strtof(s.c_str(), 0)
+            : strtod(s.c_str(), 0);
+        EXPECT_TRUE(sameBits(expected, actual)) << "'" << s << "': "
+            << expected << " != " << actual;
+    }
+
+    // A random decimal with up to maxDigits digits, a randomly placed
+    // decimal point, and an exponent in [-maxExp, maxExp].
+    string randomDecimal(mt19937& rng, int maxDigits, int maxExp) {
+        string s;
+        switch (rng() % 3) {
+            case 0: s += '-'; break;
+            case 1: s += '+'; break;
+            default: break;
+        }
+        int digits = 1 + rng() % maxDigits;
+        int dot = rng() % (digits + 2);
+        for (int i = 0; i < digits; ++i) {
+            if (i == dot)
+                s += '.';
+            s += char('0' + rng() % 10);
+        }
+        if (dot == digits)
+            s += '.';
+
+        // keep the total scale within maxExp
+        int fracDigits = dot < digits ? digits - dot : 0;
+        int e = int(rng() % (2 * maxExp + 1)) - maxExp + fracDigits;
+        e = max(-maxExp + fracDigits, min(maxExp - fracDigits, e));
+        if (rng() % 2) {
+            s += rng() % 2 ? 'e' : 'E';
+            s += to_string(e);
+        }
+        return s;
+    }
+
+    vector<string> const& syntaxCases() {
+        static vector<string> const cases = {
+            "", "+", "-", ".", "-.", "+.", "..", "1.", ".5", "-.5", "1.5.",
+            "1e", "1e+", "1e-", "1e5x", "e5", ".e5", "1.e3", "1E3", "1e+03",
+            "1e-03", " 1", "1 ", "0x10", "1,5", "--1", "+-1", "1+",
+            "nan", "NaN", "-nan", "+NAN", "nan()", "nan(abc)", "nan(", "nanx",
+            "inf", "-Inf", "INFINITY", "-infinity", "infin", "infinityx",
+            "1inf", "01inf", "1.nan", "-1.inf", "1.0inf", "2inf", "1e0inf",
+            "0", "-0", "+0", "0.0", "-0.0", "-.0", "00000000000000000000001.5",
+            "0.000000000000001",
+            "4.9e-324", "2.2250738585072014e-308", "1e-300", "1e300",
+        };
+        return cases;
+    }
+
+    template<typename T>
+    vector<string> integerCases() {
+        vector<string> rv = {
+            "", "+", "-", "0", "-0", "+0", "000", "-000", "1", "-1", "+1",
+            "1x", "x1", " 1", "1 ", "1.0", "1e3", "--1",
+            "00000000000000000000000000000012",
+            "-00000000000000000000000000000012",
+            "12345678901234567890", "99999999999999999999",
+            "123456789012345678901234567890",
+        };
+        typedef numeric_limits<T> L;
+        rv.push_back(to_string(L::max()));
+        rv.push_back(to_string(uint64_t(L::max()) + 1));
+        rv.push_back(to_string(uint64_t(L::max()) - 1));
+        rv.push_back("-" + to_string(uint64_t(L::max())));
+        rv.push_back("+" + to_string(L::max()));
+        rv.push_back("0000" + to_string(L::max()));
+        if (L::is_signed) {
+            rv.push_back(to_string(L::min()));
+            rv.push_back("-" + to_string(uint64_t(L::max()) + 2));
+        }
+        return rv;
+    }
+
+    template<typename T>
+    void integersMatchSpirit() {
+        for (auto const& s : integerCases<T>())
+            expectIntMatchesSpirit<T>(s);
+
+        mt19937 rng(1);
+        for (int i = 0; i < 20000; ++i) {
+            uint64_t v = (uint64_t(rng()) << 32) | rng();
+            v >>= rng() % 64;
+            string s = to_string(v);
+            expectIntMatchesSpirit<T>(s);
+            if (numeric_limits<T>::is_signed || v == 0)
+                expectIntMatchesSpirit<T>("-" + s);
+        }
+    }
+}
+
+TEST(TestParseNumber, integersMatchSpirit) {
+    integersMatchSpirit<int8_t>();
+    integersMatchSpirit<uint8_t>();
+    integersMatchSpirit<int16_t>();
+    integersMatchSpirit<uint16_t>();
+    integersMatchSpirit<int32_t>();
+    integersMatchSpirit<uint32_t>();
+    integersMatchSpirit<int64_t>();
+    integersMatchSpirit<uint64_t>();
+}
+
+TEST(TestParseNumber, negativeUnsignedWraps) {
+    uint32_t u32;
+    ASSERT_TRUE(parseInteger("-1", "-1" + 2, u32));
+    EXPECT_EQ(numeric_limits<uint32_t>::max(), u32);
+
+    uint64_t u64;
+    char const* s = "-18446744073709551615";
+    ASSERT_TRUE(parseInteger(s, s + strlen(s), u64));
+    EXPECT_EQ(1u, u64);
+
+    s = "-18446744073709551616";
+    EXPECT_FALSE(parseInteger(s, s + strlen(s), u64));
+}
+
+TEST(TestParseNumber, realSyntaxMatchesSpirit) {
+    for (auto const& s : syntaxCases()) {
+        expectRealMatchesSpirit<double>(s);
+        expectRealMatchesSpirit<float>(s);
+    }
+}
+
+// spirit accumulates the digits in a T and then scales by a power of 10, so
+// it is exact (and agrees with any correctly rounded parser) as long as the
+// digits and power of ten are both exactly representable.
+TEST(TestParseNumber, doublesMatchSpirit) {
+    mt19937 rng(2);
+    for (int i = 0; i < 100000; ++i)
+        expectRealMatchesSpirit<double>(randomDecimal(rng, 15, 22));
+}
+
+TEST(TestParseNumber, floatsMatchSpirit) {
+    mt19937 rng(3);
+    for (int i = 0; i < 100000; ++i)
+        expectRealMatchesSpirit<float>(randomDecimal(rng, 7, 10));
+}
+
+// Outside of that domain spirit is not correctly rounded, so check against
+// the C library instead.
+TEST(TestParseNumber, correctlyRounded) {
+    vector<string> cases = {
+        // halfway cases, round to even
+        "9007199254740993", "9007199254740995", "9007199254740993.0000000001",
+        "1.00000005960464477539062499", "1.00000005960464477539062500",
+        "1.00000005960464477539062501", "16777217", "16777219",
+        // limits
+        "1.7976931348623157e308", "1.7976931348623158e308",
+        "1.7976931348623159e308", "2.2250738585072011e-308",
+        "2.2250738585072012e-308", "4.9406564584124654e-324",
+        "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400",
+        "3.4028234e38", "3.4028236e38", "1.17549435e-38", "1.4e-45",
+        "7.0e-46", "7.1e-46", "1e400", "-1e400", "1e-2147483647",
+        // long mantissas
+        "123456789012345678901234567890",
+        "0.1000000000000000055511151231257827021181583404541015625",
+        "3.14159265358979323846264338327950288419716939937510582097494",
+        "0.0000000000000000000000000000000000000000000000000000000001",
+        "7.2057594037927933e16", "2.98023223876953125e-8",
+    };
+    for (auto const& s : cases) {
+        expectRealMatchesStrtod<double>(s);
+        expectRealMatchesStrtod<float>(s);
+    }
+
+    mt19937 rng(4);
+    char buf[64];
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t bits = (uint64_t(rng()) << 32) | rng();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (!std::isfinite(d))
+            continue;
+        int precision = 1 + rng() % 19;
+        snprintf(buf, sizeof(buf), rng() % 2 ? "%.*e" : "%.*g", precision, d);
+        expectRealMatchesStrtod<double>(buf);
+        expectRealMatchesStrtod<float>(buf);
+    }
+}
+
+TEST(TestParseNumber, specialValues) {
+    double d;
+    char const* s = "-0";
+    ASSERT_TRUE(parseFloat(s, s + 2, d));
+    EXPECT_EQ(0.0, d);
+    EXPECT_TRUE(std::signbit(d));
+
+    s = "-nan(123)";
+    ASSERT_TRUE(parseFloat(s, s + strlen(s), d));
+    EXPECT_TRUE(std::isnan(d));
+    EXPECT_TRUE(std::signbit(d));
+
+    s = "-Infinity";
+    ASSERT_TRUE(parseFloat(s, s + strlen(s), d));
+    EXPECT_EQ(-numeric_limits<double>::infinity(), d);
+
+    // exponents that don't fit in an int are rejected, as in spirit
+    s = "1e2147483648";
+    EXPECT_FALSE(parseFloat(s, s + strlen(s), d));
+}
+
+TEST(TestParseNumber, longDouble) {
+    vector<string> cases = {"1.5", "-2.25e10", "0.1", "1e-4000", "1e400", "inf"};
+    for (auto const& s : cases) {
+        long double v;
+        ASSERT_TRUE(parseFloat(s.data(), s.data() + s.size(), v)) << s;
+        EXPECT_EQ(strtold(s.c_str(), 0), v) << s;
+    }
+}
@@ -0,0 +1,49 @@
+#include "common/SharedCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SharedCache, getAndReset) {
+    int builds = 0;
+    auto build = [&builds]() { return std::string(++builds, 'x'); };
+
+    SharedCache<std::string> cache;
+    std::string const& a = cache.get(build);
+    EXPECT_EQ("x", a);
+    EXPECT_EQ(&a, &cache.get(build));
+    EXPECT_EQ(1, builds);
+
+    SharedCache<std::string> copy(cache);
+    EXPECT_EQ(&a, &copy.get(build));
+
+    cache.reset();
+    EXPECT_EQ("xx", cache.get(build));
+    EXPECT_EQ("x", copy.get(build));
+    EXPECT_EQ(2, builds);
+}
+
+TEST(SharedCache, threads) {
+    SharedCache<std::string> cache;
+    std::atomic<int> builds(0);
+    auto build = [&builds]() { ++builds; return std::string("value"); };
+
+    std::vector<std::string const*> seen(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        threads.emplace_back([&cache, &build, &seen, i]() {
+            seen[i] = &cache.get(build);
+        });
+    }
+    for (auto i = threads.begin(); i != threads.end(); ++i)
+        i->join();
+
+    // however many threads built it, they all got the same one
+    EXPECT_GE(builds.load(), 1);
+    for (std::size_t i = 0; i < seen.size(); ++i)
+        EXPECT_EQ(seen[0], seen[i]);
+    EXPECT_EQ("value", *seen[0]);
+}
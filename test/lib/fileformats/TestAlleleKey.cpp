@@ -0,0 +1,66 @@
+#include "fileformats/AlleleKey.hpp"
+#include "fileformats/Bed.hpp"
+#include "fileformats/Variant.hpp"
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace {
+    Bed mkBed(const std::string& chrom, int64_t start, int64_t stop, const std::string& refCall) {
+        vector<string> extra;
+        extra.push_back(refCall);
+        return Bed(chrom, start, stop, extra);
+    }
+}
+
+TEST(AlleleKey, parse) {
+    AlleleKey k(mkBed("1", 1, 2, "a/-"));
+    ASSERT_EQ("1", k.chrom());
+    ASSERT_EQ(1, k.start());
+    ASSERT_EQ(2, k.stop());
+    ASSERT_EQ("A", k.reference());
+    ASSERT_EQ("*", k.variant());
+
+    k.assign(Bed("2", 3, 4));
+    ASSERT_EQ("2", k.chrom());
+    ASSERT_EQ("*", k.reference());
+    ASSERT_EQ("*", k.variant());
+
+    k.assign(mkBed("2", 3, 4, "C/r/T"));
+    ASSERT_EQ("C", k.reference());
+    ASSERT_EQ("R", k.variant());
+    ASSERT_EQ(unsigned(ALLELE_A | ALLELE_G), k.variantIub());
+}
+
+// Keys must match exactly when the Variants they stand for do
+TEST(AlleleKey, sameAsVariant) {
+    vector<string> calls{
+        "", "/", "A", "A/", "/T", "A/T", "a/t", "A/T/G", "0/T", "-/T",
+        "A/0", "A/-", "A/*", "AC/T", "A/TG", "A/W", "A/w", "C/W", "A/N",
+        "A/X", "A//T", "*/A", "00/A"
+        };
+
+    for (auto i = calls.begin(); i != calls.end(); ++i) {
+        Bed bedA = mkBed("1", 1, 2, *i);
+        Variant va(bedA);
+        AlleleKey ka(bedA);
+        for (auto j = calls.begin(); j != calls.end(); ++j) {
+            Bed bedB = mkBed("1", 1, 2, *j);
+            Variant vb(bedB);
+            AlleleKey kb(bedB);
+            EXPECT_EQ(va.alleleMatch(vb), ka.alleleMatch(kb))
+                << "'" << *i << "' vs '" << *j << "'";
+            EXPECT_EQ(va.allelePartialMatch(vb), ka.allelePartialMatch(kb))
+                << "'" << *i << "' vs '" << *j << "'";
+        }
+    }
+
+    AlleleKey k(mkBed("1", 1, 2, "A/T"));
+    EXPECT_TRUE(k.positionMatch(AlleleKey(mkBed("1", 1, 2, "C/G"))));
+    EXPECT_FALSE(k.positionMatch(AlleleKey(mkBed("2", 1, 2, "A/T"))));
+    EXPECT_FALSE(k.positionMatch(AlleleKey(mkBed("1", 0, 2, "A/T"))));
+    EXPECT_FALSE(k.positionMatch(AlleleKey(mkBed("1", 1, 3, "A/T"))));
+}
@@ -184,7 +184,7 @@ TEST_F(TestVcfAlleleMerger, buildRefAdjacent) {
     ents.push_back(makeEntry("1", 10, "ACG", "A"));
     ents.push_back(makeEntry("1", 13, "TGA", "T"));
     ents.push_back(makeEntry("1", 16, "CGA", "C"));
-    string ref = AlleleMerger::buildRef(&*ents.begin(), &*ents.end());
+    string ref = AlleleMerger::buildRef(ents);
     EXPECT_EQ("ACGTGACGA", ref);
 }
 
@@ -193,7 +193,7 @@ TEST_F(TestVcfAlleleMerger, buildRefOverlap) {
     ents.push_back(makeEntry("1", 10, "ACG", "A"));
     ents.push_back(makeEntry("1", 12,   "GTA", "T"));
     ents.push_back(makeEntry("1", 13,    "TAG", "C"));
-    string ref = AlleleMerger::buildRef(&*ents.begin(), &*ents.end());
+    string ref = AlleleMerger::buildRef(ents);
     EXPECT_EQ("ACGTAG", ref);
 }
 
@@ -201,7 +201,7 @@ TEST_F(TestVcfAlleleMerger, buildRefExactMatch) {
     vector<Entry> ents;
     ents.push_back(makeEntry("1", 10, "ACGT", "CGT"));
     ents.push_back(makeEntry("1", 10, "ACGT", "GT"));
-    string ref = AlleleMerger::buildRef(&*ents.begin(), &*ents.end());
+    string ref = AlleleMerger::buildRef(ents);
     EXPECT_EQ("ACGT", ref);
 }
 
@@ -212,7 +212,7 @@ TEST_F(TestVcfAlleleMerger, buildRefDisjoint) {
     ents.push_back(makeEntry("1", 10, "ACG", "A"));
     ents.push_back(makeEntry("1", 14, "TGA", "T"));
     ents.push_back(makeEntry("1", 17, "CGA", "C"));
-    string ref = AlleleMerger::buildRef(&*ents.begin(), &*ents.end());
+    string ref = AlleleMerger::buildRef(ents);
     EXPECT_EQ("", ref);
 }
 
@@ -241,7 +241,7 @@ TEST_F(TestVcfAlleleMerger, adjacentDeletion) {
     ASSERT_EQ(3u, am.mergedAlt().size());
     ASSERT_TRUE(am.newAltIndices().size());
 
-    string ref = AlleleMerger::buildRef(&*ents.begin(), &*ents.end());
+    string ref = AlleleMerger::buildRef(ents);
     EXPECT_EQ("CAGGAGTCCAGCGCAG", ref);
 }
 
@@ -0,0 +1,386 @@
+#include "fileformats/InferFileType.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "fileformats/vcf/Entry.hpp"
+#include "fileformats/vcf/EntryWriter.hpp"
+#include "fileformats/vcf/Header.hpp"
+#include "io/InputStream.hpp"
+#include "io/StreamHandler.hpp"
+#include "io/TempFile.hpp"
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Vcf;
+
+namespace {
+    string const headerText(
+        "##fileformat=VCFv4.1\n"
+        "##contig=<ID=20,length=62435964>\n"
+        "##INFO=<ID=NS,Number=1,Type=Integer,Description=\"Number of Samples With Data\">\n"
+        "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">\n"
+        "##INFO=<ID=AA,Number=1,Type=String,Description=\"Ancestral Allele\">\n"
+        "##INFO=<ID=DB,Number=0,Type=Flag,Description=\"dbSNP membership, build 129\">\n"
+        "##FILTER=<ID=q10,Description=\"Quality below 10\">\n"
+        "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+        "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype Quality\">\n"
+        "##FORMAT=<ID=HQ,Number=2,Type=Integer,Description=\"Haplotype Quality\">\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tNA1\tNA2\tNA3\n"
+        );
+
+    // dictionary indices implied by the header above
+    enum {
+        PASS, NS, AF, AA, DB, q10, GT, GQ, HQ
+    };
+
+    enum {
+        INT8 = 1, INT16 = 2, INT32 = 3, FLOAT = 5, CHAR = 7
+    };
+
+    // Just enough of a BCF2 encoder to build test data
+    struct Encoder {
+        void u8(uint8_t v) {
+            data.push_back(char(v));
+        }
+
+        void u16(uint16_t v) {
+            u8(v & 0xff);
+            u8(v >> 8);
+        }
+
+        void u32(uint32_t v) {
+            u16(v & 0xffff);
+            u16(v >> 16);
+        }
+
+        void f32(float v) {
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            u32(bits);
+        }
+
+        void type(int type, int count) {
+            if (count < 15) {
+                u8((count << 4) | type);
+            }
+            else {
+                u8((15 << 4) | type);
+                typedInt(count);
+            }
+        }
+
+        void typedInt(int8_t v) {
+            type(INT8, 1);
+            u8(v);
+        }
+
+        void typedString(string const& s) {
+            type(CHAR, s.size());
+            data += s;
+        }
+
+        string data;
+    };
+
+    string record(Encoder const& shared, Encoder const& indiv) {
+        Encoder rv;
+        rv.u32(shared.data.size());
+        rv.u32(indiv.data.size());
+        return rv.data + shared.data + indiv.data;
+    }
+
+    void sharedStart(Encoder& e, int32_t pos, float qual, int nAllele, int nInfo, int nFmt) {
+        e.u32(0); // contig 20
+        e.u32(pos - 1);
+        e.u32(1); // rlen
+        if (qual < 0)
+            e.u32(0x7F800001);
+        else
+            e.f32(qual);
+        e.u32((nAllele << 16) | nInfo);
+        e.u32((nFmt << 24) | 3);
+    }
+
+    // 20 14370 rs6054257 G A 29 PASS NS=3;AF=0.5;AA=T;DB GT:GQ:HQ
+    //     0|0:48:51,51 1|0:300:51,51 1/1:43:.,.
+    string record1() {
+        Encoder s;
+        sharedStart(s, 14370, 29, 2, 4, 3);
+        s.typedString("rs6054257");
+        s.typedString("G");
+        s.typedString("A");
+        s.type(INT8, 1); s.u8(PASS);
+        s.typedInt(NS); s.typedInt(3);
+        s.typedInt(AF); s.type(FLOAT, 1); s.f32(0.5);
+        s.typedInt(AA); s.typedString("T");
+        s.typedInt(DB); s.type(0, 0);
+
+        Encoder i;
+        i.typedInt(GT); i.type(INT8, 2);
+        i.u8(2); i.u8(3);
+        i.u8(4); i.u8(3);
+        i.u8(4); i.u8(4);
+        i.typedInt(GQ); i.type(INT16, 1);
+        i.u16(48); i.u16(300); i.u16(43);
+        i.typedInt(HQ); i.type(INT8, 2);
+        i.u8(51); i.u8(51);
+        i.u8(51); i.u8(51);
+        i.u8(0x80); i.u8(0x80);
+
+        return record(s, i);
+    }
+
+    // 20 17330 . T A,C 3 q10 AF=0.017,. GT:GQ 0/1:3 . ./.:41
+    string record2() {
+        Encoder s;
+        sharedStart(s, 17330, 3, 3, 1, 2);
+        s.type(CHAR, 0);
+        s.typedString("T");
+        s.typedString("A");
+        s.typedString("C");
+        s.type(INT8, 1); s.u8(q10);
+        s.typedInt(AF); s.type(FLOAT, 2); s.f32(0.017f); s.u32(0x7F800001);
+
+        Encoder i;
+        i.typedInt(GT); i.type(INT8, 2);
+        i.u8(2); i.u8(4);
+        i.u8(0x80); i.u8(0x81);
+        i.u8(0); i.u8(0);
+        i.typedInt(GQ); i.type(INT32, 1);
+        i.u32(3); i.u32(0x80000000); i.u32(41);
+
+        return record(s, i);
+    }
+
+    // 20 100 . A . . . . . . . .
+    string record3() {
+        Encoder s;
+        sharedStart(s, 100, -1, 1, 0, 0);
+        s.type(CHAR, 0);
+        s.typedString("A");
+        s.type(INT8, 0);
+        return record(s, Encoder());
+    }
+
+    string bcf2File() {
+        Encoder e;
+        e.data = string("BCF\2\2", 5);
+        e.u32(headerText.size() + 1);
+        e.data += headerText;
+        e.data += '\0';
+        e.data += record1() + record2() + record3();
+        return e.data;
+    }
+
+    void writeCompressed(string const& path, string const& data) {
+        gzFile fp = gzopen(path.c_str(), "wb");
+        ASSERT_EQ(int(data.size()), gzwrite(fp, data.data(), data.size()));
+        gzclose(fp);
+    }
+
+    string readCompressed(string const& path) {
+        gzFile fp = gzopen(path.c_str(), "rb");
+        string rv;
+        char buf[4096];
+        int n;
+        while ((n = gzread(fp, buf, sizeof(buf))) > 0)
+            rv.append(buf, n);
+        gzclose(fp);
+        return rv;
+    }
+
+    // The same records as text
+    string const textLines[] = {
+        "20\t14370\trs6054257\tG\tA\t29\tPASS\tAA=T;AF=0.5;DB;NS=3\tGT:GQ:HQ"
+            "\t0|0:48:51,51\t1|0:300:51,51\t1/1:43:.,.",
+        "20\t17330\t.\tT\tA,C\t3\tq10\tAF=0.017,.\tGT:GQ"
+            "\t0/1:3\t.\t./.:41",
+        "20\t100\t.\tA\t.\t.\t.\t.\t.\t.\t.\t."
+    };
+}
+
+class TestVcfBcf2 : public ::testing::Test {
+public:
+    void SetUp() {
+        bcfFile = TempFile::create(TempFile::CLEANUP);
+        bcfFile->stream().close();
+        writeCompressed(bcfFile->path(), bcf2File());
+    }
+
+protected:
+    void writeBcf(string const& path, Header const& header, vector<Entry> const& entries) {
+        ofstream out(path.c_str(), ios::binary);
+        EntryWriter writer(out, BCF_OUTPUT);
+        writer.writeHeader(header);
+        for (auto i = entries.begin(); i != entries.end(); ++i)
+            writer(*i);
+        writer.close();
+    }
+
+    vector<string> readBack(string const& path) {
+        auto in = streams.openForReading(path);
+        auto reader = openStream<Entry>(in);
+        vector<string> rv;
+        Entry e;
+        while (reader->next(e))
+            rv.push_back(e.toString());
+        return rv;
+    }
+
+protected:
+    TempFile::ptr bcfFile;
+    StreamHandler streams;
+};
+
+TEST_F(TestVcfBcf2, read) {
+    auto in = streams.openForReading(bcfFile->path());
+    auto reader = openStream<Entry>(in);
+
+    stringstream hdr;
+    hdr << reader->header();
+    EXPECT_EQ(3u, reader->header().sampleCount());
+    EXPECT_NE(string::npos, hdr.str().find("##FILTER=<ID=q10"));
+
+    Entry e;
+    ASSERT_TRUE(reader->next(e));
+    EXPECT_EQ("20", e.chrom());
+    EXPECT_EQ(14370u, e.pos());
+    EXPECT_EQ(
+        "20\t14370\trs6054257\tG\tA\t29\tPASS\tAA=T;AF=0.5;DB;NS=3\tGT:GQ:HQ"
+        "\t0|0:48:51,51\t1|0:300:51,51\t1/1:43:.,.",
+        e.toString());
+    EXPECT_TRUE(e.sampleData().genotype(1).heterozygous());
+    EXPECT_TRUE(e.sampleData().genotype(1).phased());
+
+    ASSERT_TRUE(reader->next(e));
+    EXPECT_EQ(
+        "20\t17330\t.\tT\tA,C\t3\tq10\tAF=0.017,.\tGT:GQ"
+        "\t0/1:3\t.\t./.:41",
+        e.toString());
+    EXPECT_TRUE(e.isFiltered());
+    EXPECT_EQ(0u, e.sampleData().count(1));
+
+    ASSERT_TRUE(reader->next(e));
+    EXPECT_EQ("20\t100\t.\tA\t.\t.\t.\t.\t.\t.\t.\t.", e.toString());
+
+    EXPECT_FALSE(reader->next(e));
+}
+
+TEST_F(TestVcfBcf2, dictionaryFollowsHeader) {
+    Header h = Header::fromString(headerText);
+    Bcf2Dictionary const& dict = h.bcf2Dictionary();
+    EXPECT_EQ(q10, dict.stringIndex("q10"));
+    EXPECT_EQ(HQ, dict.stringIndex("HQ"));
+    EXPECT_EQ(0, dict.contigIndex("20"));
+    EXPECT_EQ(-1, dict.stringIndex("q20"));
+
+    h.addFilter("q20", "Quality below 20");
+    EXPECT_EQ(HQ + 1, h.bcf2Dictionary().stringIndex("q20"));
+    EXPECT_EQ(q10, h.bcf2Dictionary().stringIndex("q10"));
+}
+
+TEST_F(TestVcfBcf2, inferFileType) {
+    auto in = streams.openForReading(bcfFile->path());
+    EXPECT_EQ(VCF, inferFileType(*in));
+
+    // and the stream is still good to read after inferring
+    auto reader = openStream<Entry>(in);
+    Entry e;
+    EXPECT_TRUE(reader->next(e));
+    EXPECT_EQ(14370u, e.pos());
+}
+
+TEST_F(TestVcfBcf2, truncated) {
+    string data = bcf2File();
+    data.resize(data.size() - 3);
+    writeCompressed(bcfFile->path(), data);
+
+    auto in = streams.openForReading(bcfFile->path());
+    auto reader = openStream<Entry>(in);
+    Entry e;
+    EXPECT_TRUE(reader->next(e));
+    EXPECT_TRUE(reader->next(e));
+    EXPECT_THROW(reader->next(e), runtime_error);
+}
+
+TEST_F(TestVcfBcf2, writeCopiesUnmodifiedRecords) {
+    auto in = streams.openForReading(bcfFile->path());
+    auto reader = openStream<Entry>(in);
+    vector<Entry> entries;
+    Entry e;
+    while (reader->next(e))
+        entries.push_back(e);
+
+    auto outFile = TempFile::create(TempFile::CLEANUP);
+    outFile->stream().close();
+    writeBcf(outFile->path(), reader->header(), entries);
+
+    string data = readCompressed(outFile->path());
+    string records = record1() + record2() + record3();
+    ASSERT_LT(records.size(), data.size());
+    EXPECT_EQ(0, data.compare(0, 5, "BCF\2\2", 5));
+    EXPECT_EQ(records, data.substr(data.size() - records.size()));
+}
+
+TEST_F(TestVcfBcf2, writeEncodesEntries) {
+    stringstream hdrss(headerText);
+    InputStream hdrIn("test", hdrss);
+    Header header = Header::fromStream(hdrIn);
+
+    vector<Entry> entries;
+    for (size_t i = 0; i < 3; ++i)
+        entries.push_back(Entry(&header, textLines[i]));
+
+    auto outFile = TempFile::create(TempFile::CLEANUP);
+    outFile->stream().close();
+    writeBcf(outFile->path(), header, entries);
+
+    vector<string> lines = readBack(outFile->path());
+    ASSERT_EQ(3u, lines.size());
+    for (size_t i = 0; i < lines.size(); ++i)
+        EXPECT_EQ(textLines[i], lines[i]);
+}
+
+TEST_F(TestVcfBcf2, writeReencodesModifiedEntries) {
+    auto in = streams.openForReading(bcfFile->path());
+    auto reader = openStream<Entry>(in);
+    vector<Entry> entries;
+    Entry e;
+    while (reader->next(e)) {
+        entries.push_back(e);
+    }
+    entries[0].addFilter("q10");
+    entries[2].sampleData();
+
+    auto outFile = TempFile::create(TempFile::CLEANUP);
+    outFile->stream().close();
+    writeBcf(outFile->path(), reader->header(), entries);
+
+    vector<string> lines = readBack(outFile->path());
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_EQ(
+        "20\t14370\trs6054257\tG\tA\t29\tq10\tAA=T;AF=0.5;DB;NS=3\tGT:GQ:HQ"
+        "\t0|0:48:51,51\t1|0:300:51,51\t1/1:43:.,.",
+        lines[0]);
+    EXPECT_EQ(textLines[1], lines[1]);
+    EXPECT_EQ(textLines[2], lines[2]);
+}
+
+TEST_F(TestVcfBcf2, writeUndeclaredContig) {
+    stringstream hdrss(headerText);
+    InputStream hdrIn("test", hdrss);
+    Header header = Header::fromStream(hdrIn);
+
+    vector<Entry> entries(1, Entry(&header, "21\t100\t.\tA\t.\t.\t.\t.\t.\t.\t.\t."));
+    auto outFile = TempFile::create(TempFile::CLEANUP);
+    outFile->stream().close();
+    EXPECT_THROW(writeBcf(outFile->path(), header, entries), runtime_error);
+}
@@ -145,6 +145,30 @@ TEST_F(TestVcfEntry, parse) {
     ASSERT_EQ("T", v[2].alt()[1]);
 }
 
+TEST_F(TestVcfEntry, parseReusesEntry) {
+    // parsing over an existing entry must not leave anything behind
+    stringstream ss(vcfLines);
+    vector<string> lines;
+    string line;
+    while (getline(ss, line))
+        lines.push_back(line);
+
+    Entry e;
+    for (auto i = lines.rbegin(); i != lines.rend(); ++i) {
+        e.parse(&_header, *i);
+        ASSERT_EQ(*i, e.toString());
+    }
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        e.parse(&_header, lines[i]);
+        EXPECT_EQ(v[i].alt(), e.alt());
+        EXPECT_EQ(v[i].identifiers(), e.identifiers());
+        EXPECT_EQ(v[i].failedFilters(), e.failedFilters());
+        EXPECT_EQ(v[i].info().size(), e.info().size());
+        EXPECT_EQ(v[i].toString(), e.toString());
+    }
+}
+
 TEST_F(TestVcfEntry, variantAdaptor) {
     vector<VariantAdaptor> va;
     for (auto i = v.begin(); i != v.end(); ++i)
@@ -265,6 +289,28 @@ TEST_F(TestVcfEntry, reheader) {
     ASSERT_TRUE(*origGT.get(0) == *newGT.get(3));
 }
 
+TEST_F(TestVcfEntry, reheaderWithSampleRemap) {
+    stringstream ss(header2Text);
+    Header merged = Header::fromStream(ss);
+    merged.merge(_header, true);
+
+    SampleRemap remap(&merged);
+    ASSERT_EQ((vector<uint32_t>{3, 2, 1}), remap(_header));
+    ASSERT_EQ(&remap(_header), &remap(_header));
+
+    for (auto i = v.begin(); i != v.end(); ++i) {
+        Entry byName(*i);
+        byName.reheader(&merged);
+        i->reheader(&merged, remap(i->header()));
+        ASSERT_EQ(&merged, &i->header());
+        ASSERT_EQ(byName.toString(), i->toString());
+    }
+
+    // the table is rebuilt when the source header gains samples
+    _header.mirrorSample("NA00001", "EXTRA");
+    ASSERT_EQ((vector<uint32_t>{3, 2, 1, 0}), remap(_header));
+}
+
 TEST_F(TestVcfEntry, genotypeForSample) {
     GenotypeCall gt;
 
@@ -307,6 +353,28 @@ TEST_F(TestVcfEntry, addFilter) {
     ASSERT_FALSE(e1.toString() == v[0].toString());
 }
 
+TEST_F(TestVcfEntry, removeFilter) {
+    Entry e1 = v[0];
+    e1.addFilter("sq50");
+    e1.addFilter("sq60");
+    e1.removeFilter("sq50");
+    ASSERT_FALSE(e1.failedFilters().contains("sq50"));
+    ASSERT_TRUE(e1.failedFilters().contains("sq60"));
+
+    e1.removeFilter("sq60");
+    e1.removeFilter("not_there");
+    ASSERT_TRUE(e1.failedFilters().empty());
+}
+
+TEST_F(TestVcfEntry, removeInfo) {
+    Entry e1 = v[0];
+    e1.removeInfo("DB");
+    e1.removeInfo("not_there");
+    ASSERT_FALSE(e1.info("DB"));
+    ASSERT_EQ(4u, e1.info().size());
+    ASSERT_NE(string::npos, e1.toString().find("\tAF=0.5;DP=14;H2;NS=3\t"));
+}
+
 // this is an efficiency test
 // it makes sure that move semantics are working properly (data is stolen from
 // rvalue references in the move constructor)
@@ -414,7 +482,7 @@ TEST_F(TestVcfEntry, sampleDataPrintCertainSample) {
 TEST_F(TestVcfEntry, multipleFilters) {
     stringstream vcfss(filteredTwiceLine);
     string line;
-    ASSERT_TRUE(getline(vcfss, line));
+    ASSERT_TRUE(bool(getline(vcfss, line)));
     Entry e(&_header, line);
 
     EXPECT_EQ(2u, e.failedFilters().size());
@@ -424,7 +492,7 @@ TEST_F(TestVcfEntry, multipleFilters) {
 TEST_F(TestVcfEntry, multipleFiltersWhitelist) {
     stringstream vcfss(filteredTwiceLine);
     string line;
-    ASSERT_TRUE(getline(vcfss, line));
+    ASSERT_TRUE(bool(getline(vcfss, line)));
     Entry e(&_header, line);
 
     EXPECT_EQ(2u, e.failedFilters().size());
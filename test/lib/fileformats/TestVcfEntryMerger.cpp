@@ -124,6 +124,13 @@ public:
         return Entry(&_mergedHeader, ss.str());
     }
 
+    static vector<Entry const*> pointers(vector<Entry> const& entries) {
+        vector<Entry const*> rv;
+        for (auto e = entries.begin(); e != entries.end(); ++e)
+            rv.push_back(&*e);
+        return rv;
+    }
+
     Header _mergedHeader;
     vector<Entry> _snvs;
     vector<Entry> _indels;
@@ -137,7 +144,8 @@ TEST_F(TestVcfEntryMerger, mergeDifferentSampleFields) {
     Entry entries[2];
     Entry::parseLine(&_headers[0], t1, entries[0]);
     Entry::parseLine(&_headers[1], t2, entries[1]);
-    EntryMerger merger(*_defaultMs, &_mergedHeader, entries, entries + 2);
+    Entry const* ptrs[] = {&entries[0], &entries[1]};
+    EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
     Entry entry(std::move(merger));
     std::stringstream ss;
     // There was a bug about printing null CustomValue fields in sample
@@ -149,7 +157,8 @@ TEST_F(TestVcfEntryMerger, merge) {
     // We want to concatenate variant caller names
     _defaultMs->setMerger("VC", "uniq-concat");
 
-    EntryMerger merger(*_defaultMs, &_mergedHeader, &*_snvs.begin(), &*_snvs.end());
+    auto snvs = pointers(_snvs);
+    EntryMerger merger(*_defaultMs, &_mergedHeader, snvs.data(), snvs.data() + snvs.size());
     ASSERT_EQ("20", merger.chrom());
     ASSERT_EQ(14370u, merger.pos());
     ASSERT_EQ(3u, merger.identifiers().size());
@@ -214,26 +223,44 @@ TEST_F(TestVcfEntryMerger, merge) {
 }
 
 TEST_F(TestVcfEntryMerger, mergeWrongPos) {
-    EntryMerger merger(*_defaultMs, &_mergedHeader, &*_snvs.begin(), &*_snvs.end());
     Entry wrongPos(&_headers[2], "20\t14371\tid1\tG\tA\t29\t.\t.\t");
-    Entry e[] = { _snvs[0], wrongPos };
+    Entry const* e[] = { &_snvs[0], &wrongPos };
     ASSERT_THROW(EntryMerger(*_defaultMs, &_mergedHeader, e, e+2), runtime_error);
 
     Entry wrongChrom(&_headers[2], "21\t14370\tid1\tG\tA\t29\t.\t.\t");
-    e[1] = wrongChrom;
+    e[1] = &wrongChrom;
     EntryMerger merger2(*_defaultMs, &_mergedHeader, e, e+2);
     ASSERT_FALSE(merger2.merged());
 }
 
+// Entries from the same file can be merged if they have data for different
+// samples, as when a merge tree's earlier level left them unmerged
+TEST_F(TestVcfEntryMerger, mergeSameFile) {
+    Entry e1(&_headers[0], "20\t14370\t.\tG\tA\t.\t.\t.\tGT\t0/1\t.");
+    Entry e2(&_headers[0], "20\t14370\t.\tG\tC\t.\t.\t.\tGT\t.\t1/1");
+    Entry const* e[] = { &e1, &e2 };
+    EntryMerger merger(*_defaultMs, &_mergedHeader, e, e+2);
+    ASSERT_TRUE(merger.merged());
+    Entry merged(std::move(merger));
+    ASSERT_EQ("20\t14370\t.\tG\tA,C\t.\t.\t.\tGT\t0/1\t2/2\t.\t.\t.\t.", merged.toString());
+
+    Entry e3(&_headers[0], "20\t14370\t.\tG\tC\t.\t.\t.\tGT\t1/1\t.");
+    e[1] = &e3;
+    EntryMerger conflicting(*_defaultMs, &_mergedHeader, e, e+2);
+    ASSERT_THROW(Entry(std::move(conflicting)), runtime_error);
+}
+
 // Test merging when only 1 entry has a valid quality. The score should be preserved
 TEST_F(TestVcfEntryMerger, singleQual) {
-    EntryMerger merger(*_defaultMs, &_mergedHeader, &*_snvs.begin(), &*(_snvs.begin()+1));
+    auto snvs = pointers(_snvs);
+    EntryMerger merger(*_defaultMs, &_mergedHeader, snvs.data(), snvs.data() + 1);
     ASSERT_FALSE(merger.merged());
     ASSERT_THROW(Entry(std::move(merger)), runtime_error);
 }
 
 TEST_F(TestVcfEntryMerger, mergeAlleles) {
-    EntryMerger merger(*_defaultMs, &_mergedHeader, &*_indels.begin(), &*_indels.end());
+    auto indels = pointers(_indels);
+    EntryMerger merger(*_defaultMs, &_mergedHeader, indels.data(), indels.data() + indels.size());
     Entry e(std::move(merger));
     ASSERT_EQ(2u, e.alt().size());
     ASSERT_EQ("TAG", e.alt()[0]);
@@ -246,13 +273,14 @@ TEST_F(TestVcfEntryMerger, stripFilters) {
     Entry entries[2];
     Entry::parseLine(&_headers[0], t1, entries[0]);
     Entry::parseLine(&_headers[1], t2, entries[1]);
-    EntryMerger merger(*_defaultMs, &_mergedHeader, entries, entries+2);
+    Entry const* ptrs[] = {&entries[0], &entries[1]};
+    EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs+2);
     Entry merged(std::move(merger));
     ASSERT_EQ(2u, merged.failedFilters().size());
 
     MergeStrategy ms2(*_defaultMs);
     ms2.clearFilters(true);
-    EntryMerger merger2(ms2, &_mergedHeader, entries, entries+2);
+    EntryMerger merger2(ms2, &_mergedHeader, ptrs, ptrs+2);
     Entry e(std::move(merger2));
     ASSERT_TRUE(e.failedFilters().empty());
     ASSERT_EQ(Entry::MISSING_QUALITY, merged.qual());
@@ -264,13 +292,119 @@ TEST_F(TestVcfEntryMerger, GTfieldAlwaysFirst) {
     Entry entries[2];
     Entry::parseLine(&_headers[0], t1, entries[0]);
     Entry::parseLine(&_headers[1], t2, entries[1]);
-    EntryMerger merger(*_defaultMs, &_mergedHeader, entries, entries+2);
+    Entry const* ptrs[] = {&entries[0], &entries[1]};
+    EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs+2);
     Entry merged(std::move(merger));
     ASSERT_EQ(4u, merged.sampleData().format().size());
     ASSERT_EQ("GT", merged.sampleData().format()[0]->id());
     ASSERT_EQ(Entry::MISSING_QUALITY, merged.qual());
 }
 
+TEST_F(TestVcfEntryMerger, spliceSampleColumns) {
+    string t1="20\t14370\tid1\tG\tA,C\t29\tPASS\tVC=Samtools\tGT:GQ\t0|1:48\t2/1";
+    string t3="20\t14370\tid2\tG\tA,C\t31\tPASS\tVC=Varscan\tGT:GQ\t.\t1/1:7";
+    Entry entries[2];
+    Entry::parseLine(&_headers[0], t1, entries[0]);
+    Entry::parseLine(&_headers[2], t3, entries[1]);
+    Entry const* ptrs[] = {&entries[0], &entries[1]};
+
+    EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
+    vector<string> alt;
+    string columns;
+    ASSERT_TRUE(merger.spliceSampleColumns(alt, columns));
+    EXPECT_EQ((vector<string>{"A", "C"}), alt);
+    // the columns are copied as they are, padded to the FORMAT, with none
+    // for the missing samples of the second file
+    EXPECT_EQ("GT:GQ\t0|1:48\t2/1:.\t.\t.\t.\t1/1:7", columns);
+
+    Entry merged(std::move(merger));
+    stringstream ss;
+    ss << merged;
+    EXPECT_EQ(
+        "20\t14370\tid1;id2\tG\tA,C\t.\tPASS\t.\tGT:GQ\t0|1:48\t2/1:.\t.\t.\t.\t1/1:7",
+        ss.str());
+    EXPECT_EQ("2/1", merged.sampleData().get(1, "GT")->toString());
+}
+
+// Spliced columns are the text setAltAndGenotypeData gives, and columns it
+// would write differently are not spliced
+TEST_F(TestVcfEntryMerger, spliceSampleColumnsMatchesMerge) {
+    struct {
+        char const* first;
+        char const* second;
+        bool splice;
+    } cases[] = {
+        {"0|1:48:1:51,51\t1/1:43:5:.,.", ".\t./.", true},
+        {"0/1\t.", "2/1:7\t0/0:.:3", true},
+        {"0/1\t.:3", "./.:.\t1", true},
+        {"0/1:-12\t.", "1/1\t.", true},
+        {"0/1:07\t.", "1/1\t.", false},
+        {"0/1:-0\t.", "1/1\t.", false},
+        {"0/1:48:\t.", "1/1\t.", false},
+        {"0/1\t.", "1|2/0\t.", false},
+        {"0/01\t.", "1/1\t.", false},
+        {"0/1\t.", "1/1:48:1:51,51:9\t.", false},
+        {"0/1\t.", "1/1:48:1:51,51,51\t.", false},
+    };
+
+    string site = "20\t14370\t.\tG\tA,C\t.\t.\t.\tGT:GQ:DP:HQ\t";
+    for (auto c = begin(cases); c != end(cases); ++c) {
+        string t1 = site + c->first;
+        string t2 = site + c->second;
+        Entry entries[2];
+        Entry::parseLine(&_headers[0], t1, entries[0]);
+        Entry::parseLine(&_headers[2], t2, entries[1]);
+        Entry const* ptrs[] = {&entries[0], &entries[1]};
+        EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
+
+        vector<string> alt;
+        string columns;
+        bool spliced = merger.spliceSampleColumns(alt, columns);
+        EXPECT_EQ(c->splice, spliced) << c->first << " + " << c->second;
+        if (!spliced)
+            continue;
+
+        vector<string> mergedAlt;
+        SampleData sampleData;
+        merger.setAltAndGenotypeData(mergedAlt, sampleData);
+        stringstream ss;
+        ss << sampleData;
+        EXPECT_EQ(mergedAlt, alt);
+        EXPECT_EQ(ss.str(), columns) << c->first << " + " << c->second;
+    }
+}
+
+TEST_F(TestVcfEntryMerger, spliceSampleColumnsNeedsSameSite) {
+    string t1="20\t14370\tid1\tG\tA,C\t29\tPASS\t.\tGT:GQ\t0|1:48\t2/1";
+    string t2="20\t14370\tid1\tG\tC,A\t29\tPASS\t.\tGT:GQ\t0|1:48\t2/1";
+    string t3="20\t14370\tid1\tG\tA,C\t29\tPASS\t.\tGQ:GT\t48:0|1\t.";
+    Entry entries[3];
+    Entry::parseLine(&_headers[0], t1, entries[0]);
+    Entry::parseLine(&_headers[1], t2, entries[1]);
+    Entry::parseLine(&_headers[2], t3, entries[2]);
+
+    vector<string> alt;
+    string columns;
+
+    // alleles in a different order need their genotypes renumbered
+    Entry const* ptrs[] = {&entries[0], &entries[1]};
+    EntryMerger merger(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
+    EXPECT_FALSE(merger.spliceSampleColumns(alt, columns));
+    Entry merged(std::move(merger));
+    EXPECT_EQ("0|2", merged.sampleData().get(2, "GT")->toString());
+
+    // as does a FORMAT without GT first
+    ptrs[1] = &entries[2];
+    EntryMerger merger2(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
+    EXPECT_FALSE(merger2.spliceSampleColumns(alt, columns));
+
+    // and parsed sample data may have been changed
+    entries[1] = entries[0];
+    entries[1].sampleData();
+    EntryMerger merger3(*_defaultMs, &_mergedHeader, ptrs, ptrs + 2);
+    EXPECT_FALSE(merger3.spliceSampleColumns(alt, columns));
+}
+
 // Let's make sure the builder correctly reheaders Entry objects that are not merged.
 // That is, that the samples show up in the right output column.
 TEST_F(TestVcfEntryMerger, Builder) {
@@ -0,0 +1,140 @@
+#include "fileformats/vcf/FilterSet.hpp"
+#include "fileformats/vcf/Header.hpp"
+
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Vcf;
+
+namespace {
+    vector<string> names(FilterSet const& fs) {
+        return vector<string>(fs.begin(), fs.end());
+    }
+}
+
+TEST(FilterSet, ids) {
+    EXPECT_EQ(FilterSet::PASS, FilterSet::id("PASS"));
+    EXPECT_EQ("PASS", FilterSet::name(FilterSet::PASS));
+
+    FilterSet::Id a = FilterSet::id("FilterSetTestA");
+    EXPECT_NE(FilterSet::PASS, a);
+    EXPECT_EQ(a, FilterSet::id("FilterSetTestA"));
+    EXPECT_EQ("FilterSetTestA", FilterSet::name(a));
+
+    string const s("xxFilterSetTestAxx");
+    EXPECT_EQ(a, FilterSet::id(s.data() + 2, s.data() + s.size() - 2));
+}
+
+TEST(FilterSet, manyNames) {
+    // more names than fit in a few of the registry's chunks
+    vector<FilterSet::Id> ids;
+    for (int i = 0; i < 70000; ++i)
+        ids.push_back(FilterSet::id("FilterSetMany" + boost::lexical_cast<string>(i)));
+
+    for (int i = 0; i < 70000; ++i) {
+        string name = "FilterSetMany" + boost::lexical_cast<string>(i);
+        ASSERT_EQ(ids[i], FilterSet::id(name));
+        ASSERT_EQ(name, FilterSet::name(ids[i]));
+    }
+
+    EXPECT_THROW(FilterSet::name(ids.back() + 1000000), std::runtime_error);
+}
+
+TEST(FilterSet, empty) {
+    FilterSet fs;
+    EXPECT_TRUE(fs.empty());
+    EXPECT_EQ(0u, fs.size());
+    EXPECT_TRUE(fs.begin() == fs.end());
+    EXPECT_EQ("", boost::lexical_cast<string>(fs));
+}
+
+TEST(FilterSet, nameOrder) {
+    // assign ids in the opposite order from the names
+    FilterSet::Id z = FilterSet::id("zz");
+    FilterSet::Id m = FilterSet::id("mm");
+    FilterSet::Id a = FilterSet::id("aa");
+
+    FilterSet fs;
+    fs.insert(m);
+    fs.insert(z);
+    fs.insert(a);
+    fs.insert(m);
+    EXPECT_EQ(3u, fs.size());
+    EXPECT_EQ((vector<string>{"aa", "mm", "zz"}), names(fs));
+    EXPECT_EQ("aa;mm;zz", boost::lexical_cast<string>(fs));
+    EXPECT_TRUE(fs.contains(z));
+    EXPECT_TRUE(fs.contains("zz"));
+    EXPECT_FALSE(fs.contains(FilterSet::PASS));
+    EXPECT_FALSE(fs.contains("PASS"));
+
+    fs.erase(m);
+    EXPECT_EQ((vector<string>{"aa", "zz"}), names(fs));
+    fs.erase(m);
+    EXPECT_EQ(2u, fs.size());
+}
+
+TEST(FilterSet, spill) {
+    vector<string> expected;
+    FilterSet fs;
+    for (char c = 'j'; c >= 'a'; --c) {
+        string name(3, c);
+        fs.insert(name);
+        expected.insert(expected.begin(), name);
+        ASSERT_EQ(expected, names(fs));
+    }
+
+    FilterSet copy(fs);
+    EXPECT_EQ(fs, copy);
+
+    while (!expected.empty()) {
+        fs.erase(FilterSet::id(expected.back()));
+        expected.pop_back();
+        ASSERT_EQ(expected, names(fs));
+    }
+    EXPECT_TRUE(fs.empty());
+    EXPECT_NE(fs, copy);
+}
+
+TEST(FilterSet, unionAndSwap) {
+    FilterSet a;
+    a.insert("aa");
+    a.insert("PASS");
+
+    FilterSet b;
+    b.insert("zz");
+    b.insert("aa");
+    b.insert("mm");
+    b.insert("bb");
+
+    a.insert(b);
+    EXPECT_EQ((vector<string>{"PASS", "aa", "bb", "mm", "zz"}), names(a));
+
+    FilterSet c;
+    c.swap(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(5u, c.size());
+    a.swap(b);
+    EXPECT_EQ((vector<string>{"aa", "bb", "mm", "zz"}), names(a));
+}
+
+TEST(FilterSet, headerFilterId) {
+    Header h = Header::fromString(
+        "##fileformat=VCFv4.1\n"
+        "##FILTER=<ID=q10,Description=\"Quality below 10\">\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\n"
+        );
+
+    string const q10("q10");
+    string const pass("PASS");
+    string const other("FilterSetTestUndeclared");
+    EXPECT_EQ(FilterSet::id("q10"), h.filterId(q10.data(), q10.data() + q10.size()));
+    EXPECT_EQ(FilterSet::PASS, h.filterId(pass.data(), pass.data() + pass.size()));
+    EXPECT_EQ(FilterSet::id(other),
+        h.filterId(other.data(), other.data() + other.size()));
+}
@@ -122,3 +122,74 @@ TEST(GenotypeCall, genotypeIndex) {
     EXPECT_EQ("1/.", ss.str());
     EXPECT_TRUE(idx == 1u);
 }
+
+TEST(GenotypeCall, highPloidy) {
+    GenotypeCall gt("0/1/2/3/4/1");
+    EXPECT_FALSE(gt.phased());
+    EXPECT_EQ(6u, gt.size());
+    EXPECT_EQ(6u, distance(gt.begin(), gt.end()));
+    for (uint32_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(i, gt[i]);
+    }
+    EXPECT_EQ(1u, gt[5]);
+
+    EXPECT_EQ(5u, gt.indexSet().size());
+    EXPECT_EQ(2u, gt.indices().count(GenotypeIndex{1}));
+    EXPECT_EQ("0/1/2/3/4/1", boost::lexical_cast<std::string>(gt));
+
+    GenotypeCall copy(gt);
+    EXPECT_EQ(gt, copy);
+    EXPECT_EQ(gt.indices(), copy.indices());
+}
+
+TEST(GenotypeCall, indexSetIsSorted) {
+    GenotypeCall gt("3|1|.|1");
+    std::vector<GenotypeIndex> expected{1, 3, GenotypeIndex::Null};
+    EXPECT_EQ(gt.indexSet(), expected);
+    EXPECT_TRUE(gt.partial());
+}
+
+TEST(GenotypeCall, parseError) {
+    EXPECT_THROW(GenotypeCall("0/x"), std::runtime_error);
+    EXPECT_THROW(GenotypeCall("0/"), std::runtime_error);
+    EXPECT_THROW(GenotypeCall("0//1"), std::runtime_error);
+}
+
+TEST(GenotypeCall, intern) {
+    std::vector<std::string> calls{".", "0", "./.", "0/1", "1|0", "12/3", "0/1/2/3/4"};
+    for (auto i = calls.begin(); i != calls.end(); ++i) {
+        GenotypeCall const& a = GenotypeCall::intern(*i);
+        GenotypeCall const& b = GenotypeCall::intern(*i);
+        EXPECT_EQ(&a, &b) << *i;
+        EXPECT_EQ(GenotypeCall(*i), a) << *i;
+        EXPECT_EQ(GenotypeCall(*i).indices(), a.indices()) << *i;
+    }
+
+    EXPECT_NE(&GenotypeCall::intern("0/1"), &GenotypeCall::intern("0|1"));
+    EXPECT_THROW(GenotypeCall::intern("0/x"), std::runtime_error);
+}
+
+TEST(GenotypeCall, internPastLimit) {
+    GenotypeInternTable table(4);
+    std::vector<std::string> calls;
+    for (std::size_t i = 0; i < 4; ++i)
+        calls.push_back("0/1/" + boost::lexical_cast<std::string>(i));
+
+    for (auto i = calls.begin(); i != calls.end(); ++i)
+        table.get(*i);
+
+    // the table is full by now, so new calls are no longer shared but
+    // still parse correctly
+    std::string extra = "0/1/2/3/4/5";
+    GenotypeCall const& a = table.get(extra);
+    GenotypeCall const& b = table.get(extra);
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(GenotypeCall(extra).indices(), a.indices());
+    EXPECT_EQ(GenotypeCall(extra).indices(), b.indices());
+
+    // while those already in it, and the fixed haploid and diploid ones,
+    // still are
+    EXPECT_EQ(&table.get(calls[0]), &table.get(calls[0]));
+    EXPECT_EQ(&table.get("0/1"), &table.get("0/1"));
+    EXPECT_EQ(&table.get("."), &table.get("."));
+}
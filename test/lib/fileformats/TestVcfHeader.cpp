@@ -169,6 +169,97 @@ TEST(VcfHeader, merge) {
     ASSERT_THROW(h1.merge(conflict, true), runtime_error);
 }
 
+TEST(VcfHeader, mergeDeduplicatesLines) {
+    Header h = parse(
+        "##fileformat=VCFv4.1\n"
+        "##contig=<ID=1,length=10>\n"
+        "##contig=<ID=2,length=20>\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\n"
+        );
+    // shares some lines with h, in another order
+    Header other = parse(
+        "##fileformat=VCFv4.1\n"
+        "##fileDate=20010101\n"
+        "##contig=<ID=3,length=30>\n"
+        "##contig=<ID=2,length=20>\n"
+        "##contig=<ID=1,length=10>\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tB\n"
+        );
+
+    h.merge(other);
+    h.merge(other, true);
+
+    vector<Header::RawLine> const& lines = h.metaInfoLines();
+    ASSERT_EQ(5u, lines.size());
+    EXPECT_EQ("fileformat", lines[0].first);
+    EXPECT_EQ("<ID=1,length=10>", lines[1].second);
+    EXPECT_EQ("<ID=2,length=20>", lines[2].second);
+    EXPECT_EQ("<ID=3,length=30>", lines[3].second);
+    EXPECT_EQ("fileDate", lines[4].first);
+    EXPECT_NE("20010101", lines[4].second);
+    EXPECT_EQ((vector<string>{"A", "B"}), h.sampleNames());
+}
+
+TEST(VcfHeader, mergeReplacesFileDate) {
+    string const text =
+        "##fileformat=VCFv4.1\n"
+        "##fileDate=20010101\n"
+        "##source=a source name long enough not to fit in place in a string\n"
+        "##reference=file:///some/reference/path/that/is/also/rather/long.fa\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\n"
+        ;
+    Header h = parse(text);
+    Header other = parse(text);
+
+    // the lines after the old fileDate stay known, so merging them again
+    // does not repeat them
+    h.merge(other, true);
+    h.merge(other, true);
+
+    vector<Header::RawLine> const& lines = h.metaInfoLines();
+    ASSERT_EQ(4u, lines.size());
+    EXPECT_EQ("fileformat", lines[0].first);
+    EXPECT_EQ("source", lines[1].first);
+    EXPECT_EQ("reference", lines[2].first);
+    EXPECT_EQ("fileDate", lines[3].first);
+    EXPECT_NE("20010101", lines[3].second);
+}
+
+TEST(VcfHeader, text) {
+    string const text =
+        "##fileformat=VCFv4.1\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\n"
+        ;
+    Header h = parse(text);
+    ASSERT_EQ(text, h.text());
+
+    stringstream ss;
+    ss << h;
+    ASSERT_EQ(text, ss.str());
+
+    // the text follows changes to the header
+    h.addFilter("x", "y");
+    h.mirrorSample("A", "B");
+    ASSERT_EQ(
+        "##fileformat=VCFv4.1\n"
+        "##FILTER=<ID=x,Description=\"y\">\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\n"
+        , h.text());
+
+    // copies share the text until one of them changes
+    Header copy(h);
+    EXPECT_EQ(&h.text(), &copy.text());
+    copy.addFilter("z", "w");
+    EXPECT_NE(h.text(), copy.text());
+}
+
+TEST(VcfHeader, duplicateSampleName) {
+    ASSERT_THROW(parse(
+        "##fileformat=VCFv4.1\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tA\tB\tB\n"
+        ), runtime_error);
+}
+
 TEST(VcfHeader, sampleIndex) {
     Header h = parse(headerText);
     ASSERT_EQ(0u, h.sampleIndex("NA00001"));
@@ -178,6 +269,19 @@ TEST(VcfHeader, sampleIndex) {
     ASSERT_THROW(h.sampleIndex("hi"), runtime_error);
 }
 
+TEST(VcfHeader, sampleIndicesOf) {
+    Header h1 = parse(headerText);
+    Header h2 = parse(differentData);
+    Header merged = parse(differentData);
+    merged.merge(h1);
+
+    ASSERT_EQ((vector<uint32_t>{3, 4, 5}), merged.sampleIndicesOf(h1));
+    ASSERT_EQ((vector<uint32_t>{0, 1, 2}), merged.sampleIndicesOf(h2));
+
+    // samples the target does not have
+    ASSERT_EQ((vector<uint32_t>(3, Header::NO_SAMPLE)), h1.sampleIndicesOf(h2));
+}
+
 
 TEST(VcfHeader, toStream) {
     Header h = parse(headerText);
@@ -224,6 +328,25 @@ TEST(VcfHeader, addInfoType) {
     ASSERT_NE(string::npos, ss.str().find(expected));
 }
 
+TEST(VcfHeader, removeInfoType) {
+    Header h = parse(headerText);
+    h.removeInfoType("AF");
+    h.removeInfoType("not_there");
+    ASSERT_FALSE(h.infoType("AF"));
+    ASSERT_TRUE(h.infoType("DP"));
+
+    string expected(headerText);
+    string line = "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">\n";
+    expected.erase(expected.find(line), line.size());
+    stringstream ss;
+    ss << h;
+    ASSERT_EQ(expected, ss.str());
+
+    // the type can be added back
+    h.addInfoType(CustomType("AF", CustomType::FIXED_SIZE, 1, CustomType::STRING, "A type"));
+    ASSERT_EQ(CustomType::STRING, h.infoType("AF")->type());
+}
+
 TEST(VcfHeader, sampleMirroring) {
     Header h = parse(headerText);
     EXPECT_EQ(3u, h.sampleCount());
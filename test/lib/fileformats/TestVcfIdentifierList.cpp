@@ -0,0 +1,88 @@
+#include "fileformats/vcf/IdentifierList.hpp"
+
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Vcf;
+
+namespace {
+    IdentifierList fromString(string const& s) {
+        IdentifierList rv;
+        rv.assign(s.data(), s.data() + s.size());
+        return rv;
+    }
+
+    vector<string> ids(IdentifierList const& l) {
+        vector<string> rv;
+        for (auto i = l.begin(); i != l.end(); ++i)
+            rv.push_back(string(i->begin(), i->end()));
+        return rv;
+    }
+}
+
+TEST(IdentifierList, empty) {
+    IdentifierList l;
+    EXPECT_TRUE(l.empty());
+    EXPECT_EQ(0u, l.size());
+    EXPECT_TRUE(l.begin() == l.end());
+    EXPECT_EQ("", l.str());
+}
+
+TEST(IdentifierList, assignSorted) {
+    IdentifierList l = fromString("rs1;rs2;rs3");
+    EXPECT_EQ(3u, l.size());
+    EXPECT_EQ((vector<string>{"rs1", "rs2", "rs3"}), ids(l));
+    EXPECT_EQ("rs1;rs2;rs3", l.str());
+
+    l = fromString("rs5");
+    EXPECT_EQ(1u, l.size());
+    EXPECT_EQ("rs5", boost::lexical_cast<string>(l));
+}
+
+TEST(IdentifierList, assignUnsorted) {
+    IdentifierList l = fromString("rs3;rs1;;rs2;rs1");
+    EXPECT_EQ(3u, l.size());
+    EXPECT_EQ((vector<string>{"rs1", "rs2", "rs3"}), ids(l));
+    EXPECT_EQ("rs1;rs2;rs3", l.str());
+}
+
+TEST(IdentifierList, insert) {
+    IdentifierList l;
+    l.insert(string("id2"));
+    l.insert(string("id10"));
+    l.insert(string("id3"));
+    l.insert(string("id2"));
+    l.insert(string(""));
+    EXPECT_EQ(3u, l.size());
+    EXPECT_EQ("id10;id2;id3", l.str());
+    EXPECT_TRUE(l.contains(StringView("id3")));
+    EXPECT_FALSE(l.contains(StringView("id4")));
+
+    IdentifierList other = fromString("id1;id3;id9");
+    l.insert(other);
+    EXPECT_EQ(5u, l.size());
+    EXPECT_EQ("id1;id10;id2;id3;id9", l.str());
+
+    l.insert(l);
+    EXPECT_EQ(5u, l.size());
+}
+
+TEST(IdentifierList, equalityAndSwap) {
+    IdentifierList a = fromString("a;b");
+    IdentifierList b = fromString("b;a");
+    EXPECT_EQ(a, b);
+
+    IdentifierList c;
+    c.swap(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(b, c);
+    EXPECT_NE(a, b);
+
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(a, c);
+}
@@ -187,3 +187,33 @@ TEST_F(TestVcfMergeStrategy, parseInvalidMerger) {
     MergeStrategy strategy(&_mergedHeader);
     ASSERT_THROW(strategy.parse(in), runtime_error);
 }
+
+TEST_F(TestVcfMergeStrategy, infoPlan) {
+    MergeStrategy strategy(&_mergedHeader);
+    auto const& plan = strategy.infoPlan();
+    ASSERT_EQ(5u, plan.size());
+    // ordered by id
+    EXPECT_EQ("BAR", plan[0].id);
+    EXPECT_EQ("VC", plan[4].id);
+    for (size_t i = 0; i < plan.size(); ++i) {
+        EXPECT_EQ(i, strategy.infoPlanIndex(plan[i].id));
+        EXPECT_EQ(_mergedHeader.infoType(plan[i].id), plan[i].type);
+        EXPECT_EQ("ignore", plan[i].merger->name());
+    }
+    EXPECT_EQ(MergeStrategy::npos, strategy.infoPlanIndex("invalid"));
+
+    strategy.setMerger("DP", "sum");
+    strategy.setDefaultMerger("first");
+    EXPECT_EQ("sum", plan[strategy.infoPlanIndex("DP")].merger->name());
+    EXPECT_EQ("first", plan[strategy.infoPlanIndex("FOO")].merger->name());
+
+    // the plan is used to merge
+    strategy.setMerger("VC", "uniq-concat");
+    Entry const* snvs[] = {&_snvs[0], &_snvs[2]};
+    AlleleMerger alleles(snvs, snvs + 2);
+    CustomValue v = strategy.mergeInfo(
+        strategy.infoPlanIndex("VC"), snvs, snvs + 2, alleles.newAltIndices());
+    EXPECT_EQ("Samtools,Varscan", v.toString());
+    EXPECT_EQ(v.toString(), strategy.mergeInfo("VC", snvs, snvs + 2, alleles.newAltIndices()).toString());
+    EXPECT_THROW(strategy.mergeInfo("invalid", snvs, snvs + 2, alleles.newAltIndices()), runtime_error);
+}
@@ -0,0 +1,89 @@
+#include "io/BgzfOutputStream.hpp"
+
+#include "io/TempFile.hpp"
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    string decompress(string const& path) {
+        gzFile fp = gzopen(path.c_str(), "rb");
+        string rv;
+        char buf[4096];
+        int n;
+        while ((n = gzread(fp, buf, sizeof(buf))) > 0)
+            rv.append(buf, n);
+        gzclose(fp);
+        return rv;
+    }
+
+    // The block sizes recorded in the BC extra fields of data
+    vector<size_t> blockSizes(string const& data) {
+        vector<size_t> rv;
+        size_t pos = 0;
+        while (pos + 18 <= data.size()) {
+            unsigned char const* p = reinterpret_cast<unsigned char const*>(data.data() + pos);
+            size_t size = (p[16] | (p[17] << 8)) + 1;
+            rv.push_back(size);
+            pos += size;
+        }
+        return rv;
+    }
+}
+
+TEST(TestBgzfOutputStream, roundTrip) {
+    // more than a block's worth, and not very compressible
+    string data;
+    unsigned x = 12345;
+    while (data.size() < 3 * BgzfStreambuf::BlockDataSize) {
+        x = x * 1103515245 + 12345;
+        data += char('a' + (x >> 16) % 26);
+        if (data.size() % 80 == 0)
+            data += '\n';
+    }
+
+    auto tmp = TempFile::create(TempFile::CLEANUP);
+    tmp->stream().close();
+    {
+        ofstream raw(tmp->path().c_str(), ios::binary);
+        BgzfOutputStream out(raw);
+        out.write(data.data(), data.size() / 2);
+        out << data.substr(data.size() / 2);
+        out.close();
+    }
+
+    EXPECT_EQ(data, decompress(tmp->path()));
+
+    ifstream in(tmp->path().c_str(), ios::binary);
+    stringstream ss;
+    ss << in.rdbuf();
+    string compressed = ss.str();
+
+    vector<size_t> sizes = blockSizes(compressed);
+    ASSERT_LE(4u, sizes.size());
+    size_t total = 0;
+    for (auto i = sizes.begin(); i != sizes.end(); ++i) {
+        EXPECT_GE(BgzfStreambuf::MaxBlockSize, *i);
+        total += *i;
+    }
+    EXPECT_EQ(compressed.size(), total);
+    // ends with the empty eof block
+    EXPECT_EQ(28u, sizes.back());
+}
+
+TEST(TestBgzfOutputStream, empty) {
+    stringstream ss;
+    {
+        BgzfOutputStream out(ss);
+    }
+    EXPECT_EQ(28u, ss.str().size());
+}
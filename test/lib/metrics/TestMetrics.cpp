@@ -393,3 +393,115 @@ TEST_F(TestMetrics, identifyNovelAlleles) {
     ASSERT_FALSE(novel1[2]); //     1 0
     ASSERT_FALSE(novel2[0]); //     1 1
 }
+
+TEST_F(TestMetrics, sampleMetricsAdd) {
+    size_t const nSamples = _header.sampleCount();
+    stringstream err;
+    Metrics::SampleMetrics all(nSamples);
+    Metrics::SampleMetrics even(nSamples);
+    Metrics::SampleMetrics odd(nSamples);
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        all.processEntry(_entries[i], _metrics[i], err);
+        (i % 2 ? odd : even).processEntry(_entries[i], _metrics[i], err);
+    }
+
+    even += odd;
+    for (uint32_t i = 0; i < nSamples; ++i) {
+        EXPECT_EQ(all.numHetVariants(i), even.numHetVariants(i));
+        EXPECT_EQ(all.numHomVariants(i), even.numHomVariants(i));
+        EXPECT_EQ(all.numRefCalls(i), even.numRefCalls(i));
+        EXPECT_EQ(all.numFilteredCalls(i), even.numFilteredCalls(i));
+        EXPECT_EQ(all.numMissingCalls(i), even.numMissingCalls(i));
+        EXPECT_EQ(all.numNonDiploidCalls(i), even.numNonDiploidCalls(i));
+        EXPECT_EQ(all.numSingletonVariants(i), even.numSingletonVariants(i));
+        EXPECT_EQ(all.numVeryRareVariants(i), even.numVeryRareVariants(i));
+        EXPECT_EQ(all.numRareVariants(i), even.numRareVariants(i));
+        EXPECT_EQ(all.numCommonVariants(i), even.numCommonVariants(i));
+        EXPECT_EQ(all.numKnownVariants(i), even.numKnownVariants(i));
+        EXPECT_EQ(all.numNovelVariants(i), even.numNovelVariants(i));
+        EXPECT_EQ(all.mutationSpectrum(i).transitions(), even.mutationSpectrum(i).transitions());
+        EXPECT_EQ(all.mutationSpectrum(i).transversions(), even.mutationSpectrum(i).transversions());
+    }
+    EXPECT_EQ(3u, all.numHetVariants(1));
+
+    Metrics::SampleMetrics other(nSamples + 1);
+    EXPECT_THROW(even += other, runtime_error);
+}
+
+TEST_F(TestMetrics, sampleMetricsBySample) {
+    size_t const nSamples = _header.sampleCount();
+    stringstream err;
+    Metrics::SampleMetrics sm(nSamples);
+    sm.processEntry(_entries[0], _metrics[0], err);
+
+    EXPECT_EQ(1u, sm.numRefCalls(0));
+    EXPECT_EQ(1u, sm.numFilteredCalls(2));
+    EXPECT_EQ(0u, sm.numHetVariants(2));
+    for (uint32_t i : {1, 3, 4, 6, 7, 8}) {
+        EXPECT_EQ(1u, sm.numHetVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numHomVariants(i)) << "sample " << i;
+    }
+    EXPECT_EQ(1u, sm.numHomVariants(5));
+    EXPECT_EQ(1u, sm.numHomVariants(9));
+    // samples with no data count as missing
+    EXPECT_EQ(1u, sm.numMissingCalls(10));
+    EXPECT_EQ(0u, sm.numMissingCalls(0));
+    // 2|1 has both alts
+    EXPECT_EQ(2u, sm.numKnownVariants(8) + sm.numNovelVariants(8));
+    EXPECT_EQ(1u, sm.mutationSpectrum(5)('A', 'C'));
+    EXPECT_EQ(1u, sm.mutationSpectrum(5).transversions());
+
+    string line("1\t30\t.\tA\tC\t.\t.\t.\tGT\t1\t0/1\t1\t./.");
+    Entry haploid;
+    Entry::parseLine(&_header, line, haploid);
+    stringstream entryErr;
+    Metrics::EntryMetrics hm(haploid, _novelIndicators, entryErr);
+    EXPECT_NE(string::npos, entryErr.str().find("Non-diploid genotype for sample S1 "));
+    sm.processEntry(haploid, hm, err);
+    EXPECT_EQ(1u, sm.numNonDiploidCalls(0));
+    EXPECT_EQ(0u, sm.numNonDiploidCalls(1));
+    EXPECT_EQ(1u, sm.numNonDiploidCalls(2));
+    EXPECT_EQ(2u, sm.numHetVariants(1));
+    // ./. is a missing call, not a variant
+    EXPECT_EQ(0u, sm.numHomVariants(3));
+    EXPECT_EQ(1u, sm.numMissingCalls(3));
+    EXPECT_NE(string::npos, err.str().find("Non-diploid genotype for sample S1 "));
+    EXPECT_NE(string::npos, err.str().find("Non-diploid genotype for sample S3 "));
+}
+
+// ./. used to be classed as a variant call, indexing past the end of
+// novelStatusByAlt for its null allele. It is a missing call and adds
+// nothing else.
+TEST_F(TestMetrics, sampleMetricsMissingCall) {
+    size_t const nSamples = _header.sampleCount();
+    stringstream err;
+    Metrics::SampleMetrics sm(nSamples);
+
+    string line("1\t30\t.\tA\tC,G\t.\t.\t.\tGT\t./.\t.\t./1\t1/1");
+    Entry e;
+    Entry::parseLine(&_header, line, e);
+    Metrics::EntryMetrics m(e, _novelIndicators);
+    sm.processEntry(e, m, err);
+
+    for (uint32_t i : {0, 1}) {
+        EXPECT_EQ(1u, sm.numMissingCalls(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numHetVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numHomVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numRefCalls(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numNonDiploidCalls(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numSingletonVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numVeryRareVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numRareVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numCommonVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numKnownVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.numNovelVariants(i)) << "sample " << i;
+        EXPECT_EQ(0u, sm.mutationSpectrum(i).transitions() + sm.mutationSpectrum(i).transversions());
+    }
+
+    // a partly missing call is still a variant, counted on its one alt
+    EXPECT_EQ(0u, sm.numMissingCalls(2));
+    EXPECT_EQ(1u, sm.numHomVariants(2));
+    EXPECT_EQ(1u, sm.numKnownVariants(2) + sm.numNovelVariants(2));
+    EXPECT_EQ(1u, sm.numHomVariants(3));
+    EXPECT_TRUE(err.str().empty());
+}
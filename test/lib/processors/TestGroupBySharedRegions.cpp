@@ -0,0 +1,109 @@
+#include "processors/grouping/GroupBySharedRegions.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+    struct MockEntry {
+        int64_t start() const { return start_; }
+        int64_t stop() const { return stop_; }
+
+        int id;
+        int64_t start_;
+        int64_t stop_;
+        std::vector<Region> regions;
+    };
+
+    typedef std::unique_ptr<MockEntry> EntryPtr;
+    typedef std::vector<EntryPtr> EntryPtrVector;
+
+    struct MockRegionExtractor {
+        typedef boost::unordered_set<Region> ReturnType;
+
+        ReturnType operator()(MockEntry const& e) const {
+            return ReturnType(e.regions.begin(), e.regions.end());
+        }
+    };
+
+    struct Collector {
+        void operator()(EntryPtrVector group) {
+            std::vector<int> ids;
+            for (auto i = group.begin(); i != group.end(); ++i)
+                ids.push_back((*i)->id);
+            groups.push_back(ids);
+        }
+
+        std::vector<std::vector<int>> groups;
+    };
+
+    EntryPtr makeEntry(int id, int64_t start, int64_t stop, std::vector<Region> regions) {
+        return EntryPtr(new MockEntry{id, start, stop, regions});
+    }
+}
+
+TEST(TestGroupBySharedRegions, transitive) {
+    EntryPtrVector entries;
+    // 0 and 2 share nothing directly, but are both joined to 1
+    entries.push_back(makeEntry(0, 10, 20, {Region(10, 11)}));
+    entries.push_back(makeEntry(1, 10, 20, {Region(10, 11), Region(12, 13)}));
+    entries.push_back(makeEntry(2, 12, 13, {Region(12, 13)}));
+    // shares its span with the others, but no region
+    entries.push_back(makeEntry(3, 11, 20, {Region(11, 20)}));
+    entries.push_back(makeEntry(4, 15, 16, {Region(15, 16)}));
+    entries.push_back(makeEntry(5, 15, 16, {Region(15, 16)}));
+
+    Collector out;
+    auto grouper = makeGroupBySharedRegions(out, MockRegionExtractor());
+    grouper(std::move(entries));
+
+    ASSERT_EQ(3u, out.groups.size());
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), out.groups[0]);
+    EXPECT_EQ((std::vector<int>{3}), out.groups[1]);
+    EXPECT_EQ((std::vector<int>{4, 5}), out.groups[2]);
+}
+
+TEST(TestGroupBySharedRegions, largeBundle) {
+    // a chain of entries each sharing a region with the next
+    int n = 10000;
+    EntryPtrVector entries;
+    for (int i = 0; i < n; ++i)
+        entries.push_back(makeEntry(i, i, i + 2, {Region(i, i + 1), Region(i + 1, i + 2)}));
+    // and one off on its own
+    entries.push_back(makeEntry(n, n + 10, n + 11, {Region(n + 10, n + 11)}));
+
+    Collector out;
+    auto grouper = makeGroupBySharedRegions(out, MockRegionExtractor());
+    grouper(std::move(entries));
+
+    ASSERT_EQ(2u, out.groups.size());
+    ASSERT_EQ(size_t(n), out.groups[0].size());
+    for (int i = 0; i < n; ++i)
+        ASSERT_EQ(i, out.groups[0][i]);
+    EXPECT_EQ((std::vector<int>{n}), out.groups[1]);
+}
+
+TEST(TestGroupBySharedRegions, groupStart) {
+    EntryPtrVector entries;
+    // a padded indel listed before the snv it is joined to (say, through a
+    // multi-allelic record), so the group starts at its second entry
+    entries.push_back(makeEntry(0, 10, 14, {Region(11, 14)}));
+    entries.push_back(makeEntry(1, 8, 12, {Region(8, 9), Region(11, 14)}));
+    entries.push_back(makeEntry(2, 9, 10, {Region(9, 10)}));
+
+    Collector out;
+    std::vector<int> starts;
+    auto grouper = makeGroupBySharedRegions(
+          out
+        , MockRegionExtractor()
+        , [&starts](MockEntry const& e) { starts.push_back(e.id); }
+        );
+    grouper(std::move(entries));
+
+    ASSERT_EQ(2u, out.groups.size());
+    EXPECT_EQ((std::vector<int>{0, 1}), out.groups[0]);
+    EXPECT_EQ((std::vector<int>{2}), out.groups[1]);
+    EXPECT_EQ((std::vector<int>{1, 2}), starts);
+}
@@ -0,0 +1,124 @@
+#include "processors/grouping/GroupSortingWriter.hpp"
+
+#include "fileformats/vcf/Header.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    string const headerText =
+        "##fileformat=VCFv4.1\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n"
+        ;
+}
+
+class TestGroupSortingWriter : public ::testing::Test {
+public:
+    void SetUp() {
+        header = Vcf::Header::fromString(headerText);
+    }
+
+    Vcf::Entry makeEntry(string const& chrom, int64_t pos, string const& id, string const& ref, string const& alt = "C") {
+        stringstream ss;
+        ss << chrom << "\t" << pos << "\t" << id << "\t" << ref << "\t" << alt << "\t.\t.\t.";
+        return Vcf::Entry(&header, ss.str());
+    }
+
+    void write(Vcf::Entry const& e) {
+        written.push_back(e.identifiers().str());
+    }
+
+    GroupSortingWriter::OutputFunc output() {
+        return [this](Vcf::Entry const& e) { write(e); };
+    }
+
+    Vcf::Header header;
+    vector<string> written;
+};
+
+TEST_F(TestGroupSortingWriter, endGroup) {
+    GroupSortingWriter writer(output());
+    writer(makeEntry("1", 20, "c", "A"));
+    writer(makeEntry("1", 10, "b", "AAA"));
+    writer(makeEntry("1", 10, "a", "A"));
+    writer(makeEntry("1", 20, "d", "A"));
+    EXPECT_TRUE(written.empty());
+
+    writer.endGroup();
+    EXPECT_EQ((vector<string>{"a", "b", "c", "d"}), written);
+    EXPECT_EQ(0u, writer.size());
+}
+
+TEST_F(TestGroupSortingWriter, flushBefore) {
+    GroupSortingWriter writer(output());
+    writer(makeEntry("1", 15, "c", "A"));
+    writer(makeEntry("1", 10, "a", "A"));
+    writer(makeEntry("1", 20, "d", "A"));
+
+    // only what starts before 20 can be written
+    writer.flushBefore(makeEntry("1", 20, "x", "A"));
+    EXPECT_EQ((vector<string>{"a", "c"}), written);
+    EXPECT_EQ(1u, writer.size());
+
+    writer(makeEntry("1", 20, "e", "A"));
+    writer(makeEntry("1", 25, "f", "A"));
+    writer.flushBefore(makeEntry("1", 25, "x", "A"));
+    EXPECT_EQ((vector<string>{"a", "c", "d", "e"}), written);
+
+    // another chromosome flushes everything
+    writer.flushBefore(makeEntry("2", 1, "x", "A"));
+    EXPECT_EQ((vector<string>{"a", "c", "d", "e", "f"}), written);
+}
+
+TEST_F(TestGroupSortingWriter, chromosomeChange) {
+    {
+        GroupSortingWriter writer(output());
+        writer(makeEntry("1", 20, "b", "A"));
+        writer(makeEntry("1", 10, "a", "A"));
+        writer(makeEntry("2", 5, "d", "A"));
+        writer(makeEntry("2", 1, "c", "A"));
+        EXPECT_EQ((vector<string>{"a", "b"}), written);
+    }
+    // the rest is written on destruction
+    EXPECT_EQ((vector<string>{"a", "b", "c", "d"}), written);
+}
+
+TEST_F(TestGroupSortingWriter, reusesSlots) {
+    GroupSortingWriter writer(output());
+    for (int round = 0; round < 3; ++round) {
+        writer(makeEntry("1", 30, "c", "A"));
+        writer(makeEntry("1", 10, "a", "A"));
+        writer(makeEntry("1", 20, "b", "A"));
+        writer.flushBefore(makeEntry("1", 25, "x", "A"));
+        EXPECT_EQ(1u, writer.size());
+        writer.endGroup();
+    }
+    EXPECT_EQ((vector<string>{"a", "b", "c", "a", "b", "c", "a", "b", "c"}), written);
+}
+
+TEST_F(TestGroupSortingWriter, orderAlleles) {
+    GroupSortingWriter writer(output());
+    writer.orderAlleles(true);
+    writer(makeEntry("1", 10, "d", "A", "T"));
+    writer(makeEntry("1", 10, "b", "A", "G,T"));
+    writer(makeEntry("1", 10, "c", "A", "G,T"));
+    writer(makeEntry("1", 10, "a", "A", "C"));
+    // the same start and stop as A>T, but REF AC sorts after A
+    writer(makeEntry("1", 10, "f", "AC", "TC"));
+    writer(makeEntry("1", 10, "e", "A", "T"));
+    writer.endGroup();
+    EXPECT_EQ((vector<string>{"a", "b", "c", "d", "e", "f"}), written);
+
+    // without it, ties keep the order they came in
+    written.clear();
+    GroupSortingWriter unordered(output());
+    unordered(makeEntry("1", 10, "b", "A", "T"));
+    unordered(makeEntry("1", 10, "a", "A", "C"));
+    unordered.endGroup();
+    EXPECT_EQ((vector<string>{"b", "a"}), written);
+}
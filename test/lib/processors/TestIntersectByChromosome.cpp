@@ -0,0 +1,131 @@
+#include "processors/IntersectByChromosome.hpp"
+#include "processors/IntersectFull.hpp"
+#include "common/UnsortedDataError.hpp"
+#include "fileformats/BedReader.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "io/InputStream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+    const string BEDA =
+        "1\t2\t5\n"
+        "1\t10\t20\n"
+        "2\t3\t4\n"
+        "3\t5\t6\n"
+        "10\t1\t100\n"
+        "10\t50\t51\n"
+        "X\t7\t8\n";
+
+    const string BEDB =
+        "1\t3\t4\n"
+        "1\t30\t40\n"
+        "3\t1\t2\n"
+        "3\t5\t6\n"
+        "4\t1\t2\n"
+        "10\t40\t60\n"
+        "Y\t1\t2\n";
+
+    struct Collector {
+        Collector(ostream& hits, ostream& missA, ostream& missB)
+            : hits(hits), missesA(missA), missesB(missB)
+        {}
+
+        bool hit(const Bed& a, const Bed& b) {
+            hits << a << "\t" << b << "\n";
+            return true;
+        }
+        bool wantMissA() const { return true; }
+        bool wantMissB() const { return true; }
+        void missA(const Bed& a) { missesA << a << "\n"; }
+        void missB(const Bed& b) { missesB << b << "\n"; }
+
+        ostream& hits;
+        ostream& missesA;
+        ostream& missesB;
+    };
+
+    struct Output {
+        stringstream hits;
+        stringstream missA;
+        stringstream missB;
+    };
+
+    void intersectSerial(string const& a, string const& b, Output& out) {
+        stringstream ssA(a);
+        stringstream ssB(b);
+        InputStream streamA("A", ssA);
+        InputStream streamB("B", ssB);
+        auto readerA = openBed(streamA);
+        auto readerB = openBed(streamB);
+        Collector c(out.hits, out.missA, out.missB);
+        auto intersector = makeFullIntersector(*readerA, *readerB, c);
+        intersector.execute();
+    }
+
+    void intersectParallel(string const& a, string const& b, size_t threads, Output& out, size_t maxBufferedBytes = 0) {
+        typedef IntersectByChromosome<BedReader, BedReader> ParallelType;
+
+        stringstream ssA(a);
+        stringstream ssB(b);
+        InputStream streamA("A", ssA);
+        InputStream streamB("B", ssB);
+        auto readerA = openBed(streamA);
+        auto readerB = openBed(streamB);
+        ParallelType intersector(*readerA, *readerB, out.hits, &out.missA, &out.missB, threads, maxBufferedBytes);
+        intersector.run([](ParallelType::LinesA& a, ParallelType::LinesB& b, IntersectChunkOutput& chunk) {
+            Collector c(chunk.hits, chunk.missA, chunk.missB);
+            auto chromIntersector = makeFullIntersector(a, b, c);
+            chromIntersector.execute();
+        });
+    }
+}
+
+TEST(TestIntersectByChromosome, sameAsSerial) {
+    Output expected;
+    intersectSerial(BEDA, BEDB, expected);
+    ASSERT_FALSE(expected.hits.str().empty());
+    ASSERT_FALSE(expected.missA.str().empty());
+    ASSERT_FALSE(expected.missB.str().empty());
+
+    for (size_t threads = 1; threads <= 4; ++threads) {
+        Output out;
+        intersectParallel(BEDA, BEDB, threads, out);
+        EXPECT_EQ(expected.hits.str(), out.hits.str()) << threads << " threads";
+        EXPECT_EQ(expected.missA.str(), out.missA.str()) << threads << " threads";
+        EXPECT_EQ(expected.missB.str(), out.missB.str()) << threads << " threads";
+    }
+}
+
+// A limit smaller than any chromosome still reads one pair at a time
+TEST(TestIntersectByChromosome, bufferLimit) {
+    Output expected;
+    intersectSerial(BEDA, BEDB, expected);
+
+    for (size_t threads = 2; threads <= 4; ++threads) {
+        Output out;
+        intersectParallel(BEDA, BEDB, threads, out, 1);
+        EXPECT_EQ(expected.hits.str(), out.hits.str()) << threads << " threads";
+        EXPECT_EQ(expected.missA.str(), out.missA.str()) << threads << " threads";
+        EXPECT_EQ(expected.missB.str(), out.missB.str()) << threads << " threads";
+    }
+}
+
+TEST(TestIntersectByChromosome, unsortedChromosomes) {
+    string unsorted = BEDA + "2\t1\t2\n";
+    Output out;
+    EXPECT_THROW(intersectParallel(unsorted, BEDB, 2, out), UnsortedDataError);
+
+    // everything before the chromosome with the error is written
+    Output expected;
+    intersectSerial(BEDA, BEDB, expected);
+    EXPECT_EQ(expected.hits.str(), out.hits.str());
+    EXPECT_NE(string::npos, out.missA.str().find("10\t"));
+    EXPECT_EQ(string::npos, out.missA.str().find("X\t"));
+}
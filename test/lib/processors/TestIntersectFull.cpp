@@ -109,3 +109,37 @@ TEST(TestIntersectFull, cacheCrash) {
     ASSERT_EQ(1u, rc.missesA.size());
     ASSERT_EQ(1u, rc.missesB.size());
 }
+
+TEST(TestIntersectFull, longIntervalsInCache) {
+    // b has a 1bp region and a long one at each of 100 positions, every
+    // other long one ending at 250. the 1bp regions are all misses, the
+    // long ones are all cached for the first entry of a.
+    stringstream ssB;
+    for (int i = 0; i < 100; ++i) {
+        ssB << "1\t" << i << "\t" << i + 1 << "\n";
+        ssB << "1\t" << i << "\t" << (i % 2 ? 250 : 1000) << "\n";
+    }
+    stringstream ssA("1\t200\t201\n1\t300\t301\n2\t1\t2\n");
+
+    MockCollector rc;
+    InputStream streamA("A", ssA);
+    InputStream streamB("B", ssB);
+    auto s1 = openBed(streamA);
+    auto s2 = openBed(streamB);
+    auto intersector = makeFullIntersector(*s1, *s2, rc);
+    intersector.execute();
+
+    ASSERT_EQ(150u, rc.hitsA.size());
+    ASSERT_EQ(1u, rc.missesA.size());
+    EXPECT_EQ("2", rc.missesA[0].chrom());
+
+    ASSERT_EQ(100u, rc.missesB.size());
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(i, rc.missesB[i].start());
+
+    // hits are in the order of b
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(i, rc.hitsA[i].second.start());
+    for (int i = 0; i < 50; ++i)
+        EXPECT_EQ(2 * i, rc.hitsA[100 + i].second.start());
+}
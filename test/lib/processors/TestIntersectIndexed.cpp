@@ -0,0 +1,125 @@
+#include "processors/IntersectIndexed.hpp"
+#include "io/InputStream.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "fileformats/BedReader.hpp"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const string BEDA =
+        "1\t2\t2\t*/CC\t30\t30\n"
+        "1\t2\t2\t*/CCC\t30\t30\n"
+        "1\t5\t8\tTTT/*\t30\t30\n"
+        "1\t5\t8\tCCC/*\t30\t30";
+
+    const string BEDB =
+        "1\t2\t2\t*/CC\t30\t30\n"
+        "1\t2\t2\t*/CCC\t30\t30\n"
+        "1\t5\t8\tTTT/*\t30\t30\n"
+        "2\t1\t2\tA/T\t30\t30";
+
+    // BEDB out of order
+    const string BEDB_UNSORTED =
+        "2\t1\t2\tA/T\t30\t30\n"
+        "1\t5\t8\tTTT/*\t30\t30\n"
+        "1\t2\t2\t*/CCC\t30\t30\n"
+        "1\t2\t2\t*/CC\t30\t30";
+
+    const string BEDC =
+        "17	7985753	7985754	T/0	-	-\n"
+        "17	7985785	7985786	T/0	-	-\n"
+        "17	7993250	7993257	AAAAACA/0	-	-"
+        ;
+
+    const string BEDD =
+        "17	7985753	7985754	T/0	-	-\n"
+        "17	7985753	7985786	TTTTTTCTCCCCCTTGAACTTGAGCTCAATTCT/0	-	-\n"
+        "17	7985754	7985754	0/TTTTTCTCCCCCTTGAACTTGAGCTCAATTC	-	-\n"
+        "17	7985785	7985786	T/0	-	-"
+        ;
+
+    struct MockCollector {
+        bool hit(const Bed& a, const Bed& b) {
+            hits.push_back(make_pair(a,b));
+            return true;
+        }
+        bool wantMissA() const { return true; }
+        bool wantMissB() const { return true; }
+        void missA(const Bed& a) { missesA.push_back(a); }
+        void missB(const Bed& b) { missesB.push_back(b); }
+
+        vector<pair<Bed,Bed> > hits;
+        vector<Bed> missesA;
+        vector<Bed> missesB;
+    };
+
+    void intersect(string const& a, string const& b, MockCollector& rc, bool adjacentInsertions = false) {
+        stringstream ssA(a);
+        stringstream ssB(b);
+        InputStream streamA("A", ssA);
+        InputStream streamB("B", ssB);
+        auto s1 = openBed(streamA);
+        auto s2 = openBed(streamB);
+        auto intersector = makeIndexedIntersector(*s1, *s2, rc, adjacentInsertions);
+        intersector.execute();
+    }
+}
+
+TEST(TestIntersectIndexed, intersectSelf) {
+    MockCollector rc;
+    intersect(BEDA, BEDA, rc);
+
+    ASSERT_EQ(8u, rc.hits.size());
+    ASSERT_EQ(0u, rc.missesA.size());
+    ASSERT_EQ(0u, rc.missesB.size());
+}
+
+TEST(TestIntersectIndexed, misses) {
+    MockCollector rc;
+    intersect(BEDA, BEDB, rc);
+
+    ASSERT_EQ(6u, rc.hits.size());
+    ASSERT_EQ(0u, rc.missesA.size());
+    ASSERT_EQ(1u, rc.missesB.size());
+    EXPECT_EQ("2", rc.missesB[0].chrom());
+}
+
+TEST(TestIntersectIndexed, unsorted) {
+    MockCollector rc;
+    intersect(BEDB_UNSORTED, BEDA, rc);
+
+    ASSERT_EQ(6u, rc.hits.size());
+    ASSERT_EQ(1u, rc.missesA.size());
+    EXPECT_EQ("2", rc.missesA[0].chrom());
+    ASSERT_EQ(0u, rc.missesB.size());
+
+    // hits come in the order of b
+    EXPECT_EQ("TTT/*", rc.hits[0].first.extraFields()[0]);
+    EXPECT_EQ("TTT/*", rc.hits[0].second.extraFields()[0]);
+    EXPECT_EQ("CCC/*", rc.hits[1].second.extraFields()[0]);
+}
+
+TEST(TestIntersectIndexed, sameAsFull) {
+    MockCollector rc;
+    intersect(BEDC, BEDD, rc);
+
+    ASSERT_EQ(4u, rc.hits.size());
+    ASSERT_EQ(1u, rc.missesA.size());
+    ASSERT_EQ(1u, rc.missesB.size());
+}
+
+TEST(TestIntersectIndexed, adjacentInsertions) {
+    MockCollector rc;
+    intersect(BEDD, BEDC, rc);
+    size_t hits = rc.hits.size();
+
+    MockCollector adj;
+    intersect(BEDD, BEDC, adj, true);
+    EXPECT_LT(hits, adj.hits.size());
+}
@@ -0,0 +1,85 @@
+#include "processors/IntersectMany.hpp"
+#include "fileformats/BedReader.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "io/InputStream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    const string BEDA =
+        "1\t2\t5\n"
+        "1\t10\t20\n"
+        "1\t30\t31\n"
+        "2\t3\t4\n";
+
+    const string TRACK1 =
+        "1\t3\t4\n"
+        "1\t15\t16\n";
+
+    const string TRACK2 =
+        "1\t0\t100\n";
+
+    const string TRACK3 =
+        "1\t20\t30\n"
+        "2\t1\t3\n"
+        "2\t3\t10\n";
+
+    struct Collector {
+        void operator()(Bed const& a, vector<bool> const& hits) {
+            stringstream ss;
+            ss << a.chrom() << ":" << a.start() << " ";
+            for (auto i = hits.begin(); i != hits.end(); ++i)
+                ss << *i;
+            rows.push_back(ss.str());
+        }
+
+        vector<string> rows;
+    };
+}
+
+TEST(TestIntersectMany, hitFlags) {
+    stringstream ssA(BEDA);
+    stringstream ss1(TRACK1);
+    stringstream ss2(TRACK2);
+    stringstream ss3(TRACK3);
+    InputStream streamA("A", ssA);
+    InputStream stream1("1", ss1);
+    InputStream stream2("2", ss2);
+    InputStream stream3("3", ss3);
+    auto a = openBed(streamA);
+    auto b1 = openBed(stream1);
+    auto b2 = openBed(stream2);
+    auto b3 = openBed(stream3);
+    vector<BedReader*> bs{b1.get(), b2.get(), b3.get()};
+
+    Collector rc;
+    auto intersector = makeManyIntersector(*a, bs, rc);
+    intersector.execute();
+
+    vector<string> expected{
+        "1:2 110",
+        "1:10 110",
+        "1:30 010",
+        "2:3 001"
+    };
+    EXPECT_EQ(expected, rc.rows);
+}
+
+TEST(TestIntersectMany, noTracks) {
+    stringstream ssA(BEDA);
+    InputStream streamA("A", ssA);
+    auto a = openBed(streamA);
+    vector<BedReader*> bs;
+
+    Collector rc;
+    auto intersector = makeManyIntersector(*a, bs, rc);
+    intersector.execute();
+    ASSERT_EQ(4u, rc.rows.size());
+    EXPECT_EQ("1:2 ", rc.rows[0]);
+}
@@ -85,3 +85,28 @@ TEST_F(TestMergeSorted, execute) {
         ASSERT_EQ(_expectedBeds[i], c.beds[i]);
 }
 
+
+TEST_F(TestMergeSorted, tiesInInputOrder) {
+    // the first stream is empty, and the others all have entries at 1:2-3
+    stringstream streams[4];
+    streams[1] << "1\t2\t3\tB1\n" << "1\t2\t3\tB2\n";
+    streams[2] << "1\t1\t2\tC1\n" << "1\t2\t3\tC2\n";
+    streams[3] << "1\t2\t3\tD1\n";
+
+    vector<InputStream::ptr> inputStreams;
+    vector<BedReader::ptr> bedStreams;
+    for (int i = 0; i < 4; ++i) {
+        inputStreams.push_back(std::make_unique<InputStream>("test", streams[i]));
+        bedStreams.push_back(openBed(*inputStreams.back(), 1));
+    }
+
+    Collector c;
+    auto merger = makeMergeSorted(bedStreams);
+    auto pump = makeStreamPump(merger, c);
+    pump.execute();
+
+    vector<string> names;
+    for (auto i = c.beds.begin(); i != c.beds.end(); ++i)
+        names.push_back(i->extraFields()[0]);
+    EXPECT_EQ((vector<string>{"C1", "B1", "B2", "C2", "D1"}), names);
+}
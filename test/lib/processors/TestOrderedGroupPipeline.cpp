@@ -0,0 +1,133 @@
+#include "processors/OrderedGroupPipeline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    typedef OrderedGroupPipeline<int> PipelineType;
+
+    // Writes each group as a line of its values. Throws for a group
+    // starting with badValue.
+    struct WriteGroup {
+        int badValue;
+        PipelineType::Recycler* recycler;
+
+        void operator()(PipelineType::ValuePtrVector group, ostream& out) {
+            if (!group.empty() && *group[0] == badValue)
+                throw runtime_error("bad group");
+
+            for (auto i = group.begin(); i != group.end(); ++i) {
+                out << (i == group.begin() ? "" : ",") << **i;
+                if (recycler)
+                    recycler->release(std::move(*i));
+            }
+            out << "\n";
+        }
+    };
+
+    struct Worker {
+        int badValue;
+
+        void operator()(PipelineType& pipeline) {
+            PipelineType::Recycler recycler;
+            WriteGroup f{badValue, &recycler};
+            pipeline.work(f, &recycler);
+        }
+    };
+
+    struct FailingWorker {
+        void operator()(PipelineType&) {
+            throw runtime_error("no worker for you");
+        }
+    };
+
+    // Groups of 1, 2, 3, 1, 2, 3, ... values numbered from 0
+    void sendGroups(PipelineType& pipeline, int nGroups, ObjectPool<int>* pool = 0) {
+        int value = 0;
+        for (int i = 0; i < nGroups; ++i) {
+            PipelineType::ValuePtrVector group;
+            for (int j = 0; j <= i % 3; ++j) {
+                PipelineType::ValuePtr p = pool ? pool->acquire() : PipelineType::ValuePtr(new int);
+                *p = value++;
+                group.push_back(std::move(p));
+            }
+            pipeline(std::move(group));
+        }
+    }
+
+    string expected(int nGroups) {
+        stringstream ss;
+        int value = 0;
+        for (int i = 0; i < nGroups; ++i) {
+            for (int j = 0; j <= i % 3; ++j)
+                ss << (j ? "," : "") << value++;
+            ss << "\n";
+        }
+        return ss.str();
+    }
+}
+
+TEST(OrderedGroupPipeline, inOrder) {
+    size_t threads[] = {1, 2, 4};
+    size_t batchSizes[] = {1, 7, 1000};
+    for (size_t t = 0; t < 3; ++t) {
+        for (size_t b = 0; b < 3; ++b) {
+            stringstream out;
+            ObjectPool<int> pool;
+            PipelineType pipeline(out, threads[t], batchSizes[b], &pool);
+            pipeline.start(Worker{-1});
+            sendGroups(pipeline, 1234, &pool);
+            pipeline.finish();
+            EXPECT_EQ(expected(1234), out.str())
+                << threads[t] << " threads, batch size " << batchSizes[b];
+
+            // everything made its way back to the pool
+            EXPECT_EQ(pool.allocated(), pool.size());
+        }
+    }
+}
+
+TEST(OrderedGroupPipeline, empty) {
+    stringstream out;
+    PipelineType pipeline(out, 3, 10);
+    pipeline.start(Worker{-1});
+    pipeline.finish();
+    EXPECT_EQ("", out.str());
+}
+
+TEST(OrderedGroupPipeline, errorsInOrder) {
+    // value 99 starts group 33
+    string before = expected(33);
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        stringstream out;
+        PipelineType pipeline(out, threads, 5);
+        pipeline.start(Worker{99});
+        try {
+            sendGroups(pipeline, 500);
+            pipeline.finish();
+            FAIL() << "expected an exception with " << threads << " threads";
+        }
+        catch (runtime_error const& e) {
+            EXPECT_EQ("bad group", string(e.what()));
+        }
+        // everything before the bad group was written
+        EXPECT_EQ(before, out.str().substr(0, before.size()));
+    }
+}
+
+TEST(OrderedGroupPipeline, workerError) {
+    stringstream out;
+    PipelineType pipeline(out, 2, 5);
+    pipeline.start(FailingWorker());
+    EXPECT_THROW({
+        sendGroups(pipeline, 100);
+        pipeline.finish();
+    }, runtime_error);
+}
@@ -0,0 +1,129 @@
+#include "processors/OrderedPipeline.hpp"
+#include "fileformats/TypedStream.hpp"
+#include "fileformats/vcf/Entry.hpp"
+#include "io/InputStream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    string const headerText(
+        "##fileformat=VCFv4.1\n"
+        "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n"
+        );
+
+    string makeVcf(int nEntries, int badLine = -1) {
+        stringstream ss;
+        ss << headerText;
+        for (int i = 0; i < nEntries; ++i) {
+            if (i == badLine)
+                ss << "1\tnotanumber\t.\tA\tC\t.\t.\t.\tGT\t0/1\n";
+            else
+                ss << "1\t" << i + 1 << "\t.\tA\tC\t" << i % 50 << "\tPASS\t.\tGT\t0/1\n";
+        }
+        return ss.str();
+    }
+
+    // Rewrites the alt allele and counts what it has seen
+    struct SetAlt {
+        SetAlt()
+            : count(0)
+        {}
+
+        void operator()(Vcf::Entry& e, OrderedPipelineContext& ctx) {
+            ++count;
+            e.replaceAlts(e.pos(), e.ref(), vector<string>(1, "T"));
+            ctx.out << e << "\n";
+            if (e.pos() % 100 == 0)
+                ctx.err << "line " << ctx.lineNum << "\n";
+        }
+
+        int count;
+    };
+
+    struct Result {
+        string out;
+        string err;
+        vector<SetAlt> funcs;
+    };
+
+    typedef OrderedPipeline<TypedStream<DefaultParser<Vcf::Entry>>> PipelineType;
+
+    Result run(string const& text, size_t threads, size_t batchSize) {
+        stringstream in(text);
+        InputStream stream("test", in);
+        auto reader = openStream<Vcf::Entry>(stream);
+
+        Result rv;
+        stringstream out;
+        stringstream err;
+        PipelineType pipeline(*reader, out, threads, batchSize, err);
+        rv.funcs = pipeline.run(SetAlt());
+        rv.out = out.str();
+        rv.err = err.str();
+        return rv;
+    }
+}
+
+TEST(OrderedPipeline, matchesSerial) {
+    string text = makeVcf(2345);
+    Result serial = run(text, 1, 1000);
+    ASSERT_EQ(1u, serial.funcs.size());
+    EXPECT_EQ(2345, serial.funcs[0].count);
+    EXPECT_NE(string::npos, serial.err.find("line 103\n"));
+
+    size_t threads[] = {2, 4};
+    size_t batchSizes[] = {1, 7, 1000, 5000};
+    for (size_t t = 0; t < 2; ++t) {
+        for (size_t b = 0; b < 4; ++b) {
+            Result parallel = run(text, threads[t], batchSizes[b]);
+            EXPECT_EQ(serial.out, parallel.out)
+                << threads[t] << " threads, batch size " << batchSizes[b];
+            EXPECT_EQ(serial.err, parallel.err)
+                << threads[t] << " threads, batch size " << batchSizes[b];
+
+            ASSERT_EQ(threads[t], parallel.funcs.size());
+            int total = 0;
+            for (auto i = parallel.funcs.begin(); i != parallel.funcs.end(); ++i)
+                total += i->count;
+            EXPECT_EQ(2345, total);
+        }
+    }
+}
+
+TEST(OrderedPipeline, emptyInput) {
+    Result rv = run(makeVcf(0), 3, 10);
+    EXPECT_EQ("", rv.out);
+    EXPECT_EQ(3u, rv.funcs.size());
+}
+
+TEST(OrderedPipeline, errorsInOrder) {
+    string text = makeVcf(500, 321);
+    string expectedOut = run(makeVcf(321), 1, 1000).out;
+
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        stringstream in(text);
+        InputStream stream("test", in);
+        auto reader = openStream<Vcf::Entry>(stream);
+        stringstream out;
+        stringstream err;
+        PipelineType pipeline(*reader, out, threads, 10, err);
+        try {
+            pipeline.run(SetAlt());
+            FAIL() << "expected an exception with " << threads << " threads";
+        }
+        catch (runtime_error const& e) {
+            // header is 3 lines, the bad entry is the 322nd
+            EXPECT_NE(string::npos, string(e.what()).find("test:325"))
+                << e.what();
+        }
+        EXPECT_EQ(expectedOut, out.str());
+    }
+}
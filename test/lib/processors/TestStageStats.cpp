@@ -0,0 +1,161 @@
+#include "processors/StageStats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Record {
+        std::size_t approxBytes() const { return bytes; }
+
+        std::size_t bytes;
+    };
+
+    typedef std::unique_ptr<Record> RecordPtr;
+    typedef std::vector<RecordPtr> RecordPtrVector;
+
+    std::vector<RecordPtr> makeGroup(std::size_t size) {
+        std::vector<RecordPtr> rv;
+        for (std::size_t i = 0; i < size; ++i)
+            rv.push_back(RecordPtr(new Record{10}));
+        return rv;
+    }
+
+    // Passes groups on to another stage
+    template<typename OutputFunc>
+    struct Forward {
+        OutputFunc& out;
+
+        void operator()(RecordPtrVector group) {
+            out(std::move(group));
+        }
+    };
+
+    struct Sink {
+        Sink() : groups(0) {}
+
+        void operator()(RecordPtrVector group) {
+            ++groups;
+        }
+
+        int groups;
+    };
+
+    struct IntStream {
+        typedef int ValueType;
+
+        IntStream(int n) : i(0), n(n) {}
+
+        bool eof() const { return i >= n; }
+
+        bool peek(int** value) {
+            if (eof())
+                return false;
+            *value = &i;
+            return true;
+        }
+
+        bool next(int& value) {
+            if (eof())
+                return false;
+            value = i++;
+            return true;
+        }
+
+        int i;
+        int n;
+    };
+}
+
+TEST(TestStageStats, groups) {
+    StageStats stats("x");
+    stats.addGroup(1, 10);
+    stats.addGroup(3, 100);
+    stats.addGroup(2, 20);
+    stats.addGroup(8, 50);
+
+    EXPECT_EQ(4u, stats.calls());
+    EXPECT_EQ(14u, stats.records());
+    EXPECT_EQ(8u, stats.maxGroupSize());
+    EXPECT_EQ(100u, stats.peakGroupBytes());
+    EXPECT_EQ((std::vector<uint64_t>{0, 1, 2, 0, 1}), stats.groupSizes());
+
+    StageStats more("x");
+    more.addGroup(0, 0);
+    more.addRecords(5);
+    stats += more;
+    EXPECT_EQ(6u, stats.calls());
+    EXPECT_EQ(19u, stats.records());
+    EXPECT_EQ((std::vector<uint64_t>{1, 1, 2, 0, 1}), stats.groupSizes());
+}
+
+TEST(TestStageStats, nestedStages) {
+    PipelineStats stats;
+    Sink sink;
+    auto inner = makeTimedStage(sink, stats.stage("inner"));
+    Forward<decltype(inner)> forward{inner};
+    auto outer = makeTimedStage(forward, stats.stage("outer"));
+
+    outer(makeGroup(2));
+    outer(makeGroup(3));
+    EXPECT_EQ(2, sink.groups);
+
+    StageStats const* o = stats.stage("outer");
+    StageStats const* i = stats.stage("inner");
+    ASSERT_EQ(2u, stats.stages().size());
+    EXPECT_EQ(2u, o->calls());
+    EXPECT_EQ(5u, o->records());
+    EXPECT_EQ(30u, o->peakGroupBytes());
+    EXPECT_EQ(5u, i->records());
+
+    // the inner stage's time is not the outer's own
+    EXPECT_DOUBLE_EQ(i->seconds(), i->selfSeconds());
+    EXPECT_NEAR(o->seconds() - i->seconds(), o->selfSeconds(), 1e-9);
+}
+
+TEST(TestStageStats, nullStage) {
+    Sink sink;
+    auto stage = makeTimedStage(sink, 0);
+    stage(makeGroup(1));
+    EXPECT_EQ(1, sink.groups);
+}
+
+TEST(TestStageStats, timedStream) {
+    StageStats stats("read");
+    IntStream in(3);
+    TimedStream<IntStream> s(in, &stats);
+
+    int* p;
+    int value;
+    ASSERT_TRUE(s.peek(&p));
+    ASSERT_TRUE(s.peek(&p));
+    ASSERT_TRUE(s.next(value));
+    ASSERT_TRUE(s.next(value));
+    ASSERT_TRUE(s.next(value));
+    ASSERT_FALSE(s.next(value));
+    EXPECT_EQ(2, value);
+    EXPECT_EQ(3u, stats.records());
+}
+
+TEST(TestStageStats, pipelineStats) {
+    PipelineStats a;
+    a.stage("parse")->addRecords(2);
+    PipelineStats b;
+    b.stage("merge")->addGroup(2, 20);
+    b.stage("parse")->addRecords(1);
+
+    a += b;
+    ASSERT_EQ(2u, a.stages().size());
+    EXPECT_EQ("parse", a.stages()[0]->name());
+    EXPECT_EQ(3u, a.stages()[0]->records());
+    EXPECT_EQ("merge", a.stages()[1]->name());
+
+    std::stringstream ss;
+    a.toJson(ss);
+    std::string json = ss.str();
+    EXPECT_NE(std::string::npos, json.find("\"name\": \"merge\""));
+    EXPECT_NE(std::string::npos, json.find("\"group_sizes\": [{\"min\": 2, \"max\": 3, \"count\": 1}]"));
+}